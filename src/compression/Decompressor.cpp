@@ -30,6 +30,7 @@
 
 #include "Decompressor.h"
 #include "XMFile.h"
+#include "PPSystem.h"
 
 void DecompressorBase::removeFile(const PPSystemString& fileName)
 {
@@ -47,6 +48,39 @@ void DecompressorBase::setFilename(const PPSystemString& fileName)
 	this->fileName = fileName;
 }
 
+bool DecompressorBase::decompress(const PPSystemString& outFileName, Hints hint)
+{
+	XMFile f(outFileName, true);
+
+	if (!f.isOpenForWriting())
+		return false;
+
+	return decompress(f, hint);
+}
+
+bool DecompressorBase::decompressToStreamViaFile(XMFileBase& outFile, Hints hint)
+{
+	// back end can only write files, go through a temporary one
+	PPSystemString tempFile(System::getTempFileName());
+
+	bool res = decompress(tempFile, hint);
+
+	if (res)
+	{
+		XMFile f(tempFile);
+		res = f.isOpen();
+
+		mp_ubyte buffer[16384];
+		mp_sint32 len;
+		while (res && (len = f.read(buffer, 1, sizeof(buffer))) > 0)
+			res = outFile.write(buffer, 1, len) == len;
+	}
+
+	removeFile(tempFile);
+
+	return res;
+}
+
 Decompressor::Decompressor(const PPSystemString& fileName) :
 	DecompressorBase(fileName)
 {
@@ -133,6 +167,25 @@ bool Decompressor::decompress(const PPSystemString& outFileName, Hints hint)
 	return result;
 }
 
+bool Decompressor::decompress(XMFileBase& outFile, Hints hint)
+{
+	const mp_uint32 startPos = outFile.pos();
+
+	for (pp_int32 i = 0; i < decompressors.size(); i++)
+	{
+		if (decompressors.get(i)->identify())
+		{
+			if (decompressors.get(i)->decompress(outFile, hint))
+				return true;
+
+			// let the next one overwrite whatever has been written
+			outFile.seek(startPos);
+		}
+	}
+
+	return false;
+}
+
 DecompressorBase* Decompressor::clone()
 {
 	return new Decompressor(fileName);
@@ -35,6 +35,7 @@
 #include "SimpleVector.h"
 
 class XMFile;
+class XMFileBase;
 
 class DecompressorBase
 {
@@ -66,7 +67,12 @@ public:
 	
 	virtual const PPSimpleVector<Descriptor>& getDescriptors(Hints hint) const = 0;
 	
-	virtual bool decompress(const PPSystemString& outFileName, Hints hint) = 0;
+	// decompress into a file, by default this goes through the stream version
+	virtual bool decompress(const PPSystemString& outFileName, Hints hint);
+	// decompress into a stream, e.g. into an XMFileMemory which can be passed
+	// to XModule::loadModule(XMFileBase&) without going through a temp file.
+	// Back ends which can only write files implement this with decompressToStreamViaFile()
+	virtual bool decompress(XMFileBase& outFile, Hints hint) = 0;
 	
 	static void removeFile(const PPSystemString& fileName);
 	
@@ -75,6 +81,10 @@ public:
 	virtual DecompressorBase* clone() = 0;
 	
 protected:
+	// goes through a temporary file, only to be used by back ends which
+	// override the file version of decompress()
+	bool decompressToStreamViaFile(XMFileBase& outFile, Hints hint);
+
 	PPSystemString fileName;
 
 	mutable PPSimpleVector<Descriptor> descriptors;
@@ -95,6 +105,8 @@ public:
 	virtual const PPSimpleVector<Descriptor>& getDescriptors(Hints hint) const;
 
 	virtual bool decompress(const PPSystemString& outFileName, Hints hint);
+
+	virtual bool decompress(XMFileBase& outFile, Hints hint);
 	
 	virtual DecompressorBase* clone();
 
@@ -52,6 +52,8 @@ public:
 	virtual const PPSimpleVector<Descriptor>& getDescriptors(Hints hint) const;
 
 	virtual bool decompress(const PPSystemString& outFilename, Hints hint);
+
+	virtual bool decompress(XMFileBase& outFile, Hints hint) { return decompressToStreamViaFile(outFile, hint); }
 	
 	virtual DecompressorBase* clone();
 };
@@ -53,7 +53,7 @@ ZipExtractor::ZipExtractor(const PPSystemString& archivePath) :
 {
 }
 
-bool ZipExtractor::parseZip(pp_int32& err, bool extract, const PPSystemString* outFile)
+bool ZipExtractor::parseZip(pp_int32& err, bool extract, XMFileBase* outFile)
 {
     int i;
 	int fd;
@@ -155,11 +155,10 @@ bool ZipExtractor::parseZip(pp_int32& err, bool extract, const PPSystemString* o
 						{														
 							if (extract)
 							{
-								XMFile f(*outFile, true);
-								f.write(buf, 1, i);
+								outFile->write(buf, 1, i);
 								while (0 < (i = zzip_file_read(fp, (char*)buf, 16384)))
 								{
-									f.write(buf, 1, i);
+									outFile->write(buf, 1, i);
 								}
 								if (i < 0)
 								{
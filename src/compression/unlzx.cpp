@@ -9,6 +9,7 @@
 
 #include "unlzx.h"
 #include "XMFile.h"
+#include "XMFileMemory.h"
 
 #include <ctype.h>
 
@@ -610,21 +611,61 @@ void Unlzx::decrunch(struct UnLZX *unlzx)
 	unlzx->global_shift = shift;
 }
 
-XMFile* Unlzx::open_output(const PPSystemString& filename)
+XMFileBase* Unlzx::open_output(const PPSystemString& filename)
 {
+	// extracting into a stream: unpack each entry into memory first,
+	// only the one which is identified ends up in the stream
+	if (unlzx->outputFile)
+		return new XMFileMemory();
+
 	XMFile *file = new XMFile(filename, true);
 	
 	if (!file->isOpenForWriting())
+	{
+		delete file;
 		return NULL;
+	}
 	
 	return(file);
 }
 
+bool Unlzx::close_output(XMFileBase* out_file, struct UnLZX *unlzx, bool identify)
+{
+	bool found = false;
+
+	if (unlzx->outputFile)
+	{
+		if (identify && identificator)
+		{
+			out_file->seek(0);
+			found = identificator->identify(*out_file);
+			if (found)
+			{
+				XMFileMemory* entry = static_cast<XMFileMemory*>(out_file);
+				unlzx->outputFile->write(entry->getBuffer(), 1, entry->size());
+			}
+		}
+		delete out_file;
+	}
+	else
+	{
+		PPSystemString fileName = out_file->getFileName();
+		delete out_file;
+		if (identify && identificator)
+		{
+			XMFile f(fileName);
+			found = identificator->identify(f);
+		}
+	}
+
+	return found;
+}
+
 signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& found)
 {
 	found = false;
 	struct filename_node *node;
-	XMFile *out_file = NULL;
+	XMFileBase *out_file = NULL;
 	unsigned char *pos, *temp;
 	unsigned long count;
 	signed long abort = 0;
@@ -638,7 +679,7 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 	for(count = 0; count < 768; count ++) unlzx->literal_len[count] = 0;
 	unlzx->source_end = (unlzx->source = unlzx->read_buffer + 16384) - 1024;
 	pos = unlzx->destination_end = unlzx->destination = unlzx->decrunch_buffer + 65794;
-	for (node = unlzx->filename_list; (!abort) && node; node = node->next)
+	for (node = unlzx->filename_list; (!abort) && (!found) && node; node = node->next)
 	{
 		unlzx->sum = 0;
 		if (unlzx->use_outdir)
@@ -656,7 +697,7 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 #ifdef UNLZX_DEBUG
 			printf("Extracting \"%s\"...", (char *)node->filename);
 #endif			
-			out_file = unlzx->temporaryFile ? open_output(*(unlzx->temporaryFile)) : open_output(PPSystemString((const char*)unlzx->work_buffer));
+			out_file = open_output(PPSystemString((const char*)unlzx->work_buffer));
 		}
 		else
 		{
@@ -741,16 +782,15 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 		}
 		if (out_file)
 		{
-			PPSystemString fileName = out_file->getFileName();
-			delete out_file;
-			if (!abort)
-			{
 #ifdef UNLZX_DEBUG
+			if (!abort)
 				printf(" crc %s\n", (char *)((node->crc == unlzx->sum) ? "good" : "bad"));
 #endif				
-				if (identificator)
-					found = identificator->identify(fileName);
-			}
+			if (!abort && identificator)
+				found = close_output(out_file, unlzx, true);
+			else
+				close_output(out_file, unlzx, false);
+			out_file = NULL;
 		}
 	}
 	return(abort);
@@ -759,11 +799,11 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& found)
 {
 	struct filename_node *node;
-	XMFile *out_file = NULL;
+	XMFileBase *out_file = NULL;
 	unsigned long count;
 	signed long abort = 0;
 	
-	for (node = unlzx->filename_list; (!abort) && (node); node = node->next)
+	for (node = unlzx->filename_list; (!abort) && (!found) && (node); node = node->next)
 	{
 		unlzx->sum = 0;
 		if (unlzx->use_outdir)
@@ -781,7 +821,7 @@ signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& fou
 #ifdef UNLZX_DEBUG
 			printf("Storing \"%s\"...", (char *)node->filename);
 #endif
-			out_file = unlzx->temporaryFile ? open_output(*(unlzx->temporaryFile)) : open_output(PPSystemString((const char*)unlzx->work_buffer));
+			out_file = open_output(PPSystemString((const char*)unlzx->work_buffer));
 		}
 		else
 		{
@@ -825,16 +865,15 @@ signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& fou
 		}
 		if (out_file)
 		{
-			PPSystemString fileName = out_file->getFileName();
-			delete out_file;
-			if (!abort)
-			{
 #ifdef UNLZX_DEBUG
+			if (!abort)
 				printf(" crc %s\n", (char *)((node->crc == unlzx->sum) ? "good" : "bad"));
 #endif				
-				if (identificator)
-					found = identificator->identify(fileName);
-			}
+			if (!abort && identificator)
+				found = close_output(out_file, unlzx, true);
+			else
+				close_output(out_file, unlzx, false);
+			out_file = NULL;
 		}
 	}
 	return(abort);
@@ -1323,7 +1362,7 @@ Unlzx::~Unlzx()
 		unlzx_free(unlzx);
 }
 
-bool Unlzx::extractFile(bool extract, const PPSystemString* outFilename)
+bool Unlzx::extractFile(bool extract, XMFileBase* outFile)
 {
 	int result = 0;
 	
@@ -1332,7 +1371,7 @@ bool Unlzx::extractFile(bool extract, const PPSystemString* outFilename)
 		if (extract)
 		{
 			unlzx->mode = 1;
-			unlzx->temporaryFile = outFilename;
+			unlzx->outputFile = outFile;
 			bool found = false;
 			// TODO: make this all type safe
 			result = process_archive(archiveFilename, unlzx, found);
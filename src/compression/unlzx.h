@@ -26,13 +26,14 @@ LONG mkdir(STRPTR path, UWORD perm);
 #include "BasicTypes.h"
 
 class XMFile;
+class XMFileBase;
 
 class Unlzx
 {
 public:
 	struct FileIdentificator
 	{
-		virtual bool identify(const PPSystemString& filename) const = 0;
+		virtual bool identify(XMFileBase& f) const = 0;
 	};
 
 
@@ -97,7 +98,8 @@ private:
 		
 		unsigned long sum;
 		
-		const PPSystemString* temporaryFile;
+		// extract into this stream instead of files
+		XMFileBase* outputFile;
 	};
 	
 	PPSystemString archiveFilename;
@@ -115,7 +117,8 @@ private:
 	signed long make_decode_table(signed long number_symbols, signed long table_size, unsigned char *length, unsigned short *table);
 	signed long read_literal_table(struct UnLZX *unlzx);
 	void decrunch(struct UnLZX *unlzx);
-	XMFile* open_output(const PPSystemString& filename);
+	XMFileBase* open_output(const PPSystemString& filename);
+	bool close_output(XMFileBase* out_file, struct UnLZX *unlzx, bool identify);
 	signed long extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& found);
 	signed long extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& found);
 	signed long extract_unknown(XMFile* in_file, struct UnLZX *unlzx, bool& found);
@@ -127,7 +130,7 @@ public:
 	Unlzx(const PPSystemString& archiveFilename, const FileIdentificator* identificator = NULL);
 	~Unlzx();
 	
-	bool extractFile(bool extract, const PPSystemString* outFilename);
+	bool extractFile(bool extract, XMFileBase* outFile);
 };
 
 #define PMATCH_MAXSTRLEN  512    /*  max string length  */
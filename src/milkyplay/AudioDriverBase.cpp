@@ -42,6 +42,8 @@
 #	include <pspkernel.h>
 #elif !defined(WIN32) && !defined(_WIN32_WCE)
 #	include <unistd.h>
+#	include <time.h>
+#	include <sys/time.h>
 #else
 #	include <windows.h>
 #endif
@@ -65,6 +67,26 @@ void AudioDriverBase::msleep(mp_uint32 msecs)
 #endif
 }
 
+mp_int64 AudioDriverBase::getMicroseconds()
+{
+#if defined(WIN32) && !defined(_WIN32_WCE)
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (mp_int64)((double)counter.QuadPart * 1000000.0 / (double)frequency.QuadPart);
+#elif defined(__PSP__) || defined(__AMIGA__) || defined(__AROS__) || defined(_WIN32_WCE)
+	return 0;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (mp_int64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (mp_int64)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
 bool AudioDriverBase::isMixerActive()
 {
 	if (idle)
@@ -37,8 +37,7 @@
 #ifndef __AUDIODRIVERBASE_H__
 #define __AUDIODRIVERBASE_H__
 
-#include "MilkyPlayTypes.h"
-#include "MilkyPlayResults.h"
+#include "MilkyPlayCommon.h"
 
 // WAV Header & mixing buffer info
 #define MP_NUMCHANNELS 2
@@ -104,6 +103,11 @@ public:
 	virtual		bool		isMixerActive() = 0;
 	virtual		void		setIdle(bool idle) = 0;
 
+	// Mix numPeriods periods ahead on a separate thread instead of inside
+	// the device callback, 0 mixes in the callback again. Called by
+	// MasterMixer once the device has been initialized.
+	virtual		mp_sint32	setRenderAhead(mp_uint32 numPeriods) { return numPeriods ? MP_UNSUPPORTED : MP_OK; }
+
 	virtual     mp_sint32   getStatValue(mp_uint32 key) { return 0; }
 	virtual     mp_sint32   getChannels() const { return -1; }
 	virtual     bool        isMultiChannel() const { return false; }
@@ -168,6 +172,10 @@ public:
 	virtual		mp_sint32	getPreferredSampleRate() const { return 48000; }
 
 	virtual		void		msleep(mp_uint32 msecs);
+
+	// microseconds from an arbitrary starting point, only good for
+	// differences, 0 on platforms without a suitable clock
+	static		mp_int64	getMicroseconds();
 	virtual		bool		isMixerActive();
 	virtual		void		setIdle(bool idle);
 };
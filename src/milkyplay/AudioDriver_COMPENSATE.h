@@ -38,6 +38,7 @@
 #define __AUDIODRIVER_COMPENSATE_H__
 
 #include "AudioDriverBase.h"
+#include "AudioRenderAhead.h"
 #include "MilkyPlayCommon.h"
 #include "MasterMixer.h"
 
@@ -47,19 +48,74 @@ protected:
 	bool		deviceHasStarted;
 	mp_uint32	sampleCounter;
 
+	AudioRenderAhead* renderAhead;
+
 public:
+	// keys for getStatValue
+	enum StatKeys
+	{
+		StatKeyUnderruns,
+		StatKeyOverruns,
+		StatKeyQueuedPeriods
+	};
+
 	AudioDriver_COMPENSATE() :
 		deviceHasStarted(false),
-		sampleCounter(0)
+		sampleCounter(0),
+		renderAhead(NULL)
 	{
 	}
 
 	virtual		~AudioDriver_COMPENSATE()
 	{
+		delete renderAhead;
 	}
 
 	virtual		mp_uint32	getNumPlayedSamples() const { return sampleCounter; }
 
+	virtual		mp_sint32	setRenderAhead(mp_uint32 numPeriods)
+	{
+		if (renderAhead)
+		{
+			delete renderAhead;
+			renderAhead = NULL;
+		}
+
+		if (numPeriods == 0)
+			return MP_OK;
+
+		if (!AudioRenderAhead::isSupported())
+			return MP_UNSUPPORTED;
+
+		renderAhead = new AudioRenderAhead(this, mixer, mixer->getBufferSize(), numPeriods);
+		if (!renderAhead->start())
+		{
+			delete renderAhead;
+			renderAhead = NULL;
+			return MP_DEVICE_ERROR;
+		}
+
+		return MP_OK;
+	}
+
+	virtual		mp_sint32	getStatValue(mp_uint32 key)
+	{
+		if (renderAhead == NULL)
+			return 0;
+
+		switch (key)
+		{
+			case StatKeyUnderruns:
+				return renderAhead->getNumUnderruns();
+			case StatKeyOverruns:
+				return renderAhead->getNumOverruns();
+			case StatKeyQueuedPeriods:
+				return renderAhead->getNumQueuedPeriods();
+		}
+
+		return 0;
+	}
+
 	void fillAudioWithCompensation(char* stream, int length)
 	{
 		// sanity check
@@ -72,7 +128,10 @@ public:
 		this->sampleCounter+=length>>2;
 		//mixer->updateSampleCounter(length>>2);
 
-		if (isMixerActive())
+		// the render thread has done the mixing already
+		if (renderAhead)
+			renderAhead->readPeriod((mp_sword*)stream);
+		else if (isMixerActive())
 			mixer->mixerHandler((mp_sword*)stream);
 		else
 			memset(stream, 0, length);
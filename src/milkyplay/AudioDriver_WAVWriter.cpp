@@ -36,6 +36,15 @@
  */
 
 #include "AudioDriver_WAVWriter.h"
+#include "MasterMixer.h"
+
+// might come with windows.h already
+#ifndef WAVE_FORMAT_PCM
+#define WAVE_FORMAT_PCM			0x0001
+#endif
+#ifndef WAVE_FORMAT_EXTENSIBLE
+#define WAVE_FORMAT_EXTENSIBLE	0xFFFE
+#endif
 
 struct TWAVHeader
 {
@@ -43,13 +52,18 @@ struct TWAVHeader
 	mp_dword length;			// filesize - 8
 	mp_ubyte WAVE[4];			// "WAVE"
 	mp_ubyte FMT[4];			// "fmt "
-	mp_dword fmtDataLength;		// = 16
-	mp_uword encodingTag;		
+	mp_dword fmtDataLength;		// = 16 (PCM) or 40 (extensible)
+	mp_uword encodingTag;		// 1 = PCM, 0xFFFE = WAVE_FORMAT_EXTENSIBLE
 	mp_uword numChannels;		// Channels: 1 = mono, 2 = stereo
 	mp_dword sampleRate;		// Samples per second: e.g., 44100
 	mp_dword bytesPerSecond;	// sample rate * block align
 	mp_uword blockAlign;		// channels * numBits / 8
 	mp_uword numBits;			// 8 or 16
+	// WAVE_FORMAT_EXTENSIBLE only
+	mp_uword extensionSize;		// = 22
+	mp_uword validBits;			// = numBits
+	mp_dword channelMask;		// speaker positions, 0 = none
+	mp_ubyte subFormat[16];		// KSDATAFORMAT_SUBTYPE_PCM
 	mp_ubyte DATA[4];			// "data"
 	mp_dword dataLength;		// sample data size
 };
@@ -73,17 +87,64 @@ static void writeWAVHeader(XMFile* f, const TWAVHeader& hdr)
 	f->writeWord(hdr.blockAlign);
 	f->writeWord(hdr.numBits);
 	
+	if (hdr.encodingTag == WAVE_FORMAT_EXTENSIBLE)
+	{
+		f->writeWord(hdr.extensionSize);
+		f->writeWord(hdr.validBits);
+		f->writeDword(hdr.channelMask);
+		f->write(hdr.subFormat, 1, 16);
+	}
+	
 	f->write(hdr.DATA, 1, 4);	
 	f->writeDword(hdr.dataLength);
 }
 
+static void writeWAVHeader(XMFile* f, mp_uint32 numChannels, mp_uint32 sampleRate, mp_uint32 numFrames, mp_uint32 numBits = 16,
+						   mp_uint32 channelMask = 0)
+{
+	TWAVHeader hdr;
+
+	memcpy(hdr.RIFF, "RIFF", 4);
+	memcpy(hdr.WAVE, "WAVE", 4);
+	memcpy(hdr.FMT, "fmt ", 4);
+	hdr.numChannels = numChannels;
+	hdr.sampleRate = sampleRate;
+	hdr.numBits = numBits;
+	hdr.blockAlign = (hdr.numChannels*hdr.numBits) / 8;
+	hdr.bytesPerSecond = hdr.sampleRate*hdr.blockAlign;
+
+	// more than two channels need to be extensible, plain PCM doesn't
+	// define a channel layout for them
+	if (numChannels > 2)
+	{
+		static const mp_ubyte pcmSubFormat[16] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+												  0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+
+		hdr.fmtDataLength = 40;
+		hdr.encodingTag = WAVE_FORMAT_EXTENSIBLE;
+		hdr.extensionSize = 22;
+		hdr.validBits = numBits;
+		hdr.channelMask = channelMask;
+		memcpy(hdr.subFormat, pcmSubFormat, 16);
+	}
+	else
+	{
+		hdr.fmtDataLength = 16;
+		hdr.encodingTag = WAVE_FORMAT_PCM;
+	}
+
+	memcpy(hdr.DATA, "data", 4);
+	hdr.dataLength = numFrames*hdr.blockAlign;
+	hdr.length = 4 + (8 + hdr.fmtDataLength) + (8 + hdr.dataLength);
+
+	writeWAVHeader(f, hdr);
+}
+
 WAVWriter::WAVWriter(const SYSCHAR* fileName) :
 	AudioDriver_NULL(),
 	f(NULL),
 	mixFreq(44100)
 {
-	TWAVHeader hdr;
-	
 	f = new XMFile(fileName, true);
 
 	if (!f->isOpenForWriting())
@@ -93,22 +154,7 @@ WAVWriter::WAVWriter(const SYSCHAR* fileName) :
 	}
 	else
 	{
-		// build wav header
-		memcpy(hdr.RIFF, "RIFF", 4);
-		hdr.length = 44 - 8;
-		memcpy(hdr.WAVE, "WAVE", 4);
-		memcpy(hdr.FMT, "fmt ", 4);
-		hdr.fmtDataLength = 16;
-		hdr.encodingTag = 1;
-		hdr.numChannels = 2;
-		hdr.sampleRate = mixFreq;
-		hdr.numBits = 16;
-		hdr.blockAlign = (hdr.numChannels*hdr.numBits) / 8;
-		hdr.bytesPerSecond = hdr.sampleRate*hdr.blockAlign;
-		memcpy(hdr.DATA, "data", 4);
-		hdr.dataLength = 0;	
-		
-		writeWAVHeader(f, hdr);
+		writeWAVHeader(f, 2, mixFreq, 0);
 	}
 }
 
@@ -133,26 +179,9 @@ mp_sint32 WAVWriter::closeDevice()
 	if (!f)
 		return MP_DEVICE_ERROR;
 		
-	TWAVHeader hdr;
-	
-	// build wav header
-	memcpy(hdr.RIFF, "RIFF", 4);
-	hdr.length = 44 + numSamplesWritten*4 - 8;
-	memcpy(hdr.WAVE, "WAVE", 4);
-	memcpy(hdr.FMT, "fmt ", 4);
-	hdr.fmtDataLength = 16;
-	hdr.encodingTag = 1;
-	hdr.numChannels = 2;
-	hdr.sampleRate = mixFreq;
-	hdr.numBits = 16;
-	hdr.blockAlign = (hdr.numChannels*hdr.numBits) / 8;
-	hdr.bytesPerSecond = hdr.sampleRate*hdr.blockAlign;
-	memcpy(hdr.DATA, "data", 4);
-	hdr.dataLength = (numSamplesWritten*2*hdr.numBits)/8;	
-		
 	f->seek(0);
 
-	writeWAVHeader(f, hdr);
+	writeWAVHeader(f, 2, mixFreq, numSamplesWritten);
 	
 	return MP_OK;
 }
@@ -167,3 +196,330 @@ void WAVWriter::advance()
 	f->writeWords((mp_uword*)compensateBuffer, bufferSize);
 }
 
+WAVStemWriter::WAVStemWriter(const SYSCHAR* const* fileNames, mp_uint32 numStems) :
+	AudioDriver_NULL(),
+	proxy(numStems),
+	numFiles(numStems),
+	numStems(numStems),
+	numFileChannels(2),
+	interleaved(false),
+	frameBuffer(NULL),
+	numFramesWritten(0),
+	mixFreq(44100)
+{
+	files = new XMFile*[numFiles];
+
+	for (mp_uint32 i = 0; i < numStems; i++)
+	{
+		files[i] = NULL;
+		proxy.enableStem(i, fileNames[i] != NULL);
+
+		if (fileNames[i] == NULL)
+			continue;
+
+		files[i] = new XMFile(fileNames[i], true);
+		if (files[i]->isOpenForWriting())
+			writeWAVHeader(files[i], numFileChannels, mixFreq, 0);
+	}
+}
+
+WAVStemWriter::WAVStemWriter(const SYSCHAR* fileName, mp_uint32 numStems, const mp_ubyte* mutingArray/* = NULL*/) :
+	AudioDriver_NULL(),
+	proxy(numStems),
+	numFiles(1),
+	numStems(numStems),
+	numFileChannels(0),
+	interleaved(true),
+	frameBuffer(NULL),
+	numFramesWritten(0),
+	mixFreq(44100)
+{
+	for (mp_uint32 i = 0; i < numStems; i++)
+	{
+		proxy.enableStem(i, !mutingArray || mutingArray[i] != 1);
+		if (proxy.isStemEnabled(i))
+			numFileChannels+=MP_NUMCHANNELS;
+	}
+
+	files = new XMFile*[numFiles];
+	files[0] = NULL;
+
+	// everything muted, there is nothing to write (see isOpen)
+	if (numFileChannels == 0)
+		return;
+
+	files[0] = new XMFile(fileName, true);
+
+	// the stereo pairs of the stems don't map to speaker positions
+	if (files[0]->isOpenForWriting())
+		writeWAVHeader(files[0], numFileChannels, mixFreq, 0, 16, 0);
+}
+
+WAVStemWriter::~WAVStemWriter()
+{
+	for (mp_uint32 i = 0; i < numFiles; i++)
+		delete files[i];
+	delete[] files;
+
+	delete[] frameBuffer;
+}
+
+bool WAVStemWriter::isOpen()
+{
+	if (numFileChannels == 0)
+		return false;
+
+	for (mp_uint32 i = 0; i < numFiles; i++)
+		if (files[i] && !files[i]->isOpenForWriting())
+			return false;
+
+	return true;
+}
+
+mp_sint32 WAVStemWriter::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mixFrequency, MasterMixer* mixer)
+{
+	mp_sint32 res = AudioDriver_NULL::initDevice(bufferSizeInWords, mixFrequency, mixer);
+	if (res < 0)
+		return res;
+
+	mixFreq = mixFrequency;
+
+	delete[] frameBuffer;
+	frameBuffer = new mp_sword[(bufferSizeInWords / MP_NUMCHANNELS) * (interleaved ? numFileChannels : MP_NUMCHANNELS)];
+
+	return MP_OK;
+}
+
+mp_sint32 WAVStemWriter::closeDevice()
+{
+	if (!isOpen())
+		return MP_DEVICE_ERROR;
+
+	for (mp_uint32 i = 0; i < numFiles; i++)
+	{
+		if (!files[i])
+			continue;
+
+		files[i]->seek(0);
+		writeWAVHeader(files[i], numFileChannels, mixFreq, numFramesWritten, 16, 0);
+	}
+
+	return MP_OK;
+}
+
+void WAVStemWriter::advance()
+{
+	const mp_uint32 numFrames = bufferSize / MP_NUMCHANNELS;
+
+	// the stem proxy replaces the mix-down of AudioDriver_NULL::advance()
+	numSamplesWritten+=numFrames;
+
+	if (!mixer->isPlaying() || !isOpen())
+		return;
+
+	mixer->mixerHandler(NULL, &proxy);
+
+	if (interleaved)
+	{
+		// stems which have not been mixed (yet) are silent
+		mp_uint32 channel = 0;
+		for (mp_uint32 i = 0; i < numStems; i++)
+		{
+			if (!proxy.isStemEnabled(i))
+				continue;
+
+			const mp_sword* src = proxy.getStemBuffer(i);
+			mp_sword* dst = frameBuffer + channel;
+
+			for (mp_uint32 j = 0; j < numFrames; j++, dst+=numFileChannels)
+			{
+				dst[0] = src ? *src++ : 0;
+				dst[1] = src ? *src++ : 0;
+			}
+
+			channel+=MP_NUMCHANNELS;
+		}
+
+		files[0]->writeWords((const mp_uword*)frameBuffer, numFrames*numFileChannels);
+	}
+	else
+	{
+		memset(frameBuffer, 0, bufferSize*sizeof(mp_sword));
+
+		for (mp_uint32 i = 0; i < numFiles; i++)
+		{
+			if (!files[i])
+				continue;
+
+			const mp_sword* src = proxy.getStemBuffer(i);
+			files[i]->writeWords((const mp_uword*)(src ? src : frameBuffer), bufferSize);
+		}
+	}
+
+	numFramesWritten+=numFrames;
+}
+
+WAVNormalizingWriter::WAVNormalizingWriter(const SYSCHAR* fileName, const SYSCHAR* spillFileName,
+										   mp_uint32 numBits/* = 16*/, bool normalize/* = true*/) :
+	AudioDriver_NULL(),
+	spillFileName(spillFileName),
+	f(NULL),
+	spill(NULL),
+	numBits(numBits == 24 ? 24 : 16),
+	normalize(normalize),
+	mixFreq(44100),
+	peak(0),
+	numFramesWritten(0)
+{
+	f = new XMFile(fileName, true);
+
+	if (!f->isOpenForWriting())
+	{
+		delete f;
+		f = NULL;
+		return;
+	}
+
+	writeWAVHeader(f, MP_NUMCHANNELS, mixFreq, 0, this->numBits);
+
+	spill = new XMFile(spillFileName, true);
+
+	if (!spill->isOpenForWriting())
+	{
+		delete spill;
+		spill = NULL;
+	}
+}
+
+WAVNormalizingWriter::~WAVNormalizingWriter()
+{
+	if (spill)
+	{
+		delete spill;
+		XMFile::remove(spillFileName);
+	}
+
+	delete f;
+}
+
+mp_sint32 WAVNormalizingWriter::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mixFrequency, MasterMixer* mixer)
+{
+	mp_sint32 res = AudioDriver_NULL::initDevice(bufferSizeInWords, mixFrequency, mixer);
+	if (res < 0)
+		return res;
+
+	mixFreq = mixFrequency;
+
+	// the 16 bit output of the proxy is not used, but it needs a place to go
+	proxy.setBuffer<mp_sword>(MixerProxyMixDown::MixDownBuffer, compensateBuffer);
+
+	return MP_OK;
+}
+
+void WAVNormalizingWriter::advance()
+{
+	const mp_uint32 numFrames = bufferSize / MP_NUMCHANNELS;
+
+	// the proxy replaces the mix-down of AudioDriver_NULL::advance()
+	numSamplesWritten+=numFrames;
+
+	if (!mixer->isPlaying() || !spill)
+		return;
+
+	mixer->mixerHandler(NULL, &proxy);
+
+	// unclipped 32 bit mix
+	const mp_sint32* buffer = proxy.getBuffer<mp_sint32>(MixerProxyMixDown::MixBuffer);
+	if (buffer == NULL)
+		return;
+
+	mp_sint32 peak = this->peak;
+	for (mp_sint32 i = 0; i < bufferSize; i++)
+	{
+		const mp_sint32 s = buffer[i] < 0 ? -buffer[i] : buffer[i];
+		if (s > peak)
+			peak = s;
+	}
+	this->peak = peak;
+
+	// the spill file is private to this writer, keep host byte order
+	spill->write(buffer, sizeof(mp_sint32), bufferSize);
+	numFramesWritten+=numFrames;
+}
+
+float WAVNormalizingWriter::getGain() const
+{
+	const mp_sint32 fullScale = (32767 << mixer->getSampleShift());
+
+	// like PeakAutoAdjustFilter, never amplify
+	if (!normalize || peak <= fullScale)
+		return 1.0f;
+
+	return (float)fullScale / (float)peak;
+}
+
+mp_sint32 WAVNormalizingWriter::closeDevice()
+{
+	if (!isOpen())
+		return MP_DEVICE_ERROR;
+
+	// flush the spill file and read it back
+	delete spill;
+	spill = NULL;
+
+	XMFile in(spillFileName);
+
+	if (!in.isOpen())
+	{
+		XMFile::remove(spillFileName);
+		return MP_DEVICE_ERROR;
+	}
+
+	// the gain is applied to the 32 bit mix in 16.16 fixed point, the result
+	// is scaled to the output width: s >> sampleShift for 16 bit plus the bits
+	// which would be shifted out for 24 bit
+	const mp_int64 gain = (mp_int64)(getGain() * 65536.0f) << (numBits - 16);
+	const mp_uint32 shift = 16 + mixer->getSampleShift();
+	const mp_sint32 upperBound = (1 << (numBits - 1)) - 1;
+	const mp_sint32 lowerBound = -(1 << (numBits - 1));
+	const mp_uint32 bytesPerSample = numBits / 8;
+
+	const mp_uint32 blockSize = 4096;
+	mp_sint32* block = new mp_sint32[blockSize];
+	mp_ubyte* outBlock = new mp_ubyte[blockSize * bytesPerSample];
+
+	mp_uint32 remaining = numFramesWritten * MP_NUMCHANNELS;
+	while (remaining)
+	{
+		const mp_uint32 count = remaining < blockSize ? remaining : blockSize;
+		in.read(block, sizeof(mp_sint32), count);
+
+		mp_ubyte* dst = outBlock;
+		for (mp_uint32 i = 0; i < count; i++)
+		{
+			mp_sint32 v = (mp_sint32)(((mp_int64)block[i] * gain) >> shift);
+
+			if (v > upperBound) v = upperBound;
+			else if (v < lowerBound) v = lowerBound;
+
+			// little endian
+			*dst++ = (mp_ubyte)v;
+			*dst++ = (mp_ubyte)(v >> 8);
+			if (bytesPerSample == 3)
+				*dst++ = (mp_ubyte)(v >> 16);
+		}
+
+		f->write(outBlock, 1, count * bytesPerSample);
+		remaining-=count;
+	}
+
+	delete[] outBlock;
+	delete[] block;
+
+	f->seek(0);
+	writeWAVHeader(f, MP_NUMCHANNELS, mixFreq, numFramesWritten, numBits);
+
+	XMFile::remove(spillFileName);
+
+	return MP_OK;
+}
@@ -39,6 +39,7 @@
 #define __AUDIODRIVER_WAVWRITER_H__
 
 #include "AudioDriver_NULL.h"
+#include "MixerProxy.h"
 #include "XMFile.h"
 
 class WAVWriter : public AudioDriver_NULL
@@ -62,4 +63,82 @@ public:
 	bool					isOpen() { return f != NULL; }
 };
 
+//
+// Renders every mixer channel into a stereo stem of its own in a single
+// pass: either one 16 bit stereo WAV per stem or one WAV which interleaves
+// all stems (2 channels per stem)
+//
+class WAVStemWriter : public AudioDriver_NULL
+{
+private:
+	MixerProxyStems	proxy;
+	XMFile**	files;
+	mp_uint32	numFiles;
+	mp_uint32	numStems;
+	mp_uint32	numFileChannels;
+	bool		interleaved;
+	mp_sword*	frameBuffer;
+	mp_uint32	numFramesWritten;
+	mp_sint32	mixFreq;
+
+public:
+	// one file per stem, stems without a file name are not mixed
+				WAVStemWriter(const SYSCHAR* const* fileNames, mp_uint32 numStems);
+	// all stems which are not muted in a single file
+				WAVStemWriter(const SYSCHAR* fileName, mp_uint32 numStems, const mp_ubyte* mutingArray = NULL);
+
+	virtual		~WAVStemWriter();
+
+	virtual     mp_sint32   initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mixFrequency, MasterMixer* mixer);
+	virtual     mp_sint32   closeDevice();
+
+	virtual		const char* getDriverID() { return "WAVStemWriter"; }
+
+	virtual		void		advance();
+
+	bool					isOpen();
+};
+
+//
+// Mixes the song once into a 32 bit spill file while keeping track of the
+// peak, then converts the spill file into the final 16 or 24 bit stereo WAV
+// when the device is closed. With normalize the whole output is scaled down
+// so the peak doesn't clip (never amplified, see PeakAutoAdjustFilter),
+// replacing a separate peak estimation pass.
+//
+class WAVNormalizingWriter : public AudioDriver_NULL
+{
+private:
+	const SYSCHAR*		spillFileName;
+	XMFile*				f;
+	XMFile*				spill;
+	MixerProxyMixDown	proxy;
+	mp_uint32			numBits;
+	bool				normalize;
+	mp_sint32			mixFreq;
+	mp_sint32			peak;
+	mp_uint32			numFramesWritten;
+
+public:
+	// spillFileName must stay valid for the lifetime of the writer,
+	// the spill file is removed again when the device is closed
+				WAVNormalizingWriter(const SYSCHAR* fileName, const SYSCHAR* spillFileName,
+									 mp_uint32 numBits = 16, bool normalize = true);
+
+	virtual		~WAVNormalizingWriter();
+
+	virtual     mp_sint32   initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mixFrequency, MasterMixer* mixer);
+	virtual     mp_sint32   closeDevice();
+
+	virtual		const char* getDriverID() { return "WAVNormalizingWriter"; }
+
+	virtual		void		advance();
+
+	bool					isOpen() { return spill != NULL; }
+
+	// peak of the unclipped mix and the resulting gain
+	mp_sint32				getPeak() const { return peak; }
+	float					getGain() const;
+};
+
 #endif
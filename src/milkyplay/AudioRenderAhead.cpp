@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  AudioRenderAhead.cpp
+ *  MilkyPlay
+ *
+ */
+#include "AudioRenderAhead.h"
+#include "AudioDriverBase.h"
+#include "MasterMixer.h"
+#include "MilkyPlayAtomic.h"
+#include "MilkyPlayCommon.h"
+
+#if defined(WIN32) && !defined(_WIN32_WCE)
+	#define RENDERAHEAD_WIN32
+#elif !defined(__AMIGA__) && !defined(__AROS__) && !defined(__PSP__) && !defined(_WIN32_WCE)
+	#define RENDERAHEAD_PTHREAD
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+#if defined(RENDERAHEAD_WIN32)
+
+struct AudioRenderAhead::TPlatformData
+{
+	HANDLE			thread;
+};
+
+#elif defined(RENDERAHEAD_PTHREAD)
+
+struct AudioRenderAhead::TPlatformData
+{
+	pthread_t		thread;
+};
+
+#else
+
+struct AudioRenderAhead::TPlatformData
+{
+};
+
+#endif
+
+bool AudioRenderAhead::isSupported()
+{
+#if defined(RENDERAHEAD_WIN32) || defined(RENDERAHEAD_PTHREAD)
+	return true;
+#else
+	return false;
+#endif
+}
+
+AudioRenderAhead::AudioRenderAhead(AudioDriverInterface* audioDriver, MasterMixer* mixer,
+								   mp_uint32 periodSize, mp_uint32 numPeriods) :
+	platformData(NULL),
+	audioDriver(audioDriver),
+	mixer(mixer),
+	periodSize(periodSize),
+	numPeriods(numPeriods),
+	ring(NULL),
+	writeIndex(0),
+	readIndex(0),
+	shutdown(0),
+	numUnderruns(0),
+	numOverruns(0)
+{
+	if (this->numPeriods < 1)
+		this->numPeriods = 1;
+	else if (this->numPeriods > MAXPERIODS)
+		this->numPeriods = MAXPERIODS;
+
+	ring = new mp_sword[this->numPeriods*periodSize*MP_NUMCHANNELS];
+	memset(ring, 0, this->numPeriods*periodSize*MP_NUMCHANNELS*sizeof(mp_sword));
+}
+
+AudioRenderAhead::~AudioRenderAhead()
+{
+	stop();
+
+	delete[] ring;
+}
+
+bool AudioRenderAhead::start()
+{
+	if (platformData)
+		return true;
+
+#if defined(RENDERAHEAD_WIN32) || defined(RENDERAHEAD_PTHREAD)
+	platformData = new TPlatformData;
+
+	atomicStoreRelease(&shutdown, 0);
+
+#if defined(RENDERAHEAD_WIN32)
+	platformData->thread = CreateThread(NULL, 0, threadProc, this, 0, NULL);
+	if (platformData->thread == NULL)
+	{
+		delete platformData;
+		platformData = NULL;
+		return false;
+	}
+	SetThreadPriority(platformData->thread, THREAD_PRIORITY_HIGHEST);
+#else
+	if (pthread_create(&platformData->thread, NULL, threadProc, this) != 0)
+	{
+		delete platformData;
+		platformData = NULL;
+		return false;
+	}
+
+	// same as THREAD_PRIORITY_HIGHEST on Win32: above normal threads but
+	// below the audio driver's own thread. Needs privileges on most systems,
+	// without them the thread just keeps the default priority
+	const int minPriority = sched_get_priority_min(SCHED_FIFO);
+	const int maxPriority = sched_get_priority_max(SCHED_FIFO);
+	if (minPriority >= 0 && maxPriority >= minPriority)
+	{
+		struct sched_param param;
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = minPriority + (maxPriority - minPriority) / 4;
+		pthread_setschedparam(platformData->thread, SCHED_FIFO, &param);
+	}
+#endif
+	return true;
+#else
+	return false;
+#endif
+}
+
+void AudioRenderAhead::stop()
+{
+	if (platformData == NULL)
+		return;
+
+	atomicStoreRelease(&shutdown, 1);
+
+#if defined(RENDERAHEAD_WIN32)
+	WaitForSingleObject(platformData->thread, INFINITE);
+	CloseHandle(platformData->thread);
+#elif defined(RENDERAHEAD_PTHREAD)
+	pthread_join(platformData->thread, NULL);
+#endif
+
+	delete platformData;
+	platformData = NULL;
+}
+
+#if defined(RENDERAHEAD_WIN32)
+unsigned long __stdcall AudioRenderAhead::threadProc(void* arg)
+{
+	reinterpret_cast<AudioRenderAhead*>(arg)->renderLoop();
+	return 0;
+}
+#else
+void* AudioRenderAhead::threadProc(void* arg)
+{
+	reinterpret_cast<AudioRenderAhead*>(arg)->renderLoop();
+	return NULL;
+}
+#endif
+
+void AudioRenderAhead::renderLoop()
+{
+	const mp_uint32 periodWords = periodSize*MP_NUMCHANNELS;
+	const mp_uint32 mixFrequency = audioDriver->getMixFrequency();
+	const mp_int64 periodMicros = (mp_int64)periodSize * 1000000 / (mixFrequency ? mixFrequency : 1);
+
+	// poll twice per period while the ring buffer is full
+	mp_uint32 sleepMillis = (mp_uint32)(periodMicros / 2000);
+	if (sleepMillis < 1)
+		sleepMillis = 1;
+
+	mp_uint32 write = writeIndex;
+
+	while (!atomicLoadAcquire(&shutdown))
+	{
+		if (write - atomicLoadAcquire(&readIndex) >= numPeriods)
+		{
+			audioDriver->msleep(sleepMillis);
+			continue;
+		}
+
+		mp_sword* buffer = ring + (write % numPeriods)*periodWords;
+
+		const mp_int64 startTime = AudioDriverBase::getMicroseconds();
+
+		if (audioDriver->isMixerActive())
+			mixer->mixerHandler(buffer);
+		else
+			memset(buffer, 0, periodWords*sizeof(mp_sword));
+
+		if (AudioDriverBase::getMicroseconds() - startTime > periodMicros)
+			atomicStoreRelease(&numOverruns, numOverruns + 1);
+
+		atomicStoreRelease(&writeIndex, ++write);
+	}
+}
+
+bool AudioRenderAhead::readPeriod(mp_sword* buffer)
+{
+	const mp_uint32 periodWords = periodSize*MP_NUMCHANNELS;
+	const mp_uint32 read = readIndex;
+
+	if (atomicLoadAcquire(&writeIndex) == read)
+	{
+		memset(buffer, 0, periodWords*sizeof(mp_sword));
+		atomicStoreRelease(&numUnderruns, numUnderruns + 1);
+		return false;
+	}
+
+	memcpy(buffer, ring + (read % numPeriods)*periodWords, periodWords*sizeof(mp_sword));
+	atomicStoreRelease(&readIndex, read + 1);
+	return true;
+}
+
+mp_uint32 AudioRenderAhead::getNumQueuedPeriods() const
+{
+	return atomicLoadAcquire(&writeIndex) - atomicLoadAcquire(&readIndex);
+}
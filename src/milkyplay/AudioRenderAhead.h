@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  AudioRenderAhead.h
+ *  MilkyPlay
+ *
+ *  Runs MasterMixer::mixerHandler on a separate thread a few periods ahead
+ *  of the audio device. The rendered periods are passed to the device
+ *  callback through a single producer/single consumer ring buffer, so the
+ *  callback only copies memory and a slow mixer tick no longer lands on the
+ *  real-time thread. The price is numPeriods periods of additional latency.
+ *  Not available on platforms without thread support (Amiga, PSP).
+ */
+#ifndef __AUDIORENDERAHEAD_H__
+#define __AUDIORENDERAHEAD_H__
+
+#include "MilkyPlayTypes.h"
+
+class AudioDriverInterface;
+class MasterMixer;
+
+class AudioRenderAhead
+{
+public:
+	enum
+	{
+		MAXPERIODS = 16
+	};
+
+private:
+	struct TPlatformData;
+
+	TPlatformData*			platformData;
+	AudioDriverInterface*	audioDriver;
+	MasterMixer*			mixer;
+
+	mp_uint32				periodSize;
+	mp_uint32				numPeriods;
+	mp_sword*				ring;
+
+	// free running period counters, only written by one side each:
+	// writeIndex by the render thread, readIndex by the device callback
+	volatile mp_uint32		writeIndex;
+	volatile mp_uint32		readIndex;
+	volatile mp_uint32		shutdown;
+
+	volatile mp_uint32		numUnderruns;
+	volatile mp_uint32		numOverruns;
+
+	void					renderLoop();
+
+#if defined(WIN32) && !defined(_WIN32_WCE)
+	static unsigned long __stdcall threadProc(void* arg);
+#else
+	static void*			threadProc(void* arg);
+#endif
+
+public:
+	// periodSize is the mixer buffer size in stereo frames
+							AudioRenderAhead(AudioDriverInterface* audioDriver, MasterMixer* mixer,
+											 mp_uint32 periodSize, mp_uint32 numPeriods);
+							~AudioRenderAhead();
+
+	// start/stop the render thread, start returns false if it couldn't be created
+	bool					start();
+	void					stop();
+
+	// Called from the device callback: copies the next rendered period
+	// (periodSize 16 bit stereo frames) to buffer. If the render thread
+	// fell behind the buffer is silenced, an underrun is counted and
+	// false is returned.
+	bool					readPeriod(mp_sword* buffer);
+
+	// number of periods the device found the ring buffer empty
+	mp_uint32				getNumUnderruns() const { return numUnderruns; }
+	// number of periods which took longer to render than to play back
+	mp_uint32				getNumOverruns() const { return numOverruns; }
+	// number of periods currently rendered ahead
+	mp_uint32				getNumQueuedPeriods() const;
+	mp_uint32				getNumPeriods() const { return numPeriods; }
+
+	static bool				isSupported();
+};
+
+#endif
@@ -43,6 +43,8 @@
 #include "ResamplerMacros.h"
 #include "AudioDriverManager.h"
 #include "ProxyProcessor.h"
+#include "WorkerPool.h"
+#include "MilkyPlayAtomic.h"
 #include <math.h>
 
 // Ramp out will last (THEBEATLENGTH*RAMPDOWNFRACTION)>>8 samples
@@ -101,6 +103,7 @@ void ChannelMixer::ResamplerBase::directOutChannel(ChannelMixer* mixer, mp_uint3
 			chn->smplen = newChannel[c].smplen;
 			chn->loopstart = newChannel[c].loopstart;
 			chn->loopend = newChannel[c].loopend;
+			chn->unrolledloop = newChannel[c].unrolledloop;
 			chn->smppos = newChannel[c].smppos;
 			chn->smpposfrac = newChannel[c].smpposfrac;
 			chn->flags = newChannel[c].flags;
@@ -121,12 +124,12 @@ void ChannelMixer::ResamplerBase::directOutChannel(ChannelMixer* mixer, mp_uint3
 		directOutBlockFull((buffer), chn, (beatlength));
 }
 
-void ChannelMixer::ResamplerBase::addChannelsNormal(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
+void ChannelMixer::ResamplerBase::addChannelsNormal(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength, mp_uint32 firstChannel, mp_uint32 channelStep)
 {
 	ChannelMixer::TMixerChannel* channel = mixer->channel;
 	ChannelMixer::TMixerChannel* newChannel = mixer->newChannel;
 
-	for (mp_uint32 c=0;c<numChannels;c++)
+	for (mp_uint32 c=firstChannel;c<numChannels;c+=channelStep)
 	{
 		ChannelMixer::TMixerChannel* chn = &channel[c];
 		chn->index = c;		// For Amiga resampler
@@ -148,6 +151,7 @@ void ChannelMixer::ResamplerBase::addChannelsNormal(ChannelMixer* mixer, mp_uint
 				chn->smplen = newChannel[c].smplen;
 				chn->loopstart = newChannel[c].loopstart;
 				chn->loopend = newChannel[c].loopend;
+				chn->unrolledloop = newChannel[c].unrolledloop;
 				chn->smppos = newChannel[c].smppos;
 				chn->smpposfrac = newChannel[c].smpposfrac;
 				chn->flags = newChannel[c].flags;
@@ -169,12 +173,32 @@ void ChannelMixer::ResamplerBase::addChannelsNormal(ChannelMixer* mixer, mp_uint
 	}
 }
 
-void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
+// filter smoothing: step the coefficients towards their targets within length samples
+static inline void rampFilter(ChannelMixer::TMixerChannel* chn, mp_sint32 length)
+{
+	if (length <= 0)
+		return;
+
+	chn->rampFilterStepA = (chn->targetA-chn->a)/length;
+	chn->rampFilterStepB = (chn->targetB-chn->b)/length;
+	chn->rampFilterStepC = (chn->targetC-chn->c)/length;
+}
+
+// set the coefficients to their targets, also gets rid of the rounding errors of the steps
+static inline void snapFilter(ChannelMixer::TMixerChannel* chn)
+{
+	chn->a = chn->targetA;
+	chn->b = chn->targetB;
+	chn->c = chn->targetC;
+	chn->rampFilterStepA = chn->rampFilterStepB = chn->rampFilterStepC = 0;
+}
+
+void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength, mp_uint32 firstChannel, mp_uint32 channelStep)
 {
 	ChannelMixer::TMixerChannel* channel = mixer->channel;
 	ChannelMixer::TMixerChannel* newChannel = mixer->newChannel;
 
-	for (mp_uint32 c=0;c<numChannels;c++)
+	for (mp_uint32 c=firstChannel;c<numChannels;c+=channelStep)
 	{
 		ChannelMixer::TMixerChannel* chn = &channel[c];
 		chn->index = c;		// For Amiga resampler
@@ -195,8 +219,12 @@ void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uin
 				chn->rampFromVolStepL = (-chn->finalvoll)/beatl;
 				chn->rampFromVolStepR = (-chn->finalvolr)/beatl;
 
+				rampFilter(chn, beatl);
+
 				if (beatl)
 					addChannel(chn, buffer32, beatl, beatlength);
+
+				snapFilter(chn);
 				chn->flags&=~(MP_SAMPLE_PLAY | MP_SAMPLE_FADEOFF);
 				continue;
 			}
@@ -219,6 +247,9 @@ void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uin
 				chn->rampFromVolStepL = (volL-chn->finalvoll)/beatl;
 				chn->rampFromVolStepR = (volR-chn->finalvolr)/beatl;
 
+				// new note, starts with its own filter
+				snapFilter(chn);
+
 				// mix here
 				if (beatl)
 					addChannel(chn, buffer32, beatl, beatlength);
@@ -283,6 +314,7 @@ void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uin
 				chn->smplen = newChannel[c].smplen;
 				chn->loopstart = newChannel[c].loopstart;
 				chn->loopend = newChannel[c].loopend;
+				chn->unrolledloop = newChannel[c].unrolledloop;
 				chn->smppos = newChannel[c].smppos;
 				chn->smpposfrac = newChannel[c].smpposfrac;
 				chn->flags = newChannel[c].flags;
@@ -303,6 +335,9 @@ void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uin
 
 				chn->finalvoll = chn->finalvolr = 0;
 
+				// new note, starts with its own filter
+				snapFilter(chn);
+
 				if (beatl)
 					addChannel(chn, buffer32, beatl, beatlength);
 
@@ -326,9 +361,14 @@ void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uin
 				chn->rampFromVolStepL = (volL-chn->finalvoll)/beatlength;
 				chn->rampFromVolStepR = (volR-chn->finalvolr)/beatlength;
 
+				// filter smoothing: coefficients reach their targets within this beat packet
+				rampFilter(chn, beatlength);
+
 				// mix here
 				addChannel(chn, buffer32, beatlength, beatlength);
 
+				snapFilter(chn);
+
 				//chn->finalvoll = volL;
 				//chn->finalvolr = volR;
 				break;
@@ -338,18 +378,66 @@ void ChannelMixer::ResamplerBase::addChannelsRamping(ChannelMixer* mixer, mp_uin
 	}
 }
 
-void ChannelMixer::ResamplerBase::addChannels(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
+void ChannelMixer::ResamplerBase::addChannels(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength, mp_uint32 firstChannel/* = 0*/, mp_uint32 channelStep/* = 1*/)
 {
 	if (beatNum >= (signed)mixer->getNumBeatPackets())
 		beatNum = mixer->getNumBeatPackets();
 
 	if (isRamping())
-		addChannelsRamping(mixer, numChannels, buffer32, beatNum, beatlength);
+		addChannelsRamping(mixer, numChannels, buffer32, beatNum, beatlength, firstChannel, channelStep);
 	else
-		addChannelsNormal(mixer, numChannels, buffer32, beatNum, beatlength);
+		addChannelsNormal(mixer, numChannels, buffer32, beatNum, beatlength, firstChannel, channelStep);
 }
 
 void ChannelMixer::ResamplerBase::addChannel(TMixerChannel* chn, mp_sint32* buffer32, const mp_sint32 beatlength, const mp_sint32 beatSize)
+{
+	// a short loop unrolled in the sample padding is mixed as one long
+	// forward loop, so the no check path doesn't stop at every loop end
+	if (chn->unrolledloop && supportsNoChecking() &&
+		(chn->flags & (MP_SAMPLE_PLAY|MP_SAMPLE_ONESHOT)) == MP_SAMPLE_PLAY &&
+		chn->smppos >= chn->loopstart && chn->smppos < chn->loopend)
+	{
+		// the copy is rebuilt whenever the sample is edited,
+		// make sure it still belongs to the loop we're playing
+		TUnrolledLoopHeader header;
+		memcpy(&header, (const mp_ubyte*)chn->sample + ((chn->flags & 4) ? chn->smplen*2 : chn->smplen) + MP_UNROLLEDLOOP_HEADEROFFSET, sizeof(header));
+
+		if (header.length &&
+			header.loopstart == chn->loopstart &&
+			header.looplen == chn->loopend - chn->loopstart &&
+			header.looptype == 1 && (chn->flags & 3) == 1 &&
+			!(chn->flags & MP_SAMPLE_BACKWARD) &&
+			(header.seamless || !readsBehindPosition()))
+		{
+			addChannelUnrolled(chn, buffer32, beatlength, beatSize, header);
+			return;
+		}
+	}
+
+	addChannelBlocks(chn, buffer32, beatlength, beatSize);
+}
+
+void ChannelMixer::ResamplerBase::addChannelUnrolled(TMixerChannel* chn, mp_sint32* buffer32, const mp_sint32 beatlength, const mp_sint32 beatSize, const TUnrolledLoopHeader& header)
+{
+	const mp_sint32 flags = chn->flags;
+	const mp_sint32 loopstart = chn->loopstart;
+	const mp_sint32 loopend = chn->loopend;
+	const mp_sint32 looplen = loopend - loopstart;
+	const mp_sint32 start = getUnrolledLoopStart(chn->smplen, (flags & 4) != 0);
+
+	chn->smppos+=start - loopstart;
+	chn->loopstart = start;
+	chn->loopend = start + header.length;
+
+	addChannelBlocks(chn, buffer32, beatlength, beatSize);
+
+	// position within the original loop for everyone else
+	chn->loopstart = loopstart;
+	chn->loopend = loopend;
+	chn->smppos = ((chn->smppos - start) % looplen) + loopstart;
+}
+
+void ChannelMixer::ResamplerBase::addChannelBlocks(TMixerChannel* chn, mp_sint32* buffer32, const mp_sint32 beatlength, const mp_sint32 beatSize)
 {
 	if ((chn->flags&MP_SAMPLE_PLAY))
 	{
@@ -545,6 +633,9 @@ void ChannelMixer::setFrequency(mp_sint32 frequency)
 
 	mixbuffBeatPacket = new mp_sint32[beatPacketSize*MP_NUMCHANNELS];
 
+	reallocWorkerBeatPackets();
+	freeStemBeatPackets();
+
 	for(int i = 0; i < MAX_DIRECTOUT_CHANNELS; i++) {
 		if (mixbuffBeatPackets[i])
 			delete[] mixbuffBeatPackets[i];
@@ -607,6 +698,15 @@ ChannelMixer::ChannelMixer(mp_uint32 numChannels,
 	paused(false),
 	disableMixing(false),
 	allowFilters(false),
+	filterSmoothing(false),
+	scopeTapEnabled(false),
+	loopUnrolling(false),
+	filterTableFrequency(0),
+	numMixerThreads(MIXERTHREADS_DEFAULT),
+	workerPool(NULL),
+	workerBeatPackets(NULL),
+	stemBeatPackets(NULL),
+	numStemBeatPackets(0),
 	initialized(false),
 	sampleCounter(0)
 {
@@ -646,6 +746,10 @@ ChannelMixer::~ChannelMixer()
 		closeDevice();
 	}
 
+	delete workerPool;
+	freeWorkerBeatPackets();
+	freeStemBeatPackets();
+
 	if (mixbuffBeatPacket)
 		delete[] mixbuffBeatPacket;
 
@@ -666,6 +770,118 @@ ChannelMixer::~ChannelMixer()
 		delete resamplerTable[i];
 }
 
+void ChannelMixer::freeWorkerBeatPackets()
+{
+	if (workerBeatPackets == NULL)
+		return;
+
+	for (mp_uint32 i = 0; i < WorkerPool::MAXWORKERS; i++)
+		delete[] workerBeatPackets[i];
+
+	delete[] workerBeatPackets;
+	workerBeatPackets = NULL;
+}
+
+void ChannelMixer::reallocWorkerBeatPackets()
+{
+	freeWorkerBeatPackets();
+
+	if (workerPool == NULL)
+		return;
+
+	workerBeatPackets = new mp_sint32*[WorkerPool::MAXWORKERS];
+	memset(workerBeatPackets, 0, WorkerPool::MAXWORKERS * sizeof(mp_sint32*));
+
+	for (mp_uint32 i = 0; i < workerPool->getNumWorkers(); i++)
+		workerBeatPackets[i] = new mp_sint32[beatPacketSize*MP_NUMCHANNELS];
+}
+
+void ChannelMixer::setNumMixerThreads(mp_uint32 num)
+{
+	if (num > MIXERTHREADS_MAX)
+		num = MIXERTHREADS_MAX;
+
+	if (num == numMixerThreads)
+		return;
+
+	numMixerThreads = num;
+
+	delete workerPool;
+	workerPool = NULL;
+
+	if (num > 1 && WorkerPool::isSupported())
+	{
+		workerPool = new WorkerPool(num - 1);
+		if (workerPool->getNumWorkers() == 0)
+		{
+			delete workerPool;
+			workerPool = NULL;
+		}
+	}
+
+	reallocWorkerBeatPackets();
+}
+
+void ChannelMixer::parallelMixTask(void* userData, mp_uint32 taskIndex, mp_uint32 threadIndex)
+{
+	TParallelMixJob* job = reinterpret_cast<TParallelMixJob*>(userData);
+	ChannelMixer* mixer = job->mixer;
+
+	// the calling thread mixes straight into the destination buffer
+	mp_sint32* buffer32 = job->buffer32;
+	if (threadIndex)
+	{
+		buffer32 = mixer->workerBeatPackets[threadIndex-1];
+		if (!job->workerUsed[threadIndex-1])
+		{
+			memset(buffer32, 0, job->beatPacketSize*MP_NUMCHANNELS*sizeof(mp_sint32));
+			job->workerUsed[threadIndex-1] = true;
+		}
+	}
+
+	// one task per channel
+	mixer->resamplerTable[mixer->resamplerType]->addChannels(mixer,
+															 taskIndex + 1,
+															 buffer32,
+															 job->beatPacketIndex,
+															 job->beatPacketSize,
+															 taskIndex,
+															 1);
+}
+
+void ChannelMixer::mixBeatPacketParallel(mp_uint32 numChannels,
+										 mp_sint32* buffer32,
+										 mp_sint32 beatPacketIndex,
+										 mp_sint32 beatPacketSize)
+{
+	// channels are independent of each other (the resamplers keep per channel
+	// state only) and integer summing is order independent, so the result is
+	// identical to mixing all channels serially. Claiming them one by one
+	// leaves the calling thread every channel a preempted worker hasn't
+	// started yet
+	parallelMixJob.mixer = this;
+	parallelMixJob.numChannels = numChannels;
+	parallelMixJob.buffer32 = buffer32;
+	parallelMixJob.beatPacketIndex = beatPacketIndex;
+	parallelMixJob.beatPacketSize = beatPacketSize;
+	memset(parallelMixJob.workerUsed, 0, sizeof(parallelMixJob.workerUsed));
+
+	// this is called from the audio callback, so no locks here
+	workerPool->runRealtime(parallelMixTask, &parallelMixJob, numChannels);
+
+	// reduce partial beat packets
+	for (mp_uint32 t = 0; t < workerPool->getNumWorkers(); t++)
+	{
+		if (!parallelMixJob.workerUsed[t])
+			continue;
+
+		const mp_sint32* src = workerBeatPackets[t];
+		mp_sint32* dst = buffer32;
+		for (mp_sint32 i = 0; i < beatPacketSize*MP_NUMCHANNELS; i++, src++, dst++)
+			*dst += *src;
+	}
+}
+
 void ChannelMixer::startMixer()
 {
 	lastBeatRemainder = 0;
@@ -754,6 +970,27 @@ void ChannelMixer::setChannelFrequency(mp_sint32 c, mp_sint32 f, mp_sint32 per)
 		channel[c].rsmpadd = 0;
 }
 
+void ChannelMixer::buildFilterTables()
+{
+	const float LOG10 = 2.30258509299f;
+	const mp_sint32 IT_ENVELOPE_SHIFT = 8;
+
+	mp_sint32 i;
+
+	// cutoff is split into (cutoff>>8) and (cutoff&255), the angle is
+	// exponential in cutoff so it's the product of both parts
+	for (i = 0; i < FILTERCUTOFFSTEPS; i++)
+		filterCoarseAngle[i] = mixFrequency * pow(0.5, 0.25 + (i << IT_ENVELOPE_SHIFT)*(1.0/(24<<IT_ENVELOPE_SHIFT))) * (1.0/(2*3.14159265358979323846*110.0));
+
+	for (i = 0; i < (1 << IT_ENVELOPE_SHIFT); i++)
+		filterFineAngle[i] = pow(0.5, i*(1.0/(24<<IT_ENVELOPE_SHIFT)));
+
+	for (i = 0; i < FILTERRESONANCESTEPS; i++)
+		filterLoss[i] = (float)exp(i*(-LOG10*1.2/128.0));
+
+	filterTableFrequency = mixFrequency;
+}
+
 void ChannelMixer::setFilterAttributes(mp_sint32 chn, mp_sint32 cutoff, mp_sint32 resonance)
 {
 	if (!allowFilters ||
@@ -761,12 +998,20 @@ void ChannelMixer::setFilterAttributes(mp_sint32 chn, mp_sint32 cutoff, mp_sint3
 		 channel[chn].resonance == resonance))
 		return;
 
+	// only ramp from coefficients which have actually been in use
+	const bool ramp = filterSmoothing &&
+		channel[chn].cutoff != MP_INVALID_VALUE &&
+		channel[chn].resonance != MP_INVALID_VALUE;
+
 	channel[chn].cutoff = cutoff;
 	channel[chn].resonance = resonance;
 
 	if (cutoff == MP_INVALID_VALUE || resonance == MP_INVALID_VALUE)
 		return;
 
+	if (filterTableFrequency != mixFrequency)
+		buildFilterTables();
+
 	// Thanks to DUMB for the filter coefficient computations
 	const float LOG10 = 2.30258509299f;
 	const mp_sint32 IT_ENVELOPE_SHIFT = 8;
@@ -775,8 +1020,13 @@ void ChannelMixer::setFilterAttributes(mp_sint32 chn, mp_sint32 cutoff, mp_sint3
 	{
 		float sampfreq = this->mixFrequency;
 
-		float inv_angle = (float)(sampfreq * pow(0.5, 0.25 + cutoff*(1.0/(24<<IT_ENVELOPE_SHIFT))) * (1.0/(2*3.14159265358979323846*110.0)));
-		float loss = (float)exp(resonance*(-LOG10*1.2/128.0));
+		// table lookups for everything the player can produce
+		float inv_angle = (cutoff >= 0 && (cutoff >> IT_ENVELOPE_SHIFT) < FILTERCUTOFFSTEPS) ?
+			(float)(filterCoarseAngle[cutoff >> IT_ENVELOPE_SHIFT] * filterFineAngle[cutoff & ((1 << IT_ENVELOPE_SHIFT) - 1)]) :
+			(float)(sampfreq * pow(0.5, 0.25 + cutoff*(1.0/(24<<IT_ENVELOPE_SHIFT))) * (1.0/(2*3.14159265358979323846*110.0)));
+		float loss = (resonance >= 0 && resonance < FILTERRESONANCESTEPS) ?
+			filterLoss[resonance] :
+			(float)exp(resonance*(-LOG10*1.2/128.0));
 		float d, e;
 #if 0
 		loss *= 2; // This is the mistake most players seem to make!
@@ -797,9 +1047,17 @@ void ChannelMixer::setFilterAttributes(mp_sint32 chn, mp_sint32 cutoff, mp_sint3
 #endif
 	}
 
-	channel[chn].a = (mp_sint32)(a * (1 << (MP_FILTERPRECISION+16)));
-	channel[chn].b = (mp_sint32)(b * (1 << (MP_FILTERPRECISION+16)));
-	channel[chn].c = (mp_sint32)(c * (1 << (MP_FILTERPRECISION+16)));
+	channel[chn].targetA = (mp_sint32)(a * (1 << (MP_FILTERPRECISION+16)));
+	channel[chn].targetB = (mp_sint32)(b * (1 << (MP_FILTERPRECISION+16)));
+	channel[chn].targetC = (mp_sint32)(c * (1 << (MP_FILTERPRECISION+16)));
+
+	// otherwise the resampler ramps a,b,c towards the targets over the next beat packet
+	if (!ramp)
+	{
+		channel[chn].a = channel[chn].targetA;
+		channel[chn].b = channel[chn].targetB;
+		channel[chn].c = channel[chn].targetC;
+	}
 }
 
 void ChannelMixer::playSample(mp_sint32 c, // channel
@@ -869,6 +1127,15 @@ void ChannelMixer::playSample(mp_sint32 c, // channel
 		}
 	}
 
+	// short loops might be mixed from their unrolled copy, see addChannel
+	bool unrolledloop = false;
+	if (loopUnrolling && (flags & 3) == 1 && !(flags & 32))
+	{
+		TUnrolledLoopHeader header;
+		memcpy(&header, (const mp_ubyte*)smp + ((flags & 4) ? smplen*2 : smplen) + MP_UNROLLEDLOOP_HEADEROFFSET, sizeof(header));
+		unrolledloop = header.length && header.loopstart == lstart && header.looplen == len - lstart;
+	}
+
 	// play sample but don't ramp volume
 	if (!ramp)
 	{
@@ -876,6 +1143,7 @@ void ChannelMixer::playSample(mp_sint32 c, // channel
 		channel[c].smplen = smplen;
 		channel[c].loopstart=lstart;
 		channel[c].loopend=len;
+		channel[c].unrolledloop = unrolledloop;
 
 		if (flags & MP_SAMPLE_BACKWARD)
 			channel[c].smppos = smplen - smpoffs;
@@ -898,6 +1166,7 @@ void ChannelMixer::playSample(mp_sint32 c, // channel
 		channel[c].smplen = smplen;
 		channel[c].loopstart=lstart;
 		channel[c].loopend=len;
+		channel[c].unrolledloop = unrolledloop;
 
 		if (flags & MP_SAMPLE_BACKWARD)
 			channel[c].smppos = smplen - smpoffs;
@@ -942,6 +1211,7 @@ void ChannelMixer::playSample(mp_sint32 c, // channel
 		newChannel[c].smplen = smplen;
 		newChannel[c].loopstart = lstart;
 		newChannel[c].loopend = len;
+		newChannel[c].unrolledloop = unrolledloop;
 
 		if (flags & MP_SAMPLE_BACKWARD)
 			newChannel[c].smppos = smplen - smpoffs;
@@ -982,8 +1252,92 @@ void ChannelMixer::playSample(mp_sint32 c, // channel
 
 }
 
-static inline void storeTimeRecordData(mp_sint32 nb, ChannelMixer::TMixerChannel* chn)
+#define SCOPETAP_8BIT \
+	sd1 = ((mp_sbyte)sample[smppos])<<8; \
+	sd2 = ((mp_sbyte)sample[smppos+1])<<8; \
+	sd1 = ((sd1<<12)+(smpposfrac>>4)*(sd2-sd1))>>12; \
+	*tapData++ = (mp_sword)((sd1*vol)>>9);
+
+#define SCOPETAP_16BIT \
+	sd1 = ((mp_sword*)(sample))[smppos]; \
+	sd2 = ((mp_sword*)(sample))[smppos+1]; \
+	sd1 = ((sd1<<12)+(smpposfrac>>4)*(sd2-sd1))>>12; \
+	*tapData++ = (mp_sword)((sd1*vol)>>9);
+
+// Render the scope snapshot for beat packet nb from the current channel state,
+// walks a copy of the channel so the actual mixing state is left untouched
+static void storeScopeTapData(mp_sint32 nb, const ChannelMixer::TMixerChannel* srcChn)
 {
+	ChannelMixer::TScopeTap* tap = &srcChn->scopeTap[nb / ChannelMixer::MP_SCOPETAP_BEATSTEP];
+
+	const mp_uint32 sequence = tap->sequence;
+	atomicStoreRelease(&tap->sequence, sequence + 1);
+	atomicThreadFence();
+
+	mp_sword* tapData = tap->data;
+
+	if ((srcChn->flags & ChannelMixer::MP_SAMPLE_PLAY) && srcChn->sample && srcChn->smpadd > 0)
+	{
+		ChannelMixer::TMixerChannel channel(true);
+		channel.flags = srcChn->flags;
+		channel.sample = srcChn->sample;
+		channel.smppos = srcChn->smppos;
+		channel.smpposfrac = srcChn->smpposfrac;
+		channel.smpadd = (mp_sint32)(((mp_int64)srcChn->smpadd * ChannelMixer::MP_SCOPETAP_SPAN) / ChannelMixer::MP_SCOPETAP_SIZE);
+		channel.loopstart = srcChn->loopstart;
+		channel.loopend = srcChn->loopend;
+		channel.loopendcopy = srcChn->loopendcopy;
+
+		ChannelMixer::TMixerChannel* chn = &channel;
+		const mp_sint32 vol = srcChn->vol;
+		mp_sint32 count = ChannelMixer::MP_SCOPETAP_SIZE;
+
+		FULLMIXER_TEMPLATE(SCOPETAP_8BIT, SCOPETAP_16BIT, 16, 0);
+	}
+
+	// silent channel or sample stopped within the snapshot
+	const mp_sint32 remaining = (mp_sint32)(tap->data + ChannelMixer::MP_SCOPETAP_SIZE - tapData);
+	if (remaining > 0)
+		memset(tapData, 0, remaining * sizeof(mp_sword));
+
+	atomicStoreRelease(&tap->sequence, sequence + 2);
+}
+
+bool ChannelMixer::readScopeTap(mp_uint32 c, mp_sint32 beatIndex, mp_sword* buffer) const
+{
+	if (!scopeTapEnabled || channel == NULL || c >= mixerNumAllocatedChannels || beatIndex < 0)
+		return false;
+
+	const TMixerChannel* chn = &channel[c];
+	const mp_uint32 index = (mp_uint32)beatIndex / MP_SCOPETAP_BEATSTEP;
+	if (chn->scopeTap == NULL || index >= chn->scopeTapSize)
+		return false;
+
+	const TScopeTap* tap = &chn->scopeTap[index];
+
+	// the mixer rewrites a snapshot only once per mixing buffer,
+	// so a few retries are plenty
+	for (mp_sint32 i = 0; i < 4; i++)
+	{
+		const mp_uint32 sequence = atomicLoadAcquire(&tap->sequence);
+		if (sequence & 1)
+			continue;
+
+		memcpy(buffer, tap->data, sizeof(tap->data));
+		atomicThreadFence();
+
+		if (atomicLoadAcquire(&tap->sequence) == sequence)
+			return true;
+	}
+
+	return false;
+}
+
+static inline void storeTimeRecordData(mp_sint32 nb, ChannelMixer::TMixerChannel* chn, bool scopeTap)
+{
+	if (scopeTap && chn->scopeTap && (nb % ChannelMixer::MP_SCOPETAP_BEATSTEP) == 0)
+		storeScopeTapData(nb, chn);
+
 	if (!(chn->flags & ChannelMixer::MP_SAMPLE_PLAY))
 	{
 		if (chn->timeRecord)
@@ -1044,6 +1398,7 @@ void ChannelMixer::hardwareOutChannel(MixerProxy * mixerProxy, mp_uint32 c)
 				chn->smplen = newChannel[c].smplen;
 				chn->loopstart = newChannel[c].loopstart;
 				chn->loopend = newChannel[c].loopend;
+				chn->unrolledloop = newChannel[c].unrolledloop;
 				chn->smppos = newChannel[c].smppos;
 				chn->smpposfrac = newChannel[c].smpposfrac;
 				chn->flags = newChannel[c].flags;
@@ -1089,6 +1444,8 @@ void ChannelMixer::hardwareOut(MixerProxy * mixerProxy)
 	for(nb = 0; nb < 250 / 50; nb++) {
 		timer(nb);
 
+		processEvents(mixBufferSize);
+
 		for(c = 0; c < nChannels; c++) {
 			hardwareOutChannel(mixerProxy, c);
 		}
@@ -1137,9 +1494,11 @@ void ChannelMixer::directOut(MixerProxy * mixerProxy)
 		for (nb = 0; nb < numbeats; nb++) {
 			timer(nb);
 
+			processEvents(done - (numbeats - nb - 1) * beatLength - 1);
+
 			if (!disableMixing) {
 				for(c = 0; c < nChannels; c++) {
-					storeTimeRecordData(nb, &channel[c]);
+					storeTimeRecordData(nb, &channel[c], scopeTapEnabled);
 					if(resamplerTable[MIXER_NORMAL] != NULL) {
 						resamplerTable[MIXER_NORMAL]->directOutChannel(this, c, mixerProxy->getBuffer<mp_sword>(c) + nb * beatLength * MP_NUMCHANNELS, nb, beatLength);
 					}
@@ -1158,9 +1517,11 @@ void ChannelMixer::directOut(MixerProxy * mixerProxy)
 
 			timer(numbeats);
 
+			processEvents(done + beatLength - 1);
+
 			if (!disableMixing) {
 				for(c = 0; c < nChannels; c++) {
-					storeTimeRecordData(nb, &channel[c]);
+					storeTimeRecordData(nb, &channel[c], scopeTapEnabled);
 					if(resamplerTable[MIXER_NORMAL] != NULL) {
 						resamplerTable[MIXER_NORMAL]->directOutChannel(this, c, mixbuffBeatPackets[c], nb, beatLength);
 					}
@@ -1178,6 +1539,69 @@ void ChannelMixer::directOut(MixerProxy * mixerProxy)
 	}
 }
 
+void ChannelMixer::storeRampingState()
+{
+	const TMixerChannel* src = channel;
+	TMixerChannel* dst = newChannel;
+	if (allowFilters)
+	{
+		// this is crucial for volume ramping, store current
+		// active sample rate (stored in the step values for each channel)
+		// and also filter coefficients	and last samples
+		for (mp_uint32 c = 0; c < mixerNumActiveChannels; c++, src++, dst++)
+		{
+			dst->smpadd = src->smpadd;
+			dst->rsmpadd = src->rsmpadd;
+
+			dst->a = src->a;
+			dst->b = src->b;
+			dst->c = src->c;
+			dst->currsample = src->currsample;
+			dst->prevsample = src->prevsample;
+		}
+	}
+	else
+	{
+		// this is crucial for volume ramping, store current
+		// active sample rate (stored in the step values for each channel)
+		// and also filter coefficients	and last samples
+		for (mp_uint32 c = 0; c < mixerNumActiveChannels; c++, src++, dst++)
+		{
+			dst->smpadd = src->smpadd;
+			dst->rsmpadd = src->rsmpadd;
+		}
+	}
+}
+
+void ChannelMixer::mixBeatPacketEvents(mp_sint32* buffer32, mp_sint32 beatPacketIndex, mp_sint32 beatPacketSize, mp_sint32 offset, bool isRamping)
+{
+	// events due within the last quarter of the beat packet are left to the
+	// next one, so the volume ramps of a split never get too short
+	const mp_sint32 minLength = beatPacketSize >> 2;
+
+	mp_sint32 done = 0;
+	while (done < beatPacketSize)
+	{
+		mp_sint32 todo = beatPacketSize - done;
+
+		mp_sint32 distance = getEventDistance(offset + done, todo);
+		if (distance > 0 && distance < todo - minLength)
+			todo = distance;
+
+		mixBeatPacket(mixerNumActiveChannels, buffer32 + done*MP_NUMCHANNELS, beatPacketIndex, todo);
+
+		done+=todo;
+
+		if (done < beatPacketSize)
+		{
+			if (isRamping)
+				storeRampingState();
+
+			processEvents(offset + done);
+		}
+	}
+}
+
 void ChannelMixer::mixDown(MixerProxy * mixerProxy)
 {
 	mp_sint32* buffer = mixerProxy->getBuffer<mp_sint32>(MixerProxyMixDown::MixBuffer);
@@ -1227,53 +1651,26 @@ void ChannelMixer::mixDown(MixerProxy * mixerProxy)
 
 		const bool isRamping = this->isRamping();
 
+		// position of the first beat packet within the mix buffer
+		const mp_sint32 offset = mixBufferSize - mixSize;
+
 		for (nb=0;nb<numbeats;nb++)
 		{
 			if (isRamping)
-			{
-				const TMixerChannel* src = channel;
-				TMixerChannel* dst = newChannel;
-				const mp_uint32 mixerNumActiveChannels = this->mixerNumActiveChannels;
-				if (allowFilters)
-				{
-					// this is crucial for volume ramping, store current
-					// active sample rate (stored in the step values for each channel)
-					// and also filter coefficients	and last samples
-					for (mp_uint32 c = 0; c < mixerNumActiveChannels; c++, src++, dst++)
-					{
-						dst->smpadd = src->smpadd;
-						dst->rsmpadd = src->rsmpadd;
-
-						dst->a = src->a;
-						dst->b = src->b;
-						dst->c = src->c;
-						dst->currsample = src->currsample;
-						dst->prevsample = src->prevsample;
-					}
-				}
-				else
-				{
-					// this is crucial for volume ramping, store current
-					// active sample rate (stored in the step values for each channel)
-					// and also filter coefficients	and last samples
-					for (mp_uint32 c = 0; c < mixerNumActiveChannels; c++, src++, dst++)
-					{
-						dst->smpadd = src->smpadd;
-						dst->rsmpadd = src->rsmpadd;
-					}
-				}
-			}
+				storeRampingState();
 
 			timer(nb);
 
+			processEvents(offset+nb*beatLength);
+
 			if (!disableMixing)
 			{
 				// do some in between state recording
 				// to be able to show smooth updates even if the buffer is large
 				for (mp_uint32 c=0;c<mixerNumActiveChannels;c++)
-					storeTimeRecordData(nb, &channel[c]);
+					storeTimeRecordData(nb, &channel[c], scopeTapEnabled);
 
-				mixBeatPacket(mixerNumActiveChannels, buffer+nb*beatLength*MP_NUMCHANNELS, nb, beatLength);
+				mixBeatPacketEvents(buffer+nb*beatLength*MP_NUMCHANNELS, nb, beatLength, offset+nb*beatLength, isRamping);
 			}
 		}
 
@@ -1284,50 +1681,20 @@ void ChannelMixer::mixDown(MixerProxy * mixerProxy)
 			memset(mixbuffBeatPacket, 0, beatLength*MP_NUMCHANNELS*sizeof(mp_sint32));
 
 			if (isRamping)
-			{
-				const TMixerChannel* src = channel;
-				TMixerChannel* dst = newChannel;
-				const mp_uint32 mixerNumActiveChannels = this->mixerNumActiveChannels;
-				if (allowFilters)
-				{
-					// this is crucial for volume ramping, store current
-					// active sample rate (stored in the step values for each channel)
-					// and also filter coefficients	and last samples
-					for (mp_uint32 c = 0; c < mixerNumActiveChannels; c++, src++, dst++)
-					{
-						dst->smpadd = src->smpadd;
-						dst->rsmpadd = src->rsmpadd;
-
-						dst->a = src->a;
-						dst->b = src->b;
-						dst->c = src->c;
-						dst->currsample = src->currsample;
-						dst->prevsample = src->prevsample;
-					}
-				}
-				else
-				{
-					// this is crucial for volume ramping, store current
-					// active sample rate (stored in the step values for each channel)
-					// and also filter coefficients	and last samples
-					for (mp_uint32 c = 0; c < mixerNumActiveChannels; c++, src++, dst++)
-					{
-						dst->smpadd = src->smpadd;
-						dst->rsmpadd = src->rsmpadd;
-					}
-				}
-			}
+				storeRampingState();
 
 			timer(numbeats);
 
+			processEvents(done);
+
 			if (!disableMixing)
 			{
 				// do some in between state recording
 				// to be able to show smooth updates even if the buffer is large
 				for (mp_uint32 c=0;c<mixerNumActiveChannels;c++)
-					storeTimeRecordData(nb, &channel[c]);
+					storeTimeRecordData(nb, &channel[c], scopeTapEnabled);
 
-				mixBeatPacket(mixerNumActiveChannels, mixbuffBeatPacket, numbeats, beatLength);
+				mixBeatPacketEvents(mixbuffBeatPacket, numbeats, beatLength, done, isRamping);
 			}
 
 			mp_sint32 todo = mixBufferSize - done;
@@ -1345,6 +1712,171 @@ void ChannelMixer::mixDown(MixerProxy * mixerProxy)
 	}
 }
 
+void ChannelMixer::reallocStemBeatPackets(mp_uint32 numStems)
+{
+	freeStemBeatPackets();
+
+	stemBeatPackets = new mp_sint32*[numStems];
+	for (mp_uint32 i = 0; i < numStems; i++)
+		stemBeatPackets[i] = new mp_sint32[beatPacketSize*MP_NUMCHANNELS];
+
+	numStemBeatPackets = numStems;
+}
+
+void ChannelMixer::freeStemBeatPackets()
+{
+	if (stemBeatPackets)
+	{
+		for (mp_uint32 i = 0; i < numStemBeatPackets; i++)
+			delete[] stemBeatPackets[i];
+		delete[] stemBeatPackets;
+		stemBeatPackets = NULL;
+	}
+
+	numStemBeatPackets = 0;
+}
+
+void ChannelMixer::mixStemsBeatPacket(MixerProxy * mixerProxy, mp_uint32 numStems, mp_sint32 offset, mp_sint32 beatPacketIndex, mp_sint32 beatLength)
+{
+	ResamplerBase* resampler = resamplerTable[resamplerType];
+
+	for (mp_uint32 c = 0; c < mixerNumActiveChannels; c++)
+	{
+		// the owner of a mixer channel can change on every tick
+		// (virtual channels), so look it up for every beat packet
+		const mp_sint32 stem = getLogicalChannel(c);
+		if (stem < 0 || stem >= (mp_sint32)numStems)
+			continue;
+
+		mp_sint32* buffer = offset >= 0 ? mixerProxy->getBuffer<mp_sint32>(stem) : stemBeatPackets[stem];
+
+		// disabled stem
+		if (!buffer)
+			continue;
+
+		// mix nothing but mixer channel c into the buffer of its stem
+		resampler->addChannels(this, c + 1, offset >= 0 ? buffer + offset*MP_NUMCHANNELS : buffer, beatPacketIndex, beatLength, c, 1);
+	}
+}
+
+void ChannelMixer::mixStems(MixerProxy * mixerProxy)
+{
+	// one stem per module channel, every mixer channel is mixed into the
+	// stem of the module channel owning it
+	const mp_uint32 numStems = mixerProxy->getNumChannels();
+
+	if (numStemBeatPackets < numStems)
+		reallocStemBeatPackets(numStems);
+
+	mp_sint32 beatLength = beatPacketSize;
+	mp_sint32 mixSize = mixBufferSize;
+	mp_sint32 offset = 0;
+
+	mp_sint32 done = 0;
+	mp_uint32 c;
+
+	if (lastBeatRemainder)
+	{
+		mp_sint32 todo = lastBeatRemainder > mixBufferSize ? mixBufferSize : lastBeatRemainder;
+		mp_uint32 pos = beatLength - lastBeatRemainder;
+
+		for (c = 0; c < numStems; c++)
+		{
+			mp_sint32* dst = mixerProxy->getBuffer<mp_sint32>(c);
+			if (!dst)
+				continue;
+
+			const mp_sint32* src = stemBeatPackets[c] + pos*MP_NUMCHANNELS;
+			for (mp_sint32 i = 0; i < todo*MP_NUMCHANNELS; i++, src++, dst++)
+				*dst += *src;
+		}
+
+		if (lastBeatRemainder > mixBufferSize)
+		{
+			done = mixBufferSize;
+			lastBeatRemainder-=done;
+		}
+		else
+		{
+			offset = lastBeatRemainder;
+			mixSize-=lastBeatRemainder;
+			done = lastBeatRemainder;
+			lastBeatRemainder = 0;
+		}
+	}
+
+	if (done < (mp_sint32)mixBufferSize)
+	{
+		const mp_sint32 numbeats = mixSize / beatLength;
+
+		done+=numbeats*beatLength;
+
+		mp_sint32 nb;
+
+		const bool isRamping = this->isRamping();
+
+		for (nb=0;nb<numbeats;nb++)
+		{
+			if (isRamping)
+				storeRampingState();
+
+			timer(nb);
+
+			processEvents(offset+(nb+1)*beatLength-1);
+
+			if (!disableMixing)
+			{
+				for (c=0;c<mixerNumActiveChannels;c++)
+					storeTimeRecordData(nb, &channel[c], scopeTapEnabled);
+
+				mixStemsBeatPacket(mixerProxy, numStems, offset+nb*beatLength, nb, beatLength);
+			}
+		}
+
+		offset+=numbeats*beatLength;
+
+		if (done < (mp_sint32)mixBufferSize)
+		{
+			for (c = 0; c < numStems; c++)
+				memset(stemBeatPackets[c], 0, beatLength*MP_NUMCHANNELS*sizeof(mp_sint32));
+
+			if (isRamping)
+				storeRampingState();
+
+			timer(numbeats);
+
+			processEvents(offset+beatLength-1);
+
+			if (!disableMixing)
+			{
+				for (c=0;c<mixerNumActiveChannels;c++)
+					storeTimeRecordData(nb, &channel[c], scopeTapEnabled);
+
+				// negative offset selects the beat packet buffers
+				mixStemsBeatPacket(mixerProxy, numStems, -1, numbeats, beatLength);
+			}
+
+			mp_sint32 todo = mixBufferSize - done;
+
+			if (todo)
+			{
+				for (c = 0; c < numStems; c++)
+				{
+					mp_sint32* dst = mixerProxy->getBuffer<mp_sint32>(c);
+					if (!dst)
+						continue;
+
+					dst+=offset*MP_NUMCHANNELS;
+					const mp_sint32* src = stemBeatPackets[c];
+					for (mp_sint32 i = 0; i < todo*MP_NUMCHANNELS; i++, src++, dst++)
+						*dst += *src;
+				}
+				lastBeatRemainder = beatLength - todo;
+			}
+		}
+	}
+}
+
 void ChannelMixer::mix(MixerProxy * mixerProxy)
 {
 	updateSampleCounter(mixerProxy->getBufferSize());
@@ -1368,6 +1900,10 @@ void ChannelMixer::mix(MixerProxy * mixerProxy)
 		// Hardware out to channels for machine with multi-channel audio DMA control
 		hardwareOut(mixerProxy);
 		break;
+	case MixerProxy::Stems:
+		// Mix every channel into a stereo buffer of its own
+		mixStems(mixerProxy);
+		break;
 	}
 }
 
@@ -44,6 +44,8 @@
 #include "AudioDriverBase.h"
 #include "Mixable.h"
 
+class WorkerPool;
+
 #define MP_FP_CEIL(x)			(((x)+65535)>>16)
 #define MP_FP_MUL(a, b)			((mp_sint32)(((mp_int64)(a)*(mp_int64)(b))>>16))
 
@@ -112,6 +114,16 @@ public:
 		// pretty large buffer for most systems
 		BUFFERSIZE_DEFAULT	   = 8192
 	};
+
+	enum
+	{
+		// number of threads resampling channels in parallel,
+		// 0 or 1 means everything is mixed on the audio thread
+		MIXERTHREADS_DEFAULT	= 0,
+		MIXERTHREADS_MAX		= 16,
+		// don't bother waking up worker threads for less channels
+		MIXERTHREADS_MINCHANNELS = 8
+	};
 };
 
 class ChannelMixer : public MixerSettings, public Mixable
@@ -181,6 +193,23 @@ public:
 		}
 	};
 
+	// Decimated post volume output of a single channel, written by the mixer
+	// on every MP_SCOPETAP_BEATSTEP-th beat packet so the UI (scopes) doesn't
+	// need to resample the channel again. Readers go through readScopeTap,
+	// the sequence counter is odd while the mixer is writing (seqlock).
+	enum
+	{
+		MP_SCOPETAP_SIZE		= 128,		// points per snapshot
+		MP_SCOPETAP_SPAN		= 160,		// output samples covered by a snapshot
+		MP_SCOPETAP_BEATSTEP	= 4			// 250Hz/4 = 62.5 snapshots per second
+	};
+
+	struct TScopeTap
+	{
+		volatile mp_uint32	sequence;
+		mp_sword			data[MP_SCOPETAP_SIZE];
+	};
+
 	struct TMixerChannel
 	{
 		mp_uint32			flags;					// bit 8 = sample played
@@ -199,6 +228,7 @@ public:
 		mp_sint32			loopend;				// loop end
 		mp_sint32			loopendcopy;			// Temporary placeholder for one-shot looping
 		mp_sint32			loopstart;				// loop start
+		bool				unrolledloop;			// loop may be mixed from its copy unrolled in the sample padding
 
 		mp_sint32			finalvolr;
 		mp_sint32			finalvoll;
@@ -210,6 +240,10 @@ public:
 		mp_sint32			rampFromVolStepL;
 
 		mp_sint32			a,b,c;					// Filter coefficients
+		mp_sint32			targetA,targetB,targetC;// Filter coefficients a,b,c are ramped to when smoothing
+		mp_sint32			rampFilterStepA;		// Per sample coefficient steps
+		mp_sint32			rampFilterStepB;		// see above
+		mp_sint32			rampFilterStepC;		// see above
 		mp_sint32			currsample;				// sample history for filtering
 		mp_sint32			prevsample;				// see above
 
@@ -221,18 +255,24 @@ public:
 
 		mp_uint32			timeRecordSize;
 		TTimeRecord*		timeRecord;
+		mp_uint32			scopeTapSize;
+		TScopeTap*			scopeTap;
 		mp_sint32			index;					// For Amiga resampler
 
 		TMixerChannel() :
 			timeRecordSize(0),
-			timeRecord(NULL)
+			timeRecord(NULL),
+			scopeTapSize(0),
+			scopeTap(NULL)
 		{
 			clear();
 		}
 
 		TMixerChannel(bool fastContruction) :
 			timeRecordSize(0),
-			timeRecord(NULL)
+			timeRecord(NULL),
+			scopeTapSize(0),
+			scopeTap(NULL)
 		{
 		}
 
@@ -240,6 +280,8 @@ public:
 		{
 			if (timeRecord)
 				delete[] timeRecord;
+			if (scopeTap)
+				delete[] scopeTap;
 		}
 
 		void clear()
@@ -254,6 +296,7 @@ public:
 			loopend				= 0;
 			loopendcopy			= 0;
 			loopstart			= 0;
+			unrolledloop		= false;
 
 			finalvolr			= 0;
 			finalvoll			= 0;
@@ -265,6 +308,10 @@ public:
 			rampFromVolStepL	= 0;
 
 			a = b = c			= 0;
+			targetA = targetB = targetC = 0;
+			rampFilterStepA		= 0;
+			rampFilterStepB		= 0;
+			rampFilterStepC		= 0;
 			currsample			= 0;
 			prevsample			= 0;
 
@@ -284,6 +331,11 @@ public:
 			delete[] timeRecord;
 			timeRecordSize = size;
 			timeRecord = new TTimeRecord[size];
+
+			delete[] scopeTap;
+			scopeTapSize = size / MP_SCOPETAP_BEATSTEP + 1;
+			scopeTap = new TScopeTap[scopeTapSize];
+			memset(scopeTap, 0, sizeof(TScopeTap) * scopeTapSize);
 		}
 	};
 
@@ -291,16 +343,21 @@ public:
 	{
 	private:
 		// add channels without volume ramping
-		void addChannelsNormal(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);
+		void addChannelsNormal(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength, mp_uint32 firstChannel, mp_uint32 channelStep);
 		// add channels with volume ramping
-		void addChannelsRamping(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);
+		void addChannelsRamping(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength, mp_uint32 firstChannel, mp_uint32 channelStep);
+		// mix one channel, wrapping around its loop where necessary
+		void addChannelBlocks(TMixerChannel* chn, mp_sint32* buffer32, const mp_sint32 beatlength, const mp_sint32 beatSize);
+		// mix one channel from the unrolled copy of its loop
+		void addChannelUnrolled(TMixerChannel* chn, mp_sint32* buffer32, const mp_sint32 beatlength, const mp_sint32 beatSize, const TUnrolledLoopHeader& header);
 
 	public:
 		virtual ~ResamplerBase()
 		{
 		}
 
-		void addChannels(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);
+		// mixes channels firstChannel, firstChannel+channelStep, ... (all channels by default)
+		void addChannels(ChannelMixer* mixer, mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength, mp_uint32 firstChannel = 0, mp_uint32 channelStep = 1);
 		void addChannel(TMixerChannel* chn, mp_sint32* buffer32, const mp_sint32 beatlength, const mp_sint32 beatSize);
 		void directOutChannel(ChannelMixer* mixer, mp_uint32 c, mp_sword* buffer, mp_sint32 beatNum, mp_sint32 beatlength);
 
@@ -323,6 +380,8 @@ public:
 		virtual bool supportsNoChecking() = 0;
 		// optional: if this resampler is able to perform a full checked walk along the sample
 		virtual bool supportsFullChecking() = 0;
+		// this resampler reads the sample before the current position
+		virtual bool readsBehindPosition() { return false; }
 
 		// see above, you will need to implement at least one of the following
 		virtual void addBlockNoCheck(mp_sint32* buffer, TMixerChannel* chn, mp_uint32 count)
@@ -380,6 +439,68 @@ private:
 	bool			paused;
 	bool			disableMixing;
 	bool			allowFilters;
+	bool			filterSmoothing;
+	bool			scopeTapEnabled;
+	bool			loopUnrolling;
+
+	// IT filter coefficient tables for the current mix frequency,
+	// inv_angle = filterCoarseAngle[cutoff>>8] * filterFineAngle[cutoff&255]
+	enum
+	{
+		FILTERCUTOFFSTEPS	= 128,
+		FILTERRESONANCESTEPS = 128
+	};
+
+	double			filterCoarseAngle[FILTERCUTOFFSTEPS];
+	double			filterFineAngle[256];
+	float			filterLoss[FILTERRESONANCESTEPS];
+	mp_uint32		filterTableFrequency;
+
+	void			buildFilterTables();
+
+	// parallel mixing: every worker resamples the channels it claims into
+	// its own partial beat packet, which are summed up afterwards
+	mp_uint32		numMixerThreads;
+	WorkerPool*		workerPool;
+	mp_sint32**		workerBeatPackets;
+
+	struct TParallelMixJob
+	{
+		ChannelMixer*	mixer;
+		mp_uint32		numChannels;
+		mp_sint32*		buffer32;
+		mp_sint32		beatPacketIndex;
+		mp_sint32		beatPacketSize;
+		// a worker clears its partial beat packet with its first channel,
+		// only the packets of workers which mixed something are summed up
+		bool			workerUsed[MIXERTHREADS_MAX];
+	};
+
+	TParallelMixJob	parallelMixJob;
+
+	static void		parallelMixTask(void* userData, mp_uint32 taskIndex, mp_uint32 threadIndex);
+	void			mixBeatPacketParallel(mp_uint32 numChannels,
+										  mp_sint32* buffer32,
+										  mp_sint32 beatPacketIndex,
+										  mp_sint32 beatPacketSize);
+
+	void			reallocWorkerBeatPackets();
+	void			freeWorkerBeatPackets();
+
+	// stem mixing: partial beat packets carried over to the next buffer,
+	// one per stem
+	mp_sint32**		stemBeatPackets;
+	mp_uint32		numStemBeatPackets;
+
+	void			reallocStemBeatPackets(mp_uint32 numStems);
+	void			freeStemBeatPackets();
+	void			mixStemsBeatPacket(MixerProxy * mixerProxy,
+									   mp_uint32 numStems,
+									   mp_sint32 offset,
+									   mp_sint32 beatPacketIndex,
+									   mp_sint32 beatLength);
+
+	void			storeRampingState();
 
 	void			setFrequency(mp_sint32 frequency);
 
@@ -388,9 +509,20 @@ private:
 								  mp_sint32 beatPacketIndex,
 								  mp_sint32 beatPacketSize)
 	{
-		resamplerTable[resamplerType]->addChannels(this, numChannels, buffer32, beatPacketIndex, beatPacketSize);
+		if (workerPool && numChannels >= MIXERTHREADS_MINCHANNELS)
+			mixBeatPacketParallel(numChannels, buffer32, beatPacketIndex, beatPacketSize);
+		else
+			resamplerTable[resamplerType]->addChannels(this, numChannels, buffer32, beatPacketIndex, beatPacketSize);
 	}
 
+	// mixes a beat packet starting at offset within the mix buffer and
+	// splits it where events are due
+	void			mixBeatPacketEvents(mp_sint32* buffer32,
+										mp_sint32 beatPacketIndex,
+										mp_sint32 beatPacketSize,
+										mp_sint32 offset,
+										bool isRamping);
+
 	inline void		timer(mp_uint32 beatIndex)
 	{
 		timerHandler(beatIndex <= getNumBeatPackets() ? beatIndex : getNumBeatPackets());
@@ -409,6 +541,7 @@ public:
 
 	void			mixDown(MixerProxy * mixerProxy);
 	void			directOut(MixerProxy * mixerProxy);
+	void			mixStems(MixerProxy * mixerProxy);
 	void			hardwareOutChannel(MixerProxy * mixerProxy, mp_uint32 c);
 	void			hardwareOut(MixerProxy * mixerProxy);
 
@@ -427,6 +560,29 @@ public:
 	void			setDisableMixing(bool disableMixing) { this->disableMixing = disableMixing; }
 	void			setAllowFilters(bool allowFilters) { this->allowFilters = allowFilters; }
 	bool			getAllowFilters() const { return allowFilters; }
+	// ramp filter coefficients per sample instead of changing them at tick boundaries
+	void			setFilterSmoothing(bool filterSmoothing) { this->filterSmoothing = filterSmoothing; }
+	bool			getFilterSmoothing() const { return filterSmoothing; }
+	// mix short loops from their copies unrolled into the sample padding (see
+	// TXMSample::unrollLoop). Forward loops stay bit identical unless the
+	// step is large enough to read past the loop double buffer, for cubic
+	// resamplers only seamless ones are unrolled. Ping pong loops always
+	// take the regular path
+	void			setLoopUnrolling(bool loopUnrolling) { this->loopUnrolling = loopUnrolling; }
+	bool			getLoopUnrolling() const { return loopUnrolling; }
+
+	// let the mixer write scope snapshots (see TScopeTap)
+	void			setScopeTapEnabled(bool scopeTapEnabled) { this->scopeTapEnabled = scopeTapEnabled; }
+	bool			isScopeTapEnabled() const { return scopeTapEnabled; }
+	// copy the snapshot belonging to the given beat packet into buffer
+	// (MP_SCOPETAP_SIZE values), false if there is none or the mixer kept
+	// overwriting it while we were reading
+	bool			readScopeTap(mp_uint32 c, mp_sint32 beatIndex, mp_sword* buffer) const;
+
+	// Number of threads used for resampling channels (including the audio thread),
+	// output is bit identical to the single threaded mixer
+	void			setNumMixerThreads(mp_uint32 num);
+	mp_uint32		getNumMixerThreads() const { return numMixerThreads; }
 
 	void			resetChannelsFull();
 	void			resetChannelsWithoutMuting();
@@ -545,6 +701,17 @@ public:
 protected:
 	// timer procedure for mixing
 	virtual void	timerHandler(mp_sint32 currentBeatPacket) = 0;
+	// module channel which is currently playing on the given mixer channel,
+	// -1 if none (players with virtual channels need to override this)
+	virtual mp_sint32 getLogicalChannel(mp_uint32 mixerChannel) { return (mp_sint32)mixerChannel; }
+	// sample-accurate events (e.g. notes played live), offsets are in samples
+	// from the start of the current mix buffer: processEvents applies every
+	// event which is due at or before offset, getEventDistance returns how many
+	// of the next length samples can be mixed before the next event is due.
+	// mixDown splits beat packets there, the other mixing paths apply events
+	// once per beat packet
+	virtual void	processEvents(mp_sint32 offset) { }
+	virtual mp_sint32 getEventDistance(mp_sint32 offset, mp_sint32 length) { return length; }
 	void		   	panToVol(ChannelMixer::TMixerChannel *chn, mp_sint32 &left, mp_sint32 &right);
 	static mp_sint32 panLUT[257];
 
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ExportJobScheduler.cpp
+ *  MilkyPlay
+ *
+ */
+#include "ExportJobScheduler.h"
+#include "WorkerPool.h"
+#include "PlayerGeneric.h"
+#include "XModule.h"
+#include "ResamplerFactory.h"
+#include "MilkyPlayAtomic.h"
+
+ExportJobScheduler::ExportJobScheduler(mp_uint32 numThreads/* = 0*/) :
+	workerPool(NULL),
+	jobs(NULL),
+	numJobs(0),
+	numAllocatedJobs(0),
+	running(false)
+{
+	if (numThreads == 0)
+		numThreads = WorkerPool::getNumProcessors();
+
+	// the thread calling wait() renders as well
+	workerPool = new WorkerPool(numThreads - 1);
+}
+
+ExportJobScheduler::~ExportJobScheduler()
+{
+	if (running)
+		wait();
+
+	delete workerPool;
+	delete[] jobs;
+}
+
+mp_sint32 ExportJobScheduler::addJob(const TExportJob& job)
+{
+	if (running || job.module == NULL)
+		return MP_UNSUPPORTED;
+
+	if (numJobs == numAllocatedJobs)
+	{
+		numAllocatedJobs = numAllocatedJobs ? numAllocatedJobs*2 : 16;
+		TJobState* newJobs = new TJobState[numAllocatedJobs];
+		for (mp_uint32 i = 0; i < numJobs; i++)
+			newJobs[i] = jobs[i];
+		delete[] jobs;
+		jobs = newJobs;
+	}
+
+	TJobState& state = jobs[numJobs];
+	state.job = job;
+
+	// same clamping as PlayerGeneric::exportToWAV
+	state.endOrder = job.endOrder;
+	if (state.endOrder == -1 || state.endOrder < job.startOrder || state.endOrder > job.module->header.ordnum - 1)
+		state.endOrder = job.module->header.ordnum - 1;
+
+	state.result = 0;
+	state.orderPosition = job.startOrder;
+	state.finished = 0;
+
+	return numJobs++;
+}
+
+void ExportJobScheduler::clearJobs()
+{
+	if (running)
+		return;
+
+	numJobs = 0;
+}
+
+void ExportJobScheduler::prepareResamplers()
+{
+	bool prepared[ChannelMixer::MIXER_INVALID];
+	memset(prepared, 0, sizeof(prepared));
+
+	// every mixer starts out with MIXER_NORMAL
+	delete ResamplerFactory::createResampler(ChannelMixer::MIXER_NORMAL);
+	prepared[ChannelMixer::MIXER_NORMAL] = true;
+
+	for (mp_uint32 i = 0; i < numJobs; i++)
+	{
+		const ChannelMixer::ResamplerTypes type = jobs[i].job.resamplerType;
+		if (type < ChannelMixer::MIXER_INVALID && !prepared[type])
+		{
+			delete ResamplerFactory::createResampler(type);
+			prepared[type] = true;
+		}
+	}
+}
+
+void ExportJobScheduler::renderJob(void* userData, mp_uint32 jobIndex)
+{
+	TJobState& state = reinterpret_cast<ExportJobScheduler*>(userData)->jobs[jobIndex];
+	const TExportJob& job = state.job;
+
+	PlayerGeneric player(job.frequency);
+
+	player.setBufferSize(job.bufferSize);
+	player.setResamplerType(job.resamplerType);
+	player.setSampleShift(job.sampleShift);
+	player.setMasterVolume(job.masterVolume);
+	player.setPlayMode(job.playMode);
+	player.setAllowFilters(job.allowFilters);
+	player.setFilterSmoothing(job.filterSmoothing);
+	player.setLoopUnrolling(job.loopUnrolling);
+	player.setExportProgress(&state.orderPosition);
+
+	if (job.stemFileNames)
+		state.result = player.exportStemsToWAV(job.stemFileNames, job.module,
+											   job.startOrder, job.endOrder,
+											   job.customPanningTable);
+	else
+		state.result = player.exportToWAV(job.fileName, job.module,
+										  job.startOrder, job.endOrder,
+										  job.mutingArray, job.module->header.channum,
+										  job.customPanningTable);
+
+	atomicStoreRelease(&state.finished, 1);
+}
+
+void ExportJobScheduler::start()
+{
+	if (running)
+		return;
+
+	prepareResamplers();
+
+	running = true;
+	workerPool->start(renderJob, this, numJobs);
+}
+
+void ExportJobScheduler::wait()
+{
+	if (!running)
+		return;
+
+	workerPool->wait();
+	running = false;
+}
+
+mp_uint32 ExportJobScheduler::getNumJobsFinished() const
+{
+	mp_uint32 numFinished = 0;
+
+	for (mp_uint32 i = 0; i < numJobs; i++)
+		numFinished += atomicLoadAcquire(&jobs[i].finished);
+
+	return numFinished;
+}
+
+float ExportJobScheduler::getJobProgress(mp_uint32 index) const
+{
+	const TJobState& state = jobs[index];
+
+	if (atomicLoadAcquire(&state.finished))
+		return 1.0f;
+
+	// pattern jumps can send the order position backwards,
+	// this is an estimate only
+	const mp_sint32 numOrders = state.endOrder - state.job.startOrder + 1;
+	const mp_sint32 order = (mp_sint32)atomicLoadAcquire(&state.orderPosition) - state.job.startOrder;
+
+	if (numOrders <= 0 || order <= 0)
+		return 0.0f;
+
+	return order >= numOrders ? 1.0f : (float)order / (float)numOrders;
+}
+
+float ExportJobScheduler::getProgress() const
+{
+	if (!numJobs)
+		return 1.0f;
+
+	float progress = 0.0f;
+	for (mp_uint32 i = 0; i < numJobs; i++)
+		progress += getJobProgress(i);
+
+	return progress / (float)numJobs;
+}
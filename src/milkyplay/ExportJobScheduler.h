@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ExportJobScheduler.h
+ *  MilkyPlay
+ *
+ *  Renders a batch of independent WAV exports (different modules, order
+ *  ranges or mixer settings) concurrently on a WorkerPool. Every job gets
+ *  its own PlayerGeneric and MasterMixer, modules may be shared between
+ *  jobs as long as nobody modifies them while the jobs are running.
+ *  Progress can be polled from any thread while the jobs are rendering.
+ */
+#ifndef __EXPORTJOBSCHEDULER_H__
+#define __EXPORTJOBSCHEDULER_H__
+
+#include "MilkyPlayCommon.h"
+#include "ChannelMixer.h"
+#include "PlayerBase.h"
+
+class XModule;
+class WorkerPool;
+
+class ExportJobScheduler
+{
+public:
+	struct TExportJob
+	{
+		// destination 16 bit stereo WAV
+		const SYSCHAR*					fileName;
+		// optional: one WAV per channel instead (see PlayerGeneric::exportStemsToWAV)
+		const SYSCHAR* const*			stemFileNames;
+
+		XModule*						module;
+		mp_sint32						startOrder;
+		mp_sint32						endOrder;
+		const mp_ubyte*					mutingArray;
+		const mp_ubyte*					customPanningTable;
+
+		mp_uint32						frequency;
+		mp_uint32						bufferSize;
+		ChannelMixer::ResamplerTypes	resamplerType;
+		mp_sint32						sampleShift;
+		mp_sint32						masterVolume;
+		PlayModeSettings::PlayModes		playMode;
+		bool							allowFilters;
+		bool							filterSmoothing;
+		bool							loopUnrolling;
+
+		TExportJob() :
+			fileName(NULL),
+			stemFileNames(NULL),
+			module(NULL),
+			startOrder(0),
+			endOrder(-1),
+			mutingArray(NULL),
+			customPanningTable(NULL),
+			frequency(44100),
+			bufferSize(1024),
+			resamplerType(ChannelMixer::MIXER_LERPING),
+			sampleShift(1),
+			masterVolume(256),
+			playMode(PlayModeSettings::PlayMode_Auto),
+			allowFilters(false),
+			filterSmoothing(false),
+			loopUnrolling(false)
+		{
+		}
+	};
+
+private:
+	struct TJobState
+	{
+		TExportJob			job;
+		mp_sint32			endOrder;
+		mp_sint32			result;
+		// written by the rendering thread, see MilkyPlayAtomic.h
+		volatile mp_uint32	orderPosition;
+		volatile mp_uint32	finished;
+	};
+
+	WorkerPool*		workerPool;
+	TJobState*		jobs;
+	mp_uint32		numJobs;
+	mp_uint32		numAllocatedJobs;
+	bool			running;
+
+	static void		renderJob(void* userData, mp_uint32 jobIndex);
+
+	// initialize shared resampler tables before several threads race for it
+	void			prepareResamplers();
+
+public:
+	// numThreads is the number of jobs rendered at the same time, including
+	// the thread calling wait(). 0 = one per processor
+					ExportJobScheduler(mp_uint32 numThreads = 0);
+					~ExportJobScheduler();
+
+	// jobs can't be added or removed while the scheduler is running
+	mp_sint32		addJob(const TExportJob& job);
+	void			clearJobs();
+	mp_uint32		getNumJobs() const { return numJobs; }
+
+	// start() returns immediately, wait() blocks (and renders on the calling
+	// thread too) until all jobs are finished. Without thread support all
+	// jobs are rendered in wait().
+	void			start();
+	void			wait();
+	void			run() { start(); wait(); }
+
+	// these may be called from any thread at any time
+	mp_uint32		getNumJobsFinished() const;
+	bool			isFinished() const { return getNumJobsFinished() == numJobs; }
+	float			getJobProgress(mp_uint32 index) const;
+	float			getProgress() const;
+
+	// number of written samples or a negative error code, valid once the job is finished
+	mp_sint32		getJobResult(mp_uint32 index) const { return jobs[index].result; }
+};
+
+#endif
@@ -1348,6 +1348,16 @@ static void sort(mp_sword* array,mp_sint32 l, mp_sint32 r)
 }
 
 mp_sint32 XModule::saveExtendedModule(const SYSCHAR* fileName, bool isMagic)
+{
+	XMFile f(fileName, true);
+
+	if (!f.isOpenForWriting())
+		return MP_DEVICE_ERROR;
+
+	return saveExtendedModule(f, isMagic);
+}
+
+mp_sint32 XModule::saveExtendedModule(XMFileBase& f, bool isMagic)
 {
 	mp_sint32 i,j,k,l;
 
@@ -1368,8 +1378,6 @@ mp_sint32 XModule::saveExtendedModule(const SYSCHAR* fileName, bool isMagic)
 		insNum++;
 
 	// ------ start ---------------------------------
-	XMFile f(fileName, true);
-
 	if (!f.isOpenForWriting())
 		return MP_DEVICE_ERROR;
 
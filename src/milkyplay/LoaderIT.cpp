@@ -524,7 +524,9 @@ mp_sint32 LoaderIT::load(XMFileBase& f, XModule* module)
 	if (header->smpnum > 256)
 		header->smpnum = 256;
 	
-	// read samples
+	// read samples, the sample data is decoded in parallel after the loop
+	module->beginSampleBatch();
+
 	for (i = 0; i < header->smpnum; i++)
 	{
 		f.seekWithBaseOffset(smpOffs[i]);
@@ -633,12 +635,12 @@ mp_sint32 LoaderIT::load(XMFileBase& f, XModule* module)
 
 				if (itSmp.Flg & 8)
 				{
-					if (!module->loadSample(f, smp[i].sample, smp[i].samplen, smp[i].samplen, (itSmp.Cvt & 4) ? XModule::ST_PACKING_IT215 : XModule::ST_PACKING_IT))
+					if (!module->queueSample(f, smp[i].sample, smp[i].samplen, smp[i].samplen, (itSmp.Cvt & 4) ? XModule::ST_PACKING_IT215 : XModule::ST_PACKING_IT))
 					{
 						return MP_OUT_OF_MEMORY;
 					}
 				}
-				else if (!module->loadSample(f,smp[i].sample,smp[i].samplen,smp[i].samplen, (itSmp.Cvt & 1) ? XModule::ST_DEFAULT : XModule::ST_UNSIGNED))
+				else if (!module->queueSample(f,smp[i].sample,smp[i].samplen,smp[i].samplen, (itSmp.Cvt & 1) ? XModule::ST_DEFAULT : XModule::ST_UNSIGNED))
 				{
 					return MP_OUT_OF_MEMORY;
 				}					
@@ -654,12 +656,12 @@ mp_sint32 LoaderIT::load(XMFileBase& f, XModule* module)
 
 				if (itSmp.Flg & 8)
 				{
-					if (!module->loadSample(f, smp[i].sample, smp[i].samplen, smp[i].samplen, (itSmp.Cvt & 4) ? (XModule::ST_PACKING_IT215 | XModule::ST_16BIT) : (XModule::ST_PACKING_IT | XModule::ST_16BIT)))
+					if (!module->queueSample(f, smp[i].sample, smp[i].samplen, smp[i].samplen, (itSmp.Cvt & 4) ? (XModule::ST_PACKING_IT215 | XModule::ST_16BIT) : (XModule::ST_PACKING_IT | XModule::ST_16BIT)))
 					{
 						return MP_OUT_OF_MEMORY;
 					}
 				}
-				else if (!module->loadSample(f,smp[i].sample,smp[i].samplen<<1,smp[i].samplen, XModule::ST_16BIT | ((itSmp.Cvt & 1) ? XModule::ST_DEFAULT : XModule::ST_UNSIGNED)))
+				else if (!module->queueSample(f,smp[i].sample,smp[i].samplen<<1,smp[i].samplen, XModule::ST_16BIT | ((itSmp.Cvt & 1) ? XModule::ST_DEFAULT : XModule::ST_UNSIGNED)))
 				{
 					return MP_OUT_OF_MEMORY;
 				}					
@@ -667,6 +669,9 @@ mp_sint32 LoaderIT::load(XMFileBase& f, XModule* module)
 		}
 	}
 
+	if (!module->finishSampleBatch())
+		return MP_OUT_OF_MEMORY;
+
 	if (!(flags & 4))
 		header->insnum = header->smpnum;
 	/*else
@@ -367,6 +367,9 @@ mp_sint32 LoaderMDL::load(XMFileBase& f, XModule* module)
 			}
 		}
 		else if (!memcmp(&blockhead,"SA",2)) {
+			// sample data is decoded in parallel after the loop
+			module->beginSampleBatch();
+			
 			for (mp_uint32 s=0;s<numsamples;s++) {
 				
 				mp_ubyte pb = (mdlsamp[s].infobyte>>2)&3;
@@ -387,7 +390,7 @@ mp_sint32 LoaderMDL::load(XMFileBase& f, XModule* module)
 								return MP_OUT_OF_MEMORY;
 							}
 							
-							if (!module->loadSample(f,mdlsamp[s].smp,mdlsamp[s].samplen,mdlsamp[s].samplen))
+							if (!module->queueSample(f,mdlsamp[s].smp,mdlsamp[s].samplen,mdlsamp[s].samplen))
 							{
 								if (mdlins) delete[] mdlins;
 								if (mdlsamp) delete[] mdlsamp;
@@ -412,7 +415,7 @@ mp_sint32 LoaderMDL::load(XMFileBase& f, XModule* module)
 								return MP_OUT_OF_MEMORY;
 							}
 							
-							if (!module->loadSample(f,mdlsamp[s].smp,mdlsamp[s].samplen,mdlsamp[s].samplen>>1,XModule::ST_16BIT))
+							if (!module->queueSample(f,mdlsamp[s].smp,mdlsamp[s].samplen,mdlsamp[s].samplen>>1,XModule::ST_16BIT))
 							{
 								if (mdlins) delete[] mdlins;
 								if (mdlsamp) delete[] mdlsamp;
@@ -443,7 +446,7 @@ mp_sint32 LoaderMDL::load(XMFileBase& f, XModule* module)
 							return MP_OUT_OF_MEMORY;
 						}
 						
-						if (!module->loadSample(f,mdlsamp[s].smp,size,mdlsamp[s].samplen,XModule::ST_PACKING_MDL))
+						if (!module->queueSample(f,mdlsamp[s].smp,size,mdlsamp[s].samplen,XModule::ST_PACKING_MDL))
 						{
 							if (mdlins) delete[] mdlins;
 							if (mdlsamp) delete[] mdlsamp;
@@ -474,7 +477,7 @@ mp_sint32 LoaderMDL::load(XMFileBase& f, XModule* module)
 						//mp_uint32 loopstart = mdlsamp[s].loopstart>>1;
 						//mp_uint32 looplen = mdlsamp[s].looplen>>1;
 						
-						if (!module->loadSample(f,mdlsamp[s].smp,size,samplen,XModule::ST_PACKING_MDL | XModule::ST_16BIT))
+						if (!module->queueSample(f,mdlsamp[s].smp,size,samplen,XModule::ST_PACKING_MDL | XModule::ST_16BIT))
 						{
 							if (mdlins) delete[] mdlins;
 							if (mdlsamp) delete[] mdlsamp;
@@ -487,6 +490,16 @@ mp_sint32 LoaderMDL::load(XMFileBase& f, XModule* module)
 					}; break;
 				}
 			}
+			
+			if (!module->finishSampleBatch())
+			{
+				if (mdlins) delete[] mdlins;
+				if (mdlsamp) delete[] mdlsamp;
+				if (trackseq) delete[] trackseq;
+				if (tracks) delete[] tracks;
+				
+				return MP_OUT_OF_MEMORY;
+			}
 		}
 		else if (!memcmp(&blockhead,"VE",2)) {
 			mp_uint32 numenvs = f.readByte();
@@ -434,6 +434,9 @@ mp_sint32 LoaderMOD::load(XMFileBase& f, XModule* module)
 	}
 	delete[] buffer;
 
+	// sample data is decoded in parallel after the loop
+	module->beginSampleBatch();
+
 	for (i=0; i < header->smpnum; i++)
 	{
 		// MAGIC
@@ -474,6 +477,9 @@ mp_sint32 LoaderMOD::load(XMFileBase& f, XModule* module)
 			return result;
 	}
 
+	if (!module->finishSampleBatch())
+		return MP_OUT_OF_MEMORY;
+
 	header->speed=125;
 	header->tempo=6;
 	header->mainvol=255;
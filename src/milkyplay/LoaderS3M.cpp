@@ -684,6 +684,9 @@ mp_sint32 LoaderS3M::load(XMFileBase& f, XModule* module)
 	delete[] insParaPtrs;
 	delete[] patParaPtrs;
 	
+	// sample data is decoded in parallel after the loop
+	module->beginSampleBatch();
+
 	s = 0;
 	for (i = 0; i < header->insnum; i++)
 	{
@@ -719,6 +722,9 @@ mp_sint32 LoaderS3M::load(XMFileBase& f, XModule* module)
 	
 	delete[] samplePtrs;
 	
+	if (!module->finishSampleBatch())
+		return MP_OUT_OF_MEMORY;
+	
 	header->smpnum = s;
 	
 	strcpy(header->tracker,"Screamtracker 3");
@@ -467,6 +467,9 @@ mp_sint32 LoaderXM::load(XMFileBase& f, XModule* module)
 
 	}
 
+	// sample data is queued and decoded in parallel once all instruments are read
+	module->beginSampleBatch();
+
 	if (header->ver == 0x104)
 	{
 		mp_sint32 s = 0;
@@ -811,6 +814,9 @@ mp_sint32 LoaderXM::load(XMFileBase& f, XModule* module)
 		}
 	}
 
+	if (!module->finishSampleBatch())
+		return MP_OUT_OF_MEMORY;
+
 	// convert modplug stereo samples
 	for (mp_sint32 s = 0; s < header->smpnum; s++)
 	{
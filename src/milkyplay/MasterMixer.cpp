@@ -52,6 +52,7 @@ MasterMixer::MasterMixer(mp_uint32 sampleRate,
 	listener(0),
 	sampleRate(sampleRate),
 	bufferSize(bufferSize),
+	renderAhead(0),
 	buffer(0),
 	sampleShift(0),
 	disableMixing(false),
@@ -120,6 +121,10 @@ mp_sint32 MasterMixer::openAudioDevice()
 		notifyListener(MasterMixerNotificationSampleRateChanged);
 	}
 
+	// falls back to mixing in the device callback if not supported
+	if (renderAhead)
+		audioDriver->setRenderAhead(renderAhead);
+
 	initialized = true;
 	return 0;
 }
@@ -135,6 +140,9 @@ mp_sint32 MasterMixer::closeAudioDevice()
 	mp_sint32 res = 0;
 	if (audioDriver)
 	{
+		// stop the render thread before the device goes away
+		audioDriver->setRenderAhead(0);
+
 		res = audioDriver->closeDevice();
 		if (res == 0)
 			initialized = false;
@@ -226,6 +234,19 @@ mp_sint32 MasterMixer::setSampleRate(mp_uint32 sampleRate)
 	return 0;
 }
 
+mp_sint32 MasterMixer::setRenderAhead(mp_uint32 numPeriods)
+{
+	if (numPeriods != renderAhead)
+	{
+		mp_sint32 res = closeAudioDevice();
+		if (res != 0)
+			return res;
+
+		renderAhead = numPeriods;
+	}
+	return 0;
+}
+
 bool MasterMixer::addDevice(Mixable* device, bool paused/* = false*/)
 {
 	for (mp_uint32 i = 0; i < numDevices; i++)
@@ -88,6 +88,11 @@ public:
 	mp_sint32 setSampleRate(mp_uint32 sampleRate);
 	mp_uint32 getSampleRate() const { return sampleRate; }
 
+	// Mix numPeriods buffers ahead on a separate render thread if the audio
+	// driver supports it (0 = mix in the device callback)
+	mp_sint32 setRenderAhead(mp_uint32 numPeriods);
+	mp_uint32 getRenderAhead() const { return renderAhead; }
+
 	bool addDevice(Mixable* device, bool paused = false);
 	bool removeDevice(Mixable* device, bool blocking = true);
 	bool isDeviceRemoved(Mixable* device);
@@ -124,6 +129,7 @@ private:
 	MasterMixerNotificationListener* listener;
 	mp_uint32 sampleRate;
 	mp_uint32 bufferSize;
+	mp_uint32 renderAhead;
 	mp_sint32* buffer;
 	mp_uint32 sampleShift;
 	bool disableMixing;
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  MilkyPlayAtomic.h
+ *  MilkyPlay
+ *
+ *  Minimal acquire/release access to 32 bit values shared between exactly
+ *  one writer and any number of readers on other threads (e.g. the indices
+ *  of a single producer/single consumer ring buffer), plus the two read-
+ *  modify-write operations needed when there is more than one writer.
+ *  Targets without threads or compiler support fall back to volatile
+ *  accesses.
+ */
+#ifndef __MILKYPLAYATOMIC_H__
+#define __MILKYPLAYATOMIC_H__
+
+#include "MilkyPlayTypes.h"
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+	#define __MP_ATOMIC_GCC__
+#elif defined(__GNUC__)
+	#define __MP_ATOMIC_SYNC__
+#elif defined(_MSC_VER)
+	#define __MP_ATOMIC_MSVC__
+	#include <windows.h>
+#endif
+
+// read a value published by another thread, later reads can't move before it
+static inline mp_uint32 atomicLoadAcquire(const volatile mp_uint32* value)
+{
+#if defined(__MP_ATOMIC_GCC__)
+	return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#elif defined(__MP_ATOMIC_SYNC__)
+	const mp_uint32 result = *value;
+	__sync_synchronize();
+	return result;
+#elif defined(__MP_ATOMIC_MSVC__)
+	const mp_uint32 result = *value;
+	MemoryBarrier();
+	return result;
+#else
+	return *value;
+#endif
+}
+
+// publish a value, earlier writes can't move after it
+static inline void atomicStoreRelease(volatile mp_uint32* value, mp_uint32 newValue)
+{
+#if defined(__MP_ATOMIC_GCC__)
+	__atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+#elif defined(__MP_ATOMIC_SYNC__)
+	__sync_synchronize();
+	*value = newValue;
+#elif defined(__MP_ATOMIC_MSVC__)
+	MemoryBarrier();
+	*value = newValue;
+#else
+	*value = newValue;
+#endif
+}
+
+// full barrier, no reads or writes can move across it in either direction
+static inline void atomicThreadFence()
+{
+#if defined(__MP_ATOMIC_GCC__)
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+#elif defined(__MP_ATOMIC_SYNC__)
+	__sync_synchronize();
+#elif defined(__MP_ATOMIC_MSVC__)
+	MemoryBarrier();
+#endif
+}
+
+// add to a value, returns the previous value (full barrier)
+static inline mp_uint32 atomicFetchAdd(volatile mp_uint32* value, mp_uint32 add)
+{
+#if defined(__MP_ATOMIC_GCC__)
+	return __atomic_fetch_add(value, add, __ATOMIC_SEQ_CST);
+#elif defined(__MP_ATOMIC_SYNC__)
+	return __sync_fetch_and_add(value, add);
+#elif defined(__MP_ATOMIC_MSVC__)
+	return (mp_uint32)InterlockedExchangeAdd((volatile LONG*)value, (LONG)add);
+#else
+	const mp_uint32 result = *value;
+	*value = result + add;
+	return result;
+#endif
+}
+
+// replace a value if it still is the expected one, returns true if it was
+// replaced (full barrier)
+static inline bool atomicCompareExchange(volatile mp_uint32* value, mp_uint32 expected, mp_uint32 newValue)
+{
+#if defined(__MP_ATOMIC_GCC__)
+	return __atomic_compare_exchange_n(value, &expected, newValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#elif defined(__MP_ATOMIC_SYNC__)
+	return __sync_bool_compare_and_swap(value, expected, newValue);
+#elif defined(__MP_ATOMIC_MSVC__)
+	return (mp_uint32)InterlockedCompareExchange((volatile LONG*)value, (LONG)newValue, (LONG)expected) == expected;
+#else
+	if (*value != expected)
+		return false;
+	*value = newValue;
+	return true;
+#endif
+}
+
+#endif
@@ -72,11 +72,14 @@
 	typedef HANDLE FHANDLE;
 #ifdef __GNUWIN32__
 	typedef long long mp_int64;
+	typedef unsigned long long mp_uint64;
 #else
 	typedef __int64 mp_int64;
+	typedef unsigned __int64 mp_uint64;
 #endif
 #else
 	typedef long long mp_int64;
+	typedef unsigned long long mp_uint64;
 	typedef char SYSCHAR;
 	typedef FILE* FHANDLE;
 #endif
@@ -89,6 +92,50 @@
 
 #define MP_NUMEFFECTS 4
 
+// Forward loops shorter than this are repeated into the trailing sample
+// padding until they're at least this long (see TXMSample::unrollLoop), so
+// the mixer doesn't have to wrap around the loop every few output samples
+#define MP_UNROLLEDLOOP_MINLENGTH 256
+
+// Offset of the unrolled loop header from the end of the sample data in
+// bytes, the padding before it belongs to the loop double buffering
+#define MP_UNROLLEDLOOP_HEADEROFFSET 16
+
+// Samples after the unrolled loop which continue it
+#define MP_UNROLLEDLOOP_LEADOUT 4
+
+// Describes the copy, the mixer only uses it for the very loop it was made of
+struct TUnrolledLoopHeader
+{
+	mp_sint32 loopstart;
+	mp_sint32 looplen;
+	// 1 = forward, 0 = no copy
+	mp_sint32 looptype;
+	// length of the copy, a multiple of the loop length
+	mp_sint32 length;
+	// the sample before the loop equals the last one of the loop, so
+	// resamplers reading behind the position see the very same values
+	// when wrapping around in the copy as in the original loop
+	mp_sint32 seamless;
+};
+
+// Length of the unrolled loop (always a multiple of the loop length)
+// or 0 if a loop of that length is not unrolled
+static inline mp_sint32 getUnrolledLoopLength(mp_sint32 looplen)
+{
+	if (looplen <= 0 || looplen >= MP_UNROLLEDLOOP_MINLENGTH)
+		return 0;
+	return ((MP_UNROLLEDLOOP_MINLENGTH + looplen - 1) / looplen) * looplen;
+}
+
+// Index of the first unrolled sample, the copy is preceded by one
+// sample of lead in and followed by MP_UNROLLEDLOOP_LEADOUT samples
+static inline mp_sint32 getUnrolledLoopStart(mp_sint32 samplen, bool is16Bit)
+{
+	const mp_sint32 offset = MP_UNROLLEDLOOP_HEADEROFFSET + sizeof(TUnrolledLoopHeader);
+	return samplen + (is16Bit ? offset / 2 : offset) + 1;
+}
+
 #if (defined(WIN32) || defined(_WIN32_WCE)) && !defined(__FORCE_SDL_AUDIO__)
 	#define DRIVER_WIN32
 #elif defined(__APPLE__) && !defined(__FORCE_SDL_AUDIO__)
@@ -35,7 +35,9 @@
 #include <stdio.h>
 
 MixerProxy::MixerProxy(mp_uint32 numChannels, ProxyProcessor * processor)
-: numChannels(numChannels)
+: numChannels(numChannels),
+  bufferSize(0),
+  sampleShift(0)
 {
     buffers = new void* [numChannels];
     memset(buffers, 0, numChannels * sizeof(void *));
@@ -108,3 +110,90 @@ bool MixerProxyHardwareOut::lock(mp_uint32 bufferSize, mp_uint32 sampleShift)
 {
     return true;
 }
+
+MixerProxyStems::MixerProxyStems(mp_uint32 numChannels, ProxyProcessor * processor)
+: MixerProxy(numChannels, processor)
+{
+    stemBuffers = new mp_sword* [numChannels];
+    memset(stemBuffers, 0, numChannels * sizeof(mp_sword *));
+
+    enabled = new bool[numChannels];
+    for (mp_uint32 i = 0; i < numChannels; i++)
+        enabled[i] = true;
+}
+
+MixerProxyStems::~MixerProxyStems()
+{
+    freeBuffers();
+
+    delete[] stemBuffers;
+    delete[] enabled;
+}
+
+void MixerProxyStems::freeBuffer(mp_uint32 idx)
+{
+    deleteBuffer<mp_sint32>(idx);
+    setBuffer<mp_sint32>(idx, NULL);
+
+    delete[] stemBuffers[idx];
+    stemBuffers[idx] = NULL;
+}
+
+void MixerProxyStems::freeBuffers()
+{
+    for (mp_uint32 i = 0; i < numChannels; i++)
+        freeBuffer(i);
+}
+
+bool MixerProxyStems::lock(mp_uint32 bufferSize, mp_uint32 sampleShift)
+{
+    if(this->bufferSize != bufferSize)
+        freeBuffers();
+
+    MixerProxy::lock(bufferSize, sampleShift);
+
+    for (mp_uint32 i = 0; i < numChannels; i++) {
+        // disabled stems have a NULL buffer which tells the mixer to skip them
+        if (!enabled[i]) {
+            if (buffers[i])
+                freeBuffer(i);
+            continue;
+        }
+
+        if (!buffers[i]) {
+            setBuffer<mp_sint32>(i, new mp_sint32[bufferSize * MP_NUMCHANNELS]);
+            stemBuffers[i] = new mp_sword[bufferSize * MP_NUMCHANNELS];
+        }
+
+        clearBuffer<mp_sint32>(i, bufferSize * MP_NUMCHANNELS);
+    }
+
+    return true;
+}
+
+void MixerProxyStems::unlock(Mixable * filterHook)
+{
+	// filter hooks expect a single mix-down buffer, there is none here
+
+	const mp_sint32 sampleShift = this->sampleShift;
+	const mp_sint32 lowerBound = -((128<<sampleShift)*256);
+	const mp_sint32 upperBound = ((128<<sampleShift)*256)-1;
+	const mp_sint32 bufferSize = this->bufferSize * MP_NUMCHANNELS;
+
+	for (mp_uint32 c = 0; c < numChannels; c++) {
+		const mp_sint32 * bufferIn = getBuffer<mp_sint32>(c);
+		mp_sword * bufferOut = stemBuffers[c];
+
+		if (!bufferIn)
+			continue;
+
+		for (mp_sint32 i = 0; i < bufferSize; i++) {
+			mp_sint32 b = *bufferIn++;
+
+			if (b>upperBound) b = upperBound;
+			else if (b<lowerBound) b = lowerBound;
+
+			*bufferOut++ = b>>sampleShift;
+		}
+	}
+}
@@ -50,7 +50,8 @@ public:
 	enum ProcessingType {
 		MixDown,
 		DirectOut,
-		HardwareOut
+		HardwareOut,
+		Stems
 	};
 
 protected:
@@ -141,4 +142,33 @@ public:
 	virtual ~MixerProxyHardwareOut() {}
 };
 
+//
+// Mixes every mixer channel into a stereo buffer of its own, used for
+// rendering multi-track stems in one pass. Slot i holds the 32 bit mix
+// buffer of channel i, the clipped 16 bit result is available through
+// getStemBuffer(i) after unlock(). Stems which are disabled (see enableStem)
+// are not mixed at all.
+//
+class MixerProxyStems : public MixerProxy
+{
+private:
+	mp_sword**				stemBuffers;
+	bool*					enabled;
+
+	void					freeBuffer(mp_uint32 idx);
+	void					freeBuffers();
+
+public:
+	void					enableStem(mp_uint32 idx, bool enable) { enabled[idx] = enable; }
+	bool					isStemEnabled(mp_uint32 idx) const { return enabled[idx]; }
+	const mp_sword*			getStemBuffer(mp_uint32 idx) const { return stemBuffers[idx]; }
+
+	virtual bool 			lock(mp_uint32 bufferSize, mp_uint32 sampleShift);
+	virtual void 			unlock(Mixable * filterHook);
+	virtual ProcessingType	getProcessingType() const { return Stems; }
+
+	MixerProxyStems(mp_uint32 numChannels, ProxyProcessor * processor = 0);
+	virtual ~MixerProxyStems();
+};
+
 #endif
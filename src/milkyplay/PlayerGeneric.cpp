@@ -41,6 +41,7 @@
 #include "XModule.h"
 #include "AudioDriver_WAVWriter.h"
 #include "AudioDriverManager.h"
+#include "MilkyPlayAtomic.h"
 #include "PlayerBase.h"
 #include "PlayerSTD.h"
 #ifndef MILKYTRACKER
@@ -169,6 +170,8 @@ PlayerGeneric::PlayerGeneric(mp_sint32 frequency, AudioDriverInterface* audioDri
 	sampleShift = 0;
 
 	resamplerType = MIXER_NORMAL;
+	numMixerThreads = MIXERTHREADS_DEFAULT;
+	exportProgress = NULL;
 
 	idle = false;
 	playOneRowOnly = false;
@@ -178,6 +181,8 @@ PlayerGeneric::PlayerGeneric(mp_sint32 frequency, AudioDriverInterface* audioDri
 	autoAdjustPeak = false;
 	disableMixing = false;
 	allowFilters = false;
+	filterSmoothing = false;
+	loopUnrolling = false;
 #ifdef __FORCEPOWEROFTWOBUFFERSIZE__
 	compensateBufferFlag = true;
 #else
@@ -256,6 +261,21 @@ ChannelMixer::ResamplerTypes PlayerGeneric::getResamplerType() const
 	return resamplerType;
 }
 
+void PlayerGeneric::setNumMixerThreads(mp_uint32 num)
+{
+	numMixerThreads = num;
+	if (player)
+		player->setNumMixerThreads(num);
+}
+
+mp_uint32 PlayerGeneric::getNumMixerThreads() const
+{
+	if (player)
+		return player->getNumMixerThreads();
+
+	return numMixerThreads;
+}
+
 void PlayerGeneric::setSampleShift(mp_sint32 shift)
 {
 	sampleShift = shift;
@@ -570,6 +590,7 @@ mp_sint32 PlayerGeneric::startPlaying(XModule* module,
 			player->resetOnStop(resetOnStopFlag);
 			player->setBufferSize(bufferSize);
 			player->setResamplerType(resamplerType);
+			player->setNumMixerThreads(numMixerThreads);
 			player->setMasterVolume(masterVolume);
 			player->setPanningSeparation(panningSeparation);
 			player->setPlayMode(playMode);
@@ -579,6 +600,8 @@ mp_sint32 PlayerGeneric::startPlaying(XModule* module,
 
 			player->setDisableMixing(disableMixing);
 			player->setAllowFilters(allowFilters);
+			player->setFilterSmoothing(filterSmoothing);
+			player->setLoopUnrolling(loopUnrolling);
 			//if (paused)
 			//	player->pausePlaying();
 
@@ -713,6 +736,38 @@ bool PlayerGeneric::getAllowFilters() const
 	return allowFilters;
 }
 
+void PlayerGeneric::setFilterSmoothing(bool b)
+{
+	filterSmoothing = b;
+
+	if (player)
+		player->setFilterSmoothing(filterSmoothing);
+}
+
+bool PlayerGeneric::getFilterSmoothing() const
+{
+	if (player)
+		return player->getFilterSmoothing();
+
+	return filterSmoothing;
+}
+
+void PlayerGeneric::setLoopUnrolling(bool b)
+{
+	loopUnrolling = b;
+
+	if (player)
+		player->setLoopUnrolling(loopUnrolling);
+}
+
+bool PlayerGeneric::getLoopUnrolling() const
+{
+	if (player)
+		return player->getLoopUnrolling();
+
+	return loopUnrolling;
+}
+
 // volume control
 void PlayerGeneric::setMasterVolume(mp_sint32 vol)
 {
@@ -959,10 +1014,13 @@ mp_sint32 PlayerGeneric::exportToWAV(const SYSCHAR* fileName, XModule* module,
 		player->resetOnStop(resetOnStopFlag);
 		player->setBufferSize(bufferSize);
 		player->setResamplerType(resamplerType);
+		player->setNumMixerThreads(numMixerThreads);
 		player->setMasterVolume(masterVolume);
 		player->setPlayMode(playMode);
 		player->setDisableMixing(disableMixing);
 		player->setAllowFilters(allowFilters);
+		player->setFilterSmoothing(filterSmoothing);
+		player->setLoopUnrolling(loopUnrolling);
 #ifndef MILKYTRACKER
 		if (player->getType() == PlayerBase::PlayerType_IT)
 		{
@@ -996,6 +1054,9 @@ mp_sint32 PlayerGeneric::exportToWAV(const SYSCHAR* fileName, XModule* module,
 		timingLUT[curOrderPos] = 0;
 	}
 
+	if (exportProgress)
+		atomicStoreRelease(exportProgress, curOrderPos);
+
 	while (!player->hasSongHalted() && player->getOrder(0) <= endOrder)
 	{
 		wavWriter->advance();
@@ -1008,6 +1069,8 @@ mp_sint32 PlayerGeneric::exportToWAV(const SYSCHAR* fileName, XModule* module,
 			curOrderPos = player->getOrder(0);
 			if (timingLUT && curOrderPos < module->header.ordnum && timingLUT[curOrderPos] == -1)
 				timingLUT[curOrderPos] = wavWriter->getNumPlayedSamples();
+			if (exportProgress)
+				atomicStoreRelease(exportProgress, curOrderPos);
 		}
 	}
 
@@ -1035,6 +1098,33 @@ mp_sint32 PlayerGeneric::exportToWAV(const SYSCHAR* fileName, XModule* module,
 	return numWrittenSamples;
 }
 
+// export every channel to a 16bit stereo WAV of its own in one pass
+mp_sint32 PlayerGeneric::exportStemsToWAV(const SYSCHAR* const* fileNames, XModule* module,
+										  mp_sint32 startOrder/* = 0*/, mp_sint32 endOrder/* = -1*/,
+										  const mp_ubyte* customPanningTable/* = NULL*/)
+{
+	WAVStemWriter stemWriter(fileNames, module->header.channum);
+
+	if (!stemWriter.isOpen())
+		return MP_DEVICE_ERROR;
+
+	return exportToWAV(NULL, module, startOrder, endOrder, NULL, 0, customPanningTable, &stemWriter);
+}
+
+// export all channels into one multichannel 16bit WAV in one pass
+mp_sint32 PlayerGeneric::exportStemsToMultiChannelWAV(const SYSCHAR* fileName, XModule* module,
+													  mp_sint32 startOrder/* = 0*/, mp_sint32 endOrder/* = -1*/,
+													  const mp_ubyte* mutingArray/* = NULL*/,
+													  const mp_ubyte* customPanningTable/* = NULL*/)
+{
+	WAVStemWriter stemWriter(fileName, module->header.channum, mutingArray);
+
+	if (!stemWriter.isOpen())
+		return MP_DEVICE_ERROR;
+
+	return exportToWAV(NULL, module, startOrder, endOrder, NULL, 0, customPanningTable, &stemWriter);
+}
+
 bool PlayerGeneric::grabChannelInfo(mp_sint32 chn, TPlayerChannelInfo& channelInfo) const
 {
 	if (player)
@@ -85,6 +85,10 @@ private:
 	bool				disableMixing;
 	// remember if filters are allowed
 	bool				allowFilters;
+	// remember if filter coefficients are smoothed
+	bool				filterSmoothing;
+	// remember if short loops are unrolled
+	bool				loopUnrolling;
 	// remember idle state
 	bool				idle;
 	// remember to play only one row
@@ -103,6 +107,10 @@ private:
 	mp_sint32			panningSeparation;
 	// remember maximum amount of virtual channels
 	mp_sint32			numMaxVirChannels;
+	// remember number of mixer threads
+	mp_uint32			numMixerThreads;
+	// exportToWAV publishes the order it is rendering here
+	volatile mp_uint32*	exportProgress;
 
 	void				adjustSettings();
 
@@ -158,6 +166,22 @@ public:
 	 */
 	ChannelMixer::ResamplerTypes	getResamplerType() const;
 
+	/**
+	 * Specify how many threads are used for mixing the channels
+	 * Values of 0 or 1 mix serially on the calling thread, the output is
+	 * bit identical regardless of the number of threads
+	 * @param  num		number of mixer threads
+	 * @see				MixerSettings
+	 */
+	void				setNumMixerThreads(mp_uint32 num);
+
+	/**
+	 * Get the number of mixer threads
+	 * @return			number of mixer threads
+	 * @see				setNumMixerThreads
+	 */
+	mp_uint32			getNumMixerThreads() const;
+
 	/**
 	 * Specify the amount of which the sample data is right-shifted before sent to the sound driver
 	 * This is an amplify in the opposite direction (shift value of 2 means 25% of the original volume)
@@ -494,6 +518,36 @@ public:
 	 */
 	bool				getAllowFilters() const;
 
+	/**
+	 * Smooth filter changes.
+	 * Filter coefficients are interpolated per sample instead of
+	 * being changed at tick boundaries, costs a little CPU power.
+	 * @param  b		true or false
+	 */
+	void				setFilterSmoothing(bool b);
+
+	/**
+	 * Tell if filter changes are smoothed.
+	 * @return			true if filter smoothing is enabled.
+	 * @see				setFilterSmoothing
+	 */
+	bool				getFilterSmoothing() const;
+
+	/**
+	 * Mix short sample loops from copies unrolled into the sample padding.
+	 * Saves CPU power on chip style samples without changing the output,
+	 * ping pong loops are never unrolled.
+	 * @param  b		true or false
+	 */
+	void				setLoopUnrolling(bool b);
+
+	/**
+	 * Tell if short loops are unrolled.
+	 * @return			true if loop unrolling is enabled.
+	 * @see				setLoopUnrolling
+	 */
+	bool				getLoopUnrolling() const;
+
 	/**
 	 * Set master volume for the mixer
 	 * @param  vol		Master volume between 0 and 256
@@ -617,6 +671,14 @@ public:
 	 */
 	void				resetMainVolumeOnStartPlay(bool b);
 
+	/**
+	 * Let exportToWAV publish the order position it is currently rendering,
+	 * the value is written with release semantics and can be polled from
+	 * another thread (see MilkyPlayAtomic.h)
+	 * @param  orderPosition		where to store the order position, NULL = don't publish
+	 */
+	void				setExportProgress(volatile mp_uint32* orderPosition) { exportProgress = orderPosition; }
+
 	/**
 	 * Export the song as WAV file
 	 * @param  fileName				the path and the filename to export to
@@ -639,6 +701,36 @@ public:
 									AudioDriverBase* preferredDriver = NULL,
 									mp_sint32* timingLUT = NULL);
 
+	/**
+	 * Export every channel of the song into a stereo WAV file of its own,
+	 * the song is played only once for all channels
+	 * @param  fileNames			one file name per module channel, channels with a NULL file name are skipped
+	 * @param  module				the module to export
+	 * @param  startOrder			the start position within the order list of the song
+	 * @param  endOrder				the last order to be played
+	 * @param  customPanningTable	When specifying a custom panning table the panning default from the module is ignored
+	 */
+	mp_sint32			exportStemsToWAV(const SYSCHAR* const* fileNames,
+										 XModule* module,
+										 mp_sint32 startOrder = 0, mp_sint32 endOrder = -1,
+										 const mp_ubyte* customPanningTable = NULL);
+
+	/**
+	 * Export every channel of the song into a single multichannel WAV file,
+	 * each channel becomes a stereo pair of the WAV file
+	 * @param  fileName				the path and the filename to export to
+	 * @param  module				the module to export
+	 * @param  startOrder			the start position within the order list of the song
+	 * @param  endOrder				the last order to be played
+	 * @param  mutingArray			optional: an array telling which channels to leave out (module->header.channum entries)
+	 * @param  customPanningTable	When specifying a custom panning table the panning default from the module is ignored
+	 */
+	mp_sint32			exportStemsToMultiChannelWAV(const SYSCHAR* fileName,
+													 XModule* module,
+													 mp_sint32 startOrder = 0, mp_sint32 endOrder = -1,
+													 const mp_ubyte* mutingArray = NULL,
+													 const mp_ubyte* customPanningTable = NULL);
+
 	/**
 	 * Grab current channel data from a module channel
 	 * @param  chn					the channel index to grab the data from
@@ -286,6 +286,9 @@ PlayerIT::PlayerIT(mp_uint32 frequency) :
 	chninfo		= NULL;
 	vchninfo	= NULL;
 	attick		= NULL;	
+	envBatch	= NULL;
+	envStride	= 0;
+	envChannel	= -1;
 	// fill in some default values, don't know if this is necessary
 
 	tickSpeed			= 6;				// our tickspeed
@@ -444,6 +447,14 @@ mp_sint32 PlayerIT::allocateStructures()
 	chninfo			= new TModuleChannel[numModuleChannels];
 	vchninfo		= new TVirtualChannel[numVirtualChannels];
 	attick			= new mp_ubyte[numModuleChannels];
+
+	const mp_sint32 envSize = NUMENVELOPES*numVirtualChannels;
+	envBatch		= new mp_sint32[envSize*5];
+	envDist			= envBatch;
+	envDelta		= envBatch + envSize;
+	envY0			= envBatch + envSize*2;
+	envY1			= envBatch + envSize*3;
+	envValue		= envBatch + envSize*4;
 	return MP_OK;
 }
 
@@ -464,6 +475,11 @@ void PlayerIT::freeMemory()
 		delete[] attick; 
 		attick = NULL; 
 	}
+	if (envBatch)
+	{
+		delete[] envBatch;
+		envBatch = NULL;
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -942,6 +958,60 @@ mp_sint32 PlayerIT::getenvval(TPrEnv *env,mp_sint32 n)
 	return n;
 }
 
+void PlayerIT::gatherEnvelope(mp_sint32 i, TPrEnv& env, mp_sint32 n)
+{
+	if (env.isEnabled()) 
+	{
+		mp_sint32 step = env.step;
+		if (step > env.envstruc->env[env.b][0])
+			step = env.envstruc->env[env.b][0];
+		mp_sint32 dx = (env.envstruc->env[env.b][0]-env.envstruc->env[env.a][0]);
+		if (dx==0) dx=1;
+		envDist[i] = env.envstruc->env[env.b][0]-step;
+		envDelta[i] = dx;
+		envY0[i] = env.envstruc->env[env.a][1];
+		envY1[i] = env.envstruc->env[env.b][1];
+	}
+	// zero distance interpolates to y1
+	else
+	{
+		envDist[i] = 0;
+		envDelta[i] = 1;
+		envY0[i] = envY1[i] = n;
+	}
+}
+
+// getenvval() for all envelopes of the first numChannels virtual channels
+void PlayerIT::evaluateEnvelopes(mp_sint32 numChannels)
+{
+	envStride = numChannels;
+
+	TVirtualChannel* chn = vchninfo;
+	for (mp_sint32 c = 0; c < numChannels; c++, chn++)
+	{
+		// the pitch envelope is read as filter envelope (default 256)
+		// or as pitch envelope (default 128) depending on its type
+		const mp_sint32 pitchDefault = (chn->getPitchenv().envstruc != NULL &&
+										(chn->getPitchenv().envstruc->type & 128)) ? 256 : 128;
+
+		gatherEnvelope(ENVELOPE_VOLUME*numChannels+c, chn->getVenv(), 256);
+		gatherEnvelope(ENVELOPE_PANNING*numChannels+c, chn->getPenv(), 128);
+		gatherEnvelope(ENVELOPE_FREQUENCY*numChannels+c, chn->getFenv(), 128);
+		gatherEnvelope(ENVELOPE_VIBRATO*numChannels+c, chn->getVibenv(), 128);
+		gatherEnvelope(ENVELOPE_PITCH*numChannels+c, chn->getPitchenv(), pitchDefault);
+	}
+
+	// branch free interpolation, the integer division is carried out in double
+	// precision, which gives the exact quotient for operands of this size
+	const mp_sint32 num = NUMENVELOPES*numChannels;
+	for (mp_sint32 i = 0; i < num; i++)
+	{
+		const mp_sint32 t = (mp_sint32)((double)(envDist[i]*65536) / (double)envDelta[i]);
+		const mp_sint32 y = (envY0[i]*t)+(envY1[i]*(65536-t));
+		envValue[i] = y>>16;
+	}
+}
+
 mp_sint32 PlayerIT::getFinalPeriod(TChnState& state, mp_sint32 p) 
 {
 	mp_sint32 envVib = 0;
@@ -949,7 +1019,7 @@ mp_sint32 PlayerIT::getFinalPeriod(TChnState& state, mp_sint32 p)
 
 	if (state.vibenv.isEnabled())
 	{
-		mp_sint32 eval = (getenvval(&state.vibenv,128)-128) << (state.vibenv.envstruc->type>>6);
+		mp_sint32 eval = (getchnenvval(ENVELOPE_VIBRATO,&state.vibenv,128)-128) << (state.vibenv.envstruc->type>>6);
 		// AMS doc says vibrato with amplify set to 8 equals vibrato 0xF
 		// => alright
 		envVib = (eval*61408)>>(3+16-8);
@@ -2791,7 +2861,10 @@ void PlayerIT::doTickeffects()
 	{
 		for (mp_sint32 effcnt = 0; effcnt < numEffects; effcnt++) 
 		{
-			doTickEffect(chnInf, effcnt);
+			// empty effect slots don't do anything on ticks, most of them
+			// are empty so don't pay for the call
+			if (chnInf->eff[effcnt])
+				doTickEffect(chnInf, effcnt);
 		}
 	}
 }
@@ -3329,6 +3402,11 @@ void PlayerIT::update()
 	
 	TVirtualChannel* chn = vchninfo;
 	const mp_sint32 curMaxVirChannels = this->curMaxVirChannels;
+
+	// channels only advance their own envelopes after reading them,
+	// so this tick's values of all channels can be computed up front
+	evaluateEnvelopes(curMaxVirChannels);
+
 	for (c = 0; c < curMaxVirChannels; c++, chn++) 
 	{
 		if (!chn->getActive())
@@ -3337,6 +3415,8 @@ void PlayerIT::update()
 		if (chn->isFlagSet(CHANNEL_FLAGS_UPDATE_IGNORE))
 			continue;
 
+		envChannel = c;
+
 		const mp_sint32 ins = chn->getIns();
 		bool ITEnvelopes = (ins && ins <= module->header.insnum) ? (module->instr[ins-1].flags & TXMInstrument::IF_ITENVELOPES) : false;
 
@@ -3423,6 +3503,8 @@ void PlayerIT::update()
 		}
 	}
 
+	envChannel = -1;
+
 	adjustVirtualChannels();
 
 }
@@ -3844,6 +3926,19 @@ void PlayerIT::halt()
 		resetChannelsWithoutMuting();
 }
 
+mp_sint32 PlayerIT::getLogicalChannel(mp_uint32 mixerChannel)
+{
+	if (vchninfo == NULL || chninfo == NULL || (mp_sint32)mixerChannel >= numVirtualChannels)
+		return -1;
+	
+	// a virtual channel in the background (NNA) still belongs
+	// to the module channel which started it
+	TVirtualChannel* vchn = &vchninfo[mixerChannel];
+	TModuleChannel* host = vchn->getHost() ? vchn->getHost() : vchn->getOldHost();
+	
+	return host ? (mp_sint32)(host - chninfo) : -1;
+}
+
 bool PlayerIT::grabChannelInfo(mp_sint32 chn, TPlayerChannelInfo& channelInfo) const
 {
 	channelInfo.note = chninfo[chn].currentnote;
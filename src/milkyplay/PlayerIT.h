@@ -466,6 +466,28 @@ private:
 	TVirtualChannel *vchninfo;				// our virtual channels
 	
 	mp_ubyte		*attick;
+
+	// envelope values of all virtual channels for the current tick, interpolated
+	// in one pass by evaluateEnvelopes() and kept as structure of arrays so the
+	// interpolation loop vectorizes, entry e*envStride+c is envelope e of channel c
+	enum
+	{
+		ENVELOPE_VOLUME,
+		ENVELOPE_PANNING,
+		ENVELOPE_FREQUENCY,
+		ENVELOPE_VIBRATO,
+		ENVELOPE_PITCH,
+		NUMENVELOPES
+	};
+
+	mp_sint32		*envBatch;				// holds all of the arrays below
+	mp_sint32		*envDist;				// distance from the current position to the next point
+	mp_sint32		*envDelta;				// length of the current segment
+	mp_sint32		*envY0;
+	mp_sint32		*envY1;
+	mp_sint32		*envValue;
+	mp_sint32		envStride;
+	mp_sint32		envChannel;				// virtual channel the getFinal* functions take envValue of, -1 if none
 	
 	mp_sint32		patternIndex;			// holds current pattern index
 	mp_sint32		numModuleChannels;		// max number of "host" channels (from module header)
@@ -537,6 +559,19 @@ private:
 	
 	static mp_sint32	getenvval(TPrEnv* env, mp_sint32 n);					// get envelope value
 
+	// envelope value from the batch while update() refreshes a channel,
+	// debug builds check it against evaluating the envelope on its own
+	mp_sint32			getchnenvval(mp_sint32 e, TPrEnv* env, mp_sint32 n)
+	{
+		if (envChannel < 0)
+			return getenvval(env,n);
+		ASSERT(envValue[e*envStride+envChannel] == getenvval(env,n));
+		return envValue[e*envStride+envChannel];
+	}
+
+	void				gatherEnvelope(mp_sint32 i, TPrEnv& env, mp_sint32 n);
+	void				evaluateEnvelopes(mp_sint32 numChannels);
+
 	static mp_sint32	interpolate(mp_sint32 eax,mp_sint32 ebx,mp_sint32 ecx,mp_sint32 edi,mp_sint32 esi);
 
 	// This takes the period *with* 8 bit fractional part
@@ -590,7 +625,7 @@ private:
 	
 	mp_sint32		getFinalVolume(TChnState& state, mp_sint32 nv, mp_sint32 mainVolume)
 	{
-		mp_sint32 vol = (nv*getenvval(&state.venv,256))>>7;
+		mp_sint32 vol = (nv*getchnenvval(ENVELOPE_VOLUME,&state.venv,256))>>7;
 		vol = (vol*state.fadevolstart)>>16;
 		vol = (vol*state.masterVol*state.insMasterVol)>>16;
 		vol = (vol*state.smpMasterVol*mainVolume)>>16;
@@ -601,14 +636,14 @@ private:
 	{
 		if (state.pitchenv.envstruc != NULL &&
 			state.pitchenv.envstruc->type & 128)
-			return (nc != MP_INVALID_VALUE) ? nc*getenvval(&state.pitchenv, 256) : 127*getenvval(&state.pitchenv, 256);
+			return (nc != MP_INVALID_VALUE) ? nc*getchnenvval(ENVELOPE_PITCH,&state.pitchenv, 256) : 127*getchnenvval(ENVELOPE_PITCH,&state.pitchenv, 256);
 		else 
 			return (nc != MP_INVALID_VALUE) ? (nc << 8) : nc;
 	}
 	
 	mp_sint32		getFinalPanning(TChnState& state, mp_sint32 np)
 	{
-		mp_sint32 envpan = getenvval(&state.penv,128);
+		mp_sint32 envpan = getchnenvval(ENVELOPE_PANNING,&state.penv,128);
 		//if (envpan!=256) cprintf("%i\r\n",envpan);
 		mp_sint32 finalpan = np+(envpan-128)*(128-abs(np-128))/128;
 		if (finalpan<0) finalpan=0;
@@ -624,7 +659,7 @@ private:
 		if (state.pitchenv.envstruc != NULL && !(state.pitchenv.envstruc->type & 128) && (state.pitchenv.envstruc->type & 1))
 		{
 			// scale the envelope point that 256 units match one semitone
-			mp_sint32 pitch = (getenvval(&state.pitchenv, 128) - 128) * 32;		
+			mp_sint32 pitch = (getchnenvval(ENVELOPE_PITCH,&state.pitchenv, 128) - 128) * 32;		
 			// add that semitone to the current note
 			mp_sint32 note = state.getNote() + (pitch>>8);
 			// the tone between two semitones
@@ -641,7 +676,7 @@ private:
 			if (per < XM_MINPERIOD)
 				per = XM_MINPERIOD;
 		}
-		mp_sint32 eval = getenvval(&state.fenv,128)-128;
+		mp_sint32 eval = getchnenvval(ENVELOPE_FREQUENCY,&state.fenv,128)-128;
 		mp_uint32 freq = (module->header.freqtab&1) ? getlinfreq(per) : getlogfreq(per);
 		
 		mp_sint32 finalFreq = (freq+(eval*63))+(mp_sint32)state.freqadjust;
@@ -731,6 +766,9 @@ public:
 	// virtual from mixer class, perform playing here
 	virtual void	timerHandler(mp_sint32 currentBeatPacket);
 	
+	// virtual from mixer class, mixer channels are virtual channels
+	virtual mp_sint32 getLogicalChannel(mp_uint32 mixerChannel);
+	
 	// override base class method
 	virtual mp_sint32   startPlaying(XModule* module, 
 								 bool repeat = false, 
@@ -215,7 +215,10 @@ PlayerSTD::PlayerSTD(mp_uint32 frequency,
 	PlayerBase(frequency),
 	statusEventListener(statusEventListener),
 	chninfo(NULL),
-	lastNumAllocatedChannels(-1)
+	lastNumAllocatedChannels(-1),
+	envBatch(NULL),
+	envStride(0),
+	envValuesValid(false)
 {
 	smpoffs = NULL;
 	attick	= NULL;
@@ -352,6 +355,22 @@ void PlayerSTD::timerHandler(mp_sint32 currentBeatPacket)
 		statusEventListener->timerTickStarted(*this, *module);
 }
 
+void PlayerSTD::processEvents(mp_sint32 offset)
+{
+	if (paused || !statusEventListener)
+		return;
+
+	statusEventListener->processEvents(*this, *module, offset);
+}
+
+mp_sint32 PlayerSTD::getEventDistance(mp_sint32 offset, mp_sint32 length)
+{
+	if (paused || !statusEventListener)
+		return length;
+
+	return statusEventListener->getEventDistance(*this, offset, length);
+}
+
 void PlayerSTD::restart(mp_uint32 startPosition/* = 0*/, mp_uint32 startRow/* = 0*/, bool resetMixer/* = true*/, const mp_ubyte* customPanningTable/* = NULL*/, bool playOneRowOnly/* = false*/)
 {
 	if (chninfo == NULL)
@@ -425,6 +444,14 @@ mp_sint32 PlayerSTD::allocateStructures()
 		smpoffs			= new mp_uint32[initialNumChannels];
 		attick			= new mp_ubyte[initialNumChannels];
 
+		const mp_sint32 envSize = NUMENVELOPES*initialNumChannels;
+		envBatch		= new mp_sint32[envSize*5];
+		envDist			= envBatch;
+		envDelta		= envBatch + envSize;
+		envY0			= envBatch + envSize*2;
+		envY1			= envBatch + envSize*3;
+		envValue		= envBatch + envSize*4;
+
 		lastNumAllocatedChannels = initialNumChannels;
 	}
 
@@ -454,6 +481,11 @@ void PlayerSTD::freeMemory()
 		delete[] attick;
 		attick = NULL;
 	}
+	if (envBatch)
+	{
+		delete[] envBatch;
+		envBatch = NULL;
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -550,6 +582,54 @@ mp_sint32 PlayerSTD::getenvval(mp_sint32 c,TPrEnv *env,mp_sint32 n)
 	else return n;
 }
 
+void PlayerSTD::gatherEnvelope(mp_sint32 i, const TPrEnv& env, mp_sint32 n)
+{
+	if (env.envstruc != NULL && (env.envstruc->type&1))
+	{
+		mp_sint32 dx = (env.envstruc->env[env.b][0]-env.envstruc->env[env.a][0]);
+		if (dx==0) dx=1;
+		envDist[i] = env.envstruc->env[env.b][0]-env.step;
+		envDelta[i] = dx;
+		envY0[i] = env.envstruc->env[env.a][1];
+		envY1[i] = env.envstruc->env[env.b][1];
+	}
+	// zero distance interpolates to y1
+	else
+	{
+		envDist[i] = 0;
+		envDelta[i] = 1;
+		envY0[i] = envY1[i] = n;
+	}
+}
+
+// getenvval() for all envelopes of the first numChannels channels
+void PlayerSTD::evaluateEnvelopes(mp_sint32 numChannels)
+{
+	mp_sint32 c;
+
+	envStride = numChannels;
+
+	for (c = 0; c < numChannels; c++)
+	{
+		const TModuleChannel* chnInf = &chninfo[c];
+
+		gatherEnvelope(ENVELOPE_VOLUME*numChannels+c, chnInf->venv, 256);
+		gatherEnvelope(ENVELOPE_PANNING*numChannels+c, chnInf->penv, 128);
+		gatherEnvelope(ENVELOPE_FREQUENCY*numChannels+c, chnInf->fenv, 128);
+		gatherEnvelope(ENVELOPE_VIBRATO*numChannels+c, chnInf->vibenv, 128);
+	}
+
+	// branch free interpolation, the integer division is carried out in double
+	// precision, which gives the exact quotient for operands of this size
+	const mp_sint32 num = NUMENVELOPES*numChannels;
+	for (mp_sint32 i = 0; i < num; i++)
+	{
+		const mp_sint32 t = (mp_sint32)((double)(envDist[i]*65536) / (double)envDelta[i]);
+		const mp_sint32 y = (envY0[i]*t)+(envY1[i]*(65536-t));
+		envValue[i] = y>>16;
+	}
+}
+
 mp_sint32 PlayerSTD::getfinalperiod(mp_sint32 c,mp_sint32 p)
 {
 	mp_sint32 envVib = 0;
@@ -558,7 +638,7 @@ mp_sint32 PlayerSTD::getfinalperiod(mp_sint32 c,mp_sint32 p)
 	if (chninfo[c].vibenv.envstruc != NULL &&
 		(chninfo[c].vibenv.envstruc->type&1))
 	{
-		mp_sint32 eval = (getenvval(c,&chninfo[c].vibenv,128)-128) << (chninfo[c].vibenv.envstruc->type>>6);
+		mp_sint32 eval = (getchnenvval(c,ENVELOPE_VIBRATO,&chninfo[c].vibenv,128)-128) << (chninfo[c].vibenv.envstruc->type>>6);
 		// AMS doc says vibrato with amplify set to 8 equals vibrato 0xF
 		// => alright
 		envVib = (eval*61408)>>(3+16-8);
@@ -2595,29 +2675,33 @@ void PlayerSTD::progressRow()
 void PlayerSTD::update()
 {
 	mp_sint32 c;
-	//for (c=10;c<11;c++) {
 #ifdef MILKYTRACKER
-	for (c=0;c<initialNumChannels;c++)
+	const mp_sint32 numUpdateChannels = initialNumChannels;
 #else
-	for (c=0;c<numChannels;c++)
+	const mp_sint32 numUpdateChannels = numChannels;
 #endif
-	{
-		TModuleChannel *chnInf = &chninfo[c];
 
-		if (chnInf->flags & CHANNEL_FLAGS_UPDATE_IGNORE)
+	// channels don't depend on each other, so refresh all of them with this
+	// tick's envelope values first and advance the envelopes afterwards
+	evaluateEnvelopes(numUpdateChannels);
+	envValuesValid = true;
+
+	for (c=0;c<numUpdateChannels;c++)
+	{
+		if (chninfo[c].flags & CHANNEL_FLAGS_UPDATE_IGNORE)
 			continue;
 
-		mp_sint32 dfs = chnInf->flags & CHANNEL_FLAGS_DFS, dvs = chnInf->flags & CHANNEL_FLAGS_DVS;
+		refreshChannel(c);
+	}
 
-		if ((chnInf->per)&&(!dfs)) {
-			mp_sint32 finalper = getfinalperiod(c,chnInf->hasVibrato ? chnInf->finalVibratoPer : chnInf->per);
-			setFreq(c,getfreq(c,finalper,chnInf->freqadjust),finalper);
-		}
+	envValuesValid = false;
 
-		if (!dvs)
-			setVol(c,getvolume(c,chnInf-> hasTremolo ? chnInf->finalTremoloVol : chnInf->vol));
+	for (c=0;c<numUpdateChannels;c++)
+	{
+		TModuleChannel *chnInf = &chninfo[c];
 
-		setPan(c,getpanning(c,chnInf->pan));
+		if (chnInf->flags & CHANNEL_FLAGS_UPDATE_IGNORE)
+			continue;
 
 		if (chnInf->venv.envstruc != NULL &&
 			!chnInf->venv.envstruc->speed)
@@ -2661,6 +2745,26 @@ void PlayerSTD::update()
 
 }
 
+void PlayerSTD::refreshChannel(mp_sint32 c)
+{
+	TModuleChannel *chnInf = &chninfo[c];
+
+	if (chnInf->flags & CHANNEL_FLAGS_UPDATE_IGNORE)
+		return;
+
+	mp_sint32 dfs = chnInf->flags & CHANNEL_FLAGS_DFS, dvs = chnInf->flags & CHANNEL_FLAGS_DVS;
+
+	if ((chnInf->per)&&(!dfs)) {
+		mp_sint32 finalper = getfinalperiod(c,chnInf->hasVibrato ? chnInf->finalVibratoPer : chnInf->per);
+		setFreq(c,getfreq(c,finalper,chnInf->freqadjust),finalper);
+	}
+
+	if (!dvs)
+		setVol(c,getvolume(c,chnInf-> hasTremolo ? chnInf->finalTremoloVol : chnInf->vol));
+
+	setPan(c,getpanning(c,chnInf->pan));
+}
+
 void PlayerSTD::updateBPMIndependent()
 {
 	mp_int64 dummy;
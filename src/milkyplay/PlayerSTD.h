@@ -53,6 +53,9 @@ public:
 		virtual void timerTickStarted(PlayerSTD& player, XModule& module) { }
 		virtual void timerTickEnded(PlayerSTD& player, XModule& module) { }
 		virtual void patternEndReached(PlayerSTD& player, XModule& module, mp_sint32& newOrderIndex) { }
+		// sample-accurate events, see ChannelMixer::processEvents
+		virtual void processEvents(PlayerSTD& player, XModule& module, mp_sint32 offset) { }
+		virtual mp_sint32 getEventDistance(PlayerSTD& player, mp_sint32 offset, mp_sint32 length) { return length; }
 	};
 
 private:
@@ -256,6 +259,27 @@ private:
 	TModuleChannel*	chninfo;				// our channel information
 	mp_sint32		lastNumAllocatedChannels;
 
+	// envelope values of all channels for the current tick, interpolated in
+	// one pass by evaluateEnvelopes() and kept as structure of arrays so the
+	// interpolation loop vectorizes, entry e*envStride+c is envelope e of channel c
+	enum
+	{
+		ENVELOPE_VOLUME,
+		ENVELOPE_PANNING,
+		ENVELOPE_FREQUENCY,
+		ENVELOPE_VIBRATO,
+		NUMENVELOPES
+	};
+
+	mp_sint32*		envBatch;				// holds all of the arrays below
+	mp_sint32*		envDist;				// distance from the current position to the next point
+	mp_sint32*		envDelta;				// length of the current segment
+	mp_sint32*		envY0;
+	mp_sint32*		envY1;
+	mp_sint32*		envValue;
+	mp_sint32		envStride;
+	bool			envValuesValid;			// getvolume & co. use envValue
+
 	mp_uint32*		smpoffs;
 	mp_ubyte*		attick;
 
@@ -304,6 +328,19 @@ private:
 
 	static mp_sint32	getenvval(mp_sint32 c, TPrEnv* env, mp_sint32 n);			// get envelope value
 
+	// envelope value from the batch if it's valid, debug builds check
+	// it against evaluating the envelope on its own
+	mp_sint32			getchnenvval(mp_sint32 c, mp_sint32 e, TPrEnv* env, mp_sint32 n)
+	{
+		if (!envValuesValid)
+			return getenvval(c,env,n);
+		ASSERT(envValue[e*envStride+c] == getenvval(c,env,n));
+		return envValue[e*envStride+c];
+	}
+
+	void				gatherEnvelope(mp_sint32 i, const TPrEnv& env, mp_sint32 n);
+	void				evaluateEnvelopes(mp_sint32 numChannels);
+
 	// This takes the period *with* 8 bit fractional part
 	static mp_sint32	getlinfreq(mp_sint32 per);
 	// This takes the period *with* 8 bit fractional part
@@ -314,19 +351,7 @@ private:
 	// this returns a period *without* the 8 bit fractional part
 	static mp_sint32	getlogperiod(mp_sint32 note,mp_sint32 relnote,mp_sint32 finetune);
 
-	mp_uint32		getbpmrate(mp_uint32 bpm)
-	{
-		// digibooster "real BPM" setting
-		mp_uint32 realCiaTempo = (bpm * (baseBpm << 8) / 125) >> 8;
-
-		if (!realCiaTempo) realCiaTempo++;
-
-		mp_int64 t = ((mp_int64)realCiaTempo)<<(32+2);
-
-		const mp_uint32 timerBase = (mp_uint32)(5.0f*500.0f*(MP_BEATLENGTH*MP_TIMERFREQ / (float)MP_BASEFREQ));
-
-		return (mp_uint32)(t/timerBase);
-	}
+	mp_uint32		getbpmrate(mp_uint32 bpm) { return getbpmrate(bpm, baseBpm); }
 
 	mp_sint32		getperiod(mp_sint32 note,mp_sint32 relnote,mp_sint32 finetune)
 	{
@@ -355,7 +380,7 @@ private:
 
 	mp_sint32		getvolume(mp_sint32 c,mp_sint32 nv)
 	{
-		mp_sint32 vol = (nv*getenvval(c,&chninfo[c].venv,256))>>7;
+		mp_sint32 vol = (nv*getchnenvval(c,ENVELOPE_VOLUME,&chninfo[c].venv,256))>>7;
 		vol = (vol*chninfo[c].fadevolstart)>>16;
 		vol = (vol*chninfo[c].masterVol)>>8;
 		vol = (vol*mainVolume)>>8;
@@ -364,7 +389,7 @@ private:
 
 	mp_sint32		getpanning(mp_sint32 c,mp_sint32 np)
 	{
-		mp_sint32 envpan = getenvval(c,&chninfo[c].penv,128);
+		mp_sint32 envpan = getchnenvval(c,ENVELOPE_PANNING,&chninfo[c].penv,128);
 		//if (envpan!=256) cprintf("%i\r\n",envpan);
 		mp_sint32 finalpan = np+(envpan-128)*(128-abs(np-128))/128;
 		if (finalpan<0) finalpan=0;
@@ -375,7 +400,7 @@ private:
 	mp_sint32		getfreq(mp_sint32 c,mp_sint32 per,mp_sword freqadjust)
 	{
 		if (per<1) return 0;
-		mp_sint32 eval = getenvval(c,&chninfo[c].fenv,128)-128;
+		mp_sint32 eval = getchnenvval(c,ENVELOPE_FREQUENCY,&chninfo[c].fenv,128)-128;
 		mp_uint32 freq;
 
 		freq = (module->header.freqtab&1) ? getlinfreq(per) : getlogfreq(per);
@@ -461,12 +486,32 @@ public:
 
 	virtual PlayerTypes getType() const { return PlayerType_Generic; }
 
+	// BPM counter increment per timer tick (see timerHandler), a player
+	// tick is triggered each time the 32 bit counter overflows
+	static mp_uint32 getbpmrate(mp_uint32 bpm, mp_sint32 baseBpm)
+	{
+		// digibooster "real BPM" setting
+		mp_uint32 realCiaTempo = (bpm * (baseBpm << 8) / 125) >> 8;
+
+		if (!realCiaTempo) realCiaTempo++;
+
+		mp_int64 t = ((mp_int64)realCiaTempo)<<(32+2);
+
+		const mp_uint32 timerBase = (mp_uint32)(5.0f*500.0f*(MP_BEATLENGTH*MP_TIMERFREQ / (float)MP_BASEFREQ));
+
+		return (mp_uint32)(t/timerBase);
+	}
+
 	virtual mp_sint32 adjustFrequency(mp_uint32 frequency);
 	virtual mp_sint32 setBufferSize(mp_uint32 bufferSize);
 
 	// virtual from mixer class, perform playing here
 	virtual void	timerHandler(mp_sint32 currentBeatPacket);
 
+	// virtual from mixer class, events are handled by the status event listener
+	virtual void	processEvents(mp_sint32 offset);
+	virtual mp_sint32 getEventDistance(mp_sint32 offset, mp_sint32 length);
+
 	virtual void	restart(mp_uint32 startPosition = 0, mp_uint32 startRow = 0,
 							bool resetMixer = true,
 							const mp_ubyte* customPanningTable = NULL,
@@ -480,6 +525,9 @@ public:
 
 	// milkytracker
 	virtual void	playNote(mp_ubyte chn, mp_sint32 note, mp_sint32 ins, mp_sint32 vol = -1);
+	// hand frequency, volume and panning of a channel to the mixer right away
+	// without advancing envelopes, for notes played in between two ticks
+	void			refreshChannel(mp_sint32 c);
 
 	virtual void	setPanning(mp_ubyte chn, mp_ubyte pan) { chninfo[chn].pan = pan; }
 
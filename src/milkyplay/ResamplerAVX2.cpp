@@ -0,0 +1,501 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ResamplerAVX2.cpp
+ *  MilkyPlay
+ *
+ *  AVX2 versions of the linear, cubic and sinc table resamplers. Linear
+ *  and cubic interpolation compute eight frames at once, the sinc table
+ *  resampler weights the fifteen taps of a frame in two 8 lane vectors.
+ *  All arithmetic is done in 32 bit lanes with the same shifts and
+ *  wrap-around as the C code, so the output is bit identical.
+ *
+ *  This file is compiled with AVX2 code generation, so it must not
+ *  instantiate any inline or template code shared with other files.
+ */
+#include "ResamplerSIMD.h"
+
+#ifdef __RESAMPLER_AVX2__
+
+#include <immintrin.h>
+
+enum
+{
+	// matches ResamplerSincTable<ramping, 16>
+	SINC_WIDTH = 8,
+	SINC_SPZCSHIFT = 10,
+	// taps -7..7 around the current position plus one unused lane
+	SINC_LANES = 16
+};
+
+// MP_FP_MUL(a, b) for eight lanes
+static inline __m256i fpmul_epi32(const __m256i a, const __m256i b)
+{
+	const __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(a, b), 16);
+	const __m256i odd = _mm256_slli_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)), 16);
+	return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+// (s*(vol>>15))>>15 for left and right, added to eight interleaved stereo frames
+static inline void mixFrames(mp_sint32* buffer, const __m256i s, const __m256i voll, const __m256i volr)
+{
+	const __m256i l = _mm256_srai_epi32(_mm256_mullo_epi32(s, _mm256_srai_epi32(voll, 15)), 15);
+	const __m256i r = _mm256_srai_epi32(_mm256_mullo_epi32(s, _mm256_srai_epi32(volr, 15)), 15);
+
+	// unpack works within 128 bit lanes: lo = frames 0,1,4,5 hi = frames 2,3,6,7
+	const __m256i lo = _mm256_unpacklo_epi32(l, r);
+	const __m256i hi = _mm256_unpackhi_epi32(l, r);
+
+	__m256i* dst = reinterpret_cast<__m256i*>(buffer);
+	_mm256_storeu_si256(dst, _mm256_add_epi32(_mm256_loadu_si256(dst), _mm256_permute2x128_si256(lo, hi, 0x20)));
+	_mm256_storeu_si256(dst+1, _mm256_add_epi32(_mm256_loadu_si256(dst+1), _mm256_permute2x128_si256(lo, hi, 0x31)));
+}
+
+// Reads the 32 bits starting at sample[pos>>16 + offset] for each lane.
+// For 16 bit samples these are two, for 8 bit samples four consecutive
+// sample values, the padding of the sample data keeps this within bounds.
+template<class bufferType>
+static inline __m256i gatherSamples(const bufferType* sample, const __m256i pos, const mp_sint32 offset)
+{
+	__m256i index = _mm256_add_epi32(_mm256_srai_epi32(pos, 16), _mm256_set1_epi32(offset));
+	if (sizeof(bufferType) == 2)
+		index = _mm256_add_epi32(index, index);
+	return _mm256_i32gather_epi32((const int*)sample, index, 1);
+}
+
+// Sign extends byte/word number n of each lane and scales it to 16 bit
+template<class bufferType, mp_sint32 n>
+static inline __m256i extractSample(const __m256i v)
+{
+	const mp_sint32 bits = sizeof(bufferType)*8;
+	return _mm256_slli_epi32(_mm256_srai_epi32(_mm256_slli_epi32(v, 32-bits*(n+1)), 32-bits), 16-bits);
+}
+
+/////////////////////////////////////////////////////////
+//				  LINEAR INTERPOLATION				   //
+/////////////////////////////////////////////////////////
+template<class bufferType>
+static void lerpBlock(mp_sint32* buffer, const bufferType* sample, mp_sint32 posfixed, const mp_sint32 smpadd, mp_uint32 count,
+					  mp_sint32& voll, mp_sint32& volr, const mp_sint32 rampFromVolStepL, const mp_sint32 rampFromVolStepR)
+{
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i posOffsets = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(smpadd));
+	const __m256i rampL = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(rampFromVolStepL));
+	const __m256i rampR = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(rampFromVolStepR));
+
+	while (count >= 8)
+	{
+		const __m256i pos = _mm256_add_epi32(_mm256_set1_epi32(posfixed), posOffsets);
+		const __m256i v = gatherSamples(sample, pos, 0);
+		const __m256i sd1 = extractSample<bufferType, 0>(v);
+		const __m256i sd2 = extractSample<bufferType, 1>(v);
+		const __m256i frac = _mm256_and_si256(_mm256_srai_epi32(pos, 4), _mm256_set1_epi32(0xfff));
+
+		const __m256i s = _mm256_srai_epi32(_mm256_add_epi32(_mm256_slli_epi32(sd1, 12), _mm256_mullo_epi32(frac, _mm256_sub_epi32(sd2, sd1))), 12);
+
+		mixFrames(buffer, s, _mm256_add_epi32(_mm256_set1_epi32(voll), rampL), _mm256_add_epi32(_mm256_set1_epi32(volr), rampR));
+
+		voll+=rampFromVolStepL*8;
+		volr+=rampFromVolStepR*8;
+		posfixed+=smpadd*8;
+		buffer+=16;
+		count-=8;
+	}
+
+	const mp_sint32 sampleShift = 16-sizeof(bufferType)*8;
+	while (count--)
+	{
+		mp_sint32 sd1 = sample[posfixed>>16] << sampleShift;
+		mp_sint32 sd2 = sample[(posfixed>>16)+1] << sampleShift;
+
+		sd1 =((sd1<<12)+((posfixed>>4)&0xfff)*(sd2-sd1))>>12;
+
+		(*buffer++)+=((sd1*(voll>>15))>>15);
+		(*buffer++)+=((sd1*(volr>>15))>>15);
+
+		voll+=rampFromVolStepL;
+		volr+=rampFromVolStepR;
+		posfixed+=smpadd;
+	}
+}
+
+void ResamplerSIMD::addBlockLerpAVX2(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count, bool ramping)
+{
+	mp_sint32 voll = chn->finalvoll;
+	mp_sint32 volr = chn->finalvolr;
+
+	const mp_sint32 rampFromVolStepL = ramping ? chn->rampFromVolStepL : 0;
+	const mp_sint32 rampFromVolStepR = ramping ? chn->rampFromVolStepR : 0;
+
+	const mp_sint32 basepos = chn->smppos;
+	const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+	const mp_sint32 posfixed = chn->smpposfrac;
+
+	mp_sint32 fp = smpadd*count;
+	MP_INCREASESMPPOS(chn->smppos, chn->smpposfrac, fp, 16);
+
+	if ((voll == 0 && rampFromVolStepL == 0) && (volr == 0 && rampFromVolStepR == 0)) return;
+
+	if (!(chn->flags&4))
+		lerpBlock<mp_sbyte>(buffer, chn->sample + basepos, posfixed, smpadd, count, voll, volr, rampFromVolStepL, rampFromVolStepR);
+	else
+		lerpBlock<mp_sword>(buffer, (const mp_sword*)chn->sample + basepos, posfixed, smpadd, count, voll, volr, rampFromVolStepL, rampFromVolStepR);
+
+	if (ramping)
+	{
+		chn->finalvoll = voll;
+		chn->finalvolr = volr;
+	}
+}
+
+/////////////////////////////////////////////////////////
+//		CUBIC LAGRANGE/SPLINE INTERPOLATION		   //
+/////////////////////////////////////////////////////////
+template<CubicResamplers type>
+static inline __m256i interpolateCubic(const __m256i v0, const __m256i v1, const __m256i v2, const __m256i v3, const __m256i x)
+{
+	// see CubicResamplerDummy::interpolate_lagrange4Point/interpolate_spline4Point
+	const __m256i oneSixth = _mm256_set1_epi32(65536/6);
+	__m256i c0, c1, c2, c3;
+
+	if (type == CubicResamplerLagrange)
+	{
+		c0 = v1;
+		c1 = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_sub_epi32(v2,
+											   _mm256_srai_epi32(_mm256_mullo_epi32(v0, _mm256_set1_epi32(65536/3)), 16)),
+											   _mm256_srai_epi32(_mm256_mullo_epi32(v3, oneSixth), 16)),
+											   _mm256_srai_epi32(v1, 1));
+		c2 = _mm256_sub_epi32(_mm256_srai_epi32(_mm256_add_epi32(v0, v2), 1), v1);
+		c3 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(oneSixth, _mm256_sub_epi32(v3, v0)), 16),
+							  _mm256_srai_epi32(_mm256_sub_epi32(v1, v2), 1));
+	}
+	else
+	{
+		const __m256i ym1py1 = _mm256_add_epi32(v0, v2);
+		c0 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(oneSixth, ym1py1),
+												_mm256_mullo_epi32(_mm256_set1_epi32(65536*2/3), v1)), 16);
+		c1 = _mm256_srai_epi32(_mm256_sub_epi32(v2, v0), 1);
+		c2 = _mm256_sub_epi32(_mm256_srai_epi32(ym1py1, 1), v1);
+		c3 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_sub_epi32(v1, v2), 1),
+							  _mm256_srai_epi32(_mm256_mullo_epi32(oneSixth, _mm256_sub_epi32(v3, v0)), 16));
+	}
+
+	__m256i s = _mm256_add_epi32(fpmul_epi32(c3, x), c2);
+	s = _mm256_add_epi32(fpmul_epi32(s, x), c1);
+	return _mm256_add_epi32(fpmul_epi32(s, x), c0);
+}
+
+template<class bufferType, CubicResamplers type>
+static inline __m256i cubicFrames(const bufferType* sample, const __m256i pos)
+{
+	__m256i v0, v1, v2, v3;
+
+	// the sample data is padded, see CubicResamplerDummy
+	if (sizeof(bufferType) == 1)
+	{
+		const __m256i v = gatherSamples(sample, pos, -1);
+		v0 = extractSample<bufferType, 0>(v);
+		v1 = extractSample<bufferType, 1>(v);
+		v2 = extractSample<bufferType, 2>(v);
+		v3 = extractSample<bufferType, 3>(v);
+	}
+	else
+	{
+		const __m256i va = gatherSamples(sample, pos, -1);
+		const __m256i vb = gatherSamples(sample, pos, 1);
+		v0 = extractSample<bufferType, 0>(va);
+		v1 = extractSample<bufferType, 1>(va);
+		v2 = extractSample<bufferType, 0>(vb);
+		v3 = extractSample<bufferType, 1>(vb);
+	}
+
+	return interpolateCubic<type>(v0, v1, v2, v3, _mm256_and_si256(pos, _mm256_set1_epi32(65535)));
+}
+
+template<class bufferType, CubicResamplers type>
+static void cubicBlock(mp_sint32* buffer, const bufferType* sample, mp_sint32 smppos, const mp_sint32 smpadd, mp_uint32 count,
+					   mp_sint32& voll, mp_sint32& volr, const mp_sint32 rampFromVolStepL, const mp_sint32 rampFromVolStepR)
+{
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i posOffsets = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(smpadd));
+	const __m256i rampL = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(rampFromVolStepL));
+	const __m256i rampR = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(rampFromVolStepR));
+
+	while (count >= 8)
+	{
+		const __m256i s = cubicFrames<bufferType, type>(sample, _mm256_add_epi32(_mm256_set1_epi32(smppos), posOffsets));
+
+		mixFrames(buffer, s, _mm256_add_epi32(_mm256_set1_epi32(voll), rampL), _mm256_add_epi32(_mm256_set1_epi32(volr), rampR));
+
+		voll+=rampFromVolStepL*8;
+		volr+=rampFromVolStepR*8;
+		smppos+=smpadd*8;
+		buffer+=16;
+		count-=8;
+	}
+
+	// remaining frames, the lanes past the end repeat the last position
+	if (count)
+	{
+		const __m256i pos = _mm256_add_epi32(_mm256_set1_epi32(smppos),
+											 _mm256_mullo_epi32(_mm256_min_epi32(lanes, _mm256_set1_epi32(count-1)), _mm256_set1_epi32(smpadd)));
+
+		mp_sint32 s[8];
+		_mm256_storeu_si256((__m256i*)s, cubicFrames<bufferType, type>(sample, pos));
+
+		for (mp_uint32 i = 0; i < count; i++)
+		{
+			(*buffer++)+=(s[i]*(voll>>15))>>15;
+			(*buffer++)+=(s[i]*(volr>>15))>>15;
+
+			voll+=rampFromVolStepL;
+			volr+=rampFromVolStepR;
+		}
+	}
+}
+
+template<CubicResamplers type>
+static void addBlockCubic(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count, bool ramping)
+{
+	mp_sint32 voll = chn->finalvoll;
+	mp_sint32 volr = chn->finalvolr;
+
+	const mp_sint32 rampFromVolStepL = ramping ? chn->rampFromVolStepL : 0;
+	const mp_sint32 rampFromVolStepR = ramping ? chn->rampFromVolStepR : 0;
+
+	const mp_sint32 basepos = chn->smppos;
+	const mp_sint32 smpposfrac = chn->smpposfrac;
+	const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+
+	mp_sint32 fp = smpadd*count;
+	MP_INCREASESMPPOS(chn->smppos, chn->smpposfrac, fp, 16);
+
+	if (chn->flags & 4)
+		cubicBlock<mp_sword, type>(buffer, (const mp_sword*)chn->sample + basepos, smpposfrac, smpadd, count, voll, volr, rampFromVolStepL, rampFromVolStepR);
+	else
+		cubicBlock<mp_sbyte, type>(buffer, chn->sample + basepos, smpposfrac, smpadd, count, voll, volr, rampFromVolStepL, rampFromVolStepR);
+
+	if (ramping)
+	{
+		chn->finalvoll = voll;
+		chn->finalvolr = volr;
+	}
+}
+
+void ResamplerSIMD::addBlockCubicAVX2(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count, bool ramping, CubicResamplers type)
+{
+	if (type == CubicResamplerSpline)
+		addBlockCubic<CubicResamplerSpline>(buffer, chn, count, ramping);
+	else
+		addBlockCubic<CubicResamplerLagrange>(buffer, chn, count, ramping);
+}
+
+/////////////////////////////////////////////////////////
+//					 SINC TABLE						   //
+/////////////////////////////////////////////////////////
+// SINC(x) from ResamplerSinc.h for eight lanes
+static inline __m256i sinc_epi32(const mp_sint32* sincTable, const __m256i x)
+{
+	const __m256i absx = _mm256_abs_epi32(x);
+	const __m256i inside = _mm256_cmpgt_epi32(_mm256_set1_epi32(SINC_WIDTH-1), _mm256_srai_epi32(absx, 16));
+	const __m256i index = _mm256_and_si256(_mm256_srai_epi32(absx, 16-SINC_SPZCSHIFT), inside);
+
+	const __m256i t0 = _mm256_i32gather_epi32((const int*)sincTable, index, 4);
+	const __m256i t1 = _mm256_i32gather_epi32((const int*)sincTable + 1, index, 4);
+
+	const __m256i res = _mm256_add_epi32(t0, fpmul_epi32(_mm256_sub_epi32(t1, t0), _mm256_and_si256(index, _mm256_set1_epi32(65535))));
+	return _mm256_and_si256(res, inside);
+}
+
+template<class bufferType, mp_sint32 shift, bool ramping, bool downsample>
+static void sincTableBlock(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count, const mp_sint32* sincTable)
+{
+	const bufferType* sample = (const bufferType*)chn->sample;
+
+	mp_sint32 voll = chn->finalvoll;
+	mp_sint32 volr = chn->finalvolr;
+
+	const mp_sint32 rampFromVolStepL = ramping ? chn->rampFromVolStepL : 0;
+	const mp_sint32 rampFromVolStepR = ramping ? chn->rampFromVolStepR : 0;
+
+	mp_sint32 smppos = chn->smppos;
+	mp_sint32 smpposfrac = chn->smpposfrac;
+	const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+	const mp_sint32 rsmpadd = chn->rsmpadd;
+
+	const mp_sint32 flags = chn->flags;
+	const mp_sint32 loopstart = chn->loopstart;
+	const mp_sint32 loopend = chn->loopend;
+	const mp_sint32 smplen = chn->smplen;
+
+	mp_sint32 fixedtimefrac = chn->fixedtimefrac;
+	const mp_sint32 timeadd = chn->smpadd;
+
+	// Taps walk away from the current position in both directions, the ones
+	// behind (in playing direction) with increasing time. Without any loop
+	// point in reach, tap d is simply sample[smppos+d] at time + dir*d*step.
+	const mp_sint32 dir = smpadd < 0 ? 1 : -1;
+	const mp_sint32 timeStep = downsample ? rsmpadd : 65536;
+
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i timeOffsetsLo = _mm256_mullo_epi32(_mm256_sub_epi32(lanes, _mm256_set1_epi32(SINC_WIDTH-1)), _mm256_set1_epi32(dir*timeStep));
+	const __m256i timeOffsetsHi = _mm256_mullo_epi32(_mm256_add_epi32(lanes, _mm256_set1_epi32(1)), _mm256_set1_epi32(dir*timeStep));
+
+	// lane 15 (tap +8) may be read but must not contribute
+	const __m256i lastTapMask = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, -1, 0);
+
+	while (count)
+	{
+		mp_sint32 windowStart = loopstart;
+		mp_sint32 windowEnd = loopend;
+		if (!(((flags & 3) && smppos >= loopstart && smppos < loopend)))
+		{
+			windowStart = 0;
+			windowEnd = smplen;
+		}
+
+		if (smppos - (SINC_WIDTH-1) < windowStart || smppos + (SINC_WIDTH-1) >= windowEnd)
+		{
+			// the window wraps around a loop point or reaches the sample boundaries
+			chn->smppos = smppos;
+			chn->smpposfrac = smpposfrac;
+			chn->fixedtimefrac = fixedtimefrac;
+			chn->finalvoll = voll;
+			chn->finalvolr = volr;
+
+			ResamplerSIMD::addBlockSincTableScalar(buffer, chn, 1, ramping);
+
+			smppos = chn->smppos;
+			smpposfrac = chn->smpposfrac;
+			fixedtimefrac = chn->fixedtimefrac;
+			voll = chn->finalvoll;
+			volr = chn->finalvolr;
+
+			buffer+=2;
+			count--;
+			continue;
+		}
+
+		mp_sint32 time = downsample ? MP_FP_MUL(fixedtimefrac, rsmpadd) : fixedtimefrac;
+		if (!time && (flags & ChannelMixer::MP_SAMPLE_BACKWARD))
+			time = 65536;
+
+		// the sample data is padded, so reading tap +8 is safe
+		const bufferType* src = sample + smppos - (SINC_WIDTH-1);
+		__m256i tapsLo, tapsHi;
+		if (sizeof(bufferType) == 2)
+		{
+			tapsLo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)src));
+			tapsHi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(src + 8)));
+		}
+		else
+		{
+			tapsLo = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)src));
+			tapsHi = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)(src + 8)));
+		}
+		tapsHi = _mm256_and_si256(tapsHi, lastTapMask);
+
+		const __m256i t = _mm256_set1_epi32(time);
+		__m256i wLo = sinc_epi32(sincTable, _mm256_add_epi32(t, timeOffsetsLo));
+		__m256i wHi = sinc_epi32(sincTable, _mm256_add_epi32(t, timeOffsetsHi));
+		if (downsample)
+		{
+			wLo = fpmul_epi32(wLo, _mm256_set1_epi32(rsmpadd));
+			wHi = fpmul_epi32(wHi, _mm256_set1_epi32(rsmpadd));
+		}
+
+		const __m256i sum = _mm256_add_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(tapsLo, wLo), shift),
+											 _mm256_srai_epi32(_mm256_mullo_epi32(tapsHi, wHi), shift));
+
+		__m128i sum4 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(1,0,3,2)));
+		sum4 = _mm_add_epi32(sum4, _mm_shuffle_epi32(sum4, _MM_SHUFFLE(2,3,0,1)));
+		const mp_sint32 result = _mm_cvtsi128_si32(sum4);
+
+		(*buffer++)+=(((result)*(voll>>15))>>15);
+		(*buffer++)+=(((result)*(volr>>15))>>15);
+
+		voll+=rampFromVolStepL;
+		volr+=rampFromVolStepR;
+
+		MP_INCREASESMPPOS(smppos, smpposfrac, smpadd, 16);
+		fixedtimefrac=(fixedtimefrac+timeadd) & 65535;
+		count--;
+	}
+
+	chn->smppos = smppos;
+	chn->smpposfrac = smpposfrac;
+
+	chn->fixedtimefrac = fixedtimefrac;
+
+	if (ramping)
+	{
+		chn->finalvoll = voll;
+		chn->finalvolr = volr;
+	}
+}
+
+template<class bufferType, mp_sint32 shift>
+static void addBlockSincTable(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count, bool ramping, const mp_sint32* sincTable)
+{
+	const bool downsample = chn->smpadd >= 65536;
+
+	if (ramping)
+	{
+		if (downsample)
+			sincTableBlock<bufferType, shift, true, true>(buffer, chn, count, sincTable);
+		else
+			sincTableBlock<bufferType, shift, true, false>(buffer, chn, count, sincTable);
+	}
+	else
+	{
+		if (downsample)
+			sincTableBlock<bufferType, shift, false, true>(buffer, chn, count, sincTable);
+		else
+			sincTableBlock<bufferType, shift, false, false>(buffer, chn, count, sincTable);
+	}
+}
+
+void ResamplerSIMD::addBlockSincTableAVX2(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count, bool ramping, const mp_sint32* sincTable)
+{
+	// taps on both sides are walked in the same direction when not moving
+	if (chn->smpadd == 0)
+	{
+		addBlockSincTableScalar(buffer, chn, count, ramping);
+		return;
+	}
+
+	if (chn->flags & 4)
+		addBlockSincTable<mp_sword, 16>(buffer, chn, count, ramping, sincTable);
+	else
+		addBlockSincTable<mp_sbyte, 8>(buffer, chn, count, ramping, sincTable);
+}
+
+#endif
@@ -35,6 +35,9 @@
  *
  */
 
+#ifndef __RESAMPLERCUBIC_H__
+#define __RESAMPLERCUBIC_H__
+
 /*
  * Cubic 4 Point 3rd order polynomial interpolation resampler                 
  *
@@ -202,6 +205,7 @@ public:
 	virtual bool isRamping() { return ramping; }
 	virtual bool supportsFullChecking() { return false; }
 	virtual bool supportsNoChecking() { return true; }
+	virtual bool readsBehindPosition() { return true; }
 
 	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 	{
@@ -214,3 +218,5 @@ public:
 
 #undef __DEIP__
 #undef fpmul
+
+#endif
@@ -40,6 +40,15 @@
 #include "ResamplerFast.h"
 #include "ResamplerSinc.h"
 #include "ResamplerAmiga.h"
+#include "ResamplerSIMD.h"
+
+#ifdef __RESAMPLER_AVX2__
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
 
 #ifdef __AMIGA__
 template<>
@@ -49,8 +58,86 @@ template<>
 bool ResamplerSincTableBase<16>::tableInit = false;
 #endif
 
+mp_uint32 ResamplerFactory::cpuFeatureMask = ~0U;
+
+mp_uint32 ResamplerFactory::detectCPUFeatures()
+{
+	mp_uint32 features = 0;
+
+#ifdef __RESAMPLER_AVX2__
+	mp_uint32 regs[4] = {0, 0, 0, 0};
+	mp_uint32 maxLeaf;
+
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	maxLeaf = info[0];
+	if (maxLeaf >= 1)
+	{
+		__cpuid(info, 1);
+		regs[2] = info[2];
+	}
+#else
+	maxLeaf = __get_cpuid_max(0, NULL);
+	if (maxLeaf >= 1)
+		__get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+
+	// AVX2 also needs the OS to save the YMM registers (OSXSAVE + XCR0)
+	if (maxLeaf >= 7 && (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)))
+	{
+#if defined(_MSC_VER)
+		const mp_uint32 xcr0 = (mp_uint32)_xgetbv(0);
+		__cpuidex(info, 7, 0);
+		const mp_uint32 ebx7 = info[1];
+#else
+		mp_uint32 xcr0, edx;
+		__asm__ __volatile__ ("xgetbv" : "=a" (xcr0), "=d" (edx) : "c" (0));
+		mp_uint32 eax7, ebx7, ecx7, edx7;
+		__cpuid_count(7, 0, eax7, ebx7, ecx7, edx7);
+#endif
+		if ((xcr0 & 6) == 6 && (ebx7 & (1 << 5)))
+			features |= CPUFEATURE_AVX2;
+	}
+#endif
+
+	return features;
+}
+
+mp_uint32 ResamplerFactory::getCPUFeatures()
+{
+	static mp_sint32 features = -1;
+
+	if (features < 0)
+		features = (mp_sint32)detectCPUFeatures();
+
+	return (mp_uint32)features & cpuFeatureMask;
+}
+
+void ResamplerSIMD::addBlockSincTableScalar(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count, bool ramping)
+{
+	if (ramping)
+	{
+		if (chn->flags & 4)
+			SincTableResamplerDummy<true, 16, mp_sword, 16>::addBlock(buffer, chn, count);
+		else
+			SincTableResamplerDummy<true, 16, mp_sbyte, 8>::addBlock(buffer, chn, count);
+	}
+	else
+	{
+		if (chn->flags & 4)
+			SincTableResamplerDummy<false, 16, mp_sword, 16>::addBlock(buffer, chn, count);
+		else
+			SincTableResamplerDummy<false, 16, mp_sbyte, 8>::addBlock(buffer, chn, count);
+	}
+}
+
 ChannelMixer::ResamplerBase* ResamplerFactory::createResampler(ResamplerTypes type)
 {
+#ifdef __RESAMPLER_AVX2__
+	const mp_uint32 features = getCPUFeatures();
+#endif
+
 	switch (type)
 	{
 		case MIXER_NORMAL:
@@ -60,27 +147,59 @@ ChannelMixer::ResamplerBase* ResamplerFactory::createResampler(ResamplerTypes ty
 			return new ResamplerSimpleRamp();
 
 		case MIXER_LERPING:
+#ifdef __RESAMPLER_AVX2__
+			if (features & CPUFEATURE_AVX2)
+				return new ResamplerLerpAVX2();
+#endif
 			return new ResamplerLerp();
 
 		case MIXER_LERPING_RAMPING:
+#ifdef __RESAMPLER_AVX2__
+			if (features & CPUFEATURE_AVX2)
+				return new ResamplerLerpRampFilterAVX2();
+#endif
 			return new ResamplerLerpRampFilter();
 
 		case MIXER_LAGRANGE:
+#ifdef __RESAMPLER_AVX2__
+			if (features & CPUFEATURE_AVX2)
+				return new ResamplerLagrangeAVX2<false, CubicResamplerLagrange>();
+#endif
 			return new ResamplerLagrange<false, CubicResamplerLagrange>();
 
 		case MIXER_LAGRANGE_RAMPING:
+#ifdef __RESAMPLER_AVX2__
+			if (features & CPUFEATURE_AVX2)
+				return new ResamplerLagrangeAVX2<true, CubicResamplerLagrange>();
+#endif
 			return new ResamplerLagrange<true, CubicResamplerLagrange>();
 
 		case MIXER_SPLINE:
+#ifdef __RESAMPLER_AVX2__
+			if (features & CPUFEATURE_AVX2)
+				return new ResamplerLagrangeAVX2<false, CubicResamplerSpline>();
+#endif
 			return new ResamplerLagrange<false, CubicResamplerSpline>();
 
 		case MIXER_SPLINE_RAMPING:
+#ifdef __RESAMPLER_AVX2__
+			if (features & CPUFEATURE_AVX2)
+				return new ResamplerLagrangeAVX2<true, CubicResamplerSpline>();
+#endif
 			return new ResamplerLagrange<true, CubicResamplerSpline>();
 
 		case MIXER_SINCTABLE:
+#ifdef __RESAMPLER_AVX2__
+			if (features & CPUFEATURE_AVX2)
+				return new ResamplerSincTableAVX2<false>();
+#endif
 			return new ResamplerSincTable<false, 16>();
 
 		case MIXER_SINCTABLE_RAMPING:
+#ifdef __RESAMPLER_AVX2__
+			if (features & CPUFEATURE_AVX2)
+				return new ResamplerSincTableAVX2<true>();
+#endif
 			return new ResamplerSincTable<true, 16>();
 
 		case MIXER_SINC:
@@ -43,6 +43,30 @@
 class ResamplerFactory : public MixerSettings
 {
 public:
+	enum CPUFeatures
+	{
+		CPUFEATURE_AVX2 = 1
+	};
+
+private:
+	static mp_uint32 cpuFeatureMask;
+
+	static mp_uint32 detectCPUFeatures();
+
+public:
+	/**
+	 * Get the instruction set extensions the resamplers may use
+	 * @return			combination of CPUFeatures supported by CPU and build
+	 */
+	static mp_uint32 getCPUFeatures();
+
+	/**
+	 * Restrict the instruction set extensions used by resamplers created
+	 * from now on, e.g. 0 always selects the plain C resamplers
+	 * @param  mask		combination of CPUFeatures
+	 */
+	static void setCPUFeatureMask(mp_uint32 mask) { cpuFeatureMask = mask; }
+
 	static ChannelMixer::ResamplerBase* createResampler(ResamplerTypes type);
 };
 
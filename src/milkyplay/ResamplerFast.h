@@ -223,20 +223,43 @@ public:
 		// filter in use?
 		if (chn->cutoff != ChannelMixer::MP_INVALID_VALUE && chn->resonance != ChannelMixer::MP_INVALID_VALUE)
 		{
-			const mp_sint32 a = chn->a;
-			const mp_sint32 b = chn->b;
-			const mp_sint32 c = chn->c;
+			mp_sint32 a = chn->a;
+			mp_sint32 b = chn->b;
+			mp_sint32 c = chn->c;
+
+			const mp_sint32 rampFilterStepA = chn->rampFilterStepA;
+			const mp_sint32 rampFilterStepB = chn->rampFilterStepB;
+			const mp_sint32 rampFilterStepC = chn->rampFilterStepC;
 
 			mp_sint32 currsample = chn->currsample;
 			mp_sint32 prevsample = chn->prevsample;
 
-			if (rampFromVolStepL || rampFromVolStepR)
+			// coefficients are only ramped with filter smoothing enabled
+			if (rampFilterStepA || rampFilterStepB || rampFilterStepC)
 			{
-				FULLMIXER_TEMPLATE(FULLMIXER_8BIT_LERP_RAMP_FILTER(true), FULLMIXER_16BIT_LERP_RAMP_FILTER(true), 16, 0);
+				if (rampFromVolStepL || rampFromVolStepR)
+				{
+					FULLMIXER_TEMPLATE(FULLMIXER_8BIT_LERP_RAMP_FILTER(true, true), FULLMIXER_16BIT_LERP_RAMP_FILTER(true, true), 16, 4);
+				}
+				else
+				{
+					FULLMIXER_TEMPLATE(FULLMIXER_8BIT_LERP_RAMP_FILTER(false, true), FULLMIXER_16BIT_LERP_RAMP_FILTER(false, true), 16, 5);
+				}
+
+				chn->a = a;
+				chn->b = b;
+				chn->c = c;
 			}
 			else
 			{
-				FULLMIXER_TEMPLATE(FULLMIXER_8BIT_LERP_RAMP_FILTER(false), FULLMIXER_16BIT_LERP_RAMP_FILTER(false), 16, 1);
+				if (rampFromVolStepL || rampFromVolStepR)
+				{
+					FULLMIXER_TEMPLATE(FULLMIXER_8BIT_LERP_RAMP_FILTER(true, false), FULLMIXER_16BIT_LERP_RAMP_FILTER(true, false), 16, 0);
+				}
+				else
+				{
+					FULLMIXER_TEMPLATE(FULLMIXER_8BIT_LERP_RAMP_FILTER(false, false), FULLMIXER_16BIT_LERP_RAMP_FILTER(false, false), 16, 1);
+				}
 			}
 
 			chn->currsample = currsample;
@@ -280,21 +303,45 @@ public:
 		// filter in use?
 		if (chn->cutoff != ChannelMixer::MP_INVALID_VALUE && chn->resonance != ChannelMixer::MP_INVALID_VALUE)
 		{
-			const mp_sint32 a = chn->a;
-			const mp_sint32 b = chn->b;
-			const mp_sint32 c = chn->c;
+			mp_sint32 a = chn->a;
+			mp_sint32 b = chn->b;
+			mp_sint32 c = chn->c;
+
+			const mp_sint32 rampFilterStepA = chn->rampFilterStepA;
+			const mp_sint32 rampFilterStepB = chn->rampFilterStepB;
+			const mp_sint32 rampFilterStepC = chn->rampFilterStepC;
 
 			mp_sint32 currsample = chn->currsample;
 			mp_sint32 prevsample = chn->prevsample;
 
-			// check if ramping has to be performed
-			if (rampFromVolStepL || rampFromVolStepR)
+			// coefficients are only ramped with filter smoothing enabled
+			if (rampFilterStepA || rampFilterStepB || rampFilterStepC)
 			{
-				NOCHECKMIXER_TEMPLATE(NOCHECKMIXER_8BIT_LERP_RAMP_FILTER(true), NOCHECKMIXER_16BIT_LERP_RAMP_FILTER(true));
+				// check if ramping has to be performed
+				if (rampFromVolStepL || rampFromVolStepR)
+				{
+					NOCHECKMIXER_TEMPLATE(NOCHECKMIXER_8BIT_LERP_RAMP_FILTER(true, true), NOCHECKMIXER_16BIT_LERP_RAMP_FILTER(true, true));
+				}
+				else
+				{
+					NOCHECKMIXER_TEMPLATE(NOCHECKMIXER_8BIT_LERP_RAMP_FILTER(false, true), NOCHECKMIXER_16BIT_LERP_RAMP_FILTER(false, true));
+				}
+
+				chn->a = a;
+				chn->b = b;
+				chn->c = c;
 			}
 			else
 			{
-				NOCHECKMIXER_TEMPLATE(NOCHECKMIXER_8BIT_LERP_RAMP_FILTER(false), NOCHECKMIXER_16BIT_LERP_RAMP_FILTER(false));
+				// check if ramping has to be performed
+				if (rampFromVolStepL || rampFromVolStepR)
+				{
+					NOCHECKMIXER_TEMPLATE(NOCHECKMIXER_8BIT_LERP_RAMP_FILTER(true, false), NOCHECKMIXER_16BIT_LERP_RAMP_FILTER(true, false));
+				}
+				else
+				{
+					NOCHECKMIXER_TEMPLATE(NOCHECKMIXER_8BIT_LERP_RAMP_FILTER(false, false), NOCHECKMIXER_16BIT_LERP_RAMP_FILTER(false, false));
+				}
 			}
 
 			chn->currsample = currsample;
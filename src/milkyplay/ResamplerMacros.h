@@ -203,7 +203,7 @@
 /////////////////////////////////////////////////////////
 //	    INTERPOLATION/VOLUME RAMPING and FILTERING     //
 /////////////////////////////////////////////////////////
-#define NOCHECKMIXER_8BIT_LERP_RAMP_FILTER(_RAMP_) \
+#define NOCHECKMIXER_8BIT_LERP_RAMP_FILTER(_RAMP_, _FILTERRAMP_) \
 	sd1 = sample[posfixed>>16]<<8; \
 	sd2 = sample[(posfixed>>16)+1]<<8; \
 	\
@@ -221,9 +221,16 @@
 	{ \
 		voll+=rampFromVolStepL; \
 		volr+=rampFromVolStepR; \
+	} \
+	\
+	if ((_FILTERRAMP_)) \
+	{ \
+		a+=rampFilterStepA; \
+		b+=rampFilterStepB; \
+		c+=rampFilterStepC; \
 	}
 
-#define NOCHECKMIXER_16BIT_LERP_RAMP_FILTER(_RAMP_) \
+#define NOCHECKMIXER_16BIT_LERP_RAMP_FILTER(_RAMP_, _FILTERRAMP_) \
 	sd1 = sample[posfixed>>16]; \
 	sd2 = sample[(posfixed>>16)+1]; \
 	\
@@ -241,6 +248,13 @@
 	{ \
 		voll+=rampFromVolStepL; \
 		volr+=rampFromVolStepR; \
+	} \
+	\
+	if ((_FILTERRAMP_)) \
+	{ \
+		a+=rampFilterStepA; \
+		b+=rampFilterStepB; \
+		c+=rampFilterStepC; \
 	}
 
 #define BIDIR_REPOSITION(FRACBITS, SMPPOS, SMPPOSFRAC, LOOPSTART, LOOPEND) \
@@ -575,7 +589,7 @@ continueWithBiDir16_## LABELNO: \
 /////////////////////////////////////////////////////////
 //	    INTERPOLATION/VOLUME RAMPING and FILTERING     //
 /////////////////////////////////////////////////////////
-#define FULLMIXER_8BIT_LERP_RAMP_FILTER(_RAMP_) \
+#define FULLMIXER_8BIT_LERP_RAMP_FILTER(_RAMP_, _FILTERRAMP_) \
 	sd1 = ((mp_sbyte)sample[smppos])<<8; \
 	sd2 = ((mp_sbyte)sample[smppos+1])<<8; \
 	\
@@ -593,9 +607,16 @@ continueWithBiDir16_## LABELNO: \
 	{ \
 		voll+=rampFromVolStepL; \
 		volr+=rampFromVolStepR; \
+	} \
+	\
+	if ((_FILTERRAMP_)) \
+	{ \
+		a+=rampFilterStepA; \
+		b+=rampFilterStepB; \
+		c+=rampFilterStepC; \
 	}
 
-#define FULLMIXER_16BIT_LERP_RAMP_FILTER(_RAMP_) \
+#define FULLMIXER_16BIT_LERP_RAMP_FILTER(_RAMP_, _FILTERRAMP_) \
 	sd1 = ((mp_sword*)(sample))[smppos]; \
 	sd2 = ((mp_sword*)(sample))[smppos+1]; \
 	\
@@ -613,6 +634,13 @@ continueWithBiDir16_## LABELNO: \
 	{ \
 		voll+=rampFromVolStepL; \
 		volr+=rampFromVolStepR; \
+	} \
+	\
+	if ((_FILTERRAMP_)) \
+	{ \
+		a+=rampFilterStepA; \
+		b+=rampFilterStepB; \
+		c+=rampFilterStepC; \
 	}
 
 
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ResamplerSIMD.h
+ *  MilkyPlay
+ *
+ *  AVX2 versions of the linear, cubic and sinc table resamplers.
+ *  The kernels compute eight output frames (or sinc taps) at once and
+ *  are bit identical to their scalar counterparts. ResamplerFactory picks
+ *  them at runtime depending on the CPU features.
+ */
+#ifndef __RESAMPLERSIMD_H__
+#define __RESAMPLERSIMD_H__
+
+#include "ChannelMixer.h"
+#include "ResamplerFast.h"
+#include "ResamplerCubic.h"
+#include "ResamplerSinc.h"
+
+// __RESAMPLER_AVX2__ is defined by the build system when ResamplerAVX2.cpp
+// is compiled with AVX2 code generation enabled
+
+class ResamplerSIMD
+{
+public:
+	// ResamplerAVX2.cpp
+	static void addBlockLerpAVX2(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count, bool ramping);
+	static void addBlockCubicAVX2(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count, bool ramping, CubicResamplers type);
+	static void addBlockSincTableAVX2(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count, bool ramping, const mp_sint32* sincTable);
+
+	// Plain sinc table resampler, the SIMD kernels fall back to it for the
+	// frames whose window touches a loop point (ResamplerFactory.cpp)
+	static void addBlockSincTableScalar(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count, bool ramping);
+};
+
+#ifdef __RESAMPLER_AVX2__
+class ResamplerLerpAVX2 : public ResamplerLerp
+{
+public:
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		ResamplerSIMD::addBlockLerpAVX2(buffer, chn, count, false);
+	}
+};
+
+class ResamplerLerpRampFilterAVX2 : public ResamplerLerpRampFilter
+{
+public:
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		// the resonant filter is recursive, leave it to the scalar code
+		if (chn->cutoff != ChannelMixer::MP_INVALID_VALUE && chn->resonance != ChannelMixer::MP_INVALID_VALUE)
+			ResamplerLerpRampFilter::addBlockNoCheck(buffer, chn, count);
+		else
+			ResamplerSIMD::addBlockLerpAVX2(buffer, chn, count, true);
+	}
+};
+
+template<bool ramping, CubicResamplers type>
+class ResamplerLagrangeAVX2 : public ResamplerLagrange<ramping, type>
+{
+public:
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		ResamplerSIMD::addBlockCubicAVX2(buffer, chn, count, ramping, type);
+	}
+};
+
+template<bool ramping>
+class ResamplerSincTableAVX2 : public ResamplerSincTable<ramping, 16>
+{
+public:
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		ResamplerSIMD::addBlockSincTableAVX2(buffer, chn, count, ramping, ResamplerSincTableBase<16>::sinc_table);
+	}
+};
+#endif
+
+#endif
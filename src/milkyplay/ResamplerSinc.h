@@ -35,6 +35,9 @@
  *
  */
 
+#ifndef __RESAMPLERSINC_H__
+#define __RESAMPLERSINC_H__
+
 #include <math.h>
 
 /*
@@ -601,3 +604,5 @@ public:
 #undef SINCTAB
 
 #undef fpmul
+
+#endif
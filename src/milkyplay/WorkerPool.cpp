@@ -0,0 +1,479 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  WorkerPool.cpp
+ *  MilkyPlay
+ *
+ */
+#include "WorkerPool.h"
+#include "MilkyPlayCommon.h"
+#include "MilkyPlayAtomic.h"
+
+#if defined(WIN32) && !defined(_WIN32_WCE)
+	#define WORKERPOOL_WIN32
+#elif !defined(__AMIGA__) && !defined(__AROS__) && !defined(__PSP__) && !defined(_WIN32_WCE)
+	#define WORKERPOOL_PTHREAD
+	#include <pthread.h>
+	#include <sched.h>
+	#include <unistd.h>
+#endif
+
+#if defined(WORKERPOOL_WIN32)
+
+struct WorkerPool::TPlatformData
+{
+	CRITICAL_SECTION	mutex;
+	HANDLE				wakeUp;			// semaphore, one count per worker and job
+	HANDLE				allDone;		// auto reset event, set by the worker finishing the last task
+	HANDLE				threads[MAXWORKERS];
+};
+
+#define WP_LOCK(pd)		EnterCriticalSection(&(pd)->mutex)
+#define WP_UNLOCK(pd)	LeaveCriticalSection(&(pd)->mutex)
+
+#elif defined(WORKERPOOL_PTHREAD)
+
+struct WorkerPool::TPlatformData
+{
+	pthread_mutex_t		mutex;
+	pthread_cond_t		wakeUp;
+	pthread_cond_t		allDone;
+	pthread_t			threads[MAXWORKERS];
+};
+
+#define WP_LOCK(pd)		pthread_mutex_lock(&(pd)->mutex)
+#define WP_UNLOCK(pd)	pthread_mutex_unlock(&(pd)->mutex)
+
+#else
+
+struct WorkerPool::TPlatformData
+{
+};
+
+#endif
+
+// layout of rtState
+#define RT_TASKBITS		10
+#define RT_TASKMASK		((1 << RT_TASKBITS) - 1)
+#define RT_SEQSHIFT		(RT_TASKBITS * 2)
+
+// number of polls of rtState before an idle worker goes to sleep
+#define RT_SPINCOUNT	20000
+
+// number of polls runRealtime() spends waiting for running tasks before
+// it starts giving up its time slice on every poll
+#define RT_WAITSPINCOUNT 2000
+
+// tell the CPU we're in a spin loop (saves power, frees the pipeline
+// for a sibling hyperthread which might be running the worker)
+static inline void cpuRelax()
+{
+#if defined(_MSC_VER)
+	YieldProcessor();
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	__builtin_ia32_pause();
+#elif defined(__GNUC__) && (defined(__aarch64__) || defined(__arm__))
+	__asm__ __volatile__("yield");
+#endif
+}
+
+// let another thread run on this CPU, e.g. a worker which has been
+// preempted while running a task we're waiting for
+static inline void yieldThread()
+{
+#if defined(WORKERPOOL_WIN32)
+	SwitchToThread();
+#elif defined(WORKERPOOL_PTHREAD)
+	sched_yield();
+#endif
+}
+
+bool WorkerPool::isSupported()
+{
+#if defined(WORKERPOOL_WIN32) || defined(WORKERPOOL_PTHREAD)
+	return true;
+#else
+	return false;
+#endif
+}
+
+mp_uint32 WorkerPool::getNumProcessors()
+{
+#if defined(WORKERPOOL_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (mp_uint32)info.dwNumberOfProcessors : 1;
+#elif defined(WORKERPOOL_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+	long num = sysconf(_SC_NPROCESSORS_ONLN);
+	return num > 0 ? (mp_uint32)num : 1;
+#else
+	return 1;
+#endif
+}
+
+WorkerPool::WorkerPool(mp_uint32 numWorkers) :
+	platformData(NULL),
+	numWorkers(0),
+	numWorkersStarted(0),
+	handler(NULL),
+	userData(NULL),
+	numTasks(0),
+	nextTask(0),
+	numTasksDone(0),
+	shutdown(false),
+	rtHandler(NULL),
+	rtUserData(NULL),
+	rtState(0),
+	rtNumTasksDone(0),
+	rtSequence(0)
+{
+	if (!isSupported() || numWorkers == 0)
+		return;
+
+	if (numWorkers > MAXWORKERS)
+		numWorkers = MAXWORKERS;
+
+	platformData = new TPlatformData;
+
+#if defined(WORKERPOOL_WIN32)
+	InitializeCriticalSection(&platformData->mutex);
+	platformData->wakeUp = CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL);
+	platformData->allDone = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+	for (mp_uint32 i = 0; i < numWorkers; i++)
+	{
+		platformData->threads[i] = CreateThread(NULL, 0, threadProc, this, 0, NULL);
+		if (platformData->threads[i] == NULL)
+			break;
+		this->numWorkers++;
+	}
+#elif defined(WORKERPOOL_PTHREAD)
+	pthread_mutex_init(&platformData->mutex, NULL);
+	pthread_cond_init(&platformData->wakeUp, NULL);
+	pthread_cond_init(&platformData->allDone, NULL);
+
+	for (mp_uint32 i = 0; i < numWorkers; i++)
+	{
+		if (pthread_create(&platformData->threads[i], NULL, threadProc, this) != 0)
+			break;
+		this->numWorkers++;
+	}
+#endif
+}
+
+WorkerPool::~WorkerPool()
+{
+	if (platformData == NULL)
+		return;
+
+#if defined(WORKERPOOL_WIN32)
+	WP_LOCK(platformData);
+	shutdown = true;
+	WP_UNLOCK(platformData);
+	ReleaseSemaphore(platformData->wakeUp, numWorkers, NULL);
+
+	for (mp_uint32 i = 0; i < numWorkers; i++)
+	{
+		WaitForSingleObject(platformData->threads[i], INFINITE);
+		CloseHandle(platformData->threads[i]);
+	}
+
+	CloseHandle(platformData->allDone);
+	CloseHandle(platformData->wakeUp);
+	DeleteCriticalSection(&platformData->mutex);
+#elif defined(WORKERPOOL_PTHREAD)
+	WP_LOCK(platformData);
+	shutdown = true;
+	pthread_cond_broadcast(&platformData->wakeUp);
+	WP_UNLOCK(platformData);
+
+	for (mp_uint32 i = 0; i < numWorkers; i++)
+		pthread_join(platformData->threads[i], NULL);
+
+	pthread_cond_destroy(&platformData->allDone);
+	pthread_cond_destroy(&platformData->wakeUp);
+	pthread_mutex_destroy(&platformData->mutex);
+#endif
+
+	delete platformData;
+}
+
+// must be called with the mutex held
+bool WorkerPool::fetchTask(mp_uint32& taskIndex)
+{
+	if (nextTask >= numTasks)
+		return false;
+
+	taskIndex = nextTask++;
+	return true;
+}
+
+bool WorkerPool::realtimeTaskPending() const
+{
+	const mp_uint32 state = atomicLoadAcquire(&rtState);
+	return (state & RT_TASKMASK) < ((state >> RT_TASKBITS) & RT_TASKMASK);
+}
+
+void WorkerPool::processRealtimeTasks(mp_uint32 threadIndex)
+{
+	for (;;)
+	{
+		const mp_uint32 state = atomicLoadAcquire(&rtState);
+		const mp_uint32 taskIndex = state & RT_TASKMASK;
+		if (taskIndex >= ((state >> RT_TASKBITS) & RT_TASKMASK))
+			return;
+
+		// fails if somebody else claimed this task or a new job was started
+		if (!atomicCompareExchange(&rtState, state, state + 1))
+			continue;
+
+		// the job can't finish before this task does, so its
+		// handler and user data stay valid until then
+		rtHandler(rtUserData, taskIndex, threadIndex);
+		atomicFetchAdd(&rtNumTasksDone, 1);
+	}
+}
+
+#if defined(WORKERPOOL_WIN32) || defined(WORKERPOOL_PTHREAD)
+
+void WorkerPool::workerLoop(WorkerPool* pool)
+{
+	TPlatformData* pd = pool->platformData;
+
+	WP_LOCK(pd);
+	const mp_uint32 threadIndex = ++pool->numWorkersStarted;
+	while (!pool->shutdown)
+	{
+		if (pool->realtimeTaskPending())
+		{
+			WP_UNLOCK(pd);
+			pool->processRealtimeTasks(threadIndex);
+
+			// the next job is most likely just a beat packet away
+			for (mp_uint32 i = 0; i < RT_SPINCOUNT && !pool->realtimeTaskPending(); i++)
+				cpuRelax();
+
+			WP_LOCK(pd);
+			continue;
+		}
+
+		mp_uint32 taskIndex;
+		if (!pool->fetchTask(taskIndex))
+		{
+#if defined(WORKERPOOL_WIN32)
+			WP_UNLOCK(pd);
+			WaitForSingleObject(pd->wakeUp, INFINITE);
+			WP_LOCK(pd);
+#else
+			pthread_cond_wait(&pd->wakeUp, &pd->mutex);
+#endif
+			continue;
+		}
+
+		WP_UNLOCK(pd);
+		pool->handler(pool->userData, taskIndex);
+		WP_LOCK(pd);
+
+		// the worker finishing the last task wakes up run()
+		if (++pool->numTasksDone == pool->numTasks)
+		{
+#if defined(WORKERPOOL_WIN32)
+			SetEvent(pd->allDone);
+#else
+			pthread_cond_signal(&pd->allDone);
+#endif
+		}
+	}
+	WP_UNLOCK(pd);
+}
+
+#if defined(WORKERPOOL_WIN32)
+unsigned long __stdcall WorkerPool::threadProc(void* arg)
+{
+	workerLoop(reinterpret_cast<WorkerPool*>(arg));
+	return 0;
+}
+#else
+void* WorkerPool::threadProc(void* arg)
+{
+	workerLoop(reinterpret_cast<WorkerPool*>(arg));
+	return NULL;
+}
+#endif
+
+#else
+
+void WorkerPool::workerLoop(WorkerPool* pool)
+{
+}
+
+void* WorkerPool::threadProc(void* arg)
+{
+	return NULL;
+}
+
+#endif
+
+void WorkerPool::run(TTaskHandler handler, void* userData, mp_uint32 numTasks)
+{
+	if (numWorkers == 0 || numTasks <= 1)
+	{
+		for (mp_uint32 i = 0; i < numTasks; i++)
+			handler(userData, i);
+		return;
+	}
+
+	start(handler, userData, numTasks);
+	wait();
+}
+
+void WorkerPool::start(TTaskHandler handler, void* userData, mp_uint32 numTasks)
+{
+	if (numWorkers == 0)
+	{
+		// no threads, wait() processes everything
+		this->handler = handler;
+		this->userData = userData;
+		this->numTasks = numTasks;
+		this->nextTask = 0;
+		this->numTasksDone = 0;
+		return;
+	}
+
+#if defined(WORKERPOOL_WIN32) || defined(WORKERPOOL_PTHREAD)
+	TPlatformData* pd = platformData;
+
+	WP_LOCK(pd);
+	this->handler = handler;
+	this->userData = userData;
+	this->numTasks = numTasks;
+	this->nextTask = 0;
+	this->numTasksDone = 0;
+#if defined(WORKERPOOL_WIN32)
+	ReleaseSemaphore(pd->wakeUp, numTasks < numWorkers ? numTasks : numWorkers, NULL);
+#else
+	pthread_cond_broadcast(&pd->wakeUp);
+#endif
+	WP_UNLOCK(pd);
+#endif
+}
+
+void WorkerPool::wait()
+{
+	if (numWorkers == 0)
+	{
+		while (nextTask < numTasks)
+			handler(userData, nextTask++);
+		numTasksDone = numTasks;
+		return;
+	}
+
+#if defined(WORKERPOOL_WIN32) || defined(WORKERPOOL_PTHREAD)
+	TPlatformData* pd = platformData;
+
+	WP_LOCK(pd);
+
+	// the calling thread takes part in processing
+	bool finishedLast = false;
+	mp_uint32 taskIndex;
+	while (fetchTask(taskIndex))
+	{
+		WP_UNLOCK(pd);
+		handler(userData, taskIndex);
+		WP_LOCK(pd);
+
+		finishedLast = (++numTasksDone == numTasks);
+	}
+
+	// if a worker finished the last task it has signalled (or will signal) us
+	if (!finishedLast && numTasks)
+	{
+#if defined(WORKERPOOL_WIN32)
+		WP_UNLOCK(pd);
+		WaitForSingleObject(pd->allDone, INFINITE);
+		WP_LOCK(pd);
+#else
+		while (numTasksDone < numTasks)
+			pthread_cond_wait(&pd->allDone, &pd->mutex);
+#endif
+	}
+	WP_UNLOCK(pd);
+#endif
+}
+
+void WorkerPool::runRealtime(TRealtimeTaskHandler handler, void* userData, mp_uint32 numTasks)
+{
+	if (numWorkers == 0 || numTasks <= 1 || numTasks > MAXREALTIMETASKS)
+	{
+		for (mp_uint32 i = 0; i < numTasks; i++)
+			handler(userData, i, 0);
+		return;
+	}
+
+#if defined(WORKERPOOL_WIN32) || defined(WORKERPOOL_PTHREAD)
+	// all tasks of the previous job are done, nobody reads these right now
+	rtHandler = handler;
+	rtUserData = userData;
+	rtNumTasksDone = 0;
+	rtSequence++;
+	atomicStoreRelease(&rtState, (rtSequence << RT_SEQSHIFT) | (numTasks << RT_TASKBITS));
+
+	// wake up sleeping workers without waiting for the lock, if a worker
+	// holds it and misses the wake up it just sits out this job
+	TPlatformData* pd = platformData;
+#if defined(WORKERPOOL_WIN32)
+	ReleaseSemaphore(pd->wakeUp, numTasks - 1 < numWorkers ? numTasks - 1 : numWorkers, NULL);
+#else
+	if (pthread_mutex_trylock(&pd->mutex) == 0)
+	{
+		pthread_cond_broadcast(&pd->wakeUp);
+		WP_UNLOCK(pd);
+	}
+	else
+	{
+		pthread_cond_broadcast(&pd->wakeUp);
+	}
+#endif
+
+	// run every task nobody else has started
+	processRealtimeTasks(0);
+
+	// the remaining ones are already running, one per worker at most. If
+	// such a worker got preempted spinning would burn the whole period,
+	// so after a while give it the chance to finish on this CPU
+	for (mp_uint32 i = 0; atomicLoadAcquire(&rtNumTasksDone) < numTasks; i++)
+	{
+		if (i < RT_WAITSPINCOUNT)
+			cpuRelax();
+		else
+			yieldThread();
+	}
+#endif
+}
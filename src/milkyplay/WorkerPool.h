@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  WorkerPool.h
+ *  MilkyPlay
+ *
+ *  Tiny fork/join thread pool. run() distributes a number of independent
+ *  tasks among the worker threads and the calling thread and returns when
+ *  all of them are done. On platforms without thread support (Amiga, PSP)
+ *  the pool has no workers and run() simply executes all tasks in order on
+ *  the calling thread.
+ */
+#ifndef __WORKERPOOL_H__
+#define __WORKERPOOL_H__
+
+#include "MilkyPlayTypes.h"
+
+class WorkerPool
+{
+public:
+	typedef void (*TTaskHandler)(void* userData, mp_uint32 taskIndex);
+	// threadIndex is 0 for the calling thread and 1..getNumWorkers() for
+	// the workers, so tasks can accumulate into per thread buffers
+	typedef void (*TRealtimeTaskHandler)(void* userData, mp_uint32 taskIndex, mp_uint32 threadIndex);
+
+	enum
+	{
+		MAXWORKERS = 32,
+		// maximum number of tasks for runRealtime()
+		MAXREALTIMETASKS = 1023
+	};
+
+private:
+	struct TPlatformData;
+
+	TPlatformData*	platformData;
+	mp_uint32		numWorkers;
+	// workers which have entered their loop, hands out the thread indices
+	mp_uint32		numWorkersStarted;
+
+	// current job, protected by the platform mutex
+	TTaskHandler	handler;
+	void*			userData;
+	mp_uint32		numTasks;
+	mp_uint32		nextTask;
+	mp_uint32		numTasksDone;
+	bool			shutdown;
+
+	// lock free job of runRealtime(): the state packs a job sequence
+	// number, the number of tasks and the next task to be claimed
+	TRealtimeTaskHandler rtHandler;
+	void*			rtUserData;
+	volatile mp_uint32 rtState;
+	volatile mp_uint32 rtNumTasksDone;
+	mp_uint32		rtSequence;
+
+	// grab the next pending task, returns false if there is none left
+	bool			fetchTask(mp_uint32& taskIndex);
+
+	bool			realtimeTaskPending() const;
+	// claim and run tasks of the current lock free job until none is left
+	void			processRealtimeTasks(mp_uint32 threadIndex);
+
+	static void		workerLoop(WorkerPool* pool);
+
+#if defined(WIN32) && !defined(_WIN32_WCE)
+	static unsigned long __stdcall threadProc(void* arg);
+#else
+	static void*	threadProc(void* arg);
+#endif
+
+public:
+	// numWorkers is the number of *additional* threads, the calling thread
+	// always takes part in run()
+					WorkerPool(mp_uint32 numWorkers);
+					~WorkerPool();
+
+	mp_uint32		getNumWorkers() const { return numWorkers; }
+
+	void			run(TTaskHandler handler, void* userData, mp_uint32 numTasks);
+
+	// same as run() split in two: start() hands the tasks to the workers and
+	// returns immediately, wait() helps out with the remaining tasks and
+	// returns when all of them are done. Every start() needs a wait().
+	void			start(TTaskHandler handler, void* userData, mp_uint32 numTasks);
+	void			wait();
+
+	// same as run() but never blocks the calling thread, meant for the audio
+	// callback: waking the workers doesn't wait for a lock and every thread
+	// claims one task at a time, so all tasks no worker has picked up yet
+	// are run by the calling thread. Only tasks which are already running
+	// elsewhere are waited for, at most one per worker. Keep tasks small
+	// (e.g. one channel each) so a preempted worker holds up little work.
+	// Workers poll for a while after each job so back to back jobs (beat
+	// packets) find them awake. More than MAXREALTIMETASKS tasks are run
+	// serially.
+	void			runRealtime(TRealtimeTaskHandler handler, void* userData, mp_uint32 numTasks);
+
+	// returns false if this platform can't run tasks in parallel
+	static bool		isSupported();
+	static mp_uint32 getNumProcessors();
+};
+
+#endif
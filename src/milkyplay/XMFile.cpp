@@ -32,6 +32,7 @@
 // to make future porting easier										//
 //////////////////////////////////////////////////////////////////////////
 #include "XMFile.h"
+#include "LittleEndian.h"
 
 XMFileBase::XMFileBase() :
 	baseOffset(0)
@@ -99,16 +100,40 @@ mp_dword XMFileBase::readDword()
 					  ((mp_uint32)c[3]<<24));
 }
 
+// Bulk versions: read everything in one go and swap in place,
+// incomplete items at the end are zeroed just like readWord/readDword do
 void XMFileBase::readWords(mp_uword* buffer,mp_sint32 count)
 {
-	for (mp_sint32 i = 0; i < count; i++)
-		*buffer++ = readWord();
+	if (count <= 0)
+		return;
+
+	mp_ubyte* src = (mp_ubyte*)buffer;
+	mp_sint32 bytesRead = read(src, 1, count*2);
+	if (bytesRead < 0)
+		bytesRead = 0;
+	
+	mp_sint32 complete = bytesRead >> 1;
+	memset(buffer + complete, 0, (count - complete)*2);
+
+	for (mp_sint32 i = 0; i < complete; i++)
+		buffer[i] = LittleEndian::GET_WORD(src + i*2);
 }
 
 void XMFileBase::readDwords(mp_dword* buffer,mp_sint32 count)
 {
-	for (mp_sint32 i = 0; i < count; i++)
-		*buffer++ = readDword();
+	if (count <= 0)
+		return;
+
+	mp_ubyte* src = (mp_ubyte*)buffer;
+	mp_sint32 bytesRead = read(src, 1, count*4);
+	if (bytesRead < 0)
+		bytesRead = 0;
+	
+	mp_sint32 complete = bytesRead >> 2;
+	memset(buffer + complete, 0, (count - complete)*4);
+
+	for (mp_sint32 i = 0; i < complete; i++)
+		buffer[i] = LittleEndian::GET_DWORD(src + i*4);
 }
 
 void XMFileBase::writeByte(mp_ubyte b)
@@ -172,7 +197,10 @@ void XMFileBase::writeString(const char* string)
 XMFile::XMFile(const SYSCHAR*	fileName, bool writeAccess /* = false*/) :
 	XMFileBase(),
 	fileName(fileName),
-	cacheBuffer(NULL)
+	cacheBuffer(NULL),
+	mappedData(NULL),
+	mappedSize(0),
+	mappedPos(0)
 {
 	this->writeAccess = writeAccess;
 
@@ -317,6 +345,20 @@ bool XMFile::remove(const SYSCHAR* file)
 	return DeleteFile(file);
 }
 
+// No memory mapping on windows (yet), reading goes through ReadFile
+void XMFile::map()
+{
+}
+
+void XMFile::unmap()
+{
+}
+
+const mp_ubyte* XMFile::getPointer(mp_uint32 offset, mp_uint32 len)
+{
+	return NULL;
+}
+
 bool XMFile::exists(const SYSCHAR* file)
 {
 	HANDLE handle = CreateFile(file,
@@ -359,11 +401,21 @@ const char* XMFile::getFileNameASCII()
 
 #include <unistd.h>
 
+#if !defined(__AMIGA__) && !defined(__AROS__) && !defined(__PSP__)
+	#define XMFILE_MMAP
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+#endif
+
 XMFile::XMFile(const SYSCHAR*	fileName, bool writeAccess /* = false*/) :
 	XMFileBase(),
 	fileName(fileName),
 	fileNameASCII(NULL),
-	cacheBuffer(NULL)
+	cacheBuffer(NULL),
+	mappedData(NULL),
+	mappedSize(0),
+	mappedPos(0)
 {
 	this->writeAccess = writeAccess;
 
@@ -377,6 +429,10 @@ XMFile::XMFile(const SYSCHAR*	fileName, bool writeAccess /* = false*/) :
 		cacheBuffer = new mp_ubyte[BUFFERSIZE];
 		currentCacheBufferPtr = cacheBuffer;
 	}
+	else if (handle != NULL)
+	{
+		map();
+	}
 }
 
 XMFile::~XMFile()
@@ -384,6 +440,8 @@ XMFile::~XMFile()
 	if (writeAccess && handle != NULL)
 		flush();
 	
+	unmap();
+	
 	if (handle != NULL)
 		fclose(handle);
 	
@@ -399,8 +457,74 @@ bool XMFile::isOpen()
 	return handle != NULL;
 }
 
+// Map the whole file when opened for reading, reads are plain memcpys
+// from the mapping then. If mapping fails for whatever reason (empty file,
+// pipe, file system without mmap support) we silently stay with stdio.
+void XMFile::map()
+{
+#ifdef XMFILE_MMAP
+	struct stat st;
+	if (fstat(fileno(handle), &st) != 0 || !S_ISREG(st.st_mode))
+		return;
+	
+	if (st.st_size <= 0 || (mp_int64)st.st_size > (mp_int64)0x7FFFFFFF)
+		return;
+	
+	void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(handle), 0);
+	if (data == MAP_FAILED)
+		return;
+	
+#ifdef MADV_SEQUENTIAL
+	// loaders mostly read front to back
+	madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+	
+	mappedData = (mp_ubyte*)data;
+	mappedSize = (mp_uint32)st.st_size;
+	mappedPos = 0;
+#endif
+}
+
+void XMFile::unmap()
+{
+#ifdef XMFILE_MMAP
+	if (mappedData)
+		munmap(mappedData, mappedSize);
+#endif
+	mappedData = NULL;
+	mappedSize = mappedPos = 0;
+}
+
+const mp_ubyte* XMFile::getPointer(mp_uint32 offset, mp_uint32 len)
+{
+	if (mappedData == NULL || offset > mappedSize || len > mappedSize - offset)
+		return NULL;
+	
+	return mappedData + offset;
+}
+
 mp_sint32 XMFile::read(void* ptr, mp_sint32 size, mp_sint32 count)
 {
+	if (mappedData)
+	{
+		if (size <= 0 || count <= 0)
+			return 0;
+		
+		// same semantics as fread: copy what's there, but only
+		// count complete items
+		mp_uint32 avail = mappedPos < mappedSize ? mappedSize - mappedPos : 0;
+		mp_uint32 len = (mp_uint32)size*(mp_uint32)count;
+		if (len > avail)
+			len = avail;
+		
+		memcpy(ptr, mappedData + mappedPos, len);
+		mappedPos += len;
+		
+		len -= len % size;
+		bytesRead += len;
+		return (mp_sint32)len;
+	}
+	
 	unsigned long NumberOfBytesRead = fread(ptr,size,count,handle)*size;
 	bytesRead += NumberOfBytesRead;
 	return (mp_sint32)NumberOfBytesRead;
@@ -457,6 +581,21 @@ void XMFile::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTy
 		flush();
 		fflush(handle);
 	}
+	
+	if (mappedData)
+	{
+		mp_int64 newPos = (mp_int64)pos;
+		
+		if (seekOffsetType == XMFile::SeekOffsetTypeCurrent)
+			newPos = (mp_int64)mappedPos + (mp_sint32)pos;
+		else if (seekOffsetType == XMFile::SeekOffsetTypeEnd)
+			newPos = (mp_int64)mappedSize + (mp_sint32)pos;
+		
+		// like fseek: seeking before the start fails, beyond the end is fine
+		if (newPos >= 0 && newPos <= (mp_int64)0xFFFFFFFF)
+			mappedPos = (mp_uint32)newPos;
+		return;
+	}
 		
 	int moveMethod = SEEK_SET;
 
@@ -470,11 +609,17 @@ void XMFile::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTy
 
 mp_uint32 XMFile::pos()
 {
+	if (mappedData)
+		return mappedPos;
+
 	return static_cast<mp_uint32>(ftell(handle));
 }
 
 mp_uint32 XMFile::size()
 {
+	if (mappedData)
+		return mappedSize;
+
 	mp_uint32 size = 0;
 	mp_uint32 curPos = pos();
 	fseek(handle,0,SEEK_END);
@@ -70,6 +70,11 @@ public:
 	virtual	bool			isOpen() = 0;
 	virtual	bool			isOpenForWriting()  = 0;
 
+	// Direct read only access to len bytes at the absolute offset, NULL if
+	// the data isn't held in memory (or the range is out of bounds).
+	// The file position is not changed.
+	virtual const mp_ubyte*	getPointer(mp_uint32 offset, mp_uint32 len) { return NULL; }
+
 	mp_ubyte				readByte();
 	mp_uword				readWord();
 	mp_dword				readDword();
@@ -106,7 +111,14 @@ private:
 	mp_ubyte*		cacheBuffer;
 	mp_ubyte*		currentCacheBufferPtr;
 	
+	// read only files are memory mapped where available
+	mp_ubyte*		mappedData;
+	mp_uint32		mappedSize;
+	mp_uint32		mappedPos;
+	
 	void			flush();
+	void			map();
+	void			unmap();
 	
 public:
 							XMFile(const SYSCHAR* fileName, bool writeAccess = false);
@@ -126,6 +138,8 @@ public:
 	virtual bool			isOpen();
 	virtual bool			isOpenForWriting() { return isOpen() && writeAccess; }
 	
+	virtual const mp_ubyte*	getPointer(mp_uint32 offset, mp_uint32 len);
+	
 	static bool				exists(const SYSCHAR* file);
 	static bool				remove(const SYSCHAR* file);
 };
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  XMFileMemory.cpp
+ *  MilkyPlay
+ *
+ */
+#include "XMFileMemory.h"
+
+XMFileMemory::XMFileMemory(const SYSCHAR* fileName/* = NULL*/, mp_uint32 initialSize/* = 0*/) :
+	XMFileBase(),
+	fileName(fileName),
+	fileNameASCII(NULL),
+	buffer(NULL),
+	bufferSize(0),
+	dataSize(0),
+	position(0),
+	ownsBuffer(true),
+	writeAccess(true)
+{
+	if (initialSize)
+		reserve(initialSize);
+}
+
+XMFileMemory::XMFileMemory(const void* data, mp_uint32 size, const SYSCHAR* fileName/* = NULL*/) :
+	XMFileBase(),
+	fileName(fileName),
+	fileNameASCII(NULL),
+	buffer((mp_ubyte*)data),
+	bufferSize(size),
+	dataSize(size),
+	position(0),
+	ownsBuffer(false),
+	writeAccess(false)
+{
+}
+
+XMFileMemory::~XMFileMemory()
+{
+	if (ownsBuffer)
+		delete[] buffer;
+
+	delete[] fileNameASCII;
+}
+
+bool XMFileMemory::reserve(mp_uint32 size)
+{
+	if (size <= bufferSize)
+		return true;
+
+	// grow geometrically, many small writes are expected
+	mp_uint32 newSize = bufferSize ? bufferSize : 4096;
+	while (newSize < size)
+	{
+		if (newSize > 0x7FFFFFFF)
+		{
+			newSize = size;
+			break;
+		}
+		newSize<<=1;
+	}
+
+	mp_ubyte* newBuffer = new mp_ubyte[newSize];
+
+	if (buffer)
+	{
+		memcpy(newBuffer, buffer, dataSize);
+		delete[] buffer;
+	}
+
+	buffer = newBuffer;
+	bufferSize = newSize;
+	return true;
+}
+
+mp_sint32 XMFileMemory::read(void* ptr, mp_sint32 size, mp_sint32 count)
+{
+	if (size <= 0 || count <= 0 || position >= dataSize)
+		return 0;
+
+	// only whole items are read, like fread
+	mp_uint32 numItems = (dataSize - position) / size;
+	if ((mp_uint32)count < numItems)
+		numItems = count;
+
+	const mp_uint32 numBytes = numItems * size;
+
+	memcpy(ptr, buffer + position, numBytes);
+	position+=numBytes;
+
+	return (mp_sint32)numBytes;
+}
+
+mp_sint32 XMFileMemory::write(const void* ptr, mp_sint32 size, mp_sint32 count)
+{
+	if (!writeAccess || size <= 0 || count <= 0)
+		return 0;
+
+	const mp_uint32 numBytes = size * count;
+
+	if (!reserve(position + numBytes))
+		return 0;
+
+	// seeking beyond the end leaves a gap, fill it like a file system would
+	if (position > dataSize)
+		memset(buffer + dataSize, 0, position - dataSize);
+
+	memcpy(buffer + position, ptr, numBytes);
+	position+=numBytes;
+
+	if (position > dataSize)
+		dataSize = position;
+
+	return (mp_sint32)numBytes;
+}
+
+void XMFileMemory::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTypeStart*/)
+{
+	switch (seekOffsetType)
+	{
+		case SeekOffsetTypeStart:
+			position = pos;
+			break;
+		case SeekOffsetTypeCurrent:
+			position+=(mp_sint32)pos;
+			break;
+		case SeekOffsetTypeEnd:
+			position = dataSize + (mp_sint32)pos;
+			break;
+	}
+}
+
+const SYSCHAR* XMFileMemory::getFileName()
+{
+	static const SYSCHAR noName[] = {0};
+	return fileName ? fileName : noName;
+}
+
+const char* XMFileMemory::getFileNameASCII()
+{
+	const SYSCHAR* name = getFileName();
+	const SYSCHAR* ptr = name;
+
+	// strip path
+	for (const SYSCHAR* p = name; *p; p++)
+		if (*p == '/' || *p == '\\')
+			ptr = p+1;
+
+	mp_uint32 len = 0;
+	while (ptr[len])
+		len++;
+
+	delete[] fileNameASCII;
+	fileNameASCII = new char[len+1];
+
+	for (mp_uint32 i = 0; i < len; i++)
+		fileNameASCII[i] = (char)ptr[i];
+	fileNameASCII[len] = 0;
+
+	return fileNameASCII;
+}
+
+mp_ubyte* XMFileMemory::detachBuffer()
+{
+	mp_ubyte* result = ownsBuffer ? buffer : NULL;
+
+	if (ownsBuffer)
+	{
+		buffer = NULL;
+		bufferSize = dataSize = position = 0;
+	}
+
+	return result;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  XMFileMemory.h
+ *  MilkyPlay
+ *
+ *  XMFileBase implementation working on a memory buffer, either a read only
+ *  view of existing data or a growable buffer which can be written and read
+ *  back (e.g. to convert a module without going through a temporary file)
+ *
+ */
+#ifndef __XMFILEMEMORY_H__
+#define __XMFILEMEMORY_H__
+
+#include "XMFile.h"
+
+class XMFileMemory : public XMFileBase
+{
+private:
+	const SYSCHAR*	fileName;
+
+	char*			fileNameASCII;
+
+	mp_ubyte*		buffer;
+	mp_uint32		bufferSize;
+	mp_uint32		dataSize;
+	mp_uint32		position;
+
+	bool			ownsBuffer;
+	bool			writeAccess;
+
+	bool			reserve(mp_uint32 size);
+
+public:
+	// Empty growable buffer, open for writing and reading
+							XMFileMemory(const SYSCHAR* fileName = NULL, mp_uint32 initialSize = 0);
+	// Read only view of existing data, the data is not copied and
+	// must stay valid as long as this object is used
+							XMFileMemory(const void* data, mp_uint32 size, const SYSCHAR* fileName = NULL);
+	virtual					~XMFileMemory();
+
+	virtual mp_sint32		read(void* ptr,mp_sint32 size,mp_sint32 count);
+	virtual mp_sint32		write(const void* ptr,mp_sint32 size,mp_sint32 count);
+
+	virtual void			seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType = SeekOffsetTypeStart);
+	virtual mp_uint32		pos() { return position; }
+	virtual mp_uint32		size() { return dataSize; }
+
+	virtual const SYSCHAR*  getFileName();
+
+	virtual const char*		getFileNameASCII();
+
+	virtual bool			isOpen() { return buffer != NULL || ownsBuffer; }
+	virtual bool			isOpenForWriting() { return writeAccess; }
+
+	virtual const mp_ubyte*	getPointer(mp_uint32 offset, mp_uint32 len)
+	{
+		return (buffer && offset <= dataSize && len <= dataSize - offset) ? buffer + offset : NULL;
+	}
+
+	const mp_ubyte*			getBuffer() const { return buffer; }
+
+	// Hand the buffer over to the caller who has to delete[] it,
+	// the file is empty afterwards
+	mp_ubyte*				detachBuffer();
+};
+
+#endif
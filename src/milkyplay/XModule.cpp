@@ -35,6 +35,8 @@
  */
 #include "XModule.h"
 #include "Loaders.h"
+#include "XMFileMemory.h"
+#include "WorkerPool.h"
 
 #undef VERBOSE
 
@@ -309,6 +311,61 @@ void TXMSample::postProcessSamples()
 			}
 		}
 	}
+
+	unrollLoop();
+}
+
+void TXMSample::unrollLoop()
+{
+	const bool is16Bit = (type&16) != 0;
+	mp_ubyte* headerAddr = (mp_ubyte*)sample + (is16Bit ? samplen*2 : samplen) + MP_UNROLLEDLOOP_HEADEROFFSET;
+
+	TUnrolledLoopHeader header;
+	memset(&header, 0, sizeof(header));
+
+	// ping pong loops are left to the mixer's direction handling
+	if ((type&3) == 1)
+		header.length = getUnrolledLoopLength(looplen);
+
+	if (!header.length)
+	{
+		memcpy(headerAddr, &header, sizeof(header));
+		return;
+	}
+
+	header.loopstart = loopstart;
+	header.looplen = looplen;
+	header.looptype = 1;
+
+	const mp_sint32 start = getUnrolledLoopStart(samplen, is16Bit);
+	const mp_sint32 end = start + header.length + MP_UNROLLEDLOOP_LEADOUT;
+	const mp_sint32 looplen = this->looplen;
+
+	ASSERT((end - (mp_sint32)samplen) * (is16Bit ? 2 : 1) <= TrailingPadding);
+
+	if (is16Bit)
+	{
+		mp_sword* data = (mp_sword*)this->sample + loopstart;
+
+		// lead in is what the resamplers see before the loop start
+		data[start - loopstart - 1] = data[-1];
+		for (mp_sint32 i = start; i < end; i++)
+			data[i - loopstart] = data[(i - start) % looplen];
+
+		header.seamless = looplen >= 2 && data[start - loopstart - 1] == data[looplen - 1];
+	}
+	else
+	{
+		mp_sbyte* data = (mp_sbyte*)this->sample + loopstart;
+
+		data[start - loopstart - 1] = data[-1];
+		for (mp_sint32 i = start; i < end; i++)
+			data[i - loopstart] = data[(i - start) % looplen];
+
+		header.seamless = looplen >= 2 && data[start - loopstart - 1] == data[looplen - 1];
+	}
+
+	memcpy(headerAddr, &header, sizeof(header));
 }
 
 // get sample value
@@ -440,18 +497,24 @@ void TXMSample::setSampleValue(mp_ubyte* sample, mp_uint32 index, mp_sint32 valu
 class ITSampleLoader : public XModule::SampleLoader
 {
 private:
-	mp_dword* source_buffer;			/* source buffer */
-	mp_dword* source_position;			/* actual reading position */
-	mp_ubyte source_remaining_bits;		/* bits remaining in read dword */
+	mp_ubyte* source_buffer;			/* copy of the block, NULL if it's read in place */
+	const mp_ubyte* source_position;	/* next byte to go into the bit buffer */
+	const mp_ubyte* source_end;			/* end of the block */
+	mp_uint64 bit_buffer;				/* bits not consumed yet, LSB first */
+	mp_uint32 bit_count;				/* number of bits in bit_buffer */
 
 	bool it215;
 
+	void refill_bit_buffer();
+
 public:
 		ITSampleLoader(XMFileBase& file, bool isIt215 = false) :
 		SampleLoader(file),
 		source_buffer(NULL),
 		source_position(NULL),
-		source_remaining_bits(0),
+		source_end(NULL),
+		bit_buffer(0),
+		bit_count(0),
 		it215(isIt215)
 	{
 	}
@@ -461,7 +524,16 @@ public:
 		free_IT_compressed_block();
 	}
 
-	mp_dword read_n_bits_from_IT_compressed_block(mp_ubyte p_bits_to_read);
+	inline mp_dword read_n_bits_from_IT_compressed_block(mp_ubyte p_bits_to_read)
+	{
+		if (bit_count < p_bits_to_read)
+			refill_bit_buffer();
+
+		mp_dword value = (mp_dword)bit_buffer & ((1 << p_bits_to_read) - 1);
+		bit_buffer >>= p_bits_to_read;
+		bit_count -= p_bits_to_read;
+		return value;
+	}
 
 	mp_sint32 read_IT_compressed_block ();
 
@@ -480,63 +552,28 @@ public:
 
 * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE */
 
-mp_dword ITSampleLoader::read_n_bits_from_IT_compressed_block (mp_ubyte p_bits_to_read) {
-
-    mp_dword aux_return_value;
-
-    mp_dword val;
-    mp_ubyte *buffer=(mp_ubyte*)source_position;
-
-    if ( p_bits_to_read <= source_remaining_bits ) {
-
-    	val=buffer[3];
-		val<<=8;
-    	val|=buffer[2];
-		val<<=8;
-    	val|=buffer[1];
-		val<<=8;
-    	val|=buffer[0];
-
-		aux_return_value = val & ((1 << p_bits_to_read) - 1);
-		val >>= p_bits_to_read;
-		source_remaining_bits -= p_bits_to_read;
-
-		buffer[3]=val>>24;
-    	buffer[2]=(val>>16)&0xFF;
-    	buffer[1]=(val>>8)&0xFF;
-    	buffer[0]=(val)&0xFF;
-
-    } else {
-    	aux_return_value=buffer[3];
-		aux_return_value<<=8;
-    	aux_return_value|=buffer[2];
-		aux_return_value<<=8;
-    	aux_return_value|=buffer[1];
-		aux_return_value<<=8;
-    	aux_return_value|=buffer[0];
-
-		mp_dword nbits = p_bits_to_read - source_remaining_bits;
-		//	aux_return_value = *source_position;
-		source_position++;
-        buffer+=4;
-    	val=buffer[3];
-		val<<=8;
-    	val|=buffer[2];
-		val<<=8;
-    	val|=buffer[1];
-		val<<=8;
-    	val|=buffer[0];
-		aux_return_value |= ((val & ((1 << nbits) - 1)) << source_remaining_bits);
-		val >>= nbits;
-		source_remaining_bits = 32 - nbits;
-		buffer[3]=val>>24;
-    	buffer[2]=(val>>16)&0xFF;
-    	buffer[1]=(val>>8)&0xFF;
-    	buffer[0]=(val)&0xFF;
-
-    }
-
-    return aux_return_value;
+void ITSampleLoader::refill_bit_buffer() {
+
+	/* top up with whole dwords, reading past the block gives zero bits */
+	while (bit_count <= 32) {
+
+		mp_dword val = 0;
+
+		if (source_end - source_position >= 4) {
+
+			val = LittleEndian::GET_DWORD(source_position);
+			source_position += 4;
+
+		} else {
+
+			for (mp_uint32 shift = 0; source_position < source_end; shift += 8)
+				val |= (mp_dword)(*source_position++) << shift;
+
+		}
+
+		bit_buffer |= (mp_uint64)val << bit_count;
+		bit_count += 32;
+	}
 }
 
 mp_sint32 ITSampleLoader::read_IT_compressed_block () {
@@ -547,23 +584,33 @@ mp_sint32 ITSampleLoader::read_IT_compressed_block () {
 
 	if (f.isEOF()) return FUNCTION_FAILED;
 
-	mp_sint32 finalSize = 4 * ((size >> 2) + 2);
-	source_buffer = (mp_dword*)new mp_ubyte[finalSize];
+	/* take the block straight from memory if the file is held there */
+	source_position = f.getPointer(f.pos(), size);
 
-	if (source_buffer==NULL) return FUNCTION_FAILED;
+	if (source_position != NULL) {
 
-	memset(source_buffer, 0, finalSize);
+		f.seek(size, XMFileBase::SeekOffsetTypeCurrent);
 
-	mp_sint32 res = f.read(source_buffer, 1, size);
-	if (res != size)
-	{
-		delete[] (mp_ubyte*)source_buffer;
-		source_buffer = NULL;
-		return FUNCTION_FAILED;
+	} else {
+
+		source_buffer = new mp_ubyte[size + 4];
+
+		if (source_buffer==NULL) return FUNCTION_FAILED;
+
+		mp_sint32 res = f.read(source_buffer, 1, size);
+		if (res != size)
+		{
+			delete[] source_buffer;
+			source_buffer = NULL;
+			return FUNCTION_FAILED;
+		}
+
+		source_position = source_buffer;
 	}
 
-	source_position = source_buffer;
-	source_remaining_bits = 32;
+	source_end = source_position + size;
+	bit_buffer = 0;
+	bit_count = 0;
 
 	return FUNCTION_SUCCESS;
 }
@@ -571,9 +618,10 @@ mp_sint32 ITSampleLoader::read_IT_compressed_block () {
 void ITSampleLoader::free_IT_compressed_block () {
 
 
-	if (source_buffer!=NULL) delete[] (mp_ubyte*)source_buffer;
+	if (source_buffer!=NULL) delete[] source_buffer;
 
 	source_buffer = NULL;
+	source_position = source_end = NULL;
 
 }
 
@@ -1478,6 +1526,53 @@ bool XModule::loadSample(XMFileBase& f,void* buffer,mp_uint32 size,mp_uint32 len
 	}
 	else
 	{
+		const mp_uint32 bytes = (flags & ST_16BIT) ? length*2 : length;
+		const mp_ubyte* src = (flags & ST_DELTA_PTM) ? NULL : f.getPointer(f.pos(), bytes);
+
+		// sample data is in memory already (e.g. mapped file):
+		// decode straight from there instead of reading it first
+		if (src)
+		{
+			if (size > bytes)
+				memset((mp_ubyte*)buffer + bytes, 0, size - bytes);
+
+			const bool delta = (flags & ST_DELTA) != 0;
+			const bool unsign = (flags & ST_UNSIGNED) != 0;
+
+			if (flags & ST_16BIT)
+			{
+				mp_sword* dstPtr = (mp_sword*)buffer;
+				const bool bigEndian = (flags & ST_BIGENDIAN) != 0;
+				mp_sword b1 = 0;
+				for (mp_uint32 i = 0; i < length; i++)
+				{
+					mp_sword v = bigEndian ? BigEndian::GET_WORD(src+i*2) : LittleEndian::GET_WORD(src+i*2);
+					if (delta)
+						v = b1+=v;
+					if (unsign)
+						v ^= 32767;
+					dstPtr[i] = v;
+				}
+			}
+			else
+			{
+				mp_sbyte* smpPtr = (mp_sbyte*)buffer;
+				mp_sbyte b1 = 0;
+				for (mp_uint32 i = 0; i < length; i++)
+				{
+					mp_sbyte v = (mp_sbyte)src[i];
+					if (delta)
+						v = b1+=v;
+					if (unsign)
+						v ^= 127;
+					smpPtr[i] = v;
+				}
+			}
+
+			f.seek(bytes, XMFileBase::SeekOffsetTypeCurrent);
+			return true;
+		}
+
 		memset(buffer, 0, size);
 		f.read(buffer,flags & ST_16BIT ? 2 : 1, length);
 	}
@@ -1569,7 +1664,7 @@ mp_sint32 XModule::loadModuleSample(XMFileBase& f, mp_sint32 index,
 			return MP_OUT_OF_MEMORY;
 		}
 
-		if (!loadSample(f,smp[index].sample, finalSize, smp[index].samplen, flags16))
+		if (!queueSample(f,smp[index].sample, finalSize, smp[index].samplen, flags16))
 		{
 			return MP_OUT_OF_MEMORY;
 		}
@@ -1586,7 +1681,7 @@ mp_sint32 XModule::loadModuleSample(XMFileBase& f, mp_sint32 index,
 			return MP_OUT_OF_MEMORY;
 		}
 
-		if (!loadSample(f,smp[index].sample, finalSize, smp[index].samplen, flags8))
+		if (!queueSample(f,smp[index].sample, finalSize, smp[index].samplen, flags8))
 		{
 			return MP_OUT_OF_MEMORY;
 		}
@@ -1597,15 +1692,162 @@ mp_sint32 XModule::loadModuleSample(XMFileBase& f, mp_sint32 index,
 
 mp_sint32 XModule::loadModuleSamples(XMFileBase& f, mp_sint32 flags8/* = ST_DEFAULT*/, mp_sint32 flags16/* = ST_16BIT*/)
 {
+	// the loader might have opened a batch already
+	const bool batch = !sampleBatchOpen;
+	if (batch)
+		beginSampleBatch();
+
 	for (mp_sint32 i = 0; i < header.smpnum; i++)
 	{
 		mp_sint32 res = loadModuleSample(f, i, flags8, flags16);
 		if (res != MP_OK)
 			return res;
 	}
+
+	if (batch && !finishSampleBatch())
+		return MP_OUT_OF_MEMORY;
+
 	return MP_OK;
 }
 
+void XModule::beginSampleBatch()
+{
+	numSampleJobs = 0;
+	sampleBatchOpen = true;
+}
+
+bool XModule::queueSample(XMFileBase& f, void* buffer, mp_uint32 size, mp_uint32 length, mp_sint32 flags/* = ST_DEFAULT*/)
+{
+	if (!sampleBatchOpen)
+		return loadSample(f, buffer, size, length, flags);
+
+	const mp_uint32 start = f.pos();
+
+	if ((flags & ST_PACKING_IT) || (flags & ST_PACKING_IT215))
+	{
+		// the integrators and the bit width start from scratch in every
+		// block of an IT compressed sample, so each block is a job of its own
+		const mp_uint32 blockLength = (flags & ST_16BIT) ? 0x4000 : 0x8000;
+		const mp_uint32 sampleSize = (flags & ST_16BIT) ? 2 : 1;
+		const mp_uint32 firstJob = numSampleJobs;
+
+		mp_uint32 offset = start;
+		for (mp_uint32 i = 0; i < length; i+=blockLength)
+		{
+			const mp_ubyte* src = f.getPointer(offset, 2);
+			if (src == NULL)
+			{
+				// not in memory, load the whole sample right away
+				numSampleJobs = firstJob;
+				return loadSample(f, buffer, size, length, flags);
+			}
+
+			const mp_uint32 blockSize = 2 + LittleEndian::GET_WORD(src);
+
+			// one more byte if there is one: an empty block right at the end
+			// of the file must fail just like when reading from the file
+			mp_uint32 srcSize = blockSize + 1;
+			src = f.getPointer(offset, srcSize);
+			if (src == NULL)
+				src = f.getPointer(offset, --srcSize);
+			if (src == NULL)
+			{
+				numSampleJobs = firstJob;
+				return loadSample(f, buffer, size, length, flags);
+			}
+
+			const mp_uint32 count = (length - i < blockLength) ? length - i : blockLength;
+			addSampleJob(src, srcSize, (mp_ubyte*)buffer + i*sampleSize, count*sampleSize, count, flags);
+
+			offset+=blockSize;
+		}
+
+		f.seek(offset);
+		return true;
+	}
+
+	mp_uint32 bytes;
+	if (flags & ST_PACKING_MDL)
+		bytes = size;
+	else if (flags & ST_PACKING_ADPCM)
+		bytes = (flags & ST_16BIT) ? 0 : 16 + (length + 1) / 2;
+	else
+		bytes = (flags & ST_16BIT) ? length*2 : length;
+
+	const mp_ubyte* src = bytes ? f.getPointer(start, bytes) : NULL;
+	if (src == NULL)
+		return loadSample(f, buffer, size, length, flags);
+
+	addSampleJob(src, bytes, buffer, size, length, flags);
+
+	f.seek(start + bytes);
+	return true;
+}
+
+bool XModule::finishSampleBatch()
+{
+	sampleBatchOpen = false;
+
+	if (numSampleJobs > 1 && WorkerPool::isSupported() && WorkerPool::getNumProcessors() > 1)
+	{
+		mp_uint32 numWorkers = WorkerPool::getNumProcessors() - 1;
+		if (numWorkers > WorkerPool::MAXWORKERS)
+			numWorkers = WorkerPool::MAXWORKERS;
+		if (numWorkers > numSampleJobs - 1)
+			numWorkers = numSampleJobs - 1;
+
+		WorkerPool workerPool(numWorkers);
+		workerPool.run(decodeSampleJob, this, numSampleJobs);
+	}
+	else
+	{
+		for (mp_uint32 i = 0; i < numSampleJobs; i++)
+			decodeSampleJob(this, i);
+	}
+
+	bool result = true;
+	for (mp_uint32 i = 0; i < numSampleJobs; i++)
+	{
+		if (sampleJobs[i].failed)
+			result = false;
+	}
+
+	numSampleJobs = 0;
+	return result;
+}
+
+void XModule::addSampleJob(const mp_ubyte* src, mp_uint32 srcSize, void* buffer,
+						   mp_uint32 size, mp_uint32 length, mp_sint32 flags)
+{
+	if (numSampleJobs >= numSampleJobsAlloc)
+	{
+		numSampleJobsAlloc = numSampleJobsAlloc ? numSampleJobsAlloc*2 : 64;
+		TSampleJob* jobs = new TSampleJob[numSampleJobsAlloc];
+		if (numSampleJobs)
+			memcpy(jobs, sampleJobs, numSampleJobs*sizeof(TSampleJob));
+		delete[] sampleJobs;
+		sampleJobs = jobs;
+	}
+
+	TSampleJob& job = sampleJobs[numSampleJobs++];
+	job.src = src;
+	job.srcSize = srcSize;
+	job.buffer = buffer;
+	job.size = size;
+	job.length = length;
+	job.flags = flags;
+	job.failed = false;
+}
+
+void XModule::decodeSampleJob(void* userData, mp_uint32 index)
+{
+	TSampleJob& job = static_cast<XModule*>(userData)->sampleJobs[index];
+
+	// same decoder as for a file, just on the queued part of the data
+	XMFileMemory f(job.src, job.srcSize);
+	job.failed = !loadSample(f, job.buffer, job.size, job.length, job.flags);
+}
+
 ////////////////////////////////////////////
 // Before using the sample postprocessing //
 // please make sure that the memory       //
@@ -1651,7 +1893,7 @@ void XModule::setDefaultPanning()
 
 mp_ubyte* XModule::allocSampleMem(mp_uint32 size)
 {
-	// sample is always padded at start and end with 16 bytes
+	// sample is always padded at start and end, see TXMSample
 	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
 	{
 		if (samplePool[i] == NULL)
@@ -1784,6 +2026,10 @@ void XModule::fixEnvelopes(TEnvelope* envs, mp_uint32 numEnvs)
 // module right after that
 bool XModule::cleanUp()
 {
+	// drop what a failed loader has left in the queue
+	numSampleJobs = 0;
+	sampleBatchOpen = false;
+
 	if (venvs)
 	{
 		delete[] venvs;
@@ -1917,6 +2163,10 @@ XModule::XModule()
 	// reset current sample index
 	samplePointerIndex = 0;
 
+	sampleJobs = NULL;
+	numSampleJobs = numSampleJobsAlloc = 0;
+	sampleBatchOpen = false;
+
 	memset(&header,0,sizeof(TXMHeader));
 
 	if (instr) {
@@ -1986,6 +2236,8 @@ XModule::~XModule()
 {
 	cleanUp();
 
+	delete[] sampleJobs;
+
 	delete[] phead;
 	delete[] instr;
 	delete[] smp;
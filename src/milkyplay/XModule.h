@@ -132,6 +132,8 @@ struct TXMInstrument
 // getSampleValue and setSampleValue and call postProcessSamples when you're done
 // modifying the sample, so the loop information is updated correctly
 // Also call postProcessSamples when you're changing the loop information
+// Short loops are additionally unrolled into the trailing padding, that copy
+// is rebuilt by postProcessSamples as well
 struct TXMSample
 {
 private:
@@ -155,11 +157,21 @@ private:
 		LoopAreaBackupSizeMaxInBytes = 8,
 		EmptySize = 8,
 		LeadingPadding = sizeof(TLoopDoubleBuffProps) + LoopAreaBackupSizeMaxInBytes + EmptySize,
-		TrailingPadding = 16,
+		// The first MP_UNROLLEDLOOP_HEADEROFFSET bytes are what the padding
+		// used to be, resamplers playing the sample itself never read beyond
+		// them. The unrolled loop is only read while the mixer plays the copy
+		// (see ChannelMixer::ResamplerBase::addChannel), at most one sample
+		// before and two after the position (cubic resamplers, the sinc ones
+		// wrap around on their own). A copy is shorter than
+		// 2 * MP_UNROLLEDLOOP_MINLENGTH samples, so header, lead in, copy and
+		// lead out fit for 16 bit samples
+		TrailingPadding = MP_UNROLLEDLOOP_HEADEROFFSET + sizeof(TUnrolledLoopHeader) +
+						  (1 + MP_UNROLLEDLOOP_MINLENGTH * 2 + MP_UNROLLEDLOOP_LEADOUT) * 2,
 		PaddingSpace = LeadingPadding+TrailingPadding
 	};
 
 	void restoreLoopArea();
+	void unrollLoop();
 
 public:
 	mp_uint32	samplen;
@@ -453,6 +465,22 @@ public:
 	mp_sint32			loadModuleSamples(XMFileBase& f,
 										  mp_sint32 flags8 = ST_DEFAULT, mp_sint32 flags16 = ST_16BIT);
 
+	///////////////////////////////////////////////////////
+	// batched sample loading: between beginSampleBatch  //
+	// and finishSampleBatch samples which are held in   //
+	// memory (mapped files) are only queued by          //
+	// queueSample and loadModuleSample(s) and decoded   //
+	// in parallel by finishSampleBatch. The loader must //
+	// not touch the sample data before that.            //
+	///////////////////////////////////////////////////////
+	void				beginSampleBatch();
+
+	bool				queueSample(XMFileBase& f, void* buffer,
+									mp_uint32 size, mp_uint32 length,
+									mp_sint32 flags = ST_DEFAULT);
+
+	bool				finishSampleBatch();
+
 	static void			convertXMVolumeEffects(mp_ubyte volume, mp_ubyte& eff, mp_ubyte& op);
 
 	///////////////////////////////////////////////////////
@@ -499,6 +527,27 @@ private:
 	mp_ubyte*		samplePool[MP_MAXSAMPLES];
 	mp_uint32		samplePointerIndex;
 
+	// sample data queued for decoding, see beginSampleBatch
+	struct TSampleJob
+	{
+		const mp_ubyte*	src;
+		mp_uint32		srcSize;
+		void*			buffer;
+		mp_uint32		size;
+		mp_uint32		length;
+		mp_sint32		flags;
+		bool			failed;
+	};
+
+	TSampleJob*		sampleJobs;
+	mp_uint32		numSampleJobs;
+	mp_uint32		numSampleJobsAlloc;
+	bool			sampleBatchOpen;
+
+	void			addSampleJob(const mp_ubyte* src, mp_uint32 srcSize, void* buffer,
+								 mp_uint32 size, mp_uint32 length, mp_sint32 flags);
+	static void		decodeSampleJob(void* userData, mp_uint32 index);
+
 	// song message retrieving
 	char*			messagePtr;
 
@@ -659,6 +708,7 @@ public:
 	// Module exporters								 //
 	///////////////////////////////////////////////////
 	mp_sint32		saveExtendedModule(const SYSCHAR* fileName, bool isMagic = false);		// FT2 (.XM)
+	mp_sint32		saveExtendedModule(XMFileBase& f, bool isMagic = false);
 	mp_sint32		saveProtrackerModule(const SYSCHAR* fileName, bool isMagic = false); 	// Protracker compatible (.MOD)
 	mp_sint32		saveMagicalModule(const SYSCHAR* fileName, bool isExtended = true);		// Titan's Magic Module (.TMM)
 
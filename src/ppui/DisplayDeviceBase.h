@@ -148,6 +148,7 @@ protected:
 
 	pp_int32 updateStackPtr;
 	pp_int32 disabledStackPtr;
+	pp_int32 frameStackPtr;
 
 	// ----------------------------- ex. PPWindow ----------------------------
 	bool bFullScreen;
@@ -163,6 +164,7 @@ public:
 		scaleFactor(scaleFactor),
 		updateStackPtr(0),
 		disabledStackPtr(0),
+		frameStackPtr(0),
 		bFullScreen(false),
 		currentCursorType(MouseCursorTypeStandard)
 	{
@@ -198,6 +200,24 @@ public:
 		return updateStackPtr == 0;
 	}
 
+	// updates between beginFrame() and endFrame() may be collected by the
+	// device and presented at once when the outermost frame is ended
+	void beginFrame()
+	{
+		frameStackPtr++;
+	}
+
+	void endFrame()
+	{
+		if (frameStackPtr > 0 && --frameStackPtr == 0)
+			flush();
+	}
+
+	bool isInFrame() const
+	{
+		return frameStackPtr != 0;
+	}
+
 	virtual PPGraphicsAbstract* open() = 0;
 	virtual void close() = 0;
 
@@ -205,6 +225,9 @@ public:
 
 	virtual void update(const PPRect& r) = 0;
 
+	// present collected updates
+	virtual void flush() { }
+
 	virtual void setSize(const PPSize& size) { this->size = size; }
 	virtual const PPSize& getSize() const { return this->size; }
 
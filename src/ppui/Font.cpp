@@ -1579,7 +1579,8 @@ void PPFont::createLargeFromSystem(pp_uint32 index)
 }
 
 PPFont::PPFont(pp_uint8* bits, const pp_uint32 chrWidth, const pp_uint32 chrHeight, pp_uint32 fontId) :
-	charWidth(chrWidth), charHeight(chrHeight), charDim(chrHeight*chrWidth)
+	charWidth(chrWidth), charHeight(chrHeight), charDim(chrHeight*chrWidth),
+	glyphSpans(NULL), glyphLineStarts(NULL)
 {
 	fontBits = bits;
 
@@ -1592,9 +1593,68 @@ PPFont::PPFont(pp_uint8* bits, const pp_uint32 chrWidth, const pp_uint32 chrHeig
 
 PPFont::~PPFont()
 {
+	freeGlyphSpans();
 	delete bitstream;
 }
 
+void PPFont::buildGlyphSpans()
+{
+	freeGlyphSpans();
+
+	const pp_uint32 numLines = 256*charHeight;
+
+	glyphLineStarts = new pp_uint32[numLines + 1];
+
+	// first pass counts the spans, second one stores them
+	for (pp_uint32 pass = 0; pass < 2; pass++)
+	{
+		pp_uint32 numSpans = 0;
+
+		for (pp_uint32 line = 0; line < numLines; line++)
+		{
+			const pp_uint32 offset = line*charWidth;
+
+			glyphLineStarts[line] = numSpans;
+
+			pp_uint32 x = 0;
+			while (x < charWidth)
+			{
+				if (!bitstream->read(offset + x))
+				{
+					x++;
+					continue;
+				}
+
+				pp_uint32 length = 1;
+				while (x + length < charWidth && bitstream->read(offset + x + length))
+					length++;
+
+				if (glyphSpans)
+				{
+					glyphSpans[numSpans].x = (pp_uint8)x;
+					glyphSpans[numSpans].length = (pp_uint8)length;
+				}
+
+				numSpans++;
+				x += length;
+			}
+		}
+
+		glyphLineStarts[numLines] = numSpans;
+
+		if (pass == 0)
+			glyphSpans = new GlyphSpan[numSpans + 1];
+	}
+}
+
+void PPFont::freeGlyphSpans()
+{
+	delete[] glyphSpans;
+	glyphSpans = NULL;
+	delete[] glyphLineStarts;
+	glyphLineStarts = NULL;
+}
+
 PPFont* PPFont::getFont(pp_uint32 fontId)
 {
 	pp_uint32 i;
@@ -1770,6 +1830,8 @@ void PPFont::selectFontFace(FontID fontID, const char* faceName)
 				fontInstances[j]->fontBits = (pp_uint8*)fontEntries[i].data;
 				fontInstances[j]->bitstream->setSource(fontInstances[j]->fontBits, fontEntries[i].width*fontEntries[i].height / 8);
 			}
+
+			fontInstances[j]->freeGlyphSpans();
 		}
 }
 
@@ -122,6 +122,20 @@ public:
 	const pp_uint32 charWidth, charHeight;
 	const pp_uint32 charDim;
 
+	// run of set pixels within one line of a character
+	struct GlyphSpan
+	{
+		pp_uint8 x, length;
+	};
+
+private:
+	// spans of all character lines, built from the bitstream on first use
+	GlyphSpan* glyphSpans;
+	pp_uint32* glyphLineStarts;
+
+	void buildGlyphSpans();
+	void freeGlyphSpans();
+
 public:
 	~PPFont();
 
@@ -132,6 +146,11 @@ public:
 
 	bool getPixelBit(pp_uint8 chr, pp_uint32 x, pp_uint32 y) const { return bitstream->read(chr*charDim+y*charWidth+x); }
 
+	// the spans of line y of character chr are
+	// getGlyphSpans()[starts[chr*charHeight+y]] up to getGlyphSpans()[starts[chr*charHeight+y+1]]
+	const GlyphSpan* getGlyphSpans() { if (glyphSpans == NULL) buildGlyphSpans(); return glyphSpans; }
+	const pp_uint32* getGlyphLineStarts() { if (glyphLineStarts == NULL) buildGlyphSpans(); return glyphLineStarts; }
+
 	pp_uint32 getStrWidth(const char* str) const;
 
 	enum ShrinkTypes
@@ -48,6 +48,38 @@ public:
 		pitch = p;
 		buffer = (pp_uint8*)buff;
 	}
+
+protected:
+	bool scrollFrameBuffer(PPRect r, pp_int32 dy, pp_int32 bytesPerPixel)
+	{
+		if (buffer == NULL)
+			return false;
+
+		if (r.x1 < 0) r.x1 = 0;
+		if (r.y1 < 0) r.y1 = 0;
+		if (r.x2 > width) r.x2 = width;
+		if (r.y2 > height) r.y2 = height;
+
+		const pp_int32 lines = r.y2 - r.y1 - (dy < 0 ? -dy : dy);
+		if (dy == 0 || lines <= 0 || r.x2 <= r.x1)
+			return true;
+
+		const pp_int32 len = (r.x2 - r.x1) * bytesPerPixel;
+		pp_uint8* base = buffer + r.x1 * bytesPerPixel;
+
+		if (dy < 0)
+		{
+			for (pp_int32 y = r.y1; y < r.y1 + lines; y++)
+				memmove(base + y * pitch, base + (y - dy) * pitch, len);
+		}
+		else
+		{
+			for (pp_int32 y = r.y2 - 1; y >= r.y2 - lines; y--)
+				memmove(base + y * pitch, base + (y - dy) * pitch, len);
+		}
+
+		return true;
+	}
 };
 
 #define __EMPTY__
@@ -68,6 +100,7 @@ public: \
 	virtual void drawLine(pp_int32 x1, pp_int32 y1, pp_int32 x2, pp_int32 y2); \
 	virtual void drawAntialiasedLine(pp_int32 x1, pp_int32 y1, pp_int32 x2, pp_int32 y2); \
 	virtual void blit(const pp_uint8* src, const PPPoint& p, const PPSize& size, pp_uint32 pitch, pp_uint32 bpp, pp_int32 intensity = 256); \
+	virtual bool scrollVertical(const PPRect& r, pp_int32 dy); \
 	virtual void drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool underlined = false); \
 	virtual void drawString(const char* str, pp_int32 x, pp_int32 y, bool underlined = false); \
 	virtual void drawStringVertical(const char* str, pp_int32 x, pp_int32 y, bool underlined = false); \
@@ -100,6 +100,38 @@ class PPFont;
 		} \
 	}
 
+// Draws character chr at (x, y) line by line from the spans of the current
+// font, clipped against the current clip rect.
+// FILLSPAN has to set len pixels starting at dst.
+#define __PPGRAPHICSGLYPHTEMPLATE(BYTESPERPIXEL, FILLSPAN) \
+	const PPFont::GlyphSpan* spans = currentFont->getGlyphSpans(); \
+	const pp_uint32* lineStarts = currentFont->getGlyphLineStarts() + chr*charHeight; \
+	const pp_int32 left = currentClipRect.x1 - x; \
+	const pp_int32 right = currentClipRect.x2 - x; \
+	pp_int32 top = 0, bottom = charHeight; \
+	if (y + top < currentClipRect.y1) \
+		top = currentClipRect.y1 - y; \
+	if (y + bottom > currentClipRect.y2) \
+		bottom = currentClipRect.y2 - y; \
+	for (pp_int32 i = top; i < bottom; i++) \
+	{ \
+		pp_uint8* line = (pp_uint8*)buffer + (y+i)*pitch; \
+		for (pp_uint32 s = lineStarts[i]; s < lineStarts[i+1]; s++) \
+		{ \
+			pp_int32 start = spans[s].x; \
+			pp_int32 end = start + spans[s].length; \
+			if (start < left) \
+				start = left; \
+			if (end > right) \
+				end = right; \
+			if (start >= end) \
+				continue; \
+			pp_uint8* dst = line + (x+start)*(BYTESPERPIXEL); \
+			const pp_int32 len = end - start; \
+			FILLSPAN \
+		} \
+	}
+
 #define __PPGRAPHICSAALINETEMPLATE \
 	if (x1 > currentClipRect.x2 || \
 		x2 < currentClipRect.x1 || \
@@ -304,6 +336,11 @@ public:
 	virtual void drawLine(pp_int32 x1, pp_int32 y1, pp_int32 x2, pp_int32 y2) = 0;
 	virtual void drawAntialiasedLine(pp_int32 x1, pp_int32 y1, pp_int32 x2, pp_int32 y2) = 0;
 
+	// Move the pixels inside r by dy lines (negative = up), the uncovered
+	// lines are left as they are. Returns false if the device can't do it,
+	// the caller then needs to repaint the whole area.
+	virtual bool scrollVertical(const PPRect& r, pp_int32 dy) { return false; }
+
 	virtual void blit(const pp_uint8* src, const PPPoint& p, const PPSize& size,
 					  pp_uint32 pitch, pp_uint32 bpp, pp_int32 intensity = 256) = 0;
 
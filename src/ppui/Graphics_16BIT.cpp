@@ -203,6 +203,11 @@ void PPGraphics_16BIT::drawAntialiasedLine(pp_int32 x1, pp_int32 y1, pp_int32 x2
 	__PPGRAPHICSAALINETEMPLATE
 }
 
+bool PPGraphics_16BIT::scrollVertical(const PPRect& r, pp_int32 dy)
+{
+	return scrollFrameBuffer(r, dy, BPP);
+}
+
 void PPGraphics_16BIT::blit(const pp_uint8* src, const PPPoint& p, const PPSize& size, pp_uint32 pitch, pp_uint32 bpp, pp_int32 intensity/* = 256*/)
 {
 	pp_int32 w = size.width;
@@ -251,7 +256,6 @@ void PPGraphics_16BIT::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool under
 
 	pp_int32 charWidth = (signed)currentFont->getCharWidth();
 	pp_int32 charHeight = (signed)currentFont->getCharHeight();
-	pp_int32 charDim = currentFont->charDim;
 
 	if (x + (signed)charWidth < currentClipRect.x1 ||
 		x > currentClipRect.x2 ||
@@ -303,60 +307,7 @@ void PPGraphics_16BIT::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool under
 			}
 
 	}*/
-	Bitstream* bitstream = currentFont->bitstream;
-	pp_uint8* fontbuffer = bitstream->buffer;
-
-	pp_uint16* buff = (pp_uint16*)buffer+(pitch>>1)*y+x;
-
-	const pp_uint32 cchrDim = chr*charDim;
-	const pp_uint32 incr = (pitch>>1)-(charWidth);
-
-	if (x>= currentClipRect.x1 && x + charWidth < currentClipRect.x2 &&
-		y>= currentClipRect.y1 && y + charHeight < currentClipRect.y2)
-	{
-
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
-		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
-			{
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-					*buff = color16;
-				}
-				buff++;
-				xChr++;
-			}
-
-			buff+=incr;
-			yChr+=charWidth;
-		}
-	}
-	else
-	{
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
-		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
-			{
-
-				if (y+(signed)i >= currentClipRect.y1 && y+(signed)i < currentClipRect.y2 &&
-					x+(signed)j >= currentClipRect.x1 && x+(signed)j < currentClipRect.x2 &&
-					(fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-
-					pp_uint16* buff = (pp_uint16*)buffer+(pitch>>1)*(y+i)+(x+j);
-					*buff = color16;
-				}
-				xChr++;
-
-			}
-			yChr+=charWidth;
-		}
-
-	}
+	__PPGRAPHICSGLYPHTEMPLATE(BPP, { pp_uint16* pixels = (pp_uint16*)dst; for (pp_int32 n = 0; n < len; n++) pixels[n] = color16; })
 
 	if (underlined)
 		drawHLine(x, x+charWidth, y+charHeight);
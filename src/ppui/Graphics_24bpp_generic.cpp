@@ -243,6 +243,11 @@ void PPGraphics_24bpp_generic::drawAntialiasedLine(pp_int32 x1, pp_int32 y1, pp_
 	__PPGRAPHICSAALINETEMPLATE
 }
 
+bool PPGraphics_24bpp_generic::scrollVertical(const PPRect& r, pp_int32 dy)
+{
+	return scrollFrameBuffer(r, dy, BPP);
+}
+
 void PPGraphics_24bpp_generic::blit(const pp_uint8* src, const PPPoint& p, const PPSize& size, pp_uint32 pitch, pp_uint32 bpp, pp_int32 intensity/* = 256*/)
 {
 	pp_int32 w = size.width;
@@ -316,7 +321,6 @@ void PPGraphics_24bpp_generic::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bo
 
 	pp_int32 charWidth = (signed)currentFont->getCharWidth();
 	pp_int32 charHeight = (signed)currentFont->getCharHeight();
-	pp_int32 charDim = currentFont->charDim;
 
 	if (x + (signed)charWidth < currentClipRect.x1 ||
 		x > currentClipRect.x2 ||
@@ -328,72 +332,17 @@ void PPGraphics_24bpp_generic::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bo
 		(currentColor.g << bitPosG) +
 		(currentColor.b << bitPosB);
 
-	Bitstream* bitstream = currentFont->bitstream;
-	pp_uint8* fontbuffer = bitstream->buffer;
-
-	pp_uint8* buff = (pp_uint8*)buffer + y*pitch + x*BPP;
-	pp_uint32 cchrDim = chr*charDim;
-
-	if (x>= currentClipRect.x1 && x + charWidth < currentClipRect.x2 &&
-		y>= currentClipRect.y1 && y + charHeight < currentClipRect.y2)
-	{
-
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
-		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
-			{
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-#ifndef __ppc__
-					buff[0] = rgb & 255;
-					buff[1] = (rgb >> 8) & 255;
-					buff[2] = (rgb >> 16) & 255;
-#else
-					buff[0] = (rgb >> 16) & 255;
-					buff[1] = (rgb >> 8) & 255;
-					buff[2] = rgb & 255;
-#endif
-				}
-				buff+=BPP;
-				xChr++;
-			}
-			buff+=pitch-(charWidth*BPP);
-			yChr+=charWidth;
-		}
-	}
-	else
-	{
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
-		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
-			{
-
-				if (y+(signed)i >= currentClipRect.y1 && y+(signed)i < currentClipRect.y2 &&
-					x+(signed)j >= currentClipRect.x1 && x+(signed)j < currentClipRect.x2 &&
-					(fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-					pp_uint8* buff = (pp_uint8*)buffer+((y+i)*pitch+(x+j)*BPP);
 #ifndef __ppc__
-					buff[0] = rgb & 255;
-					buff[1] = (rgb >> 8) & 255;
-					buff[2] = (rgb >> 16) & 255;
+	const pp_uint8 c0 = rgb & 255;
+	const pp_uint8 c1 = (rgb >> 8) & 255;
+	const pp_uint8 c2 = (rgb >> 16) & 255;
 #else
-					buff[0] = (rgb >> 16) & 255;
-					buff[1] = (rgb >> 8) & 255;
-					buff[2] = rgb & 255;
+	const pp_uint8 c0 = (rgb >> 16) & 255;
+	const pp_uint8 c1 = (rgb >> 8) & 255;
+	const pp_uint8 c2 = rgb & 255;
 #endif
-				}
-				xChr++;
-
-			}
-			yChr+=charWidth;
-		}
 
-	}
+	__PPGRAPHICSGLYPHTEMPLATE(BPP, { for (pp_int32 n = 0; n < len; n++, dst+=BPP) { dst[0] = c0; dst[1] = c1; dst[2] = c2; } })
 
 	if (underlined)
 		drawHLine(x, x+charWidth, y+charHeight);
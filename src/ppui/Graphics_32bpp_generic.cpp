@@ -202,6 +202,11 @@ void PPGraphics_32bpp_generic::drawAntialiasedLine(pp_int32 x1, pp_int32 y1, pp_
 	__PPGRAPHICSAALINETEMPLATE
 }
 
+bool PPGraphics_32bpp_generic::scrollVertical(const PPRect& r, pp_int32 dy)
+{
+	return scrollFrameBuffer(r, dy, BPP);
+}
+
 void PPGraphics_32bpp_generic::blit(const pp_uint8* src, const PPPoint& p, const PPSize& size, pp_uint32 pitch, pp_uint32 bpp, pp_int32 intensity/* = 256*/)
 {
 	pp_int32 w = size.width;
@@ -265,64 +270,11 @@ void PPGraphics_32bpp_generic::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bo
 		y > currentClipRect.y2)
 		return;
 
-	pp_int32 charDim = currentFont->charDim;
-
-	Bitstream* bitstream = currentFont->bitstream;
-	pp_uint8* fontbuffer = bitstream->buffer;
-
 	pp_uint32 rgb1 = (currentColor.r << bitPosR) +
 		(currentColor.g << bitPosG) +
 		(currentColor.b << bitPosB);
 
-	pp_uint32 cchrDim = chr*charDim;
-
-	if (x>= currentClipRect.x1 && x + charWidth < currentClipRect.x2 &&
-		y>= currentClipRect.y1 && y + charHeight < currentClipRect.y2)
-	{
-		pp_uint8* buff = (pp_uint8*)buffer + y*pitch + x*BPP;
-
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < charHeight; i++)
-		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < charWidth; j++)
-			{
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-					*reinterpret_cast<pp_uint32*>(buff) = rgb1;
-				}
-				buff+=BPP;
-				xChr++;
-			}
-			buff+=pitch-(charWidth*BPP);
-			yChr+=charWidth;
-		}
-	}
-	else
-	{
-		pp_uint32 yChr = cchrDim;
-		for (pp_int32 i = 0; i < charHeight; i++)
-		{
-			pp_uint32 xChr = yChr;
-			for (pp_int32 j = 0; j < charWidth; j++)
-			{
-
-				if (y+(signed)i >= currentClipRect.y1 && y+(signed)i < currentClipRect.y2 &&
-					x+(signed)j >= currentClipRect.x1 && x+(signed)j < currentClipRect.x2 &&
-					(fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-
-					pp_uint8* buff = (pp_uint8*)buffer+((y+i)*pitch+(x+j)*BPP);
-
-					*reinterpret_cast<pp_uint32*>(buff) = rgb1;
-				}
-				xChr++;
-
-			}
-			yChr+=charWidth;
-		}
-
-	}
+	__PPGRAPHICSGLYPHTEMPLATE(BPP, { pp_uint32* pixels = (pp_uint32*)dst; for (pp_int32 n = 0; n < len; n++) pixels[n] = rgb1; })
 
 	if (underlined)
 		drawHLine(x, x+charWidth, y+charHeight);
@@ -179,6 +179,11 @@ void PPGraphics_8BIT::drawAntialiasedLine(pp_int32 x1, pp_int32 y1, pp_int32 x2,
 	__PPGRAPHICSAALINETEMPLATE
 }
 
+bool PPGraphics_8BIT::scrollVertical(const PPRect& r, pp_int32 dy)
+{
+	return scrollFrameBuffer(r, dy, 1);
+}
+
 void PPGraphics_8BIT::blit(const pp_uint8* src, const PPPoint& p, const PPSize& size, pp_uint32 pitch, pp_uint32 bpp, pp_int32 intensity/* = 256*/)
 {
 }
@@ -190,7 +195,6 @@ void PPGraphics_8BIT::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool underl
 
 	pp_int32 charWidth = (signed)currentFont->getCharWidth();
 	pp_int32 charHeight = (signed)currentFont->getCharHeight();
-	pp_int32 charDim = currentFont->charDim;
 
 	if (x + (signed)charWidth < currentClipRect.x1 ||
 		x > currentClipRect.x2 ||
@@ -198,51 +202,7 @@ void PPGraphics_8BIT::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool underl
 		y > currentClipRect.y2)
 		return;
 
-	Bitstream* bitstream = currentFont->bitstream;
-	pp_uint8* fontbuffer = bitstream->buffer;
-
-	pp_uint8 * d = buffer + pitch * y + x;
-
-	const pp_uint32 cchrDim = chr * charDim;
-	const pp_uint32 incr = pitch - charWidth;
-
-	if (x>= currentClipRect.x1 && x + charWidth < currentClipRect.x2 &&
-		y>= currentClipRect.y1 && y + charHeight < currentClipRect.y2)
-	{
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++) {
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++) {
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1)) {
-					*d = currentColorIndex;
-				}
-				d++;
-				xChr++;
-			}
-
-			d+=incr;
-			yChr+=charWidth;
-		}
-	}
-	else
-	{
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++) {
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++) {
-				if (y+(signed)i >= currentClipRect.y1 && y+(signed)i < currentClipRect.y2 &&
-					x+(signed)j >= currentClipRect.x1 && x+(signed)j < currentClipRect.x2 &&
-					(fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-					pp_uint8 * d = buffer + pitch * (y+i) + (x+j);
-					*d = currentColorIndex;
-				}
-
-				xChr++;
-			}
-			yChr+=charWidth;
-		}
-	}
+	__PPGRAPHICSGLYPHTEMPLATE(1, { for (pp_int32 n = 0; n < len; n++) dst[n] = currentColorIndex; })
 
 	if (underlined)
 		drawHLine(x, x+charWidth, y+charHeight);
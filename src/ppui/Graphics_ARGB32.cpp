@@ -219,6 +219,11 @@ void PPGraphics_ARGB32::drawAntialiasedLine(pp_int32 x1, pp_int32 y1, pp_int32 x
 	__PPGRAPHICSAALINETEMPLATE
 }
 
+bool PPGraphics_ARGB32::scrollVertical(const PPRect& r, pp_int32 dy)
+{
+	return scrollFrameBuffer(r, dy, BPP);
+}
+
 void PPGraphics_ARGB32::blit(const pp_uint8* src, const PPPoint& p, const PPSize& size, pp_uint32 pitch, pp_uint32 bpp, pp_int32 intensity/* = 256*/)
 {
 	pp_int32 w = size.width;
@@ -278,15 +283,10 @@ void PPGraphics_ARGB32::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool unde
 		y > currentClipRect.y2)
 		return;
 
-	const pp_int32 charDim = currentFont->charDim;
-
 	pp_uint8 r = (pp_uint8)currentColor.r;
 	pp_uint8 g = (pp_uint8)currentColor.g;
 	pp_uint8 b = (pp_uint8)currentColor.b;
 
-	Bitstream* bitstream = currentFont->bitstream;
-	pp_uint8* fontbuffer = bitstream->buffer;
-
 #ifdef __ppc__
 	pp_uint32 rgb1 = (((pp_uint32)r) << 16) +
 					 (((pp_uint32)g) << 8) +
@@ -297,55 +297,7 @@ void PPGraphics_ARGB32::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool unde
 					 (((pp_uint32)r) << 8);
 #endif
 
-	const pp_uint32 cchrDim = chr*charDim;
-
-	if (x>= currentClipRect.x1 && x + charWidth < currentClipRect.x2 &&
-		y>= currentClipRect.y1 && y + charHeight < currentClipRect.y2)
-	{
-		pp_uint8* buff = (pp_uint8*)buffer + y*pitch + x*BPP;
-
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
-		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
-			{
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-					*reinterpret_cast<pp_uint32*>(buff) = rgb1;
-				}
-				buff+=BPP;
-				xChr++;
-			}
-			buff+=pitch-(charWidth*BPP);
-			yChr+=charWidth;
-		}
-	}
-	else
-	{
-		pp_uint32 yChr = cchrDim;
-		for (pp_int32 i = 0; i < charHeight; i++)
-		{
-			pp_uint32 xChr = yChr;
-			for (pp_int32 j = 0; j < charWidth; j++)
-			{
-
-				if (y+(signed)i >= currentClipRect.y1 && y+(signed)i < currentClipRect.y2 &&
-					x+(signed)j >= currentClipRect.x1 && x+(signed)j < currentClipRect.x2 &&
-					(fontbuffer[xChr>>3]>>(xChr&7)&1))
-				{
-
-					pp_uint8* buff = (pp_uint8*)buffer+((y+i)*pitch+(x+j)*BPP);
-
-					*reinterpret_cast<pp_uint32*>(buff) = rgb1;
-				}
-				xChr++;
-
-			}
-			yChr+=charWidth;
-		}
-
-	}
+	__PPGRAPHICSGLYPHTEMPLATE(BPP, { pp_uint32* pixels = (pp_uint32*)dst; for (pp_int32 n = 0; n < len; n++) pixels[n] = rgb1; })
 
 	if (underlined)
 		drawHLine(x, x+charWidth, y+charHeight);
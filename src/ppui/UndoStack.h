@@ -205,6 +205,38 @@ public:
 		return m_pUndoStack[m_nCurIndex+1];
 	}
 
+	//---------------------------------------------------------------------------
+	// Pre     : type provides getMemoryUsage()
+	// Post    : 
+	// Globals : 
+	// I/O     : 
+	// Task    : Remove bottom entries until all entries together use no
+	//			 more than nBudget bytes, the current entry is always kept
+	//---------------------------------------------------------------------------
+	void TrimToBudget(pp_uint32 nBudget)
+	{
+		pp_uint32 nUsage = 0;
+		for (pp_int32 i = 0; i < m_nStackSize; i++)
+			if (m_pUndoStack[i])
+				nUsage += m_pUndoStack[i]->getMemoryUsage();
+		
+		while (nUsage > nBudget && m_nCurIndex > 0)
+		{
+			nUsage -= m_pUndoStack[0]->getMemoryUsage();
+			delete m_pUndoStack[0];
+			
+			// move references
+			for (pp_int32 i = 0; i < m_nStackSize; i++)
+				m_pUndoStack[i] = m_pUndoStack[i+1];
+			m_pUndoStack[m_nStackSize] = NULL;
+			
+			m_nCurIndex--;
+			m_nTopIndex--;
+			
+			m_bOverflow = true;
+		}
+	}
+
 	bool IsEmpty() const { return (m_nCurIndex == -1); }
 
 	bool IsTop() const { return ((m_nTopIndex-1)==m_nCurIndex); }
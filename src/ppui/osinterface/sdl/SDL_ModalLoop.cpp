@@ -92,9 +92,21 @@ PPModalDialog::ReturnCodes SDL_runModalLoop(PPScreen* screen, PPDialogBase* dial
 	if (globalMutex)
 		globalMutex->unlock();
 
+	// same goes for the display frame opened by the invoking event, leave it
+	// so the dialog shows up and our events get their own frames
+	PPDisplayDeviceBase* displayDevice = screen->getDisplayDevice();
+	pp_uint32 frameStackCount = 0;
+	while (displayDevice->isInFrame())
+	{
+		displayDevice->endFrame();
+		frameStackCount++;
+	}
+
 	// Create our own event loop
 	while (!exitModalLoop && SDL_WaitEvent(&event)) 
 	{
+		displayDevice->beginFrame();
+
 		switch (event.type) 
 		{
 			case SDL_MOUSEMOTION:
@@ -129,9 +141,17 @@ PPModalDialog::ReturnCodes SDL_runModalLoop(PPScreen* screen, PPDialogBase* dial
 				processSDLEvents(event);
 				break;
 		}
+
+		displayDevice->endFrame();
 	}	
 
 	// pretend nothing happened at all, continue with main event loop after we're finished here
+	while (frameStackCount > 0)
+	{
+		displayDevice->beginFrame();
+		frameStackCount--;
+	}
+
 	if (globalMutex)
 		globalMutex->lock();
 
@@ -71,7 +71,8 @@ PPDisplayDeviceFB::PPDisplayDeviceFB(
 #endif
 	width, height, scaleFactor, bpp, fullScreen, theOrientation),
 	needsTemporaryBuffer((orientation != ORIENTATION_NORMAL) || (scaleFactor != 1)),
-	temporaryBuffer(NULL)
+	temporaryBuffer(NULL),
+	numDirtyRects(0)
 {
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 	// Create an SDL window and surface
@@ -320,6 +321,11 @@ PPDisplayDeviceFB::PPDisplayDeviceFB(
 		temporaryBuffer = new pp_uint8[getSize().width*getSize().height*(bpp/8)];
 	}
 
+	statistics.numFrames = 0;
+	statistics.numRequestedRects = 0;
+	statistics.numUploadedRects = 0;
+	statistics.numUploadedBytes = 0;
+
 	currentGraphics->lock = true;
 }
 
@@ -327,6 +333,17 @@ PPDisplayDeviceFB::~PPDisplayDeviceFB()
 {
 	pp_uint32 i;
 
+#ifdef DEBUG
+	if (statistics.numFrames)
+	{
+		fprintf(stderr, "SDL: %u frames, %.2f rects requested, %.2f rects uploaded, %.1f KB uploaded per frame\n",
+				statistics.numFrames,
+				(double)statistics.numRequestedRects / statistics.numFrames,
+				(double)statistics.numUploadedRects / statistics.numFrames,
+				(double)statistics.numUploadedBytes / statistics.numFrames / 1024.0);
+	}
+#endif
+
 	SDL_FreeSurface(theSurface);
 
 #if defined(AMIGA_SAGA_PIP)
@@ -458,6 +475,82 @@ void PPDisplayDeviceFB::setPalette(PPColor * pppal)
 #endif
 }
 
+static inline pp_int32 rectArea(const PPRect& r)
+{
+	return r.width() * r.height();
+}
+
+static inline PPRect uniteRects(const PPRect& a, const PPRect& b)
+{
+	return PPRect(a.x1 < b.x1 ? a.x1 : b.x1,
+				  a.y1 < b.y1 ? a.y1 : b.y1,
+				  a.x2 > b.x2 ? a.x2 : b.x2,
+				  a.y2 > b.y2 ? a.y2 : b.y2);
+}
+
+void PPDisplayDeviceFB::addDirtyRect(const PPRect& rect)
+{
+	PPRect r(rect);
+	pp_int32 h;
+	if (r.x2 < r.x1)
+	{
+		h = r.x1; r.x1 = r.x2; r.x2 = h;
+	}
+	if (r.y2 < r.y1)
+	{
+		h = r.y1; r.y1 = r.y2; r.y2 = h;
+	}
+
+	if (r.x1 < 0) r.x1 = 0;
+	if (r.y1 < 0) r.y1 = 0;
+	if (r.x2 > getSize().width) r.x2 = getSize().width;
+	if (r.y2 > getSize().height) r.y2 = getSize().height;
+
+	if (r.x1 >= r.x2 || r.y1 >= r.y2)
+		return;
+
+	statistics.numRequestedRects++;
+
+	// swallow every rect whose union with ours isn't larger than both
+	// of them taken separately, start over whenever the rect has grown
+	pp_int32 i = 0;
+	while (i < numDirtyRects)
+	{
+		PPRect u = uniteRects(dirtyRects[i], r);
+		if (rectArea(u) <= rectArea(dirtyRects[i]) + rectArea(r))
+		{
+			r = u;
+			dirtyRects[i] = dirtyRects[--numDirtyRects];
+			i = 0;
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	if (numDirtyRects < MAXDIRTYRECTS)
+	{
+		dirtyRects[numDirtyRects++] = r;
+		return;
+	}
+
+	// out of slots, merge with the rect which grows least
+	pp_int32 best = 0;
+	pp_int32 bestGrowth = 0;
+	for (i = 0; i < numDirtyRects; i++)
+	{
+		pp_int32 growth = rectArea(uniteRects(dirtyRects[i], r)) - rectArea(dirtyRects[i]);
+		if (i == 0 || growth < bestGrowth)
+		{
+			best = i;
+			bestGrowth = growth;
+		}
+	}
+
+	dirtyRects[best] = uniteRects(dirtyRects[best], r);
+}
+
 void PPDisplayDeviceFB::update()
 {
 #if defined(AMIGA_SAGA_PIP)
@@ -470,18 +563,12 @@ void PPDisplayDeviceFB::update()
 	if (theSurface->locked)
 		return;
 
-	PPRect r(0, 0, getSize().width, getSize().height);
-	postProcess(r);
+	// everything is going to be uploaded anyway
+	numDirtyRects = 0;
+	addDirtyRect(PPRect(0, 0, getSize().width, getSize().height));
 
-#if SDL_VERSION_ATLEAST(2, 0, 0)
-	// Update entire texture and copy to renderer
-	SDL_UpdateTexture(theTexture, NULL, theSurface->pixels, theSurface->pitch);
-	SDL_RenderClear(theRenderer);
-	SDL_RenderCopy(theRenderer, theTexture, NULL, NULL);
-	SDL_RenderPresent(theRenderer);
-#else
-	SDL_UpdateRect(theSurface, 0, 0, 0, 0);
-#endif
+	if (!isInFrame())
+		flush();
 }
 
 void PPDisplayDeviceFB::update(const PPRect& r)
@@ -496,35 +583,76 @@ void PPDisplayDeviceFB::update(const PPRect& r)
 	if (theSurface->locked)
 		return;
 
+	addDirtyRect(r);
+
+	if (!isInFrame())
+		flush();
+}
+
+void PPDisplayDeviceFB::flush()
+{
+	if (numDirtyRects == 0)
+		return;
+
+	// try again with the next update
+	if (theSurface->locked)
+		return;
+
 #if SDL_VERSION_ATLEAST(2, 0, 0)
-	postProcess(r);
+	for (pp_int32 i = 0; i < numDirtyRects; i++)
+	{
+		const PPRect& r = dirtyRects[i];
+
+		postProcess(r);
 
-	PPRect r2(r);
-	r2.scale(scaleFactor);
+		PPRect r2(r);
+		r2.scale(scaleFactor);
 
-	transformInverse(r2);
+		transformInverse(r2);
 
-	SDL_Rect r3 = { r2.x1, r2.y1, r2.width(), r2.height() };
+		SDL_Rect r3 = { r2.x1, r2.y1, r2.width(), r2.height() };
 
-	// Calculate destination pixel data offset based on row pitch and x coordinate
-	void* surfaceOffset = (char*) theSurface->pixels + r2.y1 * theSurface->pitch + r2.x1 * theSurface->format->BytesPerPixel;
+		// Calculate destination pixel data offset based on row pitch and x coordinate
+		void* surfaceOffset = (char*) theSurface->pixels + r2.y1 * theSurface->pitch + r2.x1 * theSurface->format->BytesPerPixel;
 
-	// Update dirty area of texture and copy to renderer
-	SDL_UpdateTexture(theTexture, &r3, surfaceOffset, theSurface->pitch);
+		// Update dirty area of texture
+		SDL_UpdateTexture(theTexture, &r3, surfaceOffset, theSurface->pitch);
+
+		statistics.numUploadedBytes += (pp_int64)r3.w * r3.h * theSurface->format->BytesPerPixel;
+	}
+
+	// Copy to renderer once for all of them
 	SDL_RenderClear(theRenderer);
 	SDL_RenderCopy(theRenderer, theTexture, NULL, NULL);
 	SDL_RenderPresent(theRenderer);
 #else
-	PPRect r2(r);
-	postProcess(r2);
+	SDL_Rect rects[MAXDIRTYRECTS];
+
+	for (pp_int32 i = 0; i < numDirtyRects; i++)
+	{
+		const PPRect& r = dirtyRects[i];
+
+		postProcess(r);
 
-	PPRect r3(r);
-	r3.scale(scaleFactor);
+		PPRect r3(r);
+		r3.scale(scaleFactor);
 
-	transformInverse(r3);
+		transformInverse(r3);
 
-	SDL_UpdateRect(theSurface, r3.x1, r3.y1, (r3.x2-r3.x1), (r3.y2-r3.y1));
+		rects[i].x = r3.x1;
+		rects[i].y = r3.y1;
+		rects[i].w = r3.x2 - r3.x1;
+		rects[i].h = r3.y2 - r3.y1;
+
+		statistics.numUploadedBytes += (pp_int64)rects[i].w * rects[i].h * theSurface->format->BytesPerPixel;
+	}
+
+	SDL_UpdateRects(theSurface, numDirtyRects, rects);
 #endif
+
+	statistics.numFrames++;
+	statistics.numUploadedRects += numDirtyRects;
+	numDirtyRects = 0;
 }
 
 void PPDisplayDeviceFB::postProcess(const PPRect& r2)
@@ -993,6 +1121,7 @@ void PPDisplayDeviceFB::postProcess(const PPRect& r2)
 void PPDisplayDeviceFB::setSize(const PPSize& size)
 {
 	this->size = size;
+	numDirtyRects = 0;
 	theSurface = SDL_CreateRGBSurface(0, size.width, size.height, theSurface->format->BitsPerPixel, 0, 0, 0, 0);
 	theTexture = SDL_CreateTextureFromSurface(theRenderer, theSurface);
 	theRenderer = SDL_GetRenderer(theWindow);
@@ -45,6 +45,17 @@ struct Screen;
 
 class PPDisplayDeviceFB : public PPDisplayDevice
 {
+public:
+	struct FrameStatistics
+	{
+		pp_uint32 numFrames;
+		// rects passed to update()
+		pp_uint32 numRequestedRects;
+		// rects left after merging, these are the ones uploaded
+		pp_uint32 numUploadedRects;
+		pp_int64 numUploadedBytes;
+	};
+
 private:
 	bool needsTemporaryBuffer;
 	pp_uint8* temporaryBuffer;
@@ -59,9 +70,22 @@ private:
 	pp_uint32 			currentSAGAPage;
 #endif
 
+	// dirty rects collected during a frame
+	enum
+	{
+		MAXDIRTYRECTS = 16
+	};
+
+	PPRect dirtyRects[MAXDIRTYRECTS];
+	pp_int32 numDirtyRects;
+
+	FrameStatistics statistics;
+
 	// used for rotating coordinates etc.
 	void postProcess(const PPRect& r);
 
+	void addDirtyRect(const PPRect& r);
+
 public:
 	PPDisplayDeviceFB(
 #if !SDL_VERSION_ATLEAST(2, 0, 0)
@@ -91,6 +115,10 @@ public:
 
 	void update();
 	void update(const PPRect& r);
+
+	virtual void flush();
+
+	const FrameStatistics& getFrameStatistics() const { return statistics; }
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 protected:
 	SDL_Surface* theSurface;
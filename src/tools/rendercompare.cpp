@@ -0,0 +1,213 @@
+/*
+ *  tools/rendercompare.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  Regression check for player changes which are supposed to leave the
+ *  output untouched: renders a module through PlayerSTD or PlayerIT and
+ *  compares the result to a reference rendering, sample by sample.
+ *
+ *  Build it once against the old milkyplay sources and once against the
+ *  new ones, e.g.
+ *
+ *  g++ -I../milkyplay rendercompare.cpp <milkyplay objects> -lpthread -o rendercompare
+ *
+ *  then
+ *
+ *  rendercompare-old [-it] module.xm reference.wav
+ *  rendercompare-new [-it] module.xm render.wav reference.wav
+ *
+ *  Mixer options can be compared within one build as well, e.g.
+ *
+ *  rendercompare module.xm reference.wav
+ *  rendercompare -unroll module.xm render.wav reference.wav
+ *
+ *  The exit code is 0 if both renderings are identical.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include "XModule.h"
+#include "MasterMixer.h"
+#include "AudioDriver_WAVWriter.h"
+#include "PlayerSTD.h"
+#include "PlayerIT.h"
+
+using namespace std;
+
+const mp_sint32 mixFrequency = 44100;
+const mp_sint32 bufferSize = 1024;
+
+mp_sint32 render(XModule& module, const char* fileName, bool useIT, ChannelMixer::ResamplerTypes resamplerType, bool loopUnrolling)
+{
+	WAVWriter wavWriter(fileName);
+	if (!wavWriter.isOpen())
+		return -1;
+
+	MasterMixer mixer(mixFrequency, bufferSize, 1, &wavWriter);
+
+	PlayerBase* player = useIT ? static_cast<PlayerBase*>(new PlayerIT(mixFrequency)) :
+								 static_cast<PlayerBase*>(new PlayerSTD(mixFrequency));
+
+	player->setBufferSize(bufferSize);
+	player->setResamplerType(resamplerType);
+	player->setLoopUnrolling(loopUnrolling);
+	mixer.addDevice(player);
+
+	player->startPlaying(&module, false, 0, 0, -1, NULL, false, -1);
+	mixer.start();
+
+	while (!player->hasSongHalted() && player->getOrder(0) < module.header.ordnum)
+		wavWriter.advance();
+
+	player->stopPlaying();
+	mixer.stop();
+	mixer.closeAudioDevice();
+
+	delete player;
+
+	return wavWriter.getNumPlayedSamples();
+}
+
+// load the sample data of a 16 bit stereo WAV written by WAVWriter
+mp_sword* loadWAV(const char* fileName, mp_uint32& numSamples)
+{
+	FILE* f = fopen(fileName, "rb");
+	if (!f)
+		return NULL;
+
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	mp_ubyte* buffer = new mp_ubyte[size];
+	size = (long)fread(buffer, 1, size, f);
+	fclose(f);
+
+	// look for the data chunk
+	long i = 12;
+	while (i + 8 <= size && memcmp(buffer + i, "data", 4) != 0)
+		i += 8 + (buffer[i+4] | (buffer[i+5] << 8) | (buffer[i+6] << 16) | (buffer[i+7] << 24));
+
+	if (i + 8 > size)
+	{
+		delete[] buffer;
+		return NULL;
+	}
+
+	i += 8;
+	numSamples = (mp_uint32)((size - i) / 2);
+
+	mp_sword* samples = new mp_sword[numSamples];
+	for (mp_uint32 j = 0; j < numSamples; j++)
+		samples[j] = (mp_sword)(buffer[i + j*2] | (buffer[i + j*2 + 1] << 8));
+
+	delete[] buffer;
+	return samples;
+}
+
+int main(int argc, const char* argv[])
+{
+	bool useIT = false;
+	bool loopUnrolling = false;
+	ChannelMixer::ResamplerTypes resamplerType = ChannelMixer::MIXER_LERPING;
+
+	int arg = 1;
+	while (arg < argc && argv[arg][0] == '-')
+	{
+		if (strcmp(argv[arg], "-it") == 0)
+			useIT = true;
+		else if (strcmp(argv[arg], "-unroll") == 0)
+			loopUnrolling = true;
+		else if (strcmp(argv[arg], "-resampler") == 0 && arg + 1 < argc)
+			resamplerType = (ChannelMixer::ResamplerTypes)atoi(argv[++arg]);
+		else
+			break;
+		arg++;
+	}
+
+	if (argc - arg < 2 || argc - arg > 3)
+	{
+		cerr << "Usage: " << argv[0] << " [-it] [-unroll] [-resampler type] module render.wav [reference.wav]" << endl;
+		exit(-1);
+	}
+
+	XModule module;
+	if (module.loadModule(argv[arg]) != MP_OK)
+	{
+		cerr << "Could not load " << argv[arg] << endl;
+		exit(-1);
+	}
+
+	if (render(module, argv[arg+1], useIT, resamplerType, loopUnrolling) < 0)
+	{
+		cerr << "Could not create " << argv[arg+1] << endl;
+		exit(-1);
+	}
+
+	if (argc - arg == 2)
+		return 0;
+
+	mp_uint32 numRendered = 0, numReference = 0;
+	mp_sword* rendered = loadWAV(argv[arg+1], numRendered);
+	mp_sword* reference = loadWAV(argv[arg+2], numReference);
+	if (rendered == NULL || reference == NULL)
+	{
+		cerr << "Could not read " << (rendered == NULL ? argv[arg+1] : argv[arg+2]) << endl;
+		exit(-1);
+	}
+
+	mp_uint32 numDifferences = 0, firstDifference = 0;
+	mp_sint32 maxDifference = 0;
+	const mp_uint32 numSamples = numRendered < numReference ? numRendered : numReference;
+	for (mp_uint32 i = 0; i < numSamples; i++)
+	{
+		mp_sint32 d = abs(rendered[i] - reference[i]);
+		if (!d)
+			continue;
+
+		if (!numDifferences)
+			firstDifference = i;
+		if (d > maxDifference)
+			maxDifference = d;
+		numDifferences++;
+	}
+
+	delete[] rendered;
+	delete[] reference;
+
+	if (numRendered != numReference)
+	{
+		cout << "Length differs: " << numRendered/2 << " frames rendered, " << numReference/2 << " in reference" << endl;
+		return 1;
+	}
+
+	if (numDifferences)
+	{
+		cout << numDifferences << " samples differ, first at frame " << firstDifference/2 << ", by up to " << maxDifference << endl;
+		return 1;
+	}
+
+	cout << "Identical, " << numSamples/2 << " frames" << endl;
+	return 0;
+}
@@ -40,7 +40,8 @@
 DialogEQ::DialogEQ(PPScreen* screen, 
 				   DialogResponder* responder,
 				   pp_int32 id,
-				   EQNumBands numBands) :
+				   EQNumBands numBands,
+				   bool previewButton) :
 	PPDialogBase(),
 	numBands(numBands)
 {
@@ -57,7 +58,11 @@ DialogEQ::DialogEQ(PPScreen* screen,
 	
 	sprintf(dummy, "%i Band Equalizer" PPSTR_PERIODS, numSliders);
 	
-	initDialog(screen, responder, id, dummy, 300, 230, 26, "Ok", "Cancel");
+	// the middle button responds with ActionNo
+	if (previewButton)
+		initDialog(screen, responder, id, dummy, 300, 230, 26, "Ok", "Preview", "Cancel");
+	else
+		initDialog(screen, responder, id, dummy, 300, 230, 26, "Ok", "Cancel");
 
 	pp_int32 x = getMessageBoxContainer()->getLocation().x;
 	pp_int32 y = getMessageBoxContainer()->getLocation().y;
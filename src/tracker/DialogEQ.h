@@ -54,7 +54,8 @@ private:
 public:
 	DialogEQ(PPScreen* screen, DialogResponder* responder,
 			 pp_int32 id,
-			 EQNumBands numBands);
+			 EQNumBands numBands,
+			 bool previewButton = false);
 
 	void setBandParam(pp_uint32 index, float param);
 	float getBandParam(pp_uint32 index) const;
@@ -39,7 +39,7 @@
 #include "ListBox.h"
 #include "Seperator.h"
 #include "XModule.h"
-#include "ResamplerHelper.h"
+#include "SampleEditorResampler.h"
 
 float getc4spd(mp_sint32 relnote,mp_sint32 finetune)
 {
@@ -92,7 +92,6 @@ DialogResample::DialogResample(PPScreen* screen,
 							   pp_int32 id) :
 	PPDialogBase(),
 	count(0),
-	resamplerHelper(new ResamplerHelper()),
 	interpolationType(1),
 	adjustFtAndRelnote(true)
 {
@@ -191,7 +190,7 @@ DialogResample::DialogResample(PPScreen* screen,
 	
 	x2+=15*8;
 	button = new PPButton(MESSAGEBOX_CONTROL_USER1, screen, this, PPPoint(x2, y2), PPSize(button->getLocation().x + button->getSize().width - x2, 11), false);
-	button->setText(resamplerHelper->getResamplerName(interpolationType, true));
+	button->setText(SampleEditorResampler::getResamplerName(interpolationType, true));
 	button->setColor(messageBoxContainerGeneric->getColor());
 	button->setTextColor(PPUIConfig::getInstance()->getColor(PPUIConfig::ColorStaticText));
 
@@ -252,7 +251,6 @@ DialogResample::DialogResample(PPScreen* screen,
 
 DialogResample::~DialogResample()
 {
-	delete resamplerHelper;
 }
 
 void DialogResample::show(bool b/* = true*/)
@@ -264,7 +262,7 @@ void DialogResample::show(bool b/* = true*/)
 		listBoxEnterEditState(MESSAGEBOX_LISTBOX_VALUE_ONE);
 		
 		PPButton* button = static_cast<PPButton*>(messageBoxContainerGeneric->getControlByID(MESSAGEBOX_CONTROL_USER1));
-		button->setText(resamplerHelper->getResamplerName(interpolationType, true));
+		button->setText(SampleEditorResampler::getResamplerName(interpolationType, true));
 	}
 	PPDialogBase::show(b);	
 }
@@ -355,10 +353,10 @@ pp_int32 DialogResample::handleEvent(PPObject* sender, PPEvent* event)
 				if (event->getID() != eCommand)
 					break;
 				
-				interpolationType = (interpolationType + 1) % resamplerHelper->getNumResamplers();
+				interpolationType = (interpolationType + 1) % SampleEditorResampler::getNumResamplers();
 				
 				PPButton* button = static_cast<PPButton*>(messageBoxContainerGeneric->getControlByID(MESSAGEBOX_CONTROL_USER1));
-				button->setText(resamplerHelper->getResamplerName(interpolationType, true));
+				button->setText(SampleEditorResampler::getResamplerName(interpolationType, true));
 				parentScreen->paintControl(messageBoxContainerGeneric);							
 				break;
 			}
@@ -45,7 +45,6 @@ private:
 	float c4spd;
 	float originalc4spd;
 	
-	class ResamplerHelper* resamplerHelper;
 	pp_int32 interpolationType;
 	bool adjustFtAndRelnote;
 
@@ -40,7 +40,8 @@ DialogWithValues::DialogWithValues(PPScreen* screen,
 								   DialogResponder* responder,
 								   pp_int32 id,
 								   const PPString& caption,
-								   ValueStyles style) :
+								   ValueStyles style,
+								   bool previewButton) :
 	PPDialogBase()
 {
 	valueOne = 0;
@@ -54,24 +55,30 @@ DialogWithValues::DialogWithValues(PPScreen* screen,
 	numValueOneDecimals = 0; 
 	numValueTwoDecimals = 0;
 
+	pp_int32 height = 0;
 	switch (style)
 	{
 		case ValueStyleEnterOneValue:
-#ifdef __LOWRES__
-			initDialog(screen, responder, id, caption, 290, 110+15, 26+15, "Ok", "Cancel");
-#else
-			initDialog(screen, responder, id, caption, 290, 110, 26, "Ok", "Cancel");
-#endif
+			height = 110;
 			break;
 			
 		case ValueStyleEnterTwoValues:
+			height = 142;
+			break;
+	}
+
 #ifdef __LOWRES__
-			initDialog(screen, responder, id, caption, 290, 142+15, 26+15, "Ok", "Cancel");
+	const pp_int32 captionOffset = 26+15;
+	height+=15;
 #else
-			initDialog(screen, responder, id, caption, 290, 142, 26, "Ok", "Cancel");
+	const pp_int32 captionOffset = 26;
 #endif
-			break;
-	}
+
+	// the middle button responds with ActionNo
+	if (previewButton)
+		initDialog(screen, responder, id, caption, 290, height, captionOffset, "Ok", "Preview", "Cancel");
+	else
+		initDialog(screen, responder, id, caption, 290, height, captionOffset, "Ok", "Cancel");
 
 	pp_int32 x = getMessageBoxContainer()->getLocation().x;
 	
@@ -53,7 +53,8 @@ public:
 					 DialogResponder* responder,
 					 pp_int32 id,
 					 const PPString& caption,
-					 ValueStyles style);
+					 ValueStyles style,
+					 bool previewButton = false);
 
 	float getValueOne() { return valueOne; }
 	float getValueTwo() { return valueTwo; }
@@ -31,7 +31,11 @@ public:
 	~Equalizer(void);
 
 	void CalcCoeffs(float centre, float width, float rate, float gain);
+	// Clear the filter history, coefficients are kept
+	void Reset();
 	void Filter(double xL, double xR, double &yL, double &yR);
+	// Filter a mono signal in place, same as passing it as left channel
+	void Filter(double* buffer, int count);
 
 	// Calculate frequency from 20Hz to 20,000 Hz, a value of 0 to 1 should be passed (as is normally used in linear controls)
 	static float CalcFreq(float f) { return (float)(pow(1000.0f,f)*20); }
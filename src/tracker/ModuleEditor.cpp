@@ -30,6 +30,7 @@
 #include "TrackerConfig.h"
 #include "PPSystem.h"
 #include "XIInstrument.h"
+#include "XMFileMemory.h"
 
 static const char validCharacters[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_!.";
 
@@ -107,6 +108,7 @@ ModuleEditor::ModuleEditor() :
 	patternEditor(NULL),
 	sampleEditor(NULL),
 	envelopeEditor(NULL),
+	moduleServices(NULL),
 	playerCriticalSection(NULL),
 	changed(false),
 	eSaveType(ModSaveTypeXM),
@@ -188,6 +190,15 @@ PPSystemString ModuleEditor::getModuleFileName(ModSaveTypes extension/* = ModSav
 	return s.stripPath();
 }
 
+void ModuleEditor::setChanged()
+{
+	changed = true;
+
+	// song structure might have changed
+	if (moduleServices)
+		moduleServices->invalidateEstimatedSongLength();
+}
+
 void ModuleEditor::reloadCurrentPattern()
 {
 	TXMPattern* pattern = patternEditor->getPattern();
@@ -594,7 +605,7 @@ void ModuleEditor::createEmptySong(bool clearPatterns/* = true*/, bool clearInst
 		}
 		else
 		{
-			changed = true;
+			setChanged();
 		}
 
 		buildInstrumentTable();
@@ -671,7 +682,18 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 	if (!XMFile::exists(fileName))
 		return false;
 
-	mp_sint32 nRes = module->loadModule(fileName);
+	XMFile f(fileName);
+	if (!f.isOpen())
+		return false;
+
+	return openSong(f, preferredFileName ? preferredFileName : fileName);
+}
+
+bool ModuleEditor::openSong(XMFileBase& f, const SYSCHAR* fileName)
+{
+	const mp_uint32 startPos = f.pos();
+
+	mp_sint32 nRes = module->loadModule(f);
 
 	// unknown format
 	if (nRes == MP_UNKNOWN_FORMAT)
@@ -681,7 +703,7 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 
 	bool res = (nRes == MP_OK);
 
-	XMFile f(fileName);
+	f.seek(startPos);
 	bool isMagicMOD = f.readByte() == 232;
 
 	XModule::ModuleTypes type = XModule::ModuleType_NONE;
@@ -709,16 +731,19 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 			}
 		}
 
-		PPSystemString tempFile(getTempFilename());
 #if !defined(__AMIGA__)
 		try
 		{
 #endif
-			res = module->saveExtendedModule(tempFile, isMagicMOD) == MP_OK;
+			// convert to XM in memory
+			XMFileMemory xmFile(fileName);
+
+			res = module->saveExtendedModule(xmFile, isMagicMOD) == MP_OK;
 			if(!res)
 				return res;
 
-			res = module->loadModule(tempFile) == MP_OK;
+			xmFile.seek(0);
+			res = module->loadModule(xmFile) == MP_OK;
 #if !defined(__AMIGA__)
 		} catch (const std::bad_alloc &) {
 			return false;
@@ -737,8 +762,6 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 				}
 			}
 		}
-
-		XMFile::remove(tempFile);
 	}
 
 	if (module->header.channum > TrackerConfig::numPlayerChannels)
@@ -756,7 +779,7 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 		for (mp_sint32 i = 0; i < module->header.patnum; i++)
 			getPattern(i);
 
-		PPSystemString strFileName = preferredFileName ? preferredFileName : fileName;
+		PPSystemString strFileName = fileName;
 
 		moduleFileName = strFileName.stripExtension();
 
@@ -825,7 +848,7 @@ void ModuleEditor::increaseSongLength()
 	if (module->header.ordnum < 255)
 	{
 		module->header.ordnum++;
-		changed = true;
+		setChanged();
 	}
 }
 
@@ -834,7 +857,7 @@ void ModuleEditor::decreaseSongLength()
 	if (module->header.ordnum > 1)
 	{
 		module->header.ordnum--;
-		changed = true;
+		setChanged();
 	}
 }
 
@@ -849,7 +872,7 @@ void ModuleEditor::increaseRepeatPos()
 		module->header.restart = module->header.ordnum - 1;
 
 	if (old != module->header.restart)
-		changed = true;
+		setChanged();
 }
 
 void ModuleEditor::decreaseRepeatPos()
@@ -857,7 +880,7 @@ void ModuleEditor::decreaseRepeatPos()
 	if (module->header.restart > 0)
 	{
 		module->header.restart--;
-		changed = true;
+		setChanged();
 	}
 }
 
@@ -883,7 +906,7 @@ bool ModuleEditor::insertNewOrderPosition(mp_sint32 index)
 
 	memcpy(module->header.ord, temp, module->header.ordnum);
 
-	changed = true;
+	setChanged();
 
 	return true;
 }
@@ -897,7 +920,7 @@ void ModuleEditor::deleteOrderPosition(mp_sint32 index)
 
 		module->header.ordnum--;
 
-		changed = true;
+		setChanged();
 	}
 }
 
@@ -937,7 +960,7 @@ bool ModuleEditor::seqCurrentOrderPosition(mp_sint32 index, bool clone/* = false
 		module->phead[dstPatternIndex] = module->phead[srcPatternIndex];
 	}
 
-	changed = true;
+	setChanged();
 
 	return true;
 }
@@ -953,7 +976,7 @@ void ModuleEditor::increaseOrderPosition(mp_sint32 index)
 	{
 		module->header.ord[index]++;
 
-		changed = true;
+		setChanged();
 	}
 }
 
@@ -963,7 +986,7 @@ void ModuleEditor::decreaseOrderPosition(mp_sint32 index)
 	{
 		module->header.ord[index]--;
 
-		changed = true;
+		setChanged();
 	}
 }
 
@@ -1192,7 +1215,7 @@ mp_sint32 ModuleEditor::allocateInstrument()
 
 	leaveCriticalSection();
 
-	changed = true;
+	setChanged();
 
 	return 0;
 }
@@ -1244,7 +1267,7 @@ void ModuleEditor::clearSample(mp_sint32 smpIndex)
 		dst->loopstart = 0;
 		dst->looplen = 0;
 
-		changed = true;
+		setChanged();
 	}
 }
 
@@ -1301,7 +1324,7 @@ bool ModuleEditor::loadSample(const SYSCHAR* fileName,
 
 			validateInstruments();
 
-			changed = true;
+			setChanged();
 		}
 
 		leaveCriticalSection();
@@ -1391,7 +1414,7 @@ void ModuleEditor::freeInstrument()
 
 	leaveCriticalSection();
 
-	changed = true;
+	setChanged();
 }
 
 bool ModuleEditor::insertXIInstrument(mp_sint32 index, const XIInstrument* ins)
@@ -1521,7 +1544,7 @@ bool ModuleEditor::insertXIInstrument(mp_sint32 index, const XIInstrument* ins)
 		memcpy(dst->name, src->name, sizeof(dst->name));
 	}
 
-	changed = true;
+	setChanged();
 
 	return true;
 }
@@ -1678,7 +1701,7 @@ bool ModuleEditor::zapInstrument(mp_sint32 index)
 
 	leaveCriticalSection();
 
-	changed = true;
+	setChanged();
 
 	return res;
 }
@@ -1911,14 +1934,14 @@ bool ModuleEditor::swapSamples(ModuleEditor& dstModule, mp_sint32 dstInsIndex, m
 void ModuleEditor::setNumChannels(mp_uint32 channels)
 {
 	if (module->header.channum != channels)
-		changed = true;
+		setChanged();
 	module->header.channum = channels;
 }
 
 void ModuleEditor::setTitle(const char* name, mp_uint32 length)
 {
 	insertText(module->header.name, name, length);
-	changed = true;
+	setChanged();
 }
 
 void ModuleEditor::getTitle(char* name, mp_uint32 length) const
@@ -1936,7 +1959,7 @@ void ModuleEditor::setNumOrders(mp_sint32 numOrders)
 		numOrders = 1;
 
 	if (module->header.ordnum != numOrders)
-		changed = true;
+		setChanged();
 
 	module->header.ordnum = numOrders;
 }
@@ -1955,7 +1978,7 @@ void ModuleEditor::setFrequency(Frequencies frequency)
 void ModuleEditor::setSampleName(mp_sint32 insIndex, mp_sint32 smpIndex, const char* name, mp_uint32 length)
 {
 	insertText((char*)getSampleInfo(insIndex, smpIndex)->name, name, length);
-	changed = true;
+	setChanged();
 }
 
 void ModuleEditor::getSampleName(mp_sint32 insIndex, mp_sint32 smpIndex, char* name, mp_uint32 length) const
@@ -1971,7 +1994,7 @@ void ModuleEditor::setCurrentSampleName(const char* name, mp_uint32 length)
 		return;
 
 	insertText((char*)sampleEditor->getSample()->name, name, length);
-	changed = true;
+	setChanged();
 }
 
 TXMSample* ModuleEditor::getFirstSampleInfo()
@@ -1998,7 +2021,7 @@ TXMSample* ModuleEditor::getNextSampleInfo()
 void ModuleEditor::setInstrumentName(mp_sint32 insIndex, const char* name, mp_uint32 length)
 {
 	insertText(module->instr[insIndex].name, name, length);
-	changed = true;
+	setChanged();
 }
 
 void ModuleEditor::getInstrumentName(mp_sint32 insIndex, char* name, mp_uint32 length) const
@@ -2067,7 +2090,7 @@ void ModuleEditor::updateSampleTable(mp_sint32 index, const mp_ubyte* nbu)
 
 	}
 
-	changed = true;
+	setChanged();
 }
 
 void ModuleEditor::updateInstrumentData(mp_sint32 index)
@@ -2093,7 +2116,7 @@ void ModuleEditor::updateInstrumentData(mp_sint32 index)
 		smp->vibsweep = instruments[index].vibsweep;
 	}
 
-	changed = true;
+	setChanged();
 
 }
 
@@ -2110,7 +2133,7 @@ pp_int32 ModuleEditor::insRemapSong(pp_int32 oldIns, pp_int32 newIns)
 	}
 
 	if (resCnt)
-		changed = true;
+		setChanged();
 
 	return resCnt;
 }
@@ -2135,7 +2158,7 @@ pp_int32 ModuleEditor::noteTransposeSong(const PatternEditorTools::TransposePara
 	if (!evaluate)
 	{
 		if (resCnt)
-			changed = true;
+			setChanged();
 
 		return resCnt;
 	}
@@ -2199,7 +2222,7 @@ pp_int32 ModuleEditor::panConvertSong(PanConversionTypes type)
 	}
 
 	if (resCnt)
-		changed = true;
+		setChanged();
 
 	return resCnt;
 }
@@ -2210,7 +2233,7 @@ pp_int32 ModuleEditor::removeUnusedPatterns(bool evaluate)
 
 	if (!evaluate && result)
 	{
-		changed = true;
+		setChanged();
 		if (currentPatternIndex > module->header.patnum - 1)
 			currentPatternIndex = module->header.patnum - 1;
 	}
@@ -2312,7 +2335,7 @@ pp_int32 ModuleEditor::removeUnusedInstruments(bool evaluate, bool remap)
 	}
 
 	if (!evaluate && result)
-		changed = true;
+		setChanged();
 
 	delete[] bitMap;
 
@@ -2439,7 +2462,7 @@ pp_int32 ModuleEditor::removeUnusedSamples(bool evaluate)
 	}
 
 	if (!evaluate && result)
-		changed = true;
+		setChanged();
 
 	delete[] bitMap;
 
@@ -2459,7 +2482,7 @@ pp_int32 ModuleEditor::relocateCommands(const PatternEditorTools::RelocateParame
 	}
 
 	if (!evaluate && result)
-		changed = true;
+		setChanged();
 
 	return result;
 }
@@ -2477,7 +2500,7 @@ pp_int32 ModuleEditor::zeroOperands(const PatternEditorTools::OperandOptimizePar
 	}
 
 	if (!evaluate && result)
-		changed = true;
+		setChanged();
 
 	return result;
 }
@@ -2495,7 +2518,7 @@ pp_int32 ModuleEditor::fillOperands(const PatternEditorTools::OperandOptimizePar
 	}
 
 	if (!evaluate && result)
-		changed = true;
+		setChanged();
 
 	return result;
 }
@@ -2538,7 +2561,7 @@ void ModuleEditor::optimizeSamples(bool convertTo8Bit, bool minimize,
 	sampleEditor->attachSample(oldSmp, module);
 
 	if (!evaluate && (numMinimizedSamples || numConvertedSamples))
-		changed = true;
+		setChanged();
 }
 
 void ModuleEditor::insertText(char* dst, const char* src, mp_sint32 max)
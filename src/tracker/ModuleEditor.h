@@ -178,7 +178,7 @@ public:
 	void setCurrentCursorPosition(const PatternEditorTools::Position& currentCursorPosition) { this->currentCursorPosition = currentCursorPosition; }
 	const PatternEditorTools::Position& getCurrentCursorPosition() { return currentCursorPosition; }
 
-	void setChanged() { changed = true; }
+	void setChanged();
 	bool hasChanged() const { return changed; }
 
 	void reloadCurrentPattern();
@@ -245,6 +245,8 @@ public:
 	bool isEmpty() const;
 
 	bool openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFileName = NULL);
+	// load from an already opened stream (e.g. a decompressed module in memory)
+	bool openSong(XMFileBase& f, const SYSCHAR* fileName);
 	bool saveSong(const SYSCHAR* fileName, ModSaveTypes saveType = ModSaveTypeXM);
 	mp_sint32 saveBackup(const SYSCHAR* fileName);
 
@@ -32,45 +32,17 @@
 #include "SongLengthEstimator.h"
 #include "PlayerGeneric.h"
 #include "AudioDriver_NULL.h"
+#include "AudioDriver_WAVWriter.h"
+#include "MasterMixer.h"
+#include "MixerProxy.h"
 #include "XModule.h"
+#include "PPSystem.h"
 
 void ModuleServices::estimateSongLength()
 {
 	SongLengthEstimator estimator(&module);
 	estimatedSongLength = estimator.estimateSongLengthInSeconds();
-}
-
-pp_int32 ModuleServices::estimateMixerVolume(WAVWriterParameters& parameters,
-											 pp_int32* numSamplesProgressed/* = NULL*/)
-{
-	PlayerGeneric* player = new PlayerGeneric(parameters.sampleRate);
-
-	player->setBufferSize(1024);
-	player->setPlayMode((PlayerGeneric::PlayModes)parameters.playMode);
-	player->setResamplerType((ChannelMixer::ResamplerTypes)parameters.resamplerType);
-	player->setSampleShift(parameters.mixerShift);
-	player->setMasterVolume(256);
-	player->setPeakAutoAdjust(true);
-
-	AudioDriver_NULL* audioDriver = new AudioDriver_NULL;
-
-	pp_int32 res = player->exportToWAV(NULL, &module,
-									   parameters.fromOrder, parameters.toOrder,
-									   parameters.muting,
-									   module.header.channum,
-									   parameters.panning,
-									   audioDriver);
-
-	if (numSamplesProgressed)
-		*numSamplesProgressed = res;
-
-	delete audioDriver;
-
-	pp_int32 mixerVolume = player->getMasterVolume();
-
-	delete player;
-
-	return mixerVolume;
+	estimatedSongLengthOutdated = false;
 }
 
 pp_int32 ModuleServices::estimateWaveLengthInSamples(WAVWriterParameters& parameters)
@@ -111,36 +83,66 @@ pp_int32 ModuleServices::exportToWAV(const PPSystemString& fileName, WAVWriterPa
 
 	pp_int32 res = 0;
 
-	if (parameters.multiTrack)
+	if (parameters.multiTrack && parameters.multiTrackSingleFile)
+	{
+		res = player->exportStemsToMultiChannelWAV(fileName, &module,
+												   parameters.fromOrder, parameters.toOrder,
+												   parameters.muting,
+												   parameters.panning);
+	}
+	else if (parameters.multiTrack)
 	{
-		mp_ubyte* muting = new mp_ubyte[module.header.channum];
+		// all channels are rendered in a single pass,
+		// muted channels don't get a file
+		PPSystemString* fileNames = new PPSystemString[module.header.channum];
+		const SYSCHAR** stemFileNames = new const SYSCHAR*[module.header.channum];
 
 		PPSystemString baseName = fileName.stripExtension();
 		PPSystemString extension = fileName.getExtension();
 
 		for (pp_uint32 i = 0; i < module.header.channum; i++)
 		{
-			PPSystemString fileName = baseName;
+			stemFileNames[i] = NULL;
+
+			if (parameters.muting[i])
+				continue;
 
 			char infix[80];
 			sprintf(infix, "_%02d", i+1);
 
-			fileName.append(infix);
-			fileName.append(extension);
+			fileNames[i] = baseName;
+			fileNames[i].append(infix);
+			fileNames[i].append(extension);
 
-			if (!parameters.muting[i])
-			{
-				memset(muting, 1, module.header.channum);
-				muting[i] = 0;
-				res = player->exportToWAV(fileName, &module,
-										  parameters.fromOrder, parameters.toOrder,
-										  muting,
-										  module.header.channum,
-										  parameters.panning);
-			}
+			stemFileNames[i] = fileNames[i];
 		}
 
-		delete[] muting;
+		res = player->exportStemsToWAV(stemFileNames, &module,
+									   parameters.fromOrder, parameters.toOrder,
+									   parameters.panning);
+
+		delete[] stemFileNames;
+		delete[] fileNames;
+	}
+	else if (parameters.normalize || parameters.numBits == 24)
+	{
+		// mix into a 32 bit spill file, peak and final scaling are
+		// taken care of when the writer is closed
+		PPSystemString spillFileName(System::getTempFileName());
+		WAVNormalizingWriter* wavWriter = new WAVNormalizingWriter(fileName, spillFileName,
+																   parameters.numBits, parameters.normalize);
+
+		if (wavWriter->isOpen())
+		{
+			res = player->exportToWAV(NULL, &module,
+									  parameters.fromOrder, parameters.toOrder,
+									  parameters.muting,
+									  module.header.channum,
+									  parameters.panning,
+									  wavWriter);
+		}
+
+		delete wavWriter;
 	}
 	else
 	{
@@ -163,12 +165,47 @@ private:
 	bool		mono;
 	pp_uint32   index;
 
+	// normalizing: the unclipped 32 bit mix is kept until the device
+	// is closed and scaled down at once if it would clip
+	bool		normalize;
+	pp_int32*	mixBuffer;
+	pp_int32	peak;
+	MixerProxyMixDown proxy;
+
+	void store(pp_int32 res)
+	{
+		if (index < destBufferSize)
+		{
+			if (mixBuffer)
+			{
+				mixBuffer[index] = res;
+				if (res < 0) res = -res;
+				if (res > peak) peak = res;
+			}
+			else
+			{
+				if (res < -32768) res = -32768;
+				if (res > 32767) res = 32767;
+				destBuffer[index] = (pp_int16)res;
+			}
+		}
+		index++;
+	}
+
 public:
-	BufferWriter(pp_int16* buffer, pp_uint32 bufferSize, bool mono) :
+	BufferWriter(pp_int16* buffer, pp_uint32 bufferSize, bool mono, bool normalize = false) :
 		destBuffer(buffer),
 		destBufferSize(bufferSize),
-		mono(mono)
+		mono(mono),
+		normalize(normalize),
+		mixBuffer(NULL),
+		peak(0)
+	{
+	}
+
+	virtual ~BufferWriter()
 	{
+		delete[] mixBuffer;
 	}
 
 	virtual mp_sint32 initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mixFrequency, MasterMixer* mixer)
@@ -178,6 +215,17 @@ public:
 			return res;
 
 		index = 0;
+		peak = 0;
+
+		if (normalize)
+		{
+			delete[] mixBuffer;
+			mixBuffer = new pp_int32[destBufferSize];
+			memset(mixBuffer, 0, destBufferSize * sizeof(pp_int32));
+
+			proxy.setBuffer<mp_sword>(MixerProxyMixDown::MixDownBuffer, compensateBuffer);
+		}
+
 		return 0;
 	}
 
@@ -187,32 +235,72 @@ public:
 		return 0;
 	}
 
+	virtual mp_sint32 closeDevice()
+	{
+		if (!mixBuffer)
+			return AudioDriver_NULL::closeDevice();
+
+		// like PeakAutoAdjustFilter, never amplify
+		const pp_uint32 sampleShift = mixer->getSampleShift();
+		const pp_int32 fullScale = (32767 << sampleShift);
+		const pp_int64 gain = peak > fullScale ? ((pp_int64)fullScale << 16) / peak : ((pp_int64)1 << 16);
+
+		for (pp_uint32 i = 0; i < destBufferSize; i++)
+		{
+			pp_int32 res = (pp_int32)(((pp_int64)mixBuffer[i] * gain) >> (16 + sampleShift));
+			if (res < -32768) res = -32768;
+			if (res > 32767) res = 32767;
+			destBuffer[i] = (pp_int16)res;
+		}
+
+		delete[] mixBuffer;
+		mixBuffer = NULL;
+
+		return AudioDriver_NULL::closeDevice();
+	}
+
 	virtual	const char* getDriverID() { return "BufferWriter"; }
 
 	virtual void advance()
 	{
+		if (mixBuffer)
+		{
+			// the proxy replaces the mix-down of AudioDriver_NULL::advance()
+			numSamplesWritten+=bufferSize / MP_NUMCHANNELS;
+
+			if (!mixer->isPlaying())
+				return;
+
+			mixer->mixerHandler(NULL, &proxy);
+
+			const mp_sint32* buffer = proxy.getBuffer<mp_sint32>(MixerProxyMixDown::MixBuffer);
+			if (buffer == NULL)
+				return;
+
+			if (mono)
+			{
+				for (pp_int32 i = 0; i < bufferSize / MP_NUMCHANNELS; i++)
+					store((pp_int32)(((pp_int64)buffer[i*2] + (pp_int64)buffer[i*2+1]) >> 1));
+			}
+			else
+			{
+				for (pp_int32 i = 0; i < bufferSize; i++)
+					store(buffer[i]);
+			}
+			return;
+		}
+
 		AudioDriver_NULL::advance();
 
 		if (mono)
 		{
 			for (pp_int32 i = 0; i < bufferSize / MP_NUMCHANNELS; i++)
-			{
-				pp_int32 res = ((pp_int32)compensateBuffer[i*2] + (pp_int32)compensateBuffer[i*2+1]) >> 1;
-				if (res < -32768) res = -32768;
-				if (res > 32767) res = 32767;
-				if (index < destBufferSize)
-					destBuffer[index] = (pp_int16)res;
-				index++;
-			}
+				store(((pp_int32)compensateBuffer[i*2] + (pp_int32)compensateBuffer[i*2+1]) >> 1);
 		}
 		else
 		{
 			for (pp_int32 i = 0; i < bufferSize; i++)
-			{
-				if (index < destBufferSize)
-					destBuffer[index] = compensateBuffer[i];
-				index++;
-			}
+				store(compensateBuffer[i]);
 		}
 		//f->writeWords((mp_uword*)compensateBuffer, bufferSize);
 	}
@@ -229,7 +317,7 @@ pp_int32 ModuleServices::exportToBuffer16Bit(WAVWriterParameters& parameters, pp
 	player->setSampleShift(parameters.mixerShift);
 	player->setMasterVolume(parameters.mixerVolume);
 
-	BufferWriter* audioDriver = new BufferWriter(buffer, bufferSize, mono);
+	BufferWriter* audioDriver = new BufferWriter(buffer, bufferSize, mono, parameters.normalize);
 
 	pp_int32 res = player->exportToWAV(NULL, &module,
 									   parameters.fromOrder, parameters.toOrder,
@@ -238,6 +326,7 @@ pp_int32 ModuleServices::exportToBuffer16Bit(WAVWriterParameters& parameters, pp
 									   parameters.panning,
 									   audioDriver);
 
+	delete audioDriver;
 	delete player;
 	return res;
 }
@@ -40,17 +40,22 @@ private:
 	class XModule& module;
 
 	pp_int32 estimatedSongLength;
+	bool estimatedSongLengthOutdated;
 
 public:
 	ModuleServices(XModule& module) :
 		module(module),
-		estimatedSongLength(-1)
+		estimatedSongLength(-1),
+		estimatedSongLengthOutdated(false)
 	{
 	}
 	
 	void estimateSongLength();
 	pp_int32 getEstimatedSongLength() const { return estimatedSongLength; }
-	void resetEstimatedSongLength() { estimatedSongLength = -1; }
+	void resetEstimatedSongLength() { estimatedSongLength = -1; estimatedSongLengthOutdated = false; }
+	// the module has been edited, the estimation is cheap enough to be redone
+	void invalidateEstimatedSongLength() { estimatedSongLengthOutdated = true; }
+	bool isEstimatedSongLengthOutdated() const { return estimatedSongLengthOutdated; }
 	
 	struct WAVWriterParameters
 	{
@@ -66,6 +71,14 @@ public:
 		const pp_uint8* panning;
 		
 		bool multiTrack;
+		// multi-track only: one multichannel WAV instead of one WAV per channel
+		bool multiTrackSingleFile;
+		
+		// single file and buffer only: render once at mixerVolume and scale
+		// the result down if it would clip
+		bool normalize;
+		// 16 or 24
+		pp_uint32 numBits;
 		
 		WAVWriterParameters() :
 			sampleRate(0),
@@ -77,14 +90,14 @@ public:
 			toOrder(0),
 			muting(NULL),
 			panning(NULL),
-			multiTrack(false)
+			multiTrack(false),
+			multiTrackSingleFile(false),
+			normalize(false),
+			numBits(16)
 		{
 		}
 	};
 	
-	pp_int32 estimateMixerVolume(WAVWriterParameters& parameters, 
-								 pp_int32* numSamplesProgressed = NULL);
-								 
 	pp_int32 estimateWaveLengthInSamples(WAVWriterParameters& parameters);
 
 	pp_int32 exportToWAV(const PPSystemString& fileName, WAVWriterParameters& parameters);
@@ -65,8 +65,10 @@ void PatternEditor::prepareUndo()
 	undoUserData.clear();
 	notifyListener(NotificationFeedUndoData);
 
-	delete before; 
-	before = new PatternUndoStackEntry(*pattern, cursor.channel, cursor.row, cursor.inner, &undoUserData);
+	// the last state we've saved, the new entry only stores what differs
+	PatternUndoStackEntry* last = before;
+	before = new PatternUndoStackEntry(*pattern, cursor.channel, cursor.row, cursor.inner, &undoUserData, last);
+	delete last;
 }
 
 bool PatternEditor::finishUndo(LastChanges lastChange, bool nonRepeat/* = false*/)
@@ -79,7 +81,7 @@ bool PatternEditor::finishUndo(LastChanges lastChange, bool nonRepeat/* = false*
 	undoUserData.clear();
 	notifyListener(NotificationFeedUndoData);
 
-	PatternUndoStackEntry after(*pattern, cursor.channel, cursor.row, cursor.inner, &undoUserData); 
+	PatternUndoStackEntry after(*pattern, cursor.channel, cursor.row, cursor.inner, &undoUserData, before); 
 	if (*before != after) 
 	{ 
 		PatternEditorTools::Position afterPos;
@@ -94,7 +96,7 @@ bool PatternEditor::finishUndo(LastChanges lastChange, bool nonRepeat/* = false*
 	
 		result = true;
 		
-		lastOperationDidChangeRows = after.GetPattern().rows != before->GetPattern().rows;
+		lastOperationDidChangeRows = after.getRows() != before->getRows();
 		lastOperationDidChangeCursor = beforePos != afterPos;
 		notifyListener(NotificationChanges);
 		if (undoStack) 
@@ -105,7 +107,11 @@ bool PatternEditor::finishUndo(LastChanges lastChange, bool nonRepeat/* = false*
 				undoStack->Push(*before); 				
 			undoStack->Push(after); 
 			undoStack->Pop(); 
+			undoStack->TrimToBudget(UNDOMEMORY_PATTERNEDITOR);
 		} 
+
+		// keep the new state around, next entry is stored relative to it
+		*before = after;
 	} 
 	this->lastChange = lastChange; 
 
@@ -304,19 +310,21 @@ bool PatternEditor::redo()
 
 bool PatternEditor::revoke(const PatternUndoStackEntry* stackEntry)
 {
-	const TXMPattern& stackPattern = stackEntry->GetPattern();
+	const pp_int32 stackRows = stackEntry->getRows();
+	const pp_int32 stackChannum = stackEntry->getChannum();
+	const pp_int32 stackEffnum = stackEntry->getEffnum();
 
 	enterCriticalSection();
 
 	bool res = false;
 
-	if (stackPattern.rows != pattern->rows ||
-		stackPattern.channum != pattern->channum ||
-		stackPattern.effnum != pattern->effnum)
+	if (stackRows != pattern->rows ||
+		stackChannum != pattern->channum ||
+		stackEffnum != pattern->effnum)
 	{
-		pattern->rows = stackPattern.rows;
-		pattern->channum = stackPattern.channum;
-		pattern->effnum = stackPattern.effnum;
+		pattern->rows = stackRows;
+		pattern->channum = stackChannum;
+		pattern->effnum = stackEffnum;
 	
 		mp_sint32 patternSize = pattern->rows*pattern->channum*(2+pattern->effnum*2);	
 
@@ -328,15 +336,16 @@ bool PatternEditor::revoke(const PatternUndoStackEntry* stackEntry)
 		}
 	}
 	
-	if (stackPattern.rows == pattern->rows &&
-		stackPattern.channum == pattern->channum &&
-		stackPattern.effnum == pattern->effnum)
+	if (stackRows == pattern->rows &&
+		stackChannum == pattern->channum &&
+		stackEffnum == pattern->effnum)
 	{
 		cursor.channel = stackEntry->getCursorPositionChannel();
 		cursor.row = stackEntry->getCursorPositionRow();
 		cursor.inner = stackEntry->getCursorPositionInner();
 		
-		pattern->decompress(stackPattern.patternData, stackPattern.len);
+		if (pattern->patternData && stackRows)
+			stackEntry->restorePattern(*pattern);
 
 		// keep over userdata
 		undoUserData = stackEntry->getUserData();
@@ -54,7 +54,12 @@ PatternEditorControl::PatternEditorControl(pp_int32 id, PPScreen* parentScreen,
 	patternEditor(NULL), module(NULL), pattern(NULL),
 	ppreCursor(NULL),
 	lastAction(RMouseDownActionInvalid), RMouseDownInChannelHeading(-1),
-	playerMaster(playerMaster)
+	playerMaster(playerMaster),
+	paintedRows(NULL), currentRows(NULL), rowPaintData(NULL),
+	numRowPaintSlots(0), rowPaintDataSize(0),
+	paintedStartIndex(0),
+	paintedRowsValid(false),
+	incrementalPaint(false)
 {
 	// default color
 	bgColor.r = 0;
@@ -81,6 +86,8 @@ PatternEditorControl::PatternEditorControl(pp_int32 id, PPScreen* parentScreen,
 	memset(muteChannels, 0, sizeof(muteChannels));
 	memset(recChannels, 0 ,sizeof(recChannels));
 
+	memset(&paintSettings, 0, sizeof(paintSettings));
+
 	// context menu
 	editMenuControl = new PPContextMenu(4, parentScreen, this, PPPoint(0,0), TrackerConfig::colorThemeMain, false, PPFont::getFont(PPFont::FONT_SYSTEM));
 
@@ -138,6 +145,8 @@ PatternEditorControl::~PatternEditorControl()
 
 	delete transposeHandlerResponder;
 	delete dialog;
+
+	freeRowPaintStates();
 }
 
 void PatternEditorControl::setFont(PPFont* font)
@@ -202,6 +211,302 @@ static inline pp_int32 myMod(pp_int32 a, pp_int32 b)
 	return r < 0 ? b + r : r;
 }
 
+template<class Type>
+static void reverseElements(Type* first, Type* last)
+{
+	while (first < last)
+	{
+		last--;
+		if (first >= last)
+			break;
+
+		Type tmp = *first;
+		*first = *last;
+		*last = tmp;
+		first++;
+	}
+}
+
+void PatternEditorControl::allocRowPaintStates(pp_int32 numSlots, pp_uint32 dataSize)
+{
+	if (numSlots == numRowPaintSlots && dataSize <= rowPaintDataSize)
+		return;
+
+	freeRowPaintStates();
+
+	if (numSlots <= 0)
+		return;
+
+	numRowPaintSlots = numSlots;
+	rowPaintDataSize = dataSize;
+
+	paintedRows = new RowPaintState[numSlots];
+	currentRows = new RowPaintState[numSlots];
+	rowPaintData = new pp_uint8[numSlots*2*dataSize + 1];
+
+	for (pp_int32 i = 0; i < numSlots; i++)
+	{
+		paintedRows[i].state = RowPaintStateUnknown;
+		paintedRows[i].data = rowPaintData + i*dataSize;
+		currentRows[i].state = RowPaintStateUnknown;
+		currentRows[i].data = rowPaintData + (numSlots + i)*dataSize;
+	}
+}
+
+void PatternEditorControl::freeRowPaintStates()
+{
+	delete[] paintedRows;
+	delete[] currentRows;
+	delete[] rowPaintData;
+
+	paintedRows = currentRows = NULL;
+	rowPaintData = NULL;
+	numRowPaintSlots = 0;
+	rowPaintDataSize = 0;
+	paintedRowsValid = false;
+}
+
+void PatternEditorControl::collectRowPaintStates(RowPaintState* states, pp_int32 numSlots, pp_int32 numColumns)
+{
+	pp_int32 i;
+
+	for (i = 0; i < numSlots; i++)
+	{
+		states[i].state = RowPaintStateEmpty;
+		states[i].pattern = NULL;
+		states[i].index = states[i].row = 0;
+		states[i].outside = states[i].playPosition = states[i].cursor = false;
+		states[i].dirty = false;
+		states[i].dataLen = 0;
+	}
+
+	const pp_int32 cursorRow = patternEditor->getCursor().row;
+
+	pp_int32 previousPatternIndex = currentOrderlistIndex;
+	pp_int32 previousRowIndex = 0;
+
+	pp_int32 nextPatternIndex = currentOrderlistIndex;
+	pp_int32 nextRowIndex = this->pattern->rows-1;
+
+	pp_int32 songPosOrderListIndex = currentOrderlistIndex;
+
+	TXMPattern* pattern = this->pattern;
+
+	for (pp_int32 i2 = startIndex;; i2++)
+	{
+		i = i2 < 0 ? startIndex - i2 - 1: i2;
+
+		pp_int32 slot = i - startIndex;
+
+		// rows are already in invisible area => abort
+		if (slot >= numSlots)
+			break;
+
+		pp_int32 row = i;
+		bool outside = false;
+
+		if (properties.prospective && properties.scrollMode == ScrollModeStayInCenter && currentOrderlistIndex != -1)
+		{
+			if (i < 0)
+			{
+				previousRowIndex--;
+				if (previousRowIndex < 0)
+				{
+					previousPatternIndex--;
+					if (previousPatternIndex >= 0)
+					{
+						pattern = &module->phead[module->header.ord[previousPatternIndex]];
+						previousRowIndex = pattern->rows-1;
+					}
+					else
+					{
+						continue;
+					}
+				}
+
+				songPosOrderListIndex = previousPatternIndex;
+				row = previousRowIndex;
+				outside = true;
+			}
+			else if (i >= this->pattern->rows)
+			{
+				nextRowIndex++;
+				if (nextRowIndex == pattern->rows && nextPatternIndex < module->header.ordnum)
+				{
+					nextPatternIndex++;
+					if (nextPatternIndex < module->header.ordnum)
+					{
+						pattern = &module->phead[module->header.ord[nextPatternIndex]];
+						nextRowIndex = 0;
+					}
+					else
+					{
+						continue;
+					}
+				}
+				else if (nextPatternIndex >= module->header.ordnum)
+				{
+					continue;
+				}
+
+				songPosOrderListIndex = nextPatternIndex;
+				row = nextRowIndex;
+				outside = true;
+			}
+			else
+			{
+				songPosOrderListIndex = currentOrderlistIndex;
+				pattern = this->pattern;
+			}
+		}
+		else
+		{
+			if (i2 < 0 || i2 >= pattern->rows)
+				continue;
+
+			row = i;
+		}
+
+		RowPaintState& state = states[slot];
+
+		state.state = RowPaintStateRow;
+		state.pattern = pattern;
+		state.index = i;
+		state.row = row;
+		state.outside = outside;
+		state.playPosition = (row == songPos.row && songPosOrderListIndex == songPos.orderListIndex) ||
+							 (i >= 0 && i <= pattern->rows - 1 && i == songPos.row && songPos.orderListIndex == -1);
+		state.cursor = (i == cursorRow);
+
+		// remember the visible cells, that's what the row looks like
+		pp_int32 numCells = pattern->channum - startPos;
+		if (numCells > numColumns)
+			numCells = numColumns;
+
+		if (numCells > 0 && pattern->patternData)
+		{
+			const pp_int32 cellSize = 2 + pattern->effnum*2;
+			const pp_uint32 len = numCells*cellSize;
+
+			if (len > rowPaintDataSize)
+			{
+				state.state = RowPaintStateUnknown;
+				continue;
+			}
+
+			memcpy(state.data, pattern->patternData + (row*pattern->channum + startPos)*cellSize, len);
+			state.dataLen = len;
+		}
+	}
+}
+
+void PatternEditorControl::scrollRowPaintStates(pp_int32 delta, pp_int32 numVisibleSlots)
+{
+	const pp_int32 numSlots = numRowPaintSlots;
+	pp_int32 i;
+
+	// rows cut off at the bottom have never been drawn completely
+	for (i = numVisibleSlots; i < numSlots; i++)
+		paintedRows[i].state = RowPaintStateUnknown;
+
+	if (delta == 0)
+		return;
+
+	// rotate, so every slot keeps its own data buffer
+	pp_int32 shift = delta > 0 ? delta : numSlots + delta;
+
+	reverseElements(paintedRows, paintedRows + shift);
+	reverseElements(paintedRows + shift, paintedRows + numSlots);
+	reverseElements(paintedRows, paintedRows + numSlots);
+
+	// whatever has been scrolled in is garbage
+	if (delta > 0)
+	{
+		for (i = numSlots - delta; i < numSlots; i++)
+			paintedRows[i].state = RowPaintStateUnknown;
+	}
+	else
+	{
+		for (i = 0; i < -delta; i++)
+			paintedRows[i].state = RowPaintStateUnknown;
+	}
+}
+
+static inline pp_int32 packColor(const PPColor& color)
+{
+	return (color.r << 16) | (color.g << 8) | color.b;
+}
+
+void PatternEditorControl::fillPaintSettings(PaintSettings& settings,
+											 const PatternEditorTools::Position& selectionStart,
+											 const PatternEditorTools::Position& selectionEnd,
+											 pp_int32 numVisibleChannels, pp_int32 numColumns)
+{
+	// clear padding as well, settings are compared byte by byte
+	memset(&settings, 0, sizeof(settings));
+
+	settings.font = font;
+	settings.module = module;
+	settings.pattern = pattern;
+	settings.x = location.x;
+	settings.y = location.y;
+	settings.width = size.width;
+	settings.height = size.height;
+	settings.rows = pattern->rows;
+	settings.channum = pattern->channum;
+	settings.effnum = pattern->effnum;
+	settings.currentOrderlistIndex = currentOrderlistIndex;
+	settings.startPos = startPos;
+	settings.numVisibleChannels = numVisibleChannels;
+	settings.numColumns = numColumns;
+	settings.visibleWidth = visibleWidth;
+	settings.slotSize = slotSize;
+	settings.rowCountWidth = getRowCountWidth();
+	settings.cursorChannel = patternEditor->getCursor().channel;
+	settings.cursorInner = patternEditor->getCursor().inner;
+	settings.selectionStartChannel = selectionStart.channel;
+	settings.selectionStartRow = selectionStart.row;
+	settings.selectionStartInner = selectionStart.inner;
+	settings.selectionEndChannel = selectionEnd.channel;
+	settings.selectionEndRow = selectionEnd.row;
+	settings.selectionEndInner = selectionEnd.inner;
+	settings.hasFocus = hasFocus;
+	settings.showFocus = properties.showFocus;
+	settings.bgColor = packColor(bgColor);
+	settings.borderColor = packColor(*borderColor);
+	settings.cursorColor = packColor(*cursorColor);
+	settings.selectionColor = packColor(*selectionColor);
+	settings.spacing = properties.spacing;
+	settings.highlightSpacingPrimary = properties.highlightSpacingPrimary;
+	settings.highlightSpacingSecondary = properties.highlightSpacingSecondary;
+	settings.highLightRowPrimary = properties.highLightRowPrimary;
+	settings.highLightRowSecondary = properties.highLightRowSecondary;
+	settings.hexCount = properties.hexCount;
+	settings.prospective = properties.prospective;
+	settings.scrollMode = properties.scrollMode;
+	settings.muteFade = properties.muteFade;
+	settings.zeroEffectCharacter = properties.zeroEffectCharacter;
+	settings.ptNoteLimit = properties.ptNoteLimit;
+	memcpy(settings.muteChannels, muteChannels, sizeof(settings.muteChannels));
+}
+
+bool PatternEditorControl::isObscured() const
+{
+	const PPRect rect = getBoundingRect();
+
+	PPControl* control = parentScreen->getModalControl();
+	if (control && control->isVisible() && control->getBoundingRect().intersect(rect))
+		return true;
+
+	for (pp_int32 i = 0; (control = parentScreen->getContextMenuControl(i)) != NULL; i++)
+	{
+		if (control->isVisible() && control->getBoundingRect().intersect(rect))
+			return true;
+	}
+
+	return false;
+}
+
 void PatternEditorControl::paint(PPGraphicsAbstract* g)
 {
 	if (!isVisible())
@@ -228,18 +533,21 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 	// adjust bright color
 	bCursor.scaleFixed(87163);
 
-	g->setRect(location.x+SCROLLBARWIDTH, location.y+SCROLLBARWIDTH,
-			   location.x + size.width - SCROLLBARWIDTH, location.y + size.height - SCROLLBARWIDTH);
+	const PPRect innerRect(location.x+SCROLLBARWIDTH, location.y+SCROLLBARWIDTH,
+						   location.x + size.width - SCROLLBARWIDTH, location.y + size.height - SCROLLBARWIDTH);
 
-	g->setColor(bgColor);
-
-	g->fill();
+	g->setRect(innerRect);
 
 	g->setFont(font);
 
 	// ;----------------- not going any further with invalid pattern
 	if (pattern == NULL)
+	{
+		g->setColor(bgColor);
+		g->fill();
+		paintedRowsValid = false;
 		return;
+	}
 
 	// ;----------------- make layout extents
 	adjustExtents();
@@ -285,18 +593,140 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 			startIndex--;
 	}
 
-	// ;----------------- start painting rows
+	// ;----------------- row layout
 	pp_int32 startx = location.x + SCROLLBARWIDTH + getRowCountWidth() + 4;
 
-	pp_int32 previousPatternIndex = currentOrderlistIndex;
-	pp_int32 previousRowIndex = 0;
+	const pp_int32 charHeight = font->getCharHeight();
+	const pp_int32 firstRowY = location.y + SCROLLBARWIDTH + charHeight + 4;
 
-	pp_int32 nextPatternIndex = currentOrderlistIndex;
-	pp_int32 nextRowIndex = this->pattern->rows-1;
+	pp_int32 numSlots = (location.y + size.height - firstRowY + charHeight - 1) / charHeight;
+	if (numSlots < 0)
+		numSlots = 0;
 
-	pp_int32 songPosOrderListIndex = currentOrderlistIndex;
+	pp_int32 numVisibleSlots = (innerRect.y2 - firstRowY) / charHeight;
+	if (numVisibleSlots < 0)
+		numVisibleSlots = 0;
 
-	TXMPattern* pattern = this->pattern;
+	const PPRect rowsRect(innerRect.x1, firstRowY, innerRect.x2, innerRect.y2);
+
+	pp_int32 numVisibleChannels = patternEditor->getNumChannels();
+
+	pp_int32 numColumns = 0;
+	for (j = startPos; j < numVisibleChannels; j++)
+	{
+		// columns are already in invisible area => abort
+		if ((j-startPos) * slotSize + startx >= location.x + size.width)
+			break;
+
+		numColumns++;
+	}
+
+	allocRowPaintStates(numSlots, numColumns * (2 + pattern->effnum*2));
+
+	collectRowPaintStates(currentRows, numSlots, numColumns);
+
+	// ;----------------- see what's still on screen from the last time
+	PaintSettings settings;
+	fillPaintSettings(settings, selectionStart, selectionEnd, numVisibleChannels, numColumns);
+
+	const pp_int32 scrollDelta = startIndex - paintedStartIndex;
+
+	bool incremental = incrementalPaint &&
+					   paintedRowsValid &&
+					   numSlots > 0 &&
+					   !moveSelection &&
+					   scrollDelta < numSlots && -scrollDelta < numSlots &&
+					   // the cursor line of the topmost row goes into the header margin
+					   !(currentRows[0].state != RowPaintStateEmpty && currentRows[0].cursor) &&
+					   memcmp(&settings, &paintSettings, sizeof(settings)) == 0 &&
+					   !isObscured();
+
+	if (incremental && scrollDelta)
+		incremental = g->scrollVertical(rowsRect, -scrollDelta * charHeight);
+
+	if (incremental)
+	{
+		scrollRowPaintStates(scrollDelta, numVisibleSlots);
+
+		for (i = 0; i < numSlots; i++)
+		{
+			const RowPaintState& painted = paintedRows[i];
+			const RowPaintState& current = currentRows[i];
+
+			if (painted.state == RowPaintStateUnknown || current.state == RowPaintStateUnknown ||
+				painted.state != current.state)
+			{
+				currentRows[i].dirty = true;
+			}
+			else if (current.state == RowPaintStateRow)
+			{
+				currentRows[i].dirty = painted.pattern != current.pattern ||
+									   painted.index != current.index ||
+									   painted.row != current.row ||
+									   painted.outside != current.outside ||
+									   painted.playPosition != current.playPosition ||
+									   painted.cursor != current.cursor ||
+									   painted.dataLen != current.dataLen ||
+									   memcmp(painted.data, current.data, current.dataLen) != 0;
+			}
+		}
+
+		// the cursor row reaches one line into both of its neighbours,
+		// so those have to be drawn together, both for the old and the new cursor
+		bool changed = true;
+		while (changed)
+		{
+			changed = false;
+			for (i = 0; i < numSlots; i++)
+			{
+				const bool isCursor = (paintedRows[i].state == RowPaintStateRow && paintedRows[i].cursor) ||
+									  (currentRows[i].state != RowPaintStateEmpty && currentRows[i].cursor);
+
+				if (!isCursor)
+					continue;
+
+				const pp_int32 first = i > 0 ? i - 1 : i;
+				const pp_int32 last = i < numSlots - 1 ? i + 1 : i;
+
+				bool anyDirty = false;
+				for (j = first; j <= last; j++)
+					anyDirty |= currentRows[j].dirty;
+
+				if (!anyDirty)
+					continue;
+
+				for (j = first; j <= last; j++)
+				{
+					if (!currentRows[j].dirty)
+					{
+						currentRows[j].dirty = true;
+						changed = true;
+					}
+				}
+			}
+		}
+
+		g->setColor(bgColor);
+
+		// header
+		g->fill(PPRect(innerRect.x1, innerRect.y1, innerRect.x2, firstRowY));
+
+		// rows which are going to be drawn again
+		for (i = 0; i < numSlots; i++)
+		{
+			if (currentRows[i].dirty)
+				g->fill(PPRect(innerRect.x1, firstRowY + i*charHeight, innerRect.x2, firstRowY + (i+1)*charHeight));
+		}
+	}
+	else
+	{
+		g->setColor(bgColor);
+
+		g->fill();
+
+		for (i = 0; i < numSlots; i++)
+			currentRows[i].dirty = true;
+	}
 
 	// ----------------- colors -----------------
 	PPColor noteColor = TrackerConfig::colorPatternEditorNote;
@@ -311,94 +741,140 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 
 	PPColor textColor = PPUIConfig::getInstance()->getColor(PPUIConfig::ColorStaticText);
 
-	pp_int32 numVisibleChannels = patternEditor->getNumChannels();
-
-	for (pp_int32 i2 = startIndex;; i2++)
+	// ;----------------- channel header
+	for (j = startPos; j < numVisibleChannels; j++)
 	{
-		i = i2 < 0 ? startIndex - i2 - 1: i2;
-
-		pp_int32 px = location.x + SCROLLBARWIDTH;
 
-		pp_int32 py = location.y + (i-startIndex) * font->getCharHeight() + SCROLLBARWIDTH + (font->getCharHeight() + 4);
+		pp_int32 px = (location.x + (j-startPos) * slotSize + SCROLLBARWIDTH) + (getRowCountWidth() + 4);
 
-		// rows are already in invisible area => abort
-		if (py >= location.y + size.height)
+		// columns are already in invisible area => abort
+		if (px >= location.x + size.width)
 			break;
 
-		pp_int32 row = i;
+		pp_int32 py = location.y + SCROLLBARWIDTH;
+
+		if (menuInvokeChannel == j)
+			g->setColor(255-dColor.r, 255-dColor.g, 255-dColor.b);
+		else
+			g->setColor(dColor);
 
-		if (properties.prospective && properties.scrollMode == ScrollModeStayInCenter && currentOrderlistIndex != -1)
 		{
-			if (i < 0)
-			{
-				previousRowIndex--;
-				if (previousRowIndex < 0)
-				{
-					previousPatternIndex--;
-					if (previousPatternIndex >= 0)
-					{
-						pattern = &module->phead[module->header.ord[previousPatternIndex]];
-						previousRowIndex = pattern->rows-1;
+			PPColor nsdColor = g->getColor(), nsbColor = g->getColor();
 
-						noteColor.set(TrackerConfig::colorThemeMain.r, TrackerConfig::colorThemeMain.g, TrackerConfig::colorThemeMain.b);
-						insColor = volColor = effColor = opColor = noteColor;
-					}
-					else
-					{
-						continue;
-					}
-				}
+			if (menuInvokeChannel != j)
+			{
+				// adjust not so dark color
+				nsdColor.scaleFixed(50000);
 
-				songPosOrderListIndex = previousPatternIndex;
-				row = previousRowIndex;
+				// adjust bright color
+				nsbColor.scaleFixed(80000);
 			}
-			else if (i >= this->pattern->rows)
+			else
 			{
-				nextRowIndex++;
-				if (nextRowIndex == pattern->rows && nextPatternIndex < module->header.ordnum)
-				{
-					nextPatternIndex++;
-					if (nextPatternIndex < module->header.ordnum)
-					{
-						pattern = &module->phead[module->header.ord[nextPatternIndex]];
-						nextRowIndex = 0;
+				// adjust not so dark color
+				nsdColor.scaleFixed(30000);
 
-						// Outside current range display colors of main theme
-						noteColor.set(TrackerConfig::colorThemeMain.r, TrackerConfig::colorThemeMain.g, TrackerConfig::colorThemeMain.b);
-						insColor = volColor = effColor = opColor = noteColor;
-					}
-					else
-					{
-						continue;
-					}
-				}
-				else if (nextPatternIndex >= module->header.ordnum)
+				// adjust bright color
+				nsbColor.scaleFixed(60000);
+			}
+
+			PPRect rect(px, py, px+slotSize, py + font->getCharHeight()+1);
+			g->fillVerticalShaded(rect, nsbColor, nsdColor, false, g->getColor());
+
+		}
+
+		if (muteChannels[j])
+		{
+			g->setColor(128, 128, 128);
+		}
+		else
+		{
+			if (!(j&1))
+				g->setColor(hiLightPrimary);
+			else
+				g->setColor(textColor);
+
+			if (!g->needsPalette()) {
+				if (j == menuInvokeChannel)
 				{
-					continue;
+					PPColor col = g->getColor();
+					col.r = textColor.r - col.r;
+					col.g = textColor.g - col.g;
+					col.b = textColor.b - col.b;
+					col.clamp();
+					g->setColor(col);
 				}
-
-				songPosOrderListIndex = nextPatternIndex;
-				row = nextRowIndex;
 			}
-			else
-			{
-				songPosOrderListIndex = currentOrderlistIndex;
-				pattern = this->pattern;
+		}
+
+		sprintf(name, "%i", j+1);
+
+		// Collect channel options
+		bool channelMuted = muteChannels[j],
+			 channelUnsupported = false;
 
-				// inside current range display colors as usual
-				noteColor = TrackerConfig::colorPatternEditorNote;
-				insColor = TrackerConfig::colorPatternEditorInstrument;
-				volColor = TrackerConfig::colorPatternEditorVolume;
-				effColor = TrackerConfig::colorPatternEditorEffect;
-				opColor = TrackerConfig::colorPatternEditorOperand;
+		if (playerMaster) {
+			AudioDriverInterface * audioDriver = (AudioDriverInterface *) playerMaster->getCurrentDriver();
+			if (audioDriver && audioDriver->isMultiChannel()) {
+				mp_sint32 maxChannels = audioDriver->getChannels();
+				if (maxChannels >= 0 && j >= maxChannels)
+					channelUnsupported = true;
 			}
 		}
-		else
+
+		if (channelMuted && channelUnsupported)
+			strcat(name, " <M,NO>");
+		else if (channelMuted)
+			strcat(name, " <Mute>");
+		else if (channelUnsupported)
+			strcat(name, " <NoOut>");
+
+		g->drawString(name, px + (slotSize>>1)-(((pp_int32)strlen(name)*font->getCharWidth())>>1), py+1);
+	}
+
+	// ;----------------- start painting rows
+	for (pp_int32 slot = 0; slot < numSlots; slot++)
+	{
+		const RowPaintState& state = currentRows[slot];
+
+		if (!state.dirty || state.state == RowPaintStateEmpty)
+			continue;
+
+		i = state.index;
+
+		pp_int32 row = state.row;
+
+		TXMPattern* pattern = state.pattern;
+
+		pp_int32 px = location.x + SCROLLBARWIDTH;
+
+		pp_int32 py = firstRowY + slot * charHeight;
+
+		if (incremental)
 		{
-			if (i2 < 0 || i2 >= pattern->rows)
-				continue;
+			// only this row, the cursor row may draw its lines into the neighbours
+			PPRect clipRect(innerRect.x1, py - (state.cursor ? 1 : 0), innerRect.x2, py + charHeight + (state.cursor ? 1 : 0));
+			if (clipRect.y1 < rowsRect.y1)
+				clipRect.y1 = rowsRect.y1;
+			if (clipRect.y2 > rowsRect.y2)
+				clipRect.y2 = rowsRect.y2;
+			g->setRect(clipRect);
+		}
 
-			row = i;
+		if (state.outside)
+		{
+			// Outside current range display colors of main theme
+			noteColor.set(TrackerConfig::colorThemeMain.r, TrackerConfig::colorThemeMain.g, TrackerConfig::colorThemeMain.b);
+			insColor = volColor = effColor = opColor = noteColor;
+		}
+		else
+		{
+			// inside current range display colors as usual
+			noteColor = TrackerConfig::colorPatternEditorNote;
+			insColor = TrackerConfig::colorPatternEditorInstrument;
+			volColor = TrackerConfig::colorPatternEditorVolume;
+			effColor = TrackerConfig::colorPatternEditorEffect;
+			opColor = TrackerConfig::colorPatternEditorOperand;
 		}
 
 		// draw rows
@@ -416,8 +892,7 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 		}
 
 		// draw position line
-		if ((row == songPos.row && songPosOrderListIndex == songPos.orderListIndex) ||
-			(i >= 0 && i <= pattern->rows - 1 && i == songPos.row && songPos.orderListIndex == -1))
+		if (state.playPosition)
 		{
 			PPColor lineColor(TrackerConfig::colorThemeMain.r>>1, TrackerConfig::colorThemeMain.g>>1, TrackerConfig::colorThemeMain.b>>1);
 			g->setColor(lineColor);
@@ -453,97 +928,6 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 
 		g->drawString(name, px, py);
 
-		// draw channels
-		for (j = startPos; j < numVisibleChannels; j++)
-		{
-
-			pp_int32 px = (location.x + (j-startPos) * slotSize + SCROLLBARWIDTH) + (getRowCountWidth() + 4);
-
-			// columns are already in invisible area => abort
-			if (px >= location.x + size.width)
-				break;
-
-			pp_int32 py = location.y + SCROLLBARWIDTH;
-
-			if (menuInvokeChannel == j)
-				g->setColor(255-dColor.r, 255-dColor.g, 255-dColor.b);
-			else
-				g->setColor(dColor);
-
-			{
-				PPColor nsdColor = g->getColor(), nsbColor = g->getColor();
-
-				if (menuInvokeChannel != j)
-				{
-					// adjust not so dark color
-					nsdColor.scaleFixed(50000);
-
-					// adjust bright color
-					nsbColor.scaleFixed(80000);
-				}
-				else
-				{
-					// adjust not so dark color
-					nsdColor.scaleFixed(30000);
-
-					// adjust bright color
-					nsbColor.scaleFixed(60000);
-				}
-
-				PPRect rect(px, py, px+slotSize, py + font->getCharHeight()+1);
-				g->fillVerticalShaded(rect, nsbColor, nsdColor, false, g->getColor());
-
-			}
-
-			if (muteChannels[j])
-			{
-				g->setColor(128, 128, 128);
-			}
-			else
-			{
-				if (!(j&1))
-					g->setColor(hiLightPrimary);
-				else
-					g->setColor(textColor);
-
-				if (!g->needsPalette()) {
-					if (j == menuInvokeChannel)
-					{
-						PPColor col = g->getColor();
-						col.r = textColor.r - col.r;
-						col.g = textColor.g - col.g;
-						col.b = textColor.b - col.b;
-						col.clamp();
-						g->setColor(col);
-					}
-				}
-			}
-
-			sprintf(name, "%i", j+1);
-
-			// Collect channel options
-			bool channelMuted = muteChannels[j],
-				 channelUnsupported = false;
-
-			if (playerMaster) {
-				AudioDriverInterface * audioDriver = (AudioDriverInterface *) playerMaster->getCurrentDriver();
-				if (audioDriver && audioDriver->isMultiChannel()) {
-					mp_sint32 maxChannels = audioDriver->getChannels();
-					if (maxChannels >= 0 && j >= maxChannels)
-						channelUnsupported = true;
-				}
-			}
-
-			if (channelMuted && channelUnsupported)
-				strcat(name, " <M,NO>");
-			else if (channelMuted)
-				strcat(name, " <Mute>");
-			else if (channelUnsupported)
-				strcat(name, " <NoOut>");
-
-			g->drawString(name, px + (slotSize>>1)-(((pp_int32)strlen(name)*font->getCharWidth())>>1), py+1);
-		}
-
 		for (j = startPos; j < numVisibleChannels; j++)
 		{
 			pp_int32 px = (j-startPos) * slotSize + startx;
@@ -558,8 +942,7 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 				g->setColor(*selectionColor);
 
 				if(!g->needsPalette()) {
-					if ((row == songPos.row && songPosOrderListIndex == songPos.orderListIndex) ||
-						(i >= 0 && i <= pattern->rows - 1 && i == songPos.row && songPos.orderListIndex == -1))
+					if (state.playPosition)
 					{
 						PPColor c = g->getColor();
 						c.r = (TrackerConfig::colorThemeMain.r + c.r)>>1;
@@ -777,7 +1160,10 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 			g->drawString(name,px, py);
 		}
 	}
-	
+
+	if (incremental)
+		g->setRect(innerRect);
+
 	for (j = startPos; j < numVisibleChannels; j++)
 	{
 
@@ -912,6 +1298,16 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 	hBottomScrollbar->paint(g);
 	vLeftScrollbar->paint(g);
 	vRightScrollbar->paint(g);
+
+	// ;----------------- remember what's on screen now
+	RowPaintState* rows = paintedRows;
+	paintedRows = currentRows;
+	currentRows = rows;
+
+	paintSettings = settings;
+	paintedStartIndex = startIndex;
+	// the moved selection frame is drawn over the rows
+	paintedRowsValid = !moveSelection;
 }
 
 void PatternEditorControl::attachPatternEditor(PatternEditor* patternEditor)
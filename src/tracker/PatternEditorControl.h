@@ -201,6 +201,64 @@ private:
 	// Player Master
 	PlayerMaster * playerMaster;
 
+	// What every visible row slot showed after the last paint, during
+	// playback the screen contents are scrolled and only the rows which
+	// differ from this are drawn again
+	enum RowPaintStates
+	{
+		RowPaintStateEmpty,
+		RowPaintStateRow,
+		RowPaintStateUnknown
+	};
+
+	struct RowPaintState
+	{
+		pp_int32 state;
+		TXMPattern* pattern;
+		pp_int32 index;
+		pp_int32 row;
+		bool outside;
+		bool playPosition;
+		bool cursor;
+		bool dirty;
+		pp_uint32 dataLen;
+		pp_uint8* data;
+	};
+
+	// everything else the rows depend on, compared with memcmp
+	struct PaintSettings
+	{
+		const void* font;
+		const void* module;
+		const void* pattern;
+		pp_int32 x, y, width, height;
+		pp_int32 rows, channum, effnum;
+		pp_int32 currentOrderlistIndex;
+		pp_int32 startPos, numVisibleChannels, numColumns;
+		pp_int32 visibleWidth, slotSize, rowCountWidth;
+		pp_int32 cursorChannel, cursorInner;
+		pp_int32 selectionStartChannel, selectionStartRow, selectionStartInner;
+		pp_int32 selectionEndChannel, selectionEndRow, selectionEndInner;
+		pp_int32 hasFocus, showFocus;
+		pp_int32 bgColor, borderColor, cursorColor, selectionColor;
+		pp_int32 spacing, highlightSpacingPrimary, highlightSpacingSecondary;
+		pp_int32 highLightRowPrimary, highLightRowSecondary;
+		pp_int32 hexCount, prospective, scrollMode;
+		pp_int32 muteFade, zeroEffectCharacter, ptNoteLimit;
+		pp_uint8 muteChannels[TrackerConfig::MAXCHANNELS];
+	};
+
+	RowPaintState* paintedRows;
+	RowPaintState* currentRows;
+	pp_uint8* rowPaintData;
+	pp_int32 numRowPaintSlots;
+	pp_uint32 rowPaintDataSize;
+
+	PaintSettings paintSettings;
+	pp_int32 paintedStartIndex;
+	bool paintedRowsValid;
+	bool incrementalPaint;
+
 public:
 	PatternEditorControl(pp_int32 id, PPScreen* parentScreen, EventListenerInterface* eventListener,
 						 const PPPoint& location, const PPSize& size,
@@ -220,6 +278,7 @@ public:
 	virtual void setSize(const PPSize& size);
 	virtual void setLocation(const PPPoint& location);
 	virtual void paint(PPGraphicsAbstract* graphics);
+	virtual void show(bool visible) { paintedRowsValid = false; PPControl::show(visible); }
 	virtual bool gainsFocus() const { return true; }
 	virtual bool gainedFocusByMouse() const { return caughtControl == NULL; }
 	virtual pp_int32 dispatchEvent(PPEvent* event);
@@ -231,6 +290,10 @@ public:
 
 	void reset();
 
+	// next paint may scroll what's already on screen and only draw the
+	// rows which have changed, used for updates during playback
+	void setIncrementalPaint(bool incrementalPaint) { this->incrementalPaint = incrementalPaint; }
+
 	bool isDraggingVertical() const
 	{
 		return (caughtControl == vLeftScrollbar) || (caughtControl == vRightScrollbar);
@@ -367,6 +430,17 @@ private:
 
 	void validate();
 
+	// ------- incremental painting --------------------------------
+	void allocRowPaintStates(pp_int32 numSlots, pp_uint32 dataSize);
+	void freeRowPaintStates();
+	void collectRowPaintStates(RowPaintState* states, pp_int32 numSlots, pp_int32 numColumns);
+	void scrollRowPaintStates(pp_int32 delta, pp_int32 numVisibleSlots);
+	void fillPaintSettings(PaintSettings& settings,
+						   const PatternEditorTools::Position& selectionStart,
+						   const PatternEditorTools::Position& selectionEnd,
+						   pp_int32 numVisibleChannels, pp_int32 numColumns);
+	bool isObscured() const;
+
 	// ------- menu stuff ------------------------------------------
 	enum MenuCommandIDs
 	{
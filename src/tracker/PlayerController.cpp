@@ -31,6 +31,7 @@
 #include "PlayerController.h"
 #include "PlayerMaster.h"
 #include "MilkyPlay.h"
+#include "MilkyPlayAtomic.h"
 #include "ResamplerMacros.h"
 #include "PPSystem.h"
 #include "PlayerCriticalSection.h"
@@ -45,15 +46,22 @@ public:
 		clearUpdateCommandBuff();
 	}
 
-	// this is being called from the player callback in a serialized fashion
-	virtual void playerTickStarted(PlayerSTD& player, XModule& module)
+	// this is being called from the player callback in a serialized fashion.
+	// Notes played from an external source (i.e. keyboard playback) are time
+	// stamped when they're queued and played one mix buffer period later at
+	// the exact sample, the mixer splits its beat packets where they're due
+	virtual void processEvents(PlayerSTD& player, XModule& module, mp_sint32 offset)
 	{
-		while (rbReadIndex < rbWriteIndex)
+		const mp_uint32 writeIndex = atomicLoadAcquire(&rbWriteIndex);
+		mp_uint32 readIndex = rbReadIndex;
+
+		while (readIndex != writeIndex)
 		{
-			mp_sint32 idx = rbReadIndex & (UPDATEBUFFSIZE-1);
+			mp_sint32 idx = readIndex & (UPDATEBUFFSIZE-1);
+
+			if (getEventOffset(player, updateCommandBuff[idx].timeStamp) > offset)
+				break;
 
-			// handle notes that are played from external source
-			// i.e. keyboard playback
 			switch (updateCommandBuff[idx].code)
 			{
 				case UpdateCommandCodeNote:
@@ -65,6 +73,9 @@ public:
 						player.playNote(command->channel, note,
 										command->ins,
 										command->volume);
+						// we're in between ticks, get frequency/volume
+						// to the mixer before the rest is mixed
+						player.refreshChannel(command->channel);
 						command->note = 0;
 					}
 					break;
@@ -84,9 +95,29 @@ public:
 					break;
 				}
 
+				case UpdateCommandCodeSampleData:
+				{
+					UpdateCommandSampleData* command = reinterpret_cast<UpdateCommandSampleData*>(&updateCommandBuff[idx]);
+					memcpy(command->dst, command->src, command->size);
+					break;
+				}
+
 			}
-			rbReadIndex++;
+			readIndex++;
 		}
+
+		// hand the slots back to the writer
+		atomicStoreRelease(&rbReadIndex, readIndex);
+	}
+
+	virtual mp_sint32 getEventDistance(PlayerSTD& player, mp_sint32 offset, mp_sint32 length)
+	{
+		const mp_uint32 readIndex = rbReadIndex;
+		if (readIndex == atomicLoadAcquire(&rbWriteIndex))
+			return length;
+
+		mp_sint32 distance = getEventOffset(player, updateCommandBuff[readIndex & (UPDATEBUFFSIZE-1)].timeStamp) - offset;
+		return distance < length ? distance : length;
 	}
 
 	virtual void patternEndReached(PlayerSTD& player, XModule& module, mp_sint32& newOrderIndex)
@@ -98,29 +129,74 @@ public:
 	{
 		// fill ring buffer with note entries
 		// the callback will query these notes and play them
-		mp_sint32 idx = rbWriteIndex & (UPDATEBUFFSIZE-1);
+		const mp_uint32 writeIndex = rbWriteIndex;
+		if (isUpdateCommandBuffFull(writeIndex))
+			return;
+
+		mp_sint32 idx = writeIndex & (UPDATEBUFFSIZE-1);
 		UpdateCommandNote* command = reinterpret_cast<UpdateCommandNote*>(&updateCommandBuff[idx]);
 		command->channel = chn;
 		command->ins = ins;
 		command->volume = vol;
 		command->note = note;
-		// code needs to be filled in last
+		command->timeStamp = AudioDriverBase::getMicroseconds();
 		command->code = UpdateCommandCodeNote;
-		rbWriteIndex++;
+		// publish the entry after it has been filled in completely
+		atomicStoreRelease(&rbWriteIndex, writeIndex + 1);
 	}
 
 	void playSample(mp_ubyte chn, const TXMSample& smp, mp_sint32 currentSamplePlayNote, mp_sint32 rangeStart, mp_sint32 rangeEnd)
 	{
 		// fill ring buffer with sample playback entries
-		mp_sint32 idx = rbWriteIndex & (UPDATEBUFFSIZE-1);
+		const mp_uint32 writeIndex = rbWriteIndex;
+		if (isUpdateCommandBuffFull(writeIndex))
+			return;
+
+		mp_sint32 idx = writeIndex & (UPDATEBUFFSIZE-1);
 		UpdateCommandSample* command = reinterpret_cast<UpdateCommandSample*>(&updateCommandBuff[idx]);
 		command->channel = chn;
 		command->currentSamplePlayNote = currentSamplePlayNote;
 		command->rangeStart = rangeStart;
 		command->rangeEnd = rangeEnd;
 		command->smp = &smp;
+		command->timeStamp = AudioDriverBase::getMicroseconds();
 		command->code = UpdateCommandCodeSample;
-		rbWriteIndex++;
+		atomicStoreRelease(&rbWriteIndex, writeIndex + 1);
+	}
+
+	// copy sample data which might be played right now, the copy is carried
+	// out in between two mix buffers. Source and destination must stay
+	// valid until isSampleDataUpdatePending() returns false
+	bool updateSampleData(void* dst, const void* src, mp_uint32 size)
+	{
+		const mp_uint32 writeIndex = rbWriteIndex;
+		if (isUpdateCommandBuffFull(writeIndex))
+			return false;
+
+		mp_sint32 idx = writeIndex & (UPDATEBUFFSIZE-1);
+		UpdateCommandSampleData* command = reinterpret_cast<UpdateCommandSampleData*>(&updateCommandBuff[idx]);
+		command->dst = dst;
+		command->src = src;
+		command->size = size;
+		// due right away
+		command->timeStamp = 0;
+		command->code = UpdateCommandCodeSampleData;
+		lastSampleDataIndex = writeIndex;
+		sampleDataQueued = true;
+		atomicStoreRelease(&rbWriteIndex, writeIndex + 1);
+		return true;
+	}
+
+	bool isSampleDataUpdatePending()
+	{
+		return sampleDataQueued && (mp_sint32)(atomicLoadAcquire(&rbReadIndex) - lastSampleDataIndex) <= 0;
+	}
+
+	// take over the reader's part while the player callback doesn't run
+	void flush(PlayerSTD& player, XModule& module)
+	{
+		processEvents(player, module, (mp_sint32)player.getMixBufferSize());
+		sampleDataQueued = false;
 	}
 
 private:
@@ -190,10 +266,50 @@ private:
 		}
 	}
 
+	// sample offset within the mix buffer the player is working on, the
+	// buffer covers the time span of one buffer period before it was started
+	mp_sint32 getEventOffset(PlayerSTD& player, mp_int64 timeStamp)
+	{
+		const mp_sint32 mixBufferSize = (mp_sint32)player.getMixBufferSize();
+
+		if (player.getSampleCounter() != mixBufferSampleCounter)
+		{
+			mixBufferSampleCounter = player.getSampleCounter();
+			mixBufferStartTime = AudioDriverBase::getMicroseconds() -
+				(mp_int64)mixBufferSize * 1000000 / player.getMixFrequency();
+		}
+
+		// no clock on this platform
+		if (!timeStamp)
+			return 0;
+
+		mp_int64 offset = (timeStamp - mixBufferStartTime) * player.getMixFrequency() / 1000000;
+
+		// late commands are played right away, anything ahead of the clock
+		// at the end of this buffer at the latest
+		if (offset < 0)
+			offset = 0;
+		if (offset > mixBufferSize)
+			offset = mixBufferSize;
+
+		return (mp_sint32)offset;
+	}
+
 	void clearUpdateCommandBuff()
 	{
 		memset(updateCommandBuff, 0, sizeof(updateCommandBuff));
 		rbReadIndex = rbWriteIndex = 0;
+		lastSampleDataIndex = 0;
+		sampleDataQueued = false;
+		mixBufferSampleCounter = -1;
+		mixBufferStartTime = 0;
+	}
+
+	// the player hasn't caught up yet (e.g. it's suspended), rather drop
+	// the command than overwrite one which might be read right now
+	bool isUpdateCommandBuffFull(mp_uint32 writeIndex)
+	{
+		return writeIndex - atomicLoadAcquire(&rbReadIndex) >= UPDATEBUFFSIZE;
 	}
 
 	enum
@@ -207,11 +323,14 @@ private:
 		UpdateCommandCodeInvalid = 0,
 		UpdateCommandCodeNote,
 		UpdateCommandCodeSample,
+		UpdateCommandCodeSampleData,
 	};
 
+	// all commands start with the code and the time stamp
 	struct UpdateCommand
 	{
 		mp_ubyte code;
+		mp_int64 timeStamp;
 		mp_uint32 data[8];
 		void* pdata[8];
 	};
@@ -219,6 +338,7 @@ private:
 	struct UpdateCommandNote
 	{
 		mp_ubyte code;
+		mp_int64 timeStamp;
 		mp_sint32 note;
 		mp_sint32 channel;
 		mp_sint32 ins;
@@ -230,6 +350,7 @@ private:
 	struct UpdateCommandSample
 	{
 		mp_ubyte code;
+		mp_int64 timeStamp;
 		mp_uint32 currentSamplePlayNote;
 		mp_uint32 rangeStart;
 		mp_uint32 rangeEnd;
@@ -239,10 +360,31 @@ private:
 		void* pdata[7];
 	};
 
+	struct UpdateCommandSampleData
+	{
+		mp_ubyte code;
+		mp_int64 timeStamp;
+		mp_uint32 size;
+		mp_uint32 data[7];
+		void* dst;
+		const void* src;
+		void* pdata[6];
+	};
+
 	UpdateCommand updateCommandBuff[UPDATEBUFFSIZE];
 
-	mp_sint32 rbReadIndex;
-	mp_sint32 rbWriteIndex;
+	// single writer (UI) and single reader (player callback),
+	// indices are free running and published with acquire/release
+	volatile mp_uint32 rbReadIndex;
+	volatile mp_uint32 rbWriteIndex;
+
+	// writer only
+	mp_uint32 lastSampleDataIndex;
+	bool sampleDataQueued;
+
+	// player callback only
+	mp_int64 mixBufferSampleCounter;
+	mp_int64 mixBufferStartTime;
 };
 
 void PlayerController::assureNotSuspended()
@@ -294,9 +436,7 @@ PlayerController::PlayerController(MasterMixer* mixer, bool fakeScopes) :
 	totalPlayerChannels(numPlayerChannels + numVirtualChannels + 2),
 	useVirtualChannels(TrackerConfig::useVirtualChannels),
 	multiChannelKeyJazz(true),
-	multiChannelRecord(true),
-	mixerDataCacheSize(fakeScopes ? 0 : 512*2),
-	mixerDataCache(fakeScopes ? NULL : new mp_sint32[mixerDataCacheSize])
+	multiChannelRecord(true)
 {
 	criticalSection = new PlayerCriticalSection(*this);
 
@@ -304,6 +444,8 @@ PlayerController::PlayerController(MasterMixer* mixer, bool fakeScopes) :
 	player->setPlayMode(PlayerBase::PlayMode_FastTracker2);
 	player->resetMainVolumeOnStartPlay(false);
 	player->setBufferSize(mixer->getBufferSize());
+	// real scopes are rendered by the mixer itself
+	player->setScopeTapEnabled(!fakeScopes);
 
 	currentPlayingChannel = useVirtualChannels ? numPlayerChannels : 0;
 
@@ -337,8 +479,6 @@ PlayerController::PlayerController(MasterMixer* mixer, bool fakeScopes) :
 
 PlayerController::~PlayerController()
 {
-	delete[] mixerDataCache;
-
 	if (player)
 	{
 		detachDevice();
@@ -817,6 +957,30 @@ void PlayerController::resumePlayer(bool continuePlaying)
 	}
 }
 
+bool PlayerController::updateSampleData(void* dst, const void* src, mp_uint32 size)
+{
+	if (!player || suspended || mixer->isDeviceRemoved(player))
+	{
+		memcpy(dst, src, size);
+		return true;
+	}
+
+	return playerStatusTracker->updateSampleData(dst, src, size);
+}
+
+bool PlayerController::isSampleDataUpdatePending()
+{
+	return player && playerStatusTracker->isSampleDataUpdatePending();
+}
+
+void PlayerController::flushSampleDataUpdates()
+{
+	if (!player || !module || !(suspended || mixer->isDeviceRemoved(player)))
+		return;
+
+	playerStatusTracker->flush(*player, *module);
+}
+
 void PlayerController::muteChannel(mp_sint32 c, bool m)
 {
 	muteChannels[c] = m;
@@ -1274,19 +1438,29 @@ void PlayerController::grabSampleData(mp_uint32 chnIndex, mp_sint32 count, mp_si
 	if (!player)
 		return;
 
-	if (mixerDataCache && (count * 2 > mixerDataCacheSize))
+	ChannelMixer* mixer = player;
+
+	pp_int32 j = getCurrentBeatIndex();
+
+	// snapshot written by the mixer, covers MP_SCOPETAP_SPAN output samples
+	if (mixer->isScopeTapEnabled() && count > 0)
 	{
-		delete[] mixerDataCache;
-		mixerDataCacheSize = count * 2 * 2;
-		mixerDataCache = new mp_sint32[mixerDataCacheSize];
-	}
+		mp_sword tap[ChannelMixer::MP_SCOPETAP_SIZE];
 
-	ChannelMixer* mixer = player;
+		if (mixer->readScopeTap(chnIndex, j, tap))
+		{
+			const mp_int64 div = (mp_int64)count * ChannelMixer::MP_SCOPETAP_SPAN;
+			for (mp_sint32 i = 0; i < count; i++)
+			{
+				const mp_int64 index = ((mp_int64)i * fMul * ChannelMixer::MP_SCOPETAP_SIZE) / div;
+				fetcher.fetchSampleData(index < ChannelMixer::MP_SCOPETAP_SIZE ? tap[index] : 0);
+			}
+			return;
+		}
+	}
 
 	ChannelMixer::TMixerChannel* chn = &mixer->channel[chnIndex];
 
-	pp_int32 j = getCurrentBeatIndex();
-
 	if (chn->flags & ChannelMixer::MP_SAMPLE_PLAY)
 	{
 		// this is critical
@@ -1296,6 +1470,7 @@ void PlayerController::grabSampleData(mp_uint32 chnIndex, mp_sint32 count, mp_si
 		// in that case we're displaying garbage...
 		// BUT it's important that we only access sample data
 		// within the range of the current sample we have
+		// (fake scopes only or if the scope tap snapshot couldn't be read)
 		ChannelMixer::TMixerChannel channel;
 		channel.sample = chn->timeRecord[j].sample;
 
@@ -1316,35 +1491,13 @@ void PlayerController::grabSampleData(mp_uint32 chnIndex, mp_sint32 count, mp_si
 		channel.fixedtimefrac = chn->timeRecord[j].fixedtimefrac;
 		channel.cutoff = ChannelMixer::MP_INVALID_VALUE;
 		channel.resonance = ChannelMixer::MP_INVALID_VALUE;
-//		channel.index = chnIndex; Uncomment this if you like crackly audio
-		// The scopes (which I assume is what this function is for) are currently
-		// using channel 33, to avoid interfering with playback
 
 		channel.smpadd = (channel.smpadd*fMul) / (!count ? 1 : count);
 		chn = &channel;
 
-		if (mixerDataCache && channel.smpadd <= 65536)
-		{
-			memset(mixerDataCache, 0, count*2*sizeof(mp_sint32));
-
-			channel.rsmpadd = (mp_sint32)((1.0 / channel.smpadd) * 65536.0);
-
-			// we only need the left channel as no panning is involved
-			channel.finalvoll = (channel.vol*128*256)<<6;
-			channel.finalvolr = 0;
-			channel.rampFromVolStepL = channel.rampFromVolStepR = 0;
-
-			player->getCurrentResampler()->addChannel(chn, mixerDataCache, count, count);
-
-			for (mp_sint32 i = 0; i < count; i++)
-				fetcher.fetchSampleData(mixerDataCache[i*2]);
-		}
-		else
-		{
-			pp_int32 vol = chn->vol;
-			mp_sint32 y;
-			FULLMIXER_TEMPLATE(FULLMIXER_8BIT_NORMAL_TEMP, FULLMIXER_16BIT_NORMAL_TEMP, 16, 0);
-		}
+		pp_int32 vol = chn->vol;
+		mp_sint32 y;
+		FULLMIXER_TEMPLATE(FULLMIXER_8BIT_NORMAL_TEMP, FULLMIXER_16BIT_NORMAL_TEMP, 16, 0);
 	}
 	else
 	{
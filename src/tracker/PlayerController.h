@@ -92,9 +92,6 @@ private:
 	bool multiChannelKeyJazz;
 	bool multiChannelRecord;
 
-	mp_sint32 mixerDataCacheSize;
-	mp_sint32* mixerDataCache;
-
 	void assureNotSuspended();
 	void continuePlaying(bool assureNotSuspended);
 	
@@ -156,6 +153,15 @@ public:
 	void suspendPlayer(bool bResetMainVolume = true, bool stopPlaying = true);	
 	void resumePlayer(bool continuePlaying);
 
+	// copy data into a sample which might be played right now, the mixer
+	// has no lock so the copy is handed to the player callback. Returns
+	// false if the update queue is full, src and dst must stay valid
+	// while an update is pending
+	bool updateSampleData(void* dst, const void* src, mp_uint32 size);
+	bool isSampleDataUpdatePending();
+	// carry out pending updates right away, only while suspended
+	void flushSampleDataUpdates();
+
 	void muteChannel(mp_sint32 c, bool m);
 	bool isChannelMuted(mp_sint32 c);
 
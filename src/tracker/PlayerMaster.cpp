@@ -115,6 +115,14 @@ void PlayerMaster::applySettingsToPlayerController(PlayerController& playerContr
 		playerController.getCriticalSection()->leave();
 	}
 
+	if (settings.numMixerThreads >= 0 &&
+		(mp_uint32)settings.numMixerThreads != player->getNumMixerThreads())
+	{
+		playerController.getCriticalSection()->enter();
+		player->setNumMixerThreads(settings.numMixerThreads);
+		playerController.getCriticalSection()->leave();
+	}
+
 	if (!player->isPlaying() && wasPlaying)
 		player->resumePlaying(false);
 }
@@ -309,6 +317,13 @@ bool PlayerMaster::applyNewMixerSettings(const TMixerSettings& settings, bool al
 		restart = true;
 	}
 
+	if (settings.renderAhead >= 0)
+	{
+		currentSettings.renderAhead = settings.renderAhead;
+		mixer->setRenderAhead(settings.renderAhead);
+		restart = true;
+	}
+
 	if (settings.mixerVolume >= 0)
 		currentSettings.mixerVolume = settings.mixerVolume;
 
@@ -318,6 +333,9 @@ bool PlayerMaster::applyNewMixerSettings(const TMixerSettings& settings, bool al
 	if (settings.resampler >= 0)
 		currentSettings.resampler = settings.resampler;
 
+	if (settings.numMixerThreads >= 0)
+		currentSettings.numMixerThreads = settings.numMixerThreads;
+
 	// take over settings like sample rate and buffer size
 	// those are retrieved from the master mixer and set for all players
 	// accordingly
@@ -50,6 +50,11 @@ struct TMixerSettings
 	pp_int32 resampler;
 	// 0 = false, 1 = true, negative values means ignore
 	pp_int32 ramping;
+	// 0/1 = mix on the audio thread only, negative values means ignore
+	pp_int32 numMixerThreads;
+	// periods mixed ahead on a render thread, 0 = mix in the audio callback,
+	// negative values means ignore
+	pp_int32 renderAhead;
 	// NULL means ignore
 	char* audioDriverName;
     // default number of player channels
@@ -65,6 +70,8 @@ struct TMixerSettings
 		powerOfTwoCompensation(-1),
 		resampler(-1),
 		ramping(-1),
+		numMixerThreads(-1),
+		renderAhead(-1),
 		audioDriverName(NULL),
         numPlayerChannels(TrackerConfig::numPlayerChannels),
 		numVirtualChannels(-1)
@@ -111,6 +118,12 @@ struct TMixerSettings
 		if (ramping != source.ramping)
 			return false;
 
+		if (numMixerThreads != source.numMixerThreads)
+			return false;
+
+		if (renderAhead != source.renderAhead)
+			return false;
+
         if (numPlayerChannels != source.numPlayerChannels) {
             return false;
         }
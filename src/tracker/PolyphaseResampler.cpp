@@ -0,0 +1,226 @@
+/*
+ *  tracker/PolyphaseResampler.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  PolyphaseResampler.cpp
+ *  MilkyTracker
+ *
+ */
+
+#include "PolyphaseResampler.h"
+#include <math.h>
+
+static const double PI = 3.14159265358979323846;
+
+// stopband attenuation of roughly 90dB
+static const double KAISERBETA = 9.0;
+
+// passband edge relative to the lower nyquist frequency
+static const double CUTOFF = 0.95;
+
+static pp_uint32 gcd(pp_uint32 a, pp_uint32 b)
+{
+	while (b)
+	{
+		pp_uint32 t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+// zeroth order modified bessel function of the first kind
+static double besselI0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for (pp_int32 k = 1; k < 64; k++)
+	{
+		double t = x / (2.0*k);
+		term *= t*t;
+		sum += term;
+		if (term < sum*1e-12)
+			break;
+	}
+	return sum;
+}
+
+// four independent sums, count is a multiple of 4
+static inline float dot(const float* a, const float* b, pp_int32 count)
+{
+	float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+	for (pp_int32 i = 0; i < count; i+=4)
+	{
+		s0+=a[i]*b[i];
+		s1+=a[i+1]*b[i+1];
+		s2+=a[i+2]*b[i+2];
+		s3+=a[i+3]*b[i+3];
+	}
+	return (s0 + s1) + (s2 + s3);
+}
+
+PolyphaseResampler::PolyphaseResampler(float oldRate, float newRate, pp_int32 numTaps) :
+	numPhases(MAXPHASES),
+	bank(NULL),
+	exact(false),
+	step(0)
+{
+	factor = (double)oldRate / (double)newRate;
+
+	// when downsampling the cutoff moves down and the filter
+	// gets longer by the same amount. The ratio is clamped where
+	// the filter would exceed MAXTAPS, see header
+	double scale = newRate < oldRate ? (double)newRate / (double)oldRate : 1.0;
+	if (numTaps / scale > MAXTAPS)
+		scale = (double)numTaps / MAXTAPS;
+
+	pp_int32 taps = (pp_int32)ceil(numTaps / scale);
+	taps = (taps + 3) & ~3;
+	if (taps < 4)
+		taps = 4;
+	if (taps > MAXTAPS)
+		taps = MAXTAPS;
+	this->numTaps = taps;
+
+	// integer rates with a small enough ratio always hit a phase
+	double oldRateInt = floor(oldRate + 0.5);
+	double newRateInt = floor(newRate + 0.5);
+
+	if (oldRateInt >= 1.0 && newRateInt >= 1.0 &&
+		fabs(oldRate - oldRateInt) < 1e-3 && fabs(newRate - newRateInt) < 1e-3)
+	{
+		pp_uint32 m = (pp_uint32)oldRateInt;
+		pp_uint32 l = (pp_uint32)newRateInt;
+		pp_uint32 g = gcd(m, l);
+		m/=g;
+		l/=g;
+
+		if (l <= MAXPHASES)
+		{
+			exact = true;
+			numPhases = l;
+			step = m;
+		}
+	}
+
+	createBank(scale * CUTOFF);
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+	delete[] bank;
+}
+
+void PolyphaseResampler::createBank(double cutoff)
+{
+	bank = new float[(numPhases + 1) * numTaps];
+
+	const pp_int32 half = numTaps / 2;
+	const double i0Beta = besselI0(KAISERBETA);
+
+	for (pp_int32 p = 0; p <= numPhases; p++)
+	{
+		float* coeffs = bank + p*numTaps;
+		const double frac = (double)p / (double)numPhases;
+
+		double sum = 0.0;
+		for (pp_int32 k = 0; k < numTaps; k++)
+		{
+			// distance of tap k from the output position
+			double x = (double)(k - half + 1) - frac;
+
+			double y = PI * cutoff * x;
+			double h = fabs(y) < 1e-9 ? cutoff : cutoff * sin(y) / y;
+
+			double u = x / (double)half;
+			double w = u*u < 1.0 ? besselI0(KAISERBETA * sqrt(1.0 - u*u)) / i0Beta : 0.0;
+
+			coeffs[k] = (float)(h*w);
+			sum+=h*w;
+		}
+
+		// unity gain at DC for every phase
+		for (pp_int32 k = 0; k < numTaps; k++)
+			coeffs[k] = (float)(coeffs[k] / sum);
+	}
+}
+
+pp_int32 PolyphaseResampler::getOutputLength(pp_int32 srcLen) const
+{
+	if (exact)
+		return (pp_int32)(((pp_int64)srcLen * numPhases + step - 1) / step);
+
+	// the same product as in process(), not just its inverse
+	pp_int32 length = (pp_int32)ceil((double)srcLen / factor);
+	while (length > 0 && (pp_int32)((double)(length - 1) * factor) >= srcLen)
+		length--;
+
+	return length;
+}
+
+void PolyphaseResampler::process(const float* src, pp_int32 start, pp_int32 end, float* dst) const
+{
+	const pp_int32 half = numTaps / 2;
+	pp_int32 n;
+
+	if (exact)
+	{
+		pp_int64 pos = (pp_int64)start * step;
+		pp_int32 index = (pp_int32)(pos / numPhases);
+		pp_uint32 phase = (pp_uint32)(pos % numPhases);
+
+		const pp_int32 indexStep = step / numPhases;
+		const pp_uint32 phaseStep = step % numPhases;
+
+		for (n = start; n < end; n++)
+		{
+			dst[n - start] = dot(src + index - half + 1, bank + phase*numTaps, numTaps);
+
+			index+=indexStep;
+			phase+=phaseStep;
+			if (phase >= (pp_uint32)numPhases)
+			{
+				phase-=numPhases;
+				index++;
+			}
+		}
+	}
+	else
+	{
+		for (n = start; n < end; n++)
+		{
+			double t = (double)n * factor;
+			pp_int32 index = (pp_int32)t;
+			double f = (t - (double)index) * numPhases;
+			pp_int32 phase = (pp_int32)f;
+			float w = (float)(f - (double)phase);
+
+			const float* s = src + index - half + 1;
+			const float* coeffs = bank + phase*numTaps;
+
+			float a = dot(s, coeffs, numTaps);
+			float b = dot(s, coeffs + numTaps, numTaps);
+
+			dst[n - start] = a + (b - a)*w;
+		}
+	}
+}
@@ -0,0 +1,87 @@
+/*
+ *  tracker/PolyphaseResampler.h
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  PolyphaseResampler.h
+ *  MilkyTracker
+ *
+ *  Offline windowed sinc resampler working on float data. The filter
+ *  is precomputed as a bank of phases: if the ratio of both rates is
+ *  a fraction with a small enough denominator every output sample hits
+ *  one of the phases exactly, otherwise MAXPHASES phases are used and
+ *  the two closest ones are interpolated.
+ *
+ *  When downsampling the filter gets longer by the ratio of both rates,
+ *  up to MAXTAPS. Beyond a ratio of MAXTAPS / numTaps (e.g. 64 with 128
+ *  taps) the cutoff doesn't follow the ratio any further, so content
+ *  above that cutoff aliases instead of the filter losing its shape.
+ *
+ */
+
+#ifndef POLYPHASERESAMPLER__H
+#define POLYPHASERESAMPLER__H
+
+#include "BasicTypes.h"
+
+class PolyphaseResampler
+{
+public:
+	enum
+	{
+		MAXPHASES = 1024,
+		// the bank takes up to (MAXPHASES+1)*MAXTAPS floats (32MB)
+		MAXTAPS = 8192
+	};
+
+private:
+	// taps per phase, multiple of 4
+	pp_int32 numTaps;
+	pp_int32 numPhases;
+	// numPhases+1 phases of numTaps coefficients
+	float* bank;
+
+	// exact: output sample n is at input position (n*step)/numPhases
+	bool exact;
+	pp_uint32 step;
+	double factor;
+
+	void createBank(double cutoff);
+
+public:
+	// numTaps is the filter length in output samples
+	PolyphaseResampler(float oldRate, float newRate, pp_int32 numTaps);
+	~PolyphaseResampler();
+
+	// number of input samples the filter reaches to both sides
+	pp_int32 getPadding() const { return numTaps / 2; }
+
+	// number of output samples for srcLen input samples, computed with
+	// the same step process() uses so the last one stays within srcLen
+	pp_int32 getOutputLength(pp_int32 srcLen) const;
+
+	// output samples [start, end) into dst[0..end-start), src must be
+	// readable in [-getPadding(), srcLen + getPadding()) and end must
+	// not exceed getOutputLength(srcLen)
+	void process(const float* src, pp_int32 start, pp_int32 end, float* dst) const;
+};
+
+#endif
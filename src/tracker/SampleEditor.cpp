@@ -32,10 +32,11 @@
 #include "SimpleVector.h"
 #include "XModule.h"
 #include "VRand.h"
-#include "Equalizer.h"
-#include "EQConstants.h"
 #include "FilterParameters.h"
 #include "SampleEditorResampler.h"
+#include "SampleEditorDSP.h"
+#include "SamplePeakCache.h"
+#include "WorkerPool.h"
 
 #ifdef __AMIGA__
 #define powf	pow
@@ -180,7 +181,8 @@ void SampleEditor::ClipBoard::paste(TXMSample& sample, XModule& module, pp_int32
 
 void SampleEditor::prepareUndo()
 {
-	delete before; 
+	// the last state we've saved, unchanged data is shared with it
+	SampleUndoStackEntry* last = before;
 	before = NULL; 
 		
 	if (undoStackEnabled && undoStackActivated && undoStack) 
@@ -191,8 +193,98 @@ void SampleEditor::prepareUndo()
 		before = new SampleUndoStackEntry(*sample, 
 										  getSelectionStart(), 
 										  getSelectionEnd(), 
-										  &undoUserData);
+										  &undoUserData,
+										  last);
 	}
+
+	delete last;
+}
+
+void SampleEditor::selectPeakCache()
+{
+	if (peakCaches[0] && peakCaches[0]->getOwner() == sample)
+		return;
+
+	// only the current sample's summary is ever built in the background
+	if (peakCaches[0])
+		peakCaches[0]->cancel();
+
+	if (peakCacheWorkerPool == NULL && WorkerPool::isSupported())
+		peakCacheWorkerPool = new WorkerPool(1);
+
+	pp_int32 i;
+	for (i = 0; i < PEAKCACHEHISTORYSIZE - 1; i++)
+	{
+		if (peakCaches[i] == NULL || peakCaches[i]->getOwner() == sample)
+			break;
+	}
+
+	SamplePeakCache* peakCache = peakCaches[i];
+	if (peakCache == NULL || peakCache->getOwner() != sample)
+	{
+		delete peakCache;
+		peakCache = new SamplePeakCache(sample, peakCacheWorkerPool);
+	}
+
+	for (; i > 0; i--)
+		peakCaches[i] = peakCaches[i-1];
+
+	peakCaches[0] = peakCache;
+}
+
+SamplePeakCache* SampleEditor::getPeakCache()
+{
+	selectPeakCache();
+	return peakCaches[0];
+}
+
+void SampleEditor::markDirty(pp_int32 start, pp_int32 end)
+{
+	getPeakCache()->invalidate(start, end);
+}
+
+void SampleEditor::markChangedRange(const SampleUndoStackEntry* before, const SampleUndoStackEntry* after)
+{
+	if (before == NULL || after == NULL ||
+		!before->hasBuffer() || !after->hasBuffer() ||
+		before->getSampLen() != after->getSampLen() ||
+		(before->getFlags() & 16) != (after->getFlags() & 16))
+	{
+		markAllDirty();
+		return;
+	}
+
+	// unchanged chunks are shared between both entries,
+	// only look at the others
+	const pp_int32 shift = (after->getFlags() & 16) ? 1 : 0;
+	pp_uint32 first = 0xFFFFFFFF, last = 0;
+	for (pp_uint32 i = 0; i < after->getNumChunks(); i++)
+	{
+		if (after->isSharedChunk(*before, i))
+			continue;
+
+		const pp_uint8* src = before->getChunkData(i);
+		const pp_uint8* dst = after->getChunkData(i);
+		const pp_uint32 len = after->getChunkSize(i);
+
+		pp_uint32 start = 0;
+		while (start < len && src[start] == dst[start])
+			start++;
+		if (start == len)
+			continue;
+
+		pp_uint32 end = len;
+		while (end > start && src[end-1] == dst[end-1])
+			end--;
+
+		const pp_uint32 offset = i << SampleUndoStackEntry::CHUNKSHIFT;
+		if (offset + start < first)
+			first = offset + start;
+		last = offset + end;
+	}
+
+	if (first < last)
+		markDirty(first >> shift, ((last - 1) >> shift) + 1);
 }
 
 void SampleEditor::finishUndo()
@@ -212,7 +304,11 @@ void SampleEditor::finishUndo()
 		SampleUndoStackEntry after(SampleUndoStackEntry(*sample, 
 										 getSelectionStart(), 
 										 getSelectionEnd(), 
-										 &undoUserData)); 
+										 &undoUserData,
+										 before)); 
+
+		markChangedRange(before, &after);
+
 		if (*before != after) 
 		{ 
 			if (undoStack) 
@@ -222,7 +318,14 @@ void SampleEditor::finishUndo()
 				undoStack->Pop(); 
 			} 
 		} 
+
+		// keep the new state around, next snapshot can share with it
+		*before = after;
 	} 
+	else
+	{
+		markAllDirty();
+	}
 	
 	// we're done, client might want to refresh the screen or whatever
 	notifyListener(NotificationChanges);			
@@ -254,21 +357,19 @@ bool SampleEditor::revoke(const SampleUndoStackEntry* stackEntry)
 		sample->sample = NULL;
 	}
 	
-	if (stackEntry->getBuffer())
+	if (stackEntry->hasBuffer())
 	{			
 		if (sample->type & 16)
-		{
 			sample->sample = (mp_sbyte*)module->allocSampleMem(sample->samplen*2);
-			TXMSample::copyPaddedMem(sample->sample, stackEntry->getBuffer(), sample->samplen*2);
-		}
 		else
-		{
 			sample->sample = (mp_sbyte*)module->allocSampleMem(sample->samplen);
-			TXMSample::copyPaddedMem(sample->sample, stackEntry->getBuffer(), sample->samplen);
-		}
+
+		if (sample->sample)
+			stackEntry->copyBuffer(sample->sample);
 	}
 	
 	leaveCriticalSection();
+	markAllDirty();
 	undoUserData = stackEntry->getUserData();
 	notifyListener(NotificationFetchUndoData);
 	notifyListener(NotificationChanges);
@@ -304,8 +405,10 @@ SampleEditor::SampleEditor() :
 	lastOperation(OperationRegular),
 	drawing(false),
 	lastSamplePos(-1),
+	peakCacheWorkerPool(NULL),
 	lastParameters(NULL),
-	lastFilterFunc(NULL)
+	lastFilterFunc(NULL),
+	dsp(NULL)
 {
 	// Undo history
 	undoHistory = new UndoHistory<TXMSample, SampleUndoStackEntry>(UNDOHISTORYSIZE_SAMPLEEDITOR);
@@ -313,14 +416,24 @@ SampleEditor::SampleEditor() :
 	resetSelection();
 
 	memset(&lastSample, 0, sizeof(lastSample));
+
+	for (pp_int32 i = 0; i < PEAKCACHEHISTORYSIZE; i++)
+		peakCaches[i] = NULL;
+
+	dsp = new SampleEditorDSP();
 }
 
 SampleEditor::~SampleEditor()
 {
+	delete dsp;
 	delete lastParameters;
 	delete undoHistory;
 	delete undoStack;
 	delete before;
+
+	for (pp_int32 i = 0; i < PEAKCACHEHISTORYSIZE; i++)
+		delete peakCaches[i];
+	delete peakCacheWorkerPool;
 }
 
 void SampleEditor::attachSample(TXMSample* sample, XModule* module) 
@@ -358,6 +471,10 @@ void SampleEditor::attachSample(TXMSample* sample, XModule* module)
 		}
 	}
 
+	// same sample with different contents, it's been changed elsewhere
+	if (sample == this->sample)
+		markAllDirty();
+
 	this->sample = sample;
 	attachModule(module);
 
@@ -368,6 +485,13 @@ void SampleEditor::attachSample(TXMSample* sample, XModule* module)
 
 void SampleEditor::reset()
 {
+	// the samples' memory is going to be reused
+	for (pp_int32 i = 0; i < PEAKCACHEHISTORYSIZE; i++)
+	{
+		delete peakCaches[i];
+		peakCaches[i] = NULL;
+	}
+
 	if (undoStackEnabled)
 	{
 		if (undoHistory)
@@ -827,6 +951,8 @@ void SampleEditor::drawSample(pp_int32 sampleIndex, float s)
 	
 	lastSamplePos = sampleIndex;
 
+	markDirty(from, to + 1);
+
 	for (pp_int32 si = from; si <= to; si++)
 	{
 		setFloatSampleInWaveform(si, froms);
@@ -1125,6 +1251,89 @@ void SampleEditor::setFloatSampleInWaveform(pp_int32 index, float singleSample,
 	}
 }
 
+// --- block handlers for the tools which aren't a SampleEditorDSP::Filter ---
+// sample data must be in its original state (loop double buffering off),
+// block positions are relative to the processed range
+
+struct DSPRange
+{
+	void* data;
+	bool is16Bit;
+	pp_int32 start;
+
+	DSPRange(TXMSample* sample, pp_int32 start) :
+		data(sample->sample),
+		is16Bit((sample->type & 16) != 0),
+		start(start)
+	{
+	}
+
+	void read(pp_int32 start, float* buffer, pp_int32 count) const
+	{
+		SampleEditorDSP::readFloats(data, is16Bit, this->start + start, buffer, count);
+	}
+
+	void write(pp_int32 start, const float* buffer, pp_int32 count) const
+	{
+		SampleEditorDSP::writeFloats(data, is16Bit, this->start + start, buffer, count);
+	}
+};
+
+// peak and sum of every block, combined in block order afterwards
+// so the result doesn't depend on the number of threads
+struct DSPAnalyzeJob
+{
+	DSPRange range;
+	float* peaks;
+	double* sums;
+
+	DSPAnalyzeJob(const DSPRange& range, float* peaks, double* sums) :
+		range(range), peaks(peaks), sums(sums)
+	{
+	}
+};
+
+static void analyzeBlock(void* userData, pp_int32 blockIndex, pp_int32 start, pp_int32 end, float* buffer)
+{
+	const DSPAnalyzeJob* job = (const DSPAnalyzeJob*)userData;
+	job->range.read(start, buffer, end - start);
+	if (job->peaks)
+		job->peaks[blockIndex] = SampleEditorDSP::peak(buffer, end - start);
+	if (job->sums)
+		job->sums[blockIndex] = SampleEditorDSP::sum(buffer, end - start);
+}
+
+// smoothing reads across block borders, so the whole range is
+// converted before anything is written back
+struct DSPSmoothJob
+{
+	DSPRange range;
+	float* source;
+	pp_int32 length;
+	bool triangular;
+
+	DSPSmoothJob(const DSPRange& range, float* source, pp_int32 length, bool triangular) :
+		range(range), source(source), length(length), triangular(triangular)
+	{
+	}
+};
+
+static void smoothReadBlock(void* userData, pp_int32 blockIndex, pp_int32 start, pp_int32 end, float* buffer)
+{
+	const DSPSmoothJob* job = (const DSPSmoothJob*)userData;
+	job->range.read(start, job->source + start, end - start);
+}
+
+static void smoothBlock(void* userData, pp_int32 blockIndex, pp_int32 start, pp_int32 end, float* buffer)
+{
+	const DSPSmoothJob* job = (const DSPSmoothJob*)userData;
+	if (job->triangular)
+		SampleEditorDSP::smoothTriangular(job->source, job->length, start, end, buffer);
+	else
+		SampleEditorDSP::smoothRectangular(job->source, job->length, start, end, buffer);
+	job->range.write(start, buffer, end - start);
+}
+
 void SampleEditor::preFilter(TFilterFunc filterFuncPtr, const FilterParameters* par)
 {
 	if (filterFuncPtr)
@@ -1755,6 +1964,8 @@ void SampleEditor::tool_scaleSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_scaleSample, par);
 	
+	sample->restoreOriginalState();
+
 	prepareUndo();
 	
 	float startScale = par->getParameter(0).floatPart;
@@ -1762,12 +1973,8 @@ void SampleEditor::tool_scaleSample(const FilterParameters* par)
 	
 	float step = (endScale - startScale) / (float)(sEnd - sStart);
 	
-	for (pp_int32 i = sStart; i < sEnd; i++)
-	{
-		float f = getFloatSampleFromWaveform(i);
-		setFloatSampleInWaveform(i, f*startScale);
-		startScale+=step;
-	}
+	SampleEditorDSP::ScaleFilter filter(startScale, step);
+	dsp->applyFilter(sample, sStart, sEnd, filter);
 				
 	finishUndo();	
 	
@@ -1800,6 +2007,8 @@ void SampleEditor::tool_normalizeSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_normalizeSample, par);
 	
+	sample->restoreOriginalState();
+
 	prepareUndo();
 	
 	float maxLevel = ((par == NULL)? 1.0f : par->getParameter(0).floatPart);
@@ -1807,20 +2016,26 @@ void SampleEditor::tool_normalizeSample(const FilterParameters* par)
 
 	pp_int32 i;
 
+	DSPRange range(sample, sStart);
+
 	// find peak value
-	for (i = sStart; i < sEnd; i++)
+	pp_int32 numBlocks = SampleEditorDSP::getNumBlocks(sEnd - sStart);
+	float* peaks = new float[numBlocks];
+	
+	DSPAnalyzeJob analyzeJob(range, peaks, NULL);
+	dsp->processBlocks(analyzeBlock, &analyzeJob, sEnd - sStart);
+	
+	for (i = 0; i < numBlocks; i++)
 	{
-		float f = getFloatSampleFromWaveform(i);
-		if (ppfabs(f) > peak) peak = ppfabs(f);
+		if (peaks[i] > peak) peak = peaks[i];
 	}
 	
+	delete[] peaks;
+	
 	float scale = maxLevel / peak;
 	
-	for (i = sStart; i < sEnd; i++)
-	{
-		float f = getFloatSampleFromWaveform(i);
-		setFloatSampleInWaveform(i, f*scale);
-	}
+	SampleEditorDSP::ScaleFilter filter(scale, 0.0f);
+	dsp->applyFilter(sample, sStart, sEnd, filter);
 				
 	finishUndo();	
 	
@@ -2211,7 +2426,7 @@ void SampleEditor::tool_resampleSample(const FilterParameters* par)
 
 	pp_uint32 resamplerType = par->getParameter(1).intPart;
 
-	SampleEditorResampler resampler(*module, *sample, resamplerType);
+	SampleEditorResampler resampler(*module, *sample, resamplerType, *dsp);
 	
 	bool res = resampler.resample(c4spd, par->getParameter(0).floatPart);
 	
@@ -2264,21 +2479,33 @@ void SampleEditor::tool_DCNormalizeSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_DCNormalizeSample, par);
 	
+	sample->restoreOriginalState();
+
 	prepareUndo();
 	
 	pp_int32 i;
 
-	float DC = 0.0f;
-	for (i = sStart; i < sEnd; i++)
-	{
-		DC += getFloatSampleFromWaveform(i);		
-	}
-	DC = DC / (float)(sEnd-sStart);
-	for (i = sStart; i < sEnd; i++)
+	DSPRange range(sample, sStart);
+
+	pp_int32 numBlocks = SampleEditorDSP::getNumBlocks(sEnd - sStart);
+	double* sums = new double[numBlocks];
+
+	DSPAnalyzeJob analyzeJob(range, NULL, sums);
+	dsp->processBlocks(analyzeBlock, &analyzeJob, sEnd - sStart);
+
+	double sum = 0.0;
+	for (i = 0; i < numBlocks; i++)
 	{
-		setFloatSampleInWaveform(i, getFloatSampleFromWaveform(i) - DC);
+		sum += sums[i];
 	}
 	
+	delete[] sums;
+
+	float DC = (float)(sum / (double)(sEnd-sStart));
+
+	SampleEditorDSP::OffsetFilter filter(-DC);
+	dsp->applyFilter(sample, sStart, sEnd, filter);
+	
 	finishUndo();	
 	
 	postFilter();
@@ -2310,15 +2537,14 @@ void SampleEditor::tool_DCOffsetSample(const FilterParameters* par)
 	
 	preFilter(&SampleEditor::tool_DCOffsetSample, par);
 	
+	sample->restoreOriginalState();
+
 	prepareUndo();
 	
-	pp_int32 i;
-
 	float DC = par->getParameter(0).floatPart;
-	for (i = sStart; i < sEnd; i++)
-	{
-		setFloatSampleInWaveform(i, getFloatSampleFromWaveform(i) + DC);
-	}
+
+	SampleEditorDSP::OffsetFilter filter(DC);
+	dsp->applyFilter(sample, sStart, sEnd, filter);
 	
 	finishUndo();	
 	
@@ -2353,24 +2579,17 @@ void SampleEditor::tool_rectangularSmoothSample(const FilterParameters* par)
 	
 	mp_sint32 sLen = sEnd - sStart;
 	
-	mp_ubyte* buffer = new mp_ubyte[(sample->type & 16) ? sLen*2 : sLen];
+	float* buffer = new float[sLen];
 	if (!buffer)
 		return;
 
-	memcpy(buffer, sample->sample + sStart, (sample->type & 16) ? sLen*2 : sLen);
+	sample->restoreOriginalState();
 
 	prepareUndo();	
 	
-	pp_int32 i;
-
-	for (i = sStart; i < sEnd; i++)
-	{
-		float f = (getFloatSampleFromWaveform(i - sStart - 1, buffer, sLen) +
-				  getFloatSampleFromWaveform(i - sStart, buffer, sLen) +
-				  getFloatSampleFromWaveform(i - sStart + 1, buffer, sLen)) * (1.0f/3.0f);
-				  
-		setFloatSampleInWaveform(i, f);		
-	}
+	DSPSmoothJob job(DSPRange(sample, sStart), buffer, sLen, false);
+	dsp->processBlocks(smoothReadBlock, &job, sLen);
+	dsp->processBlocks(smoothBlock, &job, sLen);
 	
 	delete[] buffer;
 	
@@ -2407,26 +2626,17 @@ void SampleEditor::tool_triangularSmoothSample(const FilterParameters* par)
 	
 	mp_sint32 sLen = sEnd - sStart;
 	
-	mp_ubyte* buffer = new mp_ubyte[(sample->type & 16) ? sLen*2 : sLen];
+	float* buffer = new float[sLen];
 	if (!buffer)
 		return;
 
-	memcpy(buffer, sample->sample + sStart, (sample->type & 16) ? sLen*2 : sLen);
+	sample->restoreOriginalState();
 
 	prepareUndo();	
 	
-	pp_int32 i;
-
-	for (i = sStart; i < sEnd; i++)
-	{
-		float f = (getFloatSampleFromWaveform(i - sStart - 2, buffer, sLen) +
-				   getFloatSampleFromWaveform(i - sStart - 1, buffer, sLen)*2.0f +
-				   getFloatSampleFromWaveform(i - sStart, buffer, sLen)*3.0f +
-				   getFloatSampleFromWaveform(i - sStart + 1, buffer, sLen)*2.0f +
-				   getFloatSampleFromWaveform(i - sStart + 2, buffer, sLen)) * (1.0f/9.0f);
-				  
-		setFloatSampleInWaveform(i, f);		
-	}
+	DSPSmoothJob job(DSPRange(sample, sStart), buffer, sLen, true);
+	dsp->processBlocks(smoothReadBlock, &job, sLen);
+	dsp->processBlocks(smoothBlock, &job, sLen);
 	
 	delete[] buffer;
 	
@@ -2474,91 +2684,24 @@ void SampleEditor::tool_eqSample(const FilterParameters* par, bool selective)
 		preFilter(&SampleEditor::tool_eqSample, par);
 	}
 	
+	sample->restoreOriginalState();
+
 	prepareUndo();	
 	
-	ClipBoard* clipBoard;
-	float step;
-	float j2 = 0.0f;
-	if (selective) {
-		clipBoard = ClipBoard::getInstance();
-		step = (float)clipBoard->getWidth() / (float)(sEnd-sStart);
-	}
-	
-	float c4spd = 8363; // there really should be a global constant for this
-	
-	Equalizer** eqs = new Equalizer*[par->getNumParameters()];
-	
-	// three band EQ
-	if (par->getNumParameters() == 3)
-	{
-		for (pp_int32 i = 0; i < par->getNumParameters(); i++)
-		{
-			eqs[i] = new Equalizer();
-			eqs[i]->CalcCoeffs(EQConstants::EQ3bands[i], EQConstants::EQ3bandwidths[i], c4spd, Equalizer::CalcGain(par->getParameter(i).floatPart));
-		}
-	}
-	// ten band EQ
-	else if (par->getNumParameters() == 10)
-	{
-		for (pp_int32 i = 0; i < par->getNumParameters(); i++)
-		{
-			eqs[i] = new Equalizer();
-			eqs[i]->CalcCoeffs(EQConstants::EQ10bands[i], EQConstants::EQ10bandwidths[i], c4spd, Equalizer::CalcGain(par->getParameter(i).floatPart));
-		}
-	}
-	else
+	if (par->getNumParameters() != 3 && par->getNumParameters() != 10)
 	{
-		delete[] eqs;
 		finishUndo();
 		return;
 	}
 	
 	// apply EQ here
-	pp_int32 i;
+	float bandParams[10];
+	for (pp_int32 i = 0; i < par->getNumParameters(); i++)
+		bandParams[i] = par->getParameter(i).floatPart;
 
-	for (i = sStart; i < sEnd; i++)
-	{
-		// Fetch a stereo signal
-		double xL = getFloatSampleFromWaveform(i);
-		double xR = xL;
-		float x = (float)xL;
-			
-		for (pp_int32 j = 0; j < par->getNumParameters(); j++)
-		{
-			double yL, yR;
-			// Pass the stereo input
-			eqs[j]->Filter(xL, xR, yL, yR);
-			
-			xL = yL;
-			xR = yR;
-		}
-		if (selective)
-		{
-			float frac = j2 - (float)floor(j2);
-		
-			pp_int16 s = clipBoard->getSampleWord((pp_int32)j2);
-			float f1 = s < 0 ? (s/32768.0f) : (s/32767.0f);
-			s = clipBoard->getSampleWord((pp_int32)j2+1);
-			float f2 = s < 0 ? (s/32768.0f) : (s/32767.0f);
-
-			float f = (1.0f-frac)*f1 + frac*f2;
-
-			if (f>=0) {
-				x = f * ((float)xL) + (1.0f-f) * x;
-			} else {
-				x = -f * (x-(float)xL) + (1.0+f) * x; 
-			}
-			j2+=step;
-		} else {
-			x = (float)xL;
-		}
-		setFloatSampleInWaveform(i, x);
-	}
-	
-	for (i = 0; i < par->getNumParameters(); i++)
-		delete eqs[i];
+	SampleEditorDSP::EQFilter filter(bandParams, par->getNumParameters(), selective ? ClipBoard::getInstance() : NULL, sEnd - sStart);
+	dsp->applyFilter(sample, sStart, sEnd, filter);
 	
-	delete[] eqs;
 	finishUndo();	
 
 	postFilter();
@@ -38,6 +38,9 @@
 struct TXMSample;
 
 class FilterParameters;
+class SampleEditorDSP;
+class SamplePeakCache;
+class WorkerPool;
 
 class SampleEditor : public EditorBase
 {
@@ -120,6 +123,21 @@ private:
 	bool drawing;
 	pp_int32 lastSamplePos;
 
+	// peak summaries of the recently edited samples, most recent first,
+	// they're built by a worker thread of their own
+	enum
+	{
+		PEAKCACHEHISTORYSIZE = 4
+	};
+
+	SamplePeakCache* peakCaches[PEAKCACHEHISTORYSIZE];
+	WorkerPool* peakCacheWorkerPool;
+
+	void selectPeakCache();
+	void markDirty(pp_int32 start, pp_int32 end);
+	void markAllDirty() { markDirty(0, 0x7FFFFFFF); }
+	void markChangedRange(const SampleUndoStackEntry* before, const SampleUndoStackEntry* after);
+
 	void prepareUndo();
 	void finishUndo();
 	
@@ -242,6 +260,10 @@ public:
 	bool isDrawing() const { return drawing; }
 	void drawSample(pp_int32 sampleIndex, float s);
 	void endDrawing();
+
+	// peak summary of the current sample, sample data changes made
+	// through the editor are passed on to it
+	SamplePeakCache* getPeakCache();
 	
 	// --- operations --------------------------------------------------------	
 	// this is just for convenience, it delegates to the appropriate tool code
@@ -307,6 +329,9 @@ private:
 	typedef void (SampleEditor::*TFilterFunc)(const FilterParameters* par);
 	FilterParameters* lastParameters;
 	TFilterFunc lastFilterFunc;
+
+	// block based float processing for the filters
+	SampleEditorDSP* dsp;
 		
 	void preFilter(TFilterFunc filterFuncPtr, const FilterParameters* par);
 	void postFilter();
@@ -21,6 +21,8 @@
  */
 
 #include "SampleEditorControl.h"
+#include "SamplePeakCache.h"
+#include "SampleEditorPreview.h"
 #include "Screen.h"
 #include "GraphicsAbstract.h"
 #include "PPUIConfig.h"
@@ -103,6 +105,7 @@ SampleEditorControl::SampleEditorControl(pp_int32 id,
 	adjustScrollbars();
 
 	showMarks = new ShowMark[TrackerConfig::maximumPlayerChannels];
+
 	for (pp_int32 i = 0; i < TrackerConfig::maximumPlayerChannels; i++)
 	{
 		showMarks[i].pos = -1;
@@ -177,6 +180,8 @@ SampleEditorControl::SampleEditorControl(pp_int32 id,
 	// Create tool handler responder
 	toolHandlerResponder = new ToolHandlerResponder(*this);
 	dialog = NULL;
+	preview = new SampleEditorPreview();
+	numPreviewValues = 0;
 
 	resetLastValues();
 }
@@ -190,6 +195,8 @@ SampleEditorControl::~SampleEditorControl()
 
 	delete toolHandlerResponder;
 
+	delete preview;
+
 	delete[] showMarks;
 
 	delete hScrollbar;
@@ -420,6 +427,19 @@ void SampleEditorControl::paint(PPGraphicsAbstract* g)
 
 	mp_sint32 lasty = -(pp_int32)(sample->getSampleValue((pp_int32)(startPos*xScale))*scale);
 
+	// zoomed out: more than one sample per pixel, draw the min/max
+	// envelope from the peak summary instead of skipping samples, until the
+	// summary of a large sample is ready the samples are drawn directly
+	SamplePeakCache* peakCache = sampleEditor->getPeakCache();
+	const bool drawPeaks = xScale > 1.0f && peakCache->validate(sample);
+	float peakScale = 0.0f;
+	PPColor rmsColor(TrackerConfig::colorSampleEditorWaveform);
+	if (drawPeaks)
+	{
+		peakScale = 1.0f/(32768.0f / ((visibleHeight-4)/2));
+		rmsColor.scaleFixed(98304);
+	}
+
 	g->setColor(*borderColor);
 	g->setPixel(xOffset, yOffset);
 
@@ -440,6 +460,35 @@ void SampleEditorControl::paint(PPGraphicsAbstract* g)
 				g->setColor(TrackerConfig::colorSampleEditorWaveform);
 			}
 
+			if (drawPeaks)
+			{
+				SamplePeakCache::Peak peak;
+				peakCache->getPeak((pp_int32)((startPos+x)*xScale), (pp_int32)((startPos+x+1)*xScale), peak);
+
+				mp_sint32 ymin = -(mp_sint32)(peak.max*peakScale);
+				mp_sint32 ymax = -(mp_sint32)(peak.min*peakScale);
+
+				// connect to the previous column so steep slopes don't break up
+				if (lasty < ymin)
+					ymin = lasty;
+				else if (lasty > ymax)
+					ymax = lasty;
+
+				g->drawVLine(yOffset + ymin, yOffset + ymax + 1, xOffset + x);
+
+				mp_sint32 rms = (mp_sint32)(peak.rms*peakScale);
+				if (rms > 0)
+				{
+					PPColor color = g->getColor();
+					g->setColor(rmsColor);
+					g->drawVLine(yOffset - rms, yOffset + rms + 1, xOffset + x);
+					g->setColor(color);
+				}
+
+				lasty = -(mp_sint32)(((peak.min + peak.max) >> 1)*peakScale);
+				continue;
+			}
+
 			float findex = ((startPos+x)*xScale);
 			pp_int32 index = (pp_int32)(floor(findex));
 			pp_int32 index2 = index+1;
@@ -1128,6 +1177,12 @@ selectingAndResizing:
 			parentScreen->setMouseCursor(MouseCursorTypeStandard);
 			break;
 
+		case eTimer:
+			// a peak summary has been built in the background
+			if (sampleEditor && sampleEditor->getPeakCache()->isBuildFinished())
+				parentScreen->paintControl(this);
+			break;
+
 		case eMouseLeft:
 			parentScreen->setMouseCursor(MouseCursorTypeStandard);
 			currentPosition.x = currentPosition.y = -1;
@@ -28,6 +28,7 @@
 #include "Event.h"
 #include "SampleEditor.h"
 #include "SampleEditorControlLastValues.h"
+#include "SampleEditorDSP.h"
 
 // Forwards
 class PPGraphicsAbstract;
@@ -37,6 +38,8 @@ class PPControl;
 class PPContextMenu;
 class FilterParameters;
 class PPDialogBase;
+class SampleEditorPreview;
+class PlayerController;
 
 class SampleEditorControl : public PPControl, public EventListenerInterface, public EditorBase::EditorNotificationListener
 {
@@ -140,6 +143,7 @@ public:
 	virtual void paint(PPGraphicsAbstract* graphics);
 	virtual pp_int32 dispatchEvent(PPEvent* event);
 	virtual pp_int32 handleEvent(PPObject* sender, PPEvent* event);
+	virtual bool receiveTimerEvent() const { return true; }
 
 	virtual void setSize(const PPSize& size);
 	virtual void setLocation(const PPPoint& location);
@@ -358,6 +362,7 @@ private:
 		SampleToolTypes getSampleToolType() { return sampleToolType; }
 
 		virtual pp_int32 ActionOkay(PPObject* sender);
+		virtual pp_int32 ActionNo(PPObject* sender);
 		virtual pp_int32 ActionCancel(PPObject* sender);
 	};
 
@@ -371,6 +376,19 @@ private:
 
 	SampleEditorControlLastValues lastValues;
 
+	// non destructive preview of the tool in the open dialog
+	SampleEditorPreview* preview;
+	float previewValues[10];
+	pp_int32 numPreviewValues;
+
+	// current parameters of the tool dialog, returns the number of values,
+	// 0 if the tool can't be previewed
+	pp_int32 getToolPreviewValues(ToolHandlerResponder::SampleToolTypes type, float* values);
+	SampleEditorDSP::Filter* createToolPreviewFilter(ToolHandlerResponder::SampleToolTypes type, const float* values, pp_int32 length);
+
+	void startPreview();
+	void stopPreview();
+
 	void resetLastValues()
 	{
 		lastValues.reset();
@@ -378,6 +396,16 @@ private:
 
 public:
 	SampleEditorControlLastValues& getLastValues() { return lastValues; }
+
+	// the listener gets an eValueChanged event when the preview starts
+	// (meta data 1) or stops (meta data 0), it has to make sure the preview
+	// sample isn't played anymore and no updates of it are pending when
+	// it stops
+	SampleEditorPreview* getPreview() { return preview; }
+	// pick up changed tool parameters and render the preview ahead of
+	// the play position, -1 if the preview isn't playing. The rendered
+	// data is handed to the player controller which is playing it
+	void updatePreview(pp_int32 playPos, PlayerController* playerController);
 };
 
 #endif
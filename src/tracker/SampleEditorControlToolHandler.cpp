@@ -35,6 +35,7 @@
 #include "DialogEQ.h"
 #include "SimpleVector.h"
 #include "FilterParameters.h"
+#include "SampleEditorPreview.h"
 
 bool SampleEditorControl::invokeToolParameterDialog(SampleEditorControl::ToolHandlerResponder::SampleToolTypes type)
 {
@@ -59,14 +60,14 @@ bool SampleEditorControl::invokeToolParameterDialog(SampleEditorControl::ToolHan
 			break;
 
 		case ToolHandlerResponder::SampleToolTypeVolume:
-			dialog = new DialogWithValues(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, "Boost sample volume" PPSTR_PERIODS, DialogWithValues::ValueStyleEnterOneValue);
+			dialog = new DialogWithValues(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, "Boost sample volume" PPSTR_PERIODS, DialogWithValues::ValueStyleEnterOneValue, true);
 			static_cast<DialogWithValues*>(dialog)->setValueOneCaption("Enter new volume in percent:");
 			static_cast<DialogWithValues*>(dialog)->setValueOneRange(-10000.0f, 10000.0f, 2);
 			static_cast<DialogWithValues*>(dialog)->setValueOne(lastValues.boostSampleVolume != SampleEditorControlLastValues::invalidFloatValue() ? lastValues.boostSampleVolume : 100.0f);
 			break;
 
 		case ToolHandlerResponder::SampleToolTypeFade:
-			dialog = new DialogWithValues(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, "Fade sample" PPSTR_PERIODS, DialogWithValues::ValueStyleEnterTwoValues);
+			dialog = new DialogWithValues(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, "Fade sample" PPSTR_PERIODS, DialogWithValues::ValueStyleEnterTwoValues, true);
 			static_cast<DialogWithValues*>(dialog)->setValueOneCaption("Enter start volume in percent:");
 			static_cast<DialogWithValues*>(dialog)->setValueTwoCaption("Enter end volume in percent:");
 			static_cast<DialogWithValues*>(dialog)->setValueOneRange(-10000.0f, 10000.0f, 2);
@@ -83,7 +84,7 @@ bool SampleEditorControl::invokeToolParameterDialog(SampleEditorControl::ToolHan
 			break;
 
 		case ToolHandlerResponder::SampleToolTypeDCOffset:
-			dialog = new DialogWithValues(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, "DC offset" PPSTR_PERIODS, DialogWithValues::ValueStyleEnterOneValue);
+			dialog = new DialogWithValues(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, "DC offset" PPSTR_PERIODS, DialogWithValues::ValueStyleEnterOneValue, true);
 			static_cast<DialogWithValues*>(dialog)->setValueOneCaption("Enter offset in percent [-100..100]");
 			static_cast<DialogWithValues*>(dialog)->setValueOneRange(-100, 100.0f, 2);
 			static_cast<DialogWithValues*>(dialog)->setValueOne(lastValues.DCOffset != SampleEditorControlLastValues::invalidFloatValue() ? lastValues.DCOffset : 0.0f);
@@ -105,7 +106,7 @@ bool SampleEditorControl::invokeToolParameterDialog(SampleEditorControl::ToolHan
 			break;
 
 		case ToolHandlerResponder::SampleToolTypeEQ3Band:
-			dialog = new DialogEQ(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, DialogEQ::EQ3Bands);
+			dialog = new DialogEQ(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, DialogEQ::EQ3Bands, true);
 			if (lastValues.hasEQ3BandValues)
 			{
 				for (pp_int32 i = 0; i < 3; i++)
@@ -115,7 +116,7 @@ bool SampleEditorControl::invokeToolParameterDialog(SampleEditorControl::ToolHan
 
 		case ToolHandlerResponder::SampleToolTypeEQ10Band:
 		case ToolHandlerResponder::SampleToolTypeSelectiveEQ10Band:
-			dialog = new DialogEQ(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, DialogEQ::EQ10Bands);
+			dialog = new DialogEQ(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, DialogEQ::EQ10Bands, true);
 			if (lastValues.hasEQ10BandValues)
 			{
 				for (pp_int32 i = 0; i < 10; i++)
@@ -338,6 +339,137 @@ bool SampleEditorControl::invokeTool(ToolHandlerResponder::SampleToolTypes type)
 	return true;
 }
 
+pp_int32 SampleEditorControl::getToolPreviewValues(ToolHandlerResponder::SampleToolTypes type, float* values)
+{
+	if (dialog == NULL)
+		return 0;
+
+	switch (type)
+	{
+		case ToolHandlerResponder::SampleToolTypeVolume:
+		case ToolHandlerResponder::SampleToolTypeDCOffset:
+			values[0] = static_cast<DialogWithValues*>(dialog)->getValueOne();
+			return 1;
+
+		case ToolHandlerResponder::SampleToolTypeFade:
+			values[0] = static_cast<DialogWithValues*>(dialog)->getValueOne();
+			values[1] = static_cast<DialogWithValues*>(dialog)->getValueTwo();
+			return 2;
+
+		case ToolHandlerResponder::SampleToolTypeEQ3Band:
+		case ToolHandlerResponder::SampleToolTypeEQ10Band:
+		case ToolHandlerResponder::SampleToolTypeSelectiveEQ10Band:
+		{
+			pp_uint32 numBands = static_cast<DialogEQ*>(dialog)->getNumBandsAsInt();
+			for (pp_uint32 i = 0; i < numBands; i++)
+				values[i] = static_cast<DialogEQ*>(dialog)->getBandParam(i);
+			return numBands;
+		}
+
+		default:
+			return 0;
+	}
+}
+
+// same parameters as in invokeTool
+SampleEditorDSP::Filter* SampleEditorControl::createToolPreviewFilter(ToolHandlerResponder::SampleToolTypes type, const float* values, pp_int32 length)
+{
+	switch (type)
+	{
+		case ToolHandlerResponder::SampleToolTypeVolume:
+			return new SampleEditorDSP::ScaleFilter(values[0] / 100.0f, 0.0f);
+
+		case ToolHandlerResponder::SampleToolTypeFade:
+		{
+			float startScale = values[0] / 100.0f;
+			float endScale = values[1] / 100.0f;
+			return new SampleEditorDSP::ScaleFilter(startScale, (endScale - startScale) / (float)length);
+		}
+
+		case ToolHandlerResponder::SampleToolTypeDCOffset:
+			return new SampleEditorDSP::OffsetFilter(values[0] / 100.0f);
+
+		case ToolHandlerResponder::SampleToolTypeEQ3Band:
+		case ToolHandlerResponder::SampleToolTypeEQ10Band:
+			return new SampleEditorDSP::EQFilter(values, numPreviewValues);
+
+		case ToolHandlerResponder::SampleToolTypeSelectiveEQ10Band:
+			return new SampleEditorDSP::EQFilter(values, numPreviewValues, SampleEditor::ClipBoard::getInstance(), length);
+
+		default:
+			return NULL;
+	}
+}
+
+void SampleEditorControl::startPreview()
+{
+	if (!sampleEditor->isValidSample() || sampleEditor->isEmptySample())
+		return;
+
+	ToolHandlerResponder::SampleToolTypes type = toolHandlerResponder->getSampleToolType();
+
+	numPreviewValues = getToolPreviewValues(type, previewValues);
+	if (numPreviewValues == 0)
+		return;
+
+	// same range as the tool
+	pp_int32 rangeStart = 0;
+	pp_int32 rangeEnd = sampleEditor->getSampleLen();
+	if (sampleEditor->hasValidSelection())
+	{
+		rangeStart = sampleEditor->getLogicalSelectionStart();
+		rangeEnd = sampleEditor->getLogicalSelectionEnd();
+	}
+
+	SampleEditorDSP::Filter* filter = createToolPreviewFilter(type, previewValues, rangeEnd - rangeStart);
+
+	// a running preview might be played right now, the new
+	// filter is picked up by the next updatePreview()
+	if (preview->isActive())
+		preview->setFilter(filter);
+	else
+	{
+		if (!preview->start(sampleEditor->getSample(), rangeStart, rangeEnd, filter))
+			return;
+
+		// render the beginning before it's played
+		preview->update(-1, NULL);
+	}
+
+	PPEvent e(eValueChanged, 1);
+	eventListener->handleEvent(reinterpret_cast<PPObject*>(this), &e);
+}
+
+void SampleEditorControl::stopPreview()
+{
+	if (!preview->isActive())
+		return;
+
+	PPEvent e(eValueChanged, 0);
+	eventListener->handleEvent(reinterpret_cast<PPObject*>(this), &e);
+
+	preview->stop();
+	numPreviewValues = 0;
+}
+
+void SampleEditorControl::updatePreview(pp_int32 playPos, PlayerController* playerController)
+{
+	if (!preview->isActive())
+		return;
+
+	// the dialog commits its values on its own, just look for changes
+	float values[10];
+	pp_int32 numValues = getToolPreviewValues(toolHandlerResponder->getSampleToolType(), values);
+
+	if (numValues == numPreviewValues && memcmp(values, previewValues, numValues*sizeof(float)) != 0)
+	{
+		memcpy(previewValues, values, numValues*sizeof(float));
+		preview->setFilter(createToolPreviewFilter(toolHandlerResponder->getSampleToolType(), previewValues, preview->getRangeEnd() - preview->getRangeStart()));
+	}
+
+	preview->update(playPos, playerController);
+}
+
 SampleEditorControl::ToolHandlerResponder::ToolHandlerResponder(SampleEditorControl& theSampleEditorControl) :
 	sampleEditorControl(theSampleEditorControl),
 	sampleToolType(SampleToolTypeNone)
@@ -346,11 +478,20 @@ SampleEditorControl::ToolHandlerResponder::ToolHandlerResponder(SampleEditorCont
 
 pp_int32 SampleEditorControl::ToolHandlerResponder::ActionOkay(PPObject* sender)
 {
+	sampleEditorControl.stopPreview();
 	sampleEditorControl.invokeTool(sampleToolType);
 	return 0;
 }
 
+pp_int32 SampleEditorControl::ToolHandlerResponder::ActionNo(PPObject* sender)
+{
+	// preview, keep the dialog open
+	sampleEditorControl.startPreview();
+	return 1;
+}
+
 pp_int32 SampleEditorControl::ToolHandlerResponder::ActionCancel(PPObject* sender)
 {
+	sampleEditorControl.stopPreview();
 	return 0;
 }
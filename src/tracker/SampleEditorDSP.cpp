@@ -0,0 +1,437 @@
+/*
+ *  tracker/SampleEditorDSP.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SampleEditorDSP.cpp
+ *  MilkyTracker
+ *
+ */
+
+#include "SampleEditorDSP.h"
+#include "WorkerPool.h"
+#include "XModule.h"
+#include "Equalizer.h"
+#include "EQConstants.h"
+#include <math.h>
+
+static inline float getClamped(const float* src, pp_int32 length, pp_int32 index)
+{
+	if (index >= length)
+		index = length-1;
+	if (index < 0)
+		index = 0;
+	return src[index];
+}
+
+SampleEditorDSP::SampleEditorDSP() :
+	workerPool(NULL)
+{
+}
+
+SampleEditorDSP::~SampleEditorDSP()
+{
+	delete workerPool;
+}
+
+void SampleEditorDSP::processTask(void* userData, pp_uint32 taskIndex)
+{
+	const Job* job = (const Job*)userData;
+
+	pp_int32 block = (pp_int32)taskIndex * job->blocksPerTask;
+	pp_int32 lastBlock = block + job->blocksPerTask;
+	if (lastBlock > job->numBlocks)
+		lastBlock = job->numBlocks;
+
+	float* buffer = new float[BLOCKSIZE];
+
+	for (; block < lastBlock; block++)
+	{
+		pp_int32 start = block * BLOCKSIZE;
+		pp_int32 end = start + BLOCKSIZE;
+		if (end > job->length)
+			end = job->length;
+
+		job->handler(job->userData, block, start, end, buffer);
+	}
+
+	delete[] buffer;
+}
+
+void SampleEditorDSP::processBlocks(TBlockHandler handler, void* userData, pp_int32 length)
+{
+	if (length <= 0)
+		return;
+
+	Job job;
+	job.handler = handler;
+	job.userData = userData;
+	job.length = length;
+	job.numBlocks = getNumBlocks(length);
+	job.blocksPerTask = job.numBlocks;
+
+	if (job.numBlocks > 1 && workerPool == NULL && WorkerPool::getNumProcessors() > 1)
+		workerPool = new WorkerPool(WorkerPool::getNumProcessors() - 1);
+
+	if (workerPool == NULL || workerPool->getNumWorkers() == 0)
+	{
+		processTask(&job, 0);
+		return;
+	}
+
+	// a few tasks per thread, so nobody waits for a single straggler
+	pp_int32 numTasks = (pp_int32)(workerPool->getNumWorkers() + 1) * 4;
+	if (numTasks > job.numBlocks)
+		numTasks = job.numBlocks;
+
+	job.blocksPerTask = (job.numBlocks + numTasks - 1) / numTasks;
+	numTasks = (job.numBlocks + job.blocksPerTask - 1) / job.blocksPerTask;
+
+	workerPool->run(processTask, &job, numTasks);
+}
+
+void SampleEditorDSP::processBlocksSequential(TBlockHandler handler, void* userData, pp_int32 length)
+{
+	if (length <= 0)
+		return;
+
+	Job job;
+	job.handler = handler;
+	job.userData = userData;
+	job.length = length;
+	job.numBlocks = getNumBlocks(length);
+	job.blocksPerTask = job.numBlocks;
+
+	processTask(&job, 0);
+}
+
+struct FilterJob
+{
+	void* data;
+	bool is16Bit;
+	pp_int32 start;
+	SampleEditorDSP::Filter* filter;
+};
+
+static void filterBlock(void* userData, pp_int32 blockIndex, pp_int32 start, pp_int32 end, float* buffer)
+{
+	const FilterJob* job = (const FilterJob*)userData;
+	SampleEditorDSP::readFloats(job->data, job->is16Bit, job->start + start, buffer, end - start);
+	job->filter->process(buffer, start, end - start);
+	SampleEditorDSP::writeFloats(job->data, job->is16Bit, job->start + start, buffer, end - start);
+}
+
+void SampleEditorDSP::applyFilter(TXMSample* sample, pp_int32 start, pp_int32 end, Filter& filter)
+{
+	FilterJob job;
+	job.data = sample->sample;
+	job.is16Bit = (sample->type & 16) != 0;
+	job.start = start;
+	job.filter = &filter;
+
+	filter.reset();
+
+	if (filter.isRecursive())
+		processBlocksSequential(filterBlock, &job, end - start);
+	else
+		processBlocks(filterBlock, &job, end - start);
+}
+
+void SampleEditorDSP::readFloats(const void* data, bool is16Bit, pp_int32 start, float* dst, pp_int32 count)
+{
+	pp_int32 i;
+
+	if (is16Bit)
+	{
+		const pp_int16* src = (const pp_int16*)data + start;
+		for (i = 0; i < count; i++)
+		{
+			float s = (float)src[i];
+			dst[i] = s > 0 ? s*(1.0f/32767.0f) : s*(1.0f/32768.0f);
+		}
+	}
+	else
+	{
+		const pp_int8* src = (const pp_int8*)data + start;
+		for (i = 0; i < count; i++)
+		{
+			float s = (float)src[i];
+			dst[i] = s > 0 ? s*(1.0f/127.0f) : s*(1.0f/128.0f);
+		}
+	}
+}
+
+void SampleEditorDSP::writeFloats(void* data, bool is16Bit, pp_int32 start, const float* src, pp_int32 count)
+{
+	pp_int32 i;
+
+	if (is16Bit)
+	{
+		pp_int16* dst = (pp_int16*)data + start;
+		for (i = 0; i < count; i++)
+		{
+			float f = src[i];
+			if (f > 1.0f)
+				f = 1.0f;
+			if (f < -1.0f)
+				f = -1.0f;
+			dst[i] = f > 0 ? (pp_int16)(f*32767.0f+0.5f) : (pp_int16)(f*32768.0f-0.5f);
+		}
+	}
+	else
+	{
+		pp_int8* dst = (pp_int8*)data + start;
+		for (i = 0; i < count; i++)
+		{
+			float f = src[i];
+			if (f > 1.0f)
+				f = 1.0f;
+			if (f < -1.0f)
+				f = -1.0f;
+			dst[i] = f > 0 ? (pp_int8)(f*127.0f+0.5f) : (pp_int8)(f*128.0f-0.5f);
+		}
+	}
+}
+
+void SampleEditorDSP::writeFloatsDithered(void* data, bool is16Bit, pp_int32 start, const float* src, pp_int32 count, pp_uint32 seed)
+{
+	const float scalePos = is16Bit ? 32767.0f : 127.0f;
+	const float scaleNeg = is16Bit ? 32768.0f : 128.0f;
+	const pp_int32 maxValue = is16Bit ? 32767 : 127;
+	const pp_int32 minValue = is16Bit ? -32768 : -128;
+
+	for (pp_int32 i = 0; i < count; i++)
+	{
+		// triangular noise of +-1 LSB out of two uniform random numbers
+		seed = seed*1664525 + 1013904223;
+		float r = (float)(seed >> 8);
+		seed = seed*1664525 + 1013904223;
+		r -= (float)(seed >> 8);
+
+		float f = src[i];
+		f = (f > 0 ? f*scalePos : f*scaleNeg) + r*(1.0f/16777216.0f);
+
+		pp_int32 s = (pp_int32)floor(f + 0.5f);
+		if (s > maxValue)
+			s = maxValue;
+		if (s < minValue)
+			s = minValue;
+
+		if (is16Bit)
+			((pp_int16*)data)[start + i] = (pp_int16)s;
+		else
+			((pp_int8*)data)[start + i] = (pp_int8)s;
+	}
+}
+
+void SampleEditorDSP::scale(float* buffer, pp_int32 count, float scale)
+{
+	for (pp_int32 i = 0; i < count; i++)
+		buffer[i] *= scale;
+}
+
+void SampleEditorDSP::scaleRamp(float* buffer, pp_int32 count, float startScale, float step)
+{
+	for (pp_int32 i = 0; i < count; i++)
+		buffer[i] *= startScale + (float)i*step;
+}
+
+void SampleEditorDSP::add(float* buffer, pp_int32 count, float value)
+{
+	for (pp_int32 i = 0; i < count; i++)
+		buffer[i] += value;
+}
+
+float SampleEditorDSP::peak(const float* buffer, pp_int32 count)
+{
+	float peak = 0.0f;
+	for (pp_int32 i = 0; i < count; i++)
+	{
+		float f = buffer[i] < 0.0f ? -buffer[i] : buffer[i];
+		if (f > peak)
+			peak = f;
+	}
+	return peak;
+}
+
+double SampleEditorDSP::sum(const float* buffer, pp_int32 count)
+{
+	double sum = 0.0;
+	for (pp_int32 i = 0; i < count; i++)
+		sum += buffer[i];
+	return sum;
+}
+
+void SampleEditorDSP::smoothRectangular(const float* src, pp_int32 length, pp_int32 start, pp_int32 end, float* dst)
+{
+	// samples with a complete neighbourhood
+	pp_int32 innerStart = start < 1 ? 1 : start;
+	pp_int32 innerEnd = end > length - 1 ? length - 1 : end;
+	if (innerEnd < innerStart)
+		innerStart = innerEnd = end;
+
+	pp_int32 i;
+	for (i = start; i < innerStart; i++)
+		dst[i - start] = (getClamped(src, length, i - 1) + src[i] + getClamped(src, length, i + 1)) * (1.0f/3.0f);
+
+	for (i = innerStart; i < innerEnd; i++)
+		dst[i - start] = (src[i - 1] + src[i] + src[i + 1]) * (1.0f/3.0f);
+
+	for (i = innerEnd; i < end; i++)
+		dst[i - start] = (getClamped(src, length, i - 1) + src[i] + getClamped(src, length, i + 1)) * (1.0f/3.0f);
+}
+
+void SampleEditorDSP::smoothTriangular(const float* src, pp_int32 length, pp_int32 start, pp_int32 end, float* dst)
+{
+	pp_int32 innerStart = start < 2 ? 2 : start;
+	pp_int32 innerEnd = end > length - 2 ? length - 2 : end;
+	if (innerEnd < innerStart)
+		innerStart = innerEnd = end;
+
+	pp_int32 i;
+	for (i = start; i < innerStart; i++)
+		dst[i - start] = (getClamped(src, length, i - 2) +
+						  getClamped(src, length, i - 1)*2.0f +
+						  src[i]*3.0f +
+						  getClamped(src, length, i + 1)*2.0f +
+						  getClamped(src, length, i + 2)) * (1.0f/9.0f);
+
+	for (i = innerStart; i < innerEnd; i++)
+		dst[i - start] = (src[i - 2] + src[i - 1]*2.0f + src[i]*3.0f + src[i + 1]*2.0f + src[i + 2]) * (1.0f/9.0f);
+
+	for (i = innerEnd; i < end; i++)
+		dst[i - start] = (getClamped(src, length, i - 2) +
+						  getClamped(src, length, i - 1)*2.0f +
+						  src[i]*3.0f +
+						  getClamped(src, length, i + 1)*2.0f +
+						  getClamped(src, length, i + 2)) * (1.0f/9.0f);
+}
+
+void SampleEditorDSP::ScaleFilter::process(float* buffer, pp_int32 pos, pp_int32 count)
+{
+	if (step == 0.0f)
+		SampleEditorDSP::scale(buffer, count, startScale);
+	else
+		SampleEditorDSP::scaleRamp(buffer, count, startScale + (float)pos*step, step);
+}
+
+void SampleEditorDSP::OffsetFilter::process(float* buffer, pp_int32 pos, pp_int32 count)
+{
+	SampleEditorDSP::add(buffer, count, offset);
+}
+
+SampleEditorDSP::EQFilter::EQFilter(const float* bandParams, pp_int32 numBands, const SampleEditor::ClipBoard* clipBoard/* = NULL*/, pp_int32 length/* = 0*/) :
+	numBands(numBands),
+	clipBoard(clipBoard),
+	step(0.0f),
+	j2(0.0f),
+	nextPos(0)
+{
+	float c4spd = 8363; // there really should be a global constant for this
+
+	const float* bands = numBands == 3 ? EQConstants::EQ3bands : EQConstants::EQ10bands;
+	const float* bandwidths = numBands == 3 ? EQConstants::EQ3bandwidths : EQConstants::EQ10bandwidths;
+
+	eqs = new Equalizer*[numBands];
+	for (pp_int32 i = 0; i < numBands; i++)
+	{
+		eqs[i] = new Equalizer();
+		eqs[i]->CalcCoeffs(bands[i], bandwidths[i], c4spd, Equalizer::CalcGain(bandParams[i]));
+	}
+
+	work = new double[BLOCKSIZE];
+
+	if (clipBoard && length > 0)
+		step = (float)clipBoard->getWidth() / (float)length;
+}
+
+SampleEditorDSP::EQFilter::~EQFilter()
+{
+	for (pp_int32 i = 0; i < numBands; i++)
+		delete eqs[i];
+
+	delete[] eqs;
+	delete[] work;
+}
+
+void SampleEditorDSP::EQFilter::reset()
+{
+	for (pp_int32 i = 0; i < numBands; i++)
+		eqs[i]->Reset();
+
+	j2 = 0.0f;
+	nextPos = 0;
+}
+
+void SampleEditorDSP::EQFilter::process(float* buffer, pp_int32 pos, pp_int32 count)
+{
+	// the clipboard position is accumulated like the original tool did,
+	// only recalculated when the stream jumps
+	if (pos != nextPos)
+		j2 = (float)pos*step;
+	nextPos = pos + count;
+
+	while (count > 0)
+	{
+		const pp_int32 num = count > BLOCKSIZE ? BLOCKSIZE : count;
+		pp_int32 i;
+
+		for (i = 0; i < num; i++)
+			work[i] = buffer[i];
+
+		for (pp_int32 j = 0; j < numBands; j++)
+			eqs[j]->Filter(work, num);
+
+		if (clipBoard == NULL)
+		{
+			for (i = 0; i < num; i++)
+				buffer[i] = (float)work[i];
+		}
+		else
+		{
+			for (i = 0; i < num; i++)
+			{
+				float x = buffer[i];
+				float xL = (float)work[i];
+				float frac = j2 - (float)floor(j2);
+
+				pp_int16 s = clipBoard->getSampleWord((pp_int32)j2);
+				float f1 = s < 0 ? (s/32768.0f) : (s/32767.0f);
+				s = clipBoard->getSampleWord((pp_int32)j2+1);
+				float f2 = s < 0 ? (s/32768.0f) : (s/32767.0f);
+
+				float f = (1.0f-frac)*f1 + frac*f2;
+
+				if (f>=0) {
+					x = f * xL + (1.0f-f) * x;
+				} else {
+					x = -f * (x-xL) + (1.0+f) * x;
+				}
+				j2+=step;
+
+				buffer[i] = x;
+			}
+		}
+
+		buffer+=num;
+		count-=num;
+	}
+}
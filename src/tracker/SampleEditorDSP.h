@@ -0,0 +1,191 @@
+/*
+ *  tracker/SampleEditorDSP.h
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SampleEditorDSP.h
+ *  MilkyTracker
+ *
+ *  Block based float processing for the sample editor tools. A range of
+ *  sample data is cut into blocks of BLOCKSIZE samples, each block is
+ *  converted to float once, processed by simple loops the compiler can
+ *  vectorize and converted back. Blocks which don't depend on each other
+ *  are spread across a worker pool.
+ *
+ *  Conversion is the same as in SampleEditor::getFloatSampleFromWaveform
+ *  and SampleEditor::setFloatSampleInWaveform.
+ *
+ *  Tools which only depend on the current position (and their own state)
+ *  are implemented as Filter, so they can be applied to the whole range at
+ *  once or streamed block by block into a preview.
+ *
+ */
+
+#ifndef SAMPLEEDITORDSP__H
+#define SAMPLEEDITORDSP__H
+
+#include "BasicTypes.h"
+#include "SampleEditor.h"
+
+class WorkerPool;
+class Equalizer;
+struct TXMSample;
+
+class SampleEditorDSP
+{
+public:
+	enum
+	{
+		BLOCKSIZE = 16384
+	};
+
+	// processes the samples [start, end) of the block with the given index,
+	// buffer is scratch space for BLOCKSIZE floats owned by the calling thread
+	typedef void (*TBlockHandler)(void* userData, pp_int32 blockIndex, pp_int32 start, pp_int32 end, float* buffer);
+
+	// a sample tool working on float blocks, positions are relative to
+	// the start of the range the filter is applied to
+	class Filter
+	{
+	public:
+		virtual ~Filter() {}
+
+		// recursive filters depend on the samples before a block, so
+		// blocks have to be passed in order on a single thread
+		virtual bool isRecursive() const { return false; }
+		// forget all state, the next block can start anywhere
+		virtual void reset() {}
+
+		virtual void process(float* buffer, pp_int32 pos, pp_int32 count) = 0;
+	};
+
+	// volume change, linear fade if step != 0
+	class ScaleFilter : public Filter
+	{
+	private:
+		float startScale, step;
+
+	public:
+		ScaleFilter(float startScale, float step) :
+			startScale(startScale), step(step)
+		{
+		}
+
+		virtual void process(float* buffer, pp_int32 pos, pp_int32 count);
+	};
+
+	class OffsetFilter : public Filter
+	{
+	private:
+		float offset;
+
+	public:
+		OffsetFilter(float offset) :
+			offset(offset)
+		{
+		}
+
+		virtual void process(float* buffer, pp_int32 pos, pp_int32 count);
+	};
+
+	// 3 or 10 band EQ, bandParams as in the EQ dialog (0.5 = 0dB).
+	// The selective EQ fades between dry and filtered signal by the
+	// waveform in the clipboard, stretched over length samples.
+	class EQFilter : public Filter
+	{
+	private:
+		Equalizer** eqs;
+		pp_int32 numBands;
+		double* work;
+
+		const SampleEditor::ClipBoard* clipBoard;
+		float step;
+		float j2;
+		pp_int32 nextPos;
+
+	public:
+		EQFilter(const float* bandParams, pp_int32 numBands, const SampleEditor::ClipBoard* clipBoard = NULL, pp_int32 length = 0);
+		virtual ~EQFilter();
+
+		virtual bool isRecursive() const { return true; }
+		virtual void reset();
+
+		virtual void process(float* buffer, pp_int32 pos, pp_int32 count);
+	};
+
+private:
+	WorkerPool* workerPool;
+
+	struct Job
+	{
+		TBlockHandler handler;
+		void* userData;
+		pp_int32 length;
+		pp_int32 numBlocks;
+		pp_int32 blocksPerTask;
+	};
+
+	static void processTask(void* userData, pp_uint32 taskIndex);
+
+public:
+	SampleEditorDSP();
+	~SampleEditorDSP();
+
+	static pp_int32 getNumBlocks(pp_int32 length) { return (length + BLOCKSIZE - 1) / BLOCKSIZE; }
+
+	// call handler for all blocks of [0, length), blocks are processed in
+	// parallel so the handler must not touch data outside of its block
+	void processBlocks(TBlockHandler handler, void* userData, pp_int32 length);
+	// same on the calling thread and in order, for recursive filters
+	void processBlocksSequential(TBlockHandler handler, void* userData, pp_int32 length);
+
+	// run filter over the samples [start, end), in parallel if it isn't recursive.
+	// The loop double buffer of the sample must be switched off.
+	void applyFilter(TXMSample* sample, pp_int32 start, pp_int32 end, Filter& filter);
+
+	// sample data <-> float
+	static float sampleToFloat(pp_int32 s, bool is16Bit)
+	{
+		if (is16Bit)
+			return s > 0 ? (float)s*(1.0f/32767.0f) : (float)s*(1.0f/32768.0f);
+		return s > 0 ? (float)s*(1.0f/127.0f) : (float)s*(1.0f/128.0f);
+	}
+
+	static void readFloats(const void* data, bool is16Bit, pp_int32 start, float* dst, pp_int32 count);
+	static void writeFloats(void* data, bool is16Bit, pp_int32 start, const float* src, pp_int32 count);
+	// same with TPDF dither, seed makes the noise reproducible per block
+	static void writeFloatsDithered(void* data, bool is16Bit, pp_int32 start, const float* src, pp_int32 count, pp_uint32 seed);
+
+	// kernels
+	static void scale(float* buffer, pp_int32 count, float scale);
+	// buffer[i] *= startScale + i*step
+	static void scaleRamp(float* buffer, pp_int32 count, float startScale, float step);
+	static void add(float* buffer, pp_int32 count, float value);
+	static float peak(const float* buffer, pp_int32 count);
+	static double sum(const float* buffer, pp_int32 count);
+
+	// 3 tap box and 5 tap triangle filter of src[0..length) for the output
+	// range [start, end), the signal is extended with its border values
+	static void smoothRectangular(const float* src, pp_int32 length, pp_int32 start, pp_int32 end, float* dst);
+	static void smoothTriangular(const float* src, pp_int32 length, pp_int32 start, pp_int32 end, float* dst);
+};
+
+#endif
@@ -0,0 +1,317 @@
+/*
+ *  tracker/SampleEditorPreview.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SampleEditorPreview.cpp
+ *  MilkyTracker
+ *
+ */
+
+#include "SampleEditorPreview.h"
+#include "PlayerController.h"
+
+SampleEditorPreview::SampleEditorPreview() :
+	source(NULL),
+	rangeStart(0),
+	rangeEnd(0),
+	filter(NULL),
+	filterPos(-1),
+	blockValid(NULL),
+	blockPublished(NULL),
+	numBlocks(0),
+	loopAreaRestored(false)
+{
+	memset(&preview, 0, sizeof(preview));
+	memset(&shadow, 0, sizeof(shadow));
+	buffer = new float[BLOCKSIZE];
+}
+
+SampleEditorPreview::~SampleEditorPreview()
+{
+	stop();
+	delete[] buffer;
+}
+
+bool SampleEditorPreview::start(TXMSample* sample, pp_int32 rangeStart, pp_int32 rangeEnd, SampleEditorDSP::Filter* filter)
+{
+	stop();
+
+	if (sample == NULL || sample->sample == NULL || sample->samplen == 0 || filter == NULL)
+	{
+		delete filter;
+		return false;
+	}
+
+	const bool is16Bit = (sample->type & 16) != 0;
+	const mp_uint32 size = is16Bit ? sample->samplen*2 : sample->samplen;
+
+	mp_ubyte* mem = TXMSample::allocPaddedMem(size);
+	mp_ubyte* shadowMem = TXMSample::allocPaddedMem(size);
+	if (mem == NULL || shadowMem == NULL)
+	{
+		TXMSample::freePaddedMem(mem);
+		TXMSample::freePaddedMem(shadowMem);
+		delete filter;
+		return false;
+	}
+
+	// the clone starts out without loop double buffering,
+	// take the real sample values from the loop area
+	memcpy(shadowMem, sample->sample, size);
+
+	shadow = *sample;
+	shadow.sample = (mp_sbyte*)shadowMem;
+
+	if (sample->type & 3)
+	{
+		for (mp_uint32 i = sample->loopstart + sample->looplen; i < sample->loopstart + sample->looplen + LOOPAREASIZE && i < sample->samplen; i++)
+			shadow.setSampleValue(i, sample->getSampleValue(i));
+	}
+
+	shadow.postProcessSamples();
+
+	// nobody plays the clone yet
+	TXMSample::copyPaddedMem(mem, shadowMem, size);
+	preview = shadow;
+	preview.sample = (mp_sbyte*)mem;
+
+	source = sample;
+
+	if (rangeStart < 0)
+		rangeStart = 0;
+	if (rangeEnd > (pp_int32)sample->samplen)
+		rangeEnd = sample->samplen;
+	if (rangeEnd < rangeStart)
+		rangeEnd = rangeStart;
+
+	this->rangeStart = rangeStart;
+	this->rangeEnd = rangeEnd;
+
+	numBlocks = (sample->samplen + BLOCKSIZE - 1) / BLOCKSIZE;
+	blockValid = new bool[numBlocks];
+	blockPublished = new bool[numBlocks];
+	for (pp_int32 i = 0; i < numBlocks; i++)
+		blockPublished[i] = true;
+
+	this->filter = NULL;
+	setFilter(filter);
+
+	return true;
+}
+
+void SampleEditorPreview::stop()
+{
+	TXMSample::freePaddedMem((mp_ubyte*)preview.sample);
+	memset(&preview, 0, sizeof(preview));
+	TXMSample::freePaddedMem((mp_ubyte*)shadow.sample);
+	memset(&shadow, 0, sizeof(shadow));
+
+	delete[] blockValid;
+	blockValid = NULL;
+	delete[] blockPublished;
+	blockPublished = NULL;
+	numBlocks = 0;
+
+	delete filter;
+	filter = NULL;
+	filterPos = -1;
+
+	source = NULL;
+}
+
+void SampleEditorPreview::setFilter(SampleEditorDSP::Filter* filter)
+{
+	delete this->filter;
+	this->filter = filter;
+	filterPos = -1;
+
+	// whatever has been rendered is outdated, but it's still played
+	// until the new filter catches up
+	for (pp_int32 i = 0; i < numBlocks; i++)
+		blockValid[i] = false;
+}
+
+void SampleEditorPreview::readSource(pp_int32 start, float* dst, pp_int32 count)
+{
+	const bool is16Bit = (source->type & 16) != 0;
+
+	SampleEditorDSP::readFloats(source->sample, is16Bit, start, dst, count);
+
+	// raw data in the loop area might be the double buffered one
+	if (source->type & 3)
+	{
+		pp_int32 loopEnd = source->loopstart + source->looplen;
+		pp_int32 i = start > loopEnd ? start : loopEnd;
+		pp_int32 end = start + count;
+		if (end > loopEnd + LOOPAREASIZE)
+			end = loopEnd + LOOPAREASIZE;
+
+		for (; i < end; i++)
+			dst[i - start] = SampleEditorDSP::sampleToFloat(source->getSampleValue(i), is16Bit);
+	}
+}
+
+void SampleEditorPreview::renderBlock(pp_int32 block)
+{
+	blockValid[block] = true;
+
+	pp_int32 start = block * BLOCKSIZE;
+	pp_int32 end = start + BLOCKSIZE;
+	if (start < rangeStart)
+		start = rangeStart;
+	if (end > rangeEnd)
+		end = rangeEnd;
+	if (start >= end || filter == NULL)
+		return;
+
+	if (filter->isRecursive() && filterPos != start)
+	{
+		filter->reset();
+
+		for (pp_int32 pos = (start - WARMUP > rangeStart ? start - WARMUP : rangeStart); pos < start; pos+=BLOCKSIZE)
+		{
+			pp_int32 count = start - pos > BLOCKSIZE ? BLOCKSIZE : start - pos;
+			readSource(pos, buffer, count);
+			filter->process(buffer, pos - rangeStart, count);
+		}
+	}
+
+	readSource(start, buffer, end - start);
+	filter->process(buffer, start - rangeStart, end - start);
+
+	// switch off loop double buffering while writing, see update()
+	if (!loopAreaRestored)
+	{
+		shadow.restoreOriginalState();
+		loopAreaRestored = true;
+	}
+
+	SampleEditorDSP::writeFloats(shadow.sample, (shadow.type & 16) != 0, start, buffer, end - start);
+	blockPublished[block] = false;
+
+	filterPos = end;
+}
+
+void SampleEditorPreview::renderRange(pp_int32 start, pp_int32 end)
+{
+	if (start < rangeStart)
+		start = rangeStart;
+	if (end > rangeEnd)
+		end = rangeEnd;
+	if (start >= end)
+		return;
+
+	for (pp_int32 block = start / BLOCKSIZE; block <= (end - 1) / BLOCKSIZE; block++)
+	{
+		if (!blockValid[block])
+			renderBlock(block);
+	}
+}
+
+bool SampleEditorPreview::publish(PlayerController* playerController, pp_int32 offset, pp_int32 size)
+{
+	mp_ubyte* dst = (mp_ubyte*)preview.sample + offset;
+	const mp_ubyte* src = (const mp_ubyte*)shadow.sample + offset;
+
+	if (memcmp(dst, src, size) == 0)
+		return true;
+
+	if (playerController == NULL)
+	{
+		memcpy(dst, src, size);
+		return true;
+	}
+
+	return playerController->updateSampleData(dst, src, size);
+}
+
+void SampleEditorPreview::publishChanges(PlayerController* playerController)
+{
+	const pp_int32 sampleSize = (shadow.type & 16) ? 2 : 1;
+
+	for (pp_int32 block = 0; block < numBlocks; block++)
+	{
+		if (blockPublished[block])
+			continue;
+
+		pp_int32 start = block * BLOCKSIZE;
+		pp_int32 count = (pp_int32)shadow.samplen - start < BLOCKSIZE ? (pp_int32)shadow.samplen - start : BLOCKSIZE;
+
+		// update queue is full, try again next time
+		if (!publish(playerController, start * sampleSize, count * sampleSize))
+			return;
+
+		blockPublished[block] = true;
+	}
+
+	// the padding holds the loop double buffering and the unrolled loop
+	mp_ubyte* mem = (mp_ubyte*)shadow.sample;
+	const pp_int32 leadingSize = (pp_int32)(mem - TXMSample::getPadStartAddr(mem));
+	const pp_int32 trailingSize = (pp_int32)TXMSample::getPaddedSize(0) - leadingSize;
+
+	if (publish(playerController, -leadingSize, leadingSize))
+		publish(playerController, shadow.samplen * sampleSize, trailingSize);
+}
+
+void SampleEditorPreview::update(pp_int32 playPos, PlayerController* playerController)
+{
+	if (!isActive())
+		return;
+
+	// the player is still copying from the shadow clone
+	if (playerController && playerController->isSampleDataUpdatePending())
+		return;
+
+	if (playPos < 0 || playPos >= (pp_int32)shadow.samplen)
+		playPos = rangeStart;
+
+	const pp_int32 lookAhead = LOOKAHEAD * BLOCKSIZE;
+	const pp_int32 loopStart = shadow.loopstart;
+	const pp_int32 loopEnd = shadow.loopstart + shadow.looplen;
+
+	// ping pong loops play backwards as well
+	if ((shadow.type & 3) == 2)
+		renderRange(playPos - lookAhead, playPos + lookAhead);
+	else
+		renderRange(playPos, playPos + lookAhead);
+
+	// continue at the loop start
+	if ((shadow.type & 3) == 1 && playPos < loopEnd && playPos + lookAhead > loopEnd)
+		renderRange(loopStart, loopStart + (playPos + lookAhead - loopEnd));
+
+	if (loopAreaRestored)
+	{
+		shadow.postProcessSamples();
+		loopAreaRestored = false;
+
+		// the double buffered loop end is taken from the loop start,
+		// its block may not have been rendered
+		if (shadow.type & 3)
+		{
+			pp_int32 end = loopEnd + LOOPAREASIZE < (pp_int32)shadow.samplen ? loopEnd + LOOPAREASIZE : (pp_int32)shadow.samplen;
+			for (pp_int32 block = loopEnd / BLOCKSIZE; block <= (end - 1) / BLOCKSIZE; block++)
+				blockPublished[block] = false;
+		}
+	}
+
+	publishChanges(playerController);
+}
@@ -0,0 +1,117 @@
+/*
+ *  tracker/SampleEditorPreview.h
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SampleEditorPreview.h
+ *  MilkyTracker
+ *
+ *  Non destructive preview of a sample tool. The sample is cloned once,
+ *  the tool is streamed into the clone block by block just ahead of the
+ *  play position, so changing the tool parameters only costs rendering
+ *  a few blocks instead of processing the whole sample. The edited sample
+ *  itself is never touched.
+ *
+ *  The clone might be played while it's updated. Blocks are rendered into
+ *  a second copy and handed over through the player callback which copies
+ *  them in between two mix buffers, so the mixer never sees a half written
+ *  block or the loop double buffering switched off.
+ *
+ */
+
+#ifndef SAMPLEEDITORPREVIEW__H
+#define SAMPLEEDITORPREVIEW__H
+
+#include "BasicTypes.h"
+#include "XModule.h"
+#include "SampleEditorDSP.h"
+
+class PlayerController;
+
+class SampleEditorPreview
+{
+private:
+	enum
+	{
+		BLOCKSIZE = 4096,
+		// number of blocks rendered ahead of the play position
+		LOOKAHEAD = 8,
+		// samples a recursive filter is fed before a block it didn't
+		// reach in order, so it has settled somewhat
+		WARMUP = 4096,
+		// at least the loop double buffer area of TXMSample
+		LOOPAREASIZE = 16
+	};
+
+	TXMSample* source;
+	// the clone which is played and the one which is rendered into
+	TXMSample preview;
+	TXMSample shadow;
+
+	// range the filter is applied to
+	pp_int32 rangeStart, rangeEnd;
+
+	SampleEditorDSP::Filter* filter;
+	// next position of a recursive filter, -1 if it needs to be restarted
+	pp_int32 filterPos;
+
+	bool* blockValid;
+	// block of the shadow copy has been handed over to the played clone
+	bool* blockPublished;
+	pp_int32 numBlocks;
+
+	float* buffer;
+
+	// loop double buffering of the clone is off while rendering
+	bool loopAreaRestored;
+
+	void readSource(pp_int32 start, float* dst, pp_int32 count);
+	void renderBlock(pp_int32 block);
+	void renderRange(pp_int32 start, pp_int32 end);
+	bool publish(PlayerController* playerController, pp_int32 offset, pp_int32 size);
+	void publishChanges(PlayerController* playerController);
+
+public:
+	SampleEditorPreview();
+	~SampleEditorPreview();
+
+	// clone sample and apply filter to [rangeStart, rangeEnd) from now on,
+	// the preview takes ownership of the filter
+	bool start(TXMSample* sample, pp_int32 rangeStart, pp_int32 rangeEnd, SampleEditorDSP::Filter* filter);
+	// free the clone, the sample must not be playing anymore and
+	// no update must be pending
+	void stop();
+	bool isActive() const { return preview.sample != NULL; }
+
+	// switch to a new filter (new tool parameters), takes ownership
+	void setFilter(SampleEditorDSP::Filter* filter);
+
+	// render what's going to be played next, playPos is -1 if the
+	// preview isn't playing (yet). Without a player controller the clone
+	// is written directly, it must not be played then
+	void update(pp_int32 playPos, PlayerController* playerController);
+
+	const TXMSample* getSample() const { return &preview; }
+	pp_int32 getRangeStart() const { return rangeStart; }
+	pp_int32 getRangeEnd() const { return rangeEnd; }
+};
+
+#endif
@@ -32,12 +32,33 @@
 #include "XModule.h"
 #include "ChannelMixer.h"
 #include "ResamplerHelper.h"
+#include "SampleEditorDSP.h"
+#include "PolyphaseResampler.h"
 #include <math.h>
 
-SampleEditorResampler::SampleEditorResampler(XModule& module, TXMSample& sample, pp_uint32 type) :
+const pp_int32 SampleEditorResampler::polyphaseTaps[] =
+{
+	32,
+	128
+};
+
+const char* SampleEditorResampler::polyphaseNames[] =
+{
+	"Polyphase Sinc (32 taps)",
+	"Polyphase Sinc (128 taps)"
+};
+
+const char* SampleEditorResampler::polyphaseNamesShort[] =
+{
+	"Polyphase32",
+	"Polyphase128"
+};
+
+SampleEditorResampler::SampleEditorResampler(XModule& module, TXMSample& sample, pp_uint32 type, SampleEditorDSP& dsp) :
 	module(module),
 	sample(sample),
-	type(type)
+	type(type),
+	dsp(dsp)
 {
 }
 
@@ -45,11 +66,115 @@ SampleEditorResampler::~SampleEditorResampler()
 {
 }
 
+pp_uint32 SampleEditorResampler::getNumResamplers()
+{
+	ResamplerHelper resamplerHelper;
+	return resamplerHelper.getNumResamplers() + sizeof(polyphaseTaps) / sizeof(pp_int32);
+}
+
+const char* SampleEditorResampler::getResamplerName(pp_uint32 index, bool shortName/* = false*/)
+{
+	ResamplerHelper resamplerHelper;
+	if (index < resamplerHelper.getNumResamplers())
+		return resamplerHelper.getResamplerName(index, shortName);
+
+	index-=resamplerHelper.getNumResamplers();
+	if (index >= sizeof(polyphaseTaps) / sizeof(pp_int32))
+		return NULL;
+
+	return shortName ? polyphaseNamesShort[index] : polyphaseNames[index];
+}
+
+bool SampleEditorResampler::resample(float oldRate, float newRate)
+{
+	ResamplerHelper resamplerHelper;
+	if (type < resamplerHelper.getNumResamplers())
+		return resampleMixer(oldRate, newRate);
+
+	pp_uint32 index = type - resamplerHelper.getNumResamplers();
+	if (index >= sizeof(polyphaseTaps) / sizeof(pp_int32))
+		return false;
+
+	return resamplePolyphase(oldRate, newRate, polyphaseTaps[index]);
+}
+
+struct PolyphaseJob
+{
+	const PolyphaseResampler* resampler;
+	const float* src;
+	void* dst;
+	bool is16Bit;
+};
+
+static void polyphaseBlock(void* userData, pp_int32 blockIndex, pp_int32 start, pp_int32 end, float* buffer)
+{
+	PolyphaseJob* job = reinterpret_cast<PolyphaseJob*>(userData);
+
+	job->resampler->process(job->src, start, end, buffer);
+
+	// the dither noise only depends on the block, not on the thread
+	SampleEditorDSP::writeFloatsDithered(job->dst, job->is16Bit, start, buffer, end - start, (pp_uint32)blockIndex * 0x9E3779B9 + 1);
+}
+
+bool SampleEditorResampler::resamplePolyphase(float oldRate, float newRate, pp_int32 numTaps)
+{
+	const bool is16Bit = (sample.type & 16) != 0;
+
+	PolyphaseResampler resampler(oldRate, newRate, numTaps);
+
+	// original sample without loop modifications as float,
+	// extended with its border values on both sides
+	const pp_int32 padding = resampler.getPadding();
+	float* src = new float[sample.samplen + padding*2];
+
+	if (src == NULL)
+		return false;
+
+	mp_sint32 i;
+	for (i = 0; i < (mp_sint32)sample.samplen; i++)
+		src[padding + i] = SampleEditorDSP::sampleToFloat(sample.getSampleValue(i), is16Bit);
+
+	for (i = 0; i < padding; i++)
+	{
+		src[i] = src[padding];
+		src[padding + sample.samplen + i] = src[padding + sample.samplen - 1];
+	}
+
+	// mostly the same length as with the mixer resamplers, but the
+	// resampler's own step keeps the last output within the source
+	mp_sint32 finalSize = resampler.getOutputLength(sample.samplen);
+
+	mp_sbyte* dst = (mp_sbyte*)module.allocSampleMem(is16Bit ? finalSize*2 : finalSize);
+
+	if (dst == NULL)
+	{
+		delete[] src;
+		return false;
+	}
+
+	PolyphaseJob job;
+	job.resampler = &resampler;
+	job.src = src + padding;
+	job.dst = dst;
+	job.is16Bit = is16Bit;
+
+	dsp.processBlocks(polyphaseBlock, &job, finalSize);
+
+	delete[] src;
+
+	module.freeSampleMem((mp_ubyte*)sample.sample);
+
+	sample.sample = dst;
+	sample.samplen = finalSize;
+
+	return true;
+}
+
 // we're going to abuse the resampler of the ChannelMixer class
 // Problem here is, we need to build up some temporary channel structure 
 // PLUS the resampler only deals with stereo channels, so basically we're 
 // resampling stereo data (left channel = full, right channel = empty)
-bool SampleEditorResampler::resample(float oldRate, float newRate)
+bool SampleEditorResampler::resampleMixer(float oldRate, float newRate)
 {
 	float factor = oldRate / newRate;
 
@@ -39,12 +39,25 @@ private:
 	class XModule& module;
 	struct TXMSample& sample;
 	pp_uint32 type;
+	class SampleEditorDSP& dsp;
+
+	static const pp_int32 polyphaseTaps[];
+	static const char* polyphaseNames[];
+	static const char* polyphaseNamesShort[];
+
+	bool resampleMixer(float oldRate, float newRate);
+	bool resamplePolyphase(float oldRate, float newRate, pp_int32 numTaps);
 
 public:
-	SampleEditorResampler(XModule& module, TXMSample& sample, pp_uint32 type);
+	SampleEditorResampler(XModule& module, TXMSample& sample, pp_uint32 type, SampleEditorDSP& dsp);
 	virtual ~SampleEditorResampler();
 
 	bool resample(float oldRate, float newRate);
+
+	// the resamplers of the mixer (see ResamplerHelper)
+	// followed by the offline polyphase sinc resamplers
+	static pp_uint32 getNumResamplers();
+	static const char* getResamplerName(pp_uint32 index, bool shortName = false);
 };
 
 #endif
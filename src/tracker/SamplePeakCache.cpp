@@ -0,0 +1,425 @@
+/*
+ *  tracker/SamplePeakCache.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SamplePeakCache.cpp
+ *  MilkyTracker
+ *
+ */
+
+#include "SamplePeakCache.h"
+#include "XModule.h"
+#include "WorkerPool.h"
+#include "MilkyPlayAtomic.h"
+#include <math.h>
+#include <string.h>
+
+SamplePeakCache::Pyramid::Pyramid() :
+	numLevels(0),
+	sampleData(NULL),
+	sampleLength(0),
+	is16Bit(false)
+{
+	for (pp_int32 i = 0; i < MAXLEVELS; i++)
+	{
+		levels[i] = NULL;
+		levelSize[i] = 0;
+	}
+}
+
+void SamplePeakCache::Pyramid::free()
+{
+	for (pp_int32 i = 0; i < numLevels; i++)
+	{
+		delete[] levels[i];
+		levels[i] = NULL;
+		levelSize[i] = 0;
+	}
+	numLevels = 0;
+	sampleData = NULL;
+	sampleLength = 0;
+}
+
+void SamplePeakCache::Pyramid::alloc(pp_uint32 sampleLength)
+{
+	this->sampleLength = sampleLength;
+
+	pp_uint32 size = (sampleLength + (1 << BASESHIFT) - 1) >> BASESHIFT;
+
+	while (numLevels < MAXLEVELS)
+	{
+		levels[numLevels] = new Entry[size];
+		levelSize[numLevels] = size;
+		numLevels++;
+
+		if (size <= 1)
+			break;
+
+		size = (size + (1 << LEVELSHIFT) - 1) >> LEVELSHIFT;
+	}
+}
+
+void SamplePeakCache::Pyramid::copyLevels(const Pyramid& source)
+{
+	alloc(source.sampleLength);
+
+	sampleData = source.sampleData;
+	is16Bit = source.is16Bit;
+
+	for (pp_int32 i = 0; i < numLevels; i++)
+		memcpy(levels[i], source.levels[i], levelSize[i]*sizeof(Entry));
+}
+
+void SamplePeakCache::Pyramid::build(const void* data, pp_uint32 first, pp_uint32 last)
+{
+	const pp_uint32 firstSample = first << BASESHIFT;
+
+	// level 0 from the sample data
+	Entry* entry = levels[0] + first;
+	for (pp_uint32 b = first; b < last; b++, entry++)
+	{
+		pp_uint32 start = b << BASESHIFT;
+		pp_uint32 end = start + (1 << BASESHIFT);
+		if (end > sampleLength)
+			end = sampleLength;
+
+		pp_int32 min = 32767, max = -32768;
+		float sumSquares = 0.0f;
+
+		if (is16Bit)
+		{
+			const pp_int16* src = (const pp_int16*)data - firstSample;
+			for (pp_uint32 i = start; i < end; i++)
+			{
+				pp_int32 v = src[i];
+				if (v < min) min = v;
+				if (v > max) max = v;
+				sumSquares += (float)(v*v);
+			}
+		}
+		else
+		{
+			const pp_int8* src = (const pp_int8*)data - firstSample;
+			for (pp_uint32 i = start; i < end; i++)
+			{
+				pp_int32 v = src[i] << 8;
+				if (v < min) min = v;
+				if (v > max) max = v;
+				sumSquares += (float)(v*v);
+			}
+		}
+
+		entry->min = (pp_int16)min;
+		entry->max = (pp_int16)max;
+		entry->sumSquares = sumSquares;
+	}
+
+	// propagate up
+	for (pp_int32 level = 1; level < numLevels; level++)
+	{
+		first >>= LEVELSHIFT;
+		last = ((last - 1) >> LEVELSHIFT) + 1;
+
+		const Entry* children = levels[level-1];
+		const pp_uint32 numChildren = levelSize[level-1];
+
+		for (pp_uint32 b = first; b < last; b++)
+		{
+			pp_uint32 c = b << LEVELSHIFT;
+			pp_uint32 cEnd = c + (1 << LEVELSHIFT);
+			if (cEnd > numChildren)
+				cEnd = numChildren;
+
+			Entry combined = children[c];
+			for (c++; c < cEnd; c++)
+			{
+				if (children[c].min < combined.min) combined.min = children[c].min;
+				if (children[c].max > combined.max) combined.max = children[c].max;
+				combined.sumSquares += children[c].sumSquares;
+			}
+
+			levels[level][b] = combined;
+		}
+	}
+}
+
+SamplePeakCache::SamplePeakCache(const TXMSample* owner, WorkerPool* workerPool) :
+	owner(owner),
+	dirtyStart(0),
+	dirtyEnd(0),
+	workerPool(workerPool),
+	building(false),
+	pendingData(NULL),
+	pendingFirst(0),
+	pendingLast(0),
+	pendingDone(0)
+{
+}
+
+SamplePeakCache::~SamplePeakCache()
+{
+	cancel();
+	current.free();
+}
+
+void SamplePeakCache::buildTask(void* userData, pp_uint32 taskIndex)
+{
+	SamplePeakCache* cache = reinterpret_cast<SamplePeakCache*>(userData);
+
+	cache->pending.build(cache->pendingData, cache->pendingFirst, cache->pendingLast);
+
+	atomicStoreRelease(&cache->pendingDone, 1);
+}
+
+void SamplePeakCache::markDirty(pp_uint32 first, pp_uint32 last)
+{
+	if (first >= last)
+		return;
+
+	if (dirtyStart >= dirtyEnd)
+	{
+		dirtyStart = first;
+		dirtyEnd = last;
+	}
+	else
+	{
+		if (first < dirtyStart) dirtyStart = first;
+		if (last > dirtyEnd) dirtyEnd = last;
+	}
+}
+
+void SamplePeakCache::finishBuild()
+{
+	workerPool->wait();
+
+	current.free();
+	current = pending;
+
+	// the levels belong to current now
+	pending = Pyramid();
+
+	delete[] pendingData;
+	pendingData = NULL;
+	building = false;
+}
+
+bool SamplePeakCache::isBuildFinished() const
+{
+	return building && atomicLoadAcquire(&pendingDone) != 0;
+}
+
+void SamplePeakCache::cancel()
+{
+	if (!building)
+		return;
+
+	workerPool->wait();
+
+	// a partial update of the current summary has to be done again,
+	// a new summary is started from scratch by the next validate()
+	if (pending.sampleData == current.sampleData &&
+		pending.sampleLength == current.sampleLength &&
+		current.numLevels)
+		markDirty(pendingFirst, pendingLast);
+
+	pending.free();
+
+	delete[] pendingData;
+	pendingData = NULL;
+	building = false;
+}
+
+void SamplePeakCache::invalidate()
+{
+	cancel();
+	current.free();
+	dirtyStart = dirtyEnd = 0;
+}
+
+void SamplePeakCache::invalidate(pp_int32 start, pp_int32 end)
+{
+	if (start < 0)
+		start = 0;
+	if (start >= end)
+		return;
+
+	markDirty((pp_uint32)start >> BASESHIFT, (((pp_uint32)end - 1) >> BASESHIFT) + 1);
+}
+
+bool SamplePeakCache::matches(const TXMSample* sample) const
+{
+	return current.numLevels != 0 &&
+		current.sampleData == sample->sample &&
+		current.sampleLength == sample->samplen &&
+		current.is16Bit == ((sample->type & 16) != 0);
+}
+
+bool SamplePeakCache::validate(const TXMSample* sample)
+{
+	if (isBuildFinished())
+		finishBuild();
+
+	if (sample == NULL || sample->sample == NULL || sample->samplen == 0)
+	{
+		invalidate();
+		return false;
+	}
+
+	const bool identical = matches(sample);
+
+	// one build at a time, the changes since then are picked up afterwards
+	if (building)
+		return identical;
+
+	pp_uint32 first = 0;
+	pp_uint32 last = (sample->samplen + (1 << BASESHIFT) - 1) >> BASESHIFT;
+
+	if (identical)
+	{
+		if (dirtyStart >= dirtyEnd)
+			return true;
+
+		first = dirtyStart;
+		if (dirtyEnd < last)
+			last = dirtyEnd;
+	}
+
+	dirtyStart = dirtyEnd = 0;
+
+	if (first >= last)
+		return identical;
+
+	const pp_uint32 firstSample = first << BASESHIFT;
+	pp_uint32 lastSample = last << BASESHIFT;
+	if (lastSample > sample->samplen)
+		lastSample = sample->samplen;
+
+	const bool is16Bit = (sample->type & 16) != 0;
+	const pp_uint32 bytesPerSample = is16Bit ? 2 : 1;
+	const pp_uint8* data = (const pp_uint8*)sample->sample + firstSample*bytesPerSample;
+
+	if (workerPool == NULL || lastSample - firstSample <= SYNCHRONOUSBUILDSIZE)
+	{
+		if (!identical)
+		{
+			current.free();
+			current.alloc(sample->samplen);
+			current.sampleData = sample->sample;
+			current.is16Bit = is16Bit;
+		}
+
+		current.build(data, first, last);
+		return true;
+	}
+
+	// the sample memory might be changed or freed by the editor while the
+	// worker is busy, so it gets a copy of the samples it has to look at
+	if (identical)
+	{
+		pending.copyLevels(current);
+	}
+	else
+	{
+		current.free();
+		pending.alloc(sample->samplen);
+		pending.sampleData = sample->sample;
+		pending.is16Bit = is16Bit;
+	}
+
+	pendingData = new pp_uint8[(lastSample - firstSample)*bytesPerSample];
+	memcpy(pendingData, data, (lastSample - firstSample)*bytesPerSample);
+	pendingFirst = first;
+	pendingLast = last;
+	pendingDone = 0;
+	building = true;
+
+	workerPool->start(buildTask, this, 1);
+
+	return identical;
+}
+
+pp_int32 SamplePeakCache::getSampleValue(pp_uint32 index) const
+{
+	return current.is16Bit ? ((const pp_int16*)current.sampleData)[index] : (((const pp_int8*)current.sampleData)[index] << 8);
+}
+
+void SamplePeakCache::getPeak(pp_int32 start, pp_int32 end, Peak& peak) const
+{
+	peak.min = peak.max = peak.rms = 0;
+
+	if (current.numLevels == 0)
+		return;
+
+	if (start < 0)
+		start = 0;
+	if (end > (pp_int32)current.sampleLength)
+		end = current.sampleLength;
+	if (start >= end)
+		return;
+
+	const pp_uint32 numSamples = end - start;
+
+	// coarsest level which still has a couple of blocks per range,
+	// blocks overlapping the range borders are taken as a whole
+	pp_int32 level = current.numLevels - 1;
+	while (level >= 0 && ((pp_int64)getBlockSize(level) << 2) > (pp_int64)numSamples)
+		level--;
+
+	pp_int32 min = 32767, max = -32768;
+	double sumSquares = 0.0;
+	pp_int64 count = 0;
+
+	if (level < 0)
+	{
+		for (pp_int32 i = start; i < end; i++)
+		{
+			pp_int32 v = getSampleValue(i);
+			if (v < min) min = v;
+			if (v > max) max = v;
+			sumSquares += (double)(v*v);
+		}
+		count = numSamples;
+	}
+	else
+	{
+		const pp_uint32 shift = BASESHIFT + level*LEVELSHIFT;
+		const pp_uint32 first = (pp_uint32)start >> shift;
+		const pp_uint32 last = ((pp_uint32)(end - 1) >> shift) + 1;
+
+		const Entry* entry = current.levels[level] + first;
+		for (pp_uint32 b = first; b < last; b++, entry++)
+		{
+			if (entry->min < min) min = entry->min;
+			if (entry->max > max) max = entry->max;
+			sumSquares += entry->sumSquares;
+		}
+
+		pp_int64 blockEnd = (pp_int64)last << shift;
+		if (blockEnd > (pp_int64)current.sampleLength)
+			blockEnd = current.sampleLength;
+		count = blockEnd - ((pp_int64)first << shift);
+	}
+
+	peak.min = min;
+	peak.max = max;
+	peak.rms = count ? (pp_int32)sqrt(sumSquares / (double)count) : 0;
+}
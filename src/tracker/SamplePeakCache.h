@@ -0,0 +1,148 @@
+/*
+ *  tracker/SamplePeakCache.h
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SamplePeakCache.h
+ *  MilkyTracker
+ *
+ *  Multi resolution min/max/RMS summary of a sample, so the sample editor
+ *  can draw a zoomed out waveform in O(pixels) without skipping transients.
+ *  Level 0 summarizes blocks of 32 samples, every further level combines
+ *  4 blocks of the level below.
+ *
+ *  There is one summary per sample (see SampleEditor::getPeakCache). Small
+ *  changes are summarized right away, anything bigger is built by a worker
+ *  thread from a copy of the changed sample data while the old summary
+ *  (or nothing) is drawn.
+ *
+ */
+
+#ifndef SAMPLEPEAKCACHE__H
+#define SAMPLEPEAKCACHE__H
+
+#include "BasicTypes.h"
+
+struct TXMSample;
+class WorkerPool;
+
+class SamplePeakCache
+{
+public:
+	// all values are scaled to 16 bit range
+	struct Peak
+	{
+		pp_int32 min, max;
+		pp_int32 rms;
+	};
+
+private:
+	enum
+	{
+		BASESHIFT = 5,
+		LEVELSHIFT = 2,
+		MAXLEVELS = 16,
+		// changes of up to that many samples are summarized on the calling thread
+		SYNCHRONOUSBUILDSIZE = 65536
+	};
+
+	struct Entry
+	{
+		pp_int16 min, max;
+		float sumSquares;
+	};
+
+	struct Pyramid
+	{
+		Entry* levels[MAXLEVELS];
+		pp_uint32 levelSize[MAXLEVELS];
+		pp_int32 numLevels;
+
+		// what the summary has been built from
+		const void* sampleData;
+		pp_uint32 sampleLength;
+		bool is16Bit;
+
+		Pyramid();
+
+		void free();
+		void alloc(pp_uint32 sampleLength);
+		void copyLevels(const Pyramid& source);
+
+		// summarize level 0 blocks [first, last) from data, which holds the
+		// samples starting at block first, and propagate the change up
+		void build(const void* data, pp_uint32 first, pp_uint32 last);
+	};
+
+	const TXMSample* owner;
+
+	// the summary which is drawn
+	Pyramid current;
+
+	// range of level 0 blocks which need to be rebuilt
+	pp_uint32 dirtyStart, dirtyEnd;
+
+	// background build: the worker summarizes a private copy of the
+	// changed samples into a pyramid of its own, validate() takes it over
+	WorkerPool* workerPool;
+	bool building;
+	Pyramid pending;
+	pp_uint8* pendingData;
+	pp_uint32 pendingFirst, pendingLast;
+	volatile pp_uint32 pendingDone;
+
+	static void buildTask(void* userData, pp_uint32 taskIndex);
+
+	void markDirty(pp_uint32 first, pp_uint32 last);
+	void finishBuild();
+
+	bool matches(const TXMSample* sample) const;
+
+	pp_int32 getSampleValue(pp_uint32 index) const;
+	pp_uint32 getBlockSize(pp_int32 level) const { return 1 << (BASESHIFT + level*LEVELSHIFT); }
+
+public:
+	// workerPool may be NULL, everything is built on the calling thread then
+	SamplePeakCache(const TXMSample* owner, WorkerPool* workerPool);
+	~SamplePeakCache();
+
+	const TXMSample* getOwner() const { return owner; }
+
+	// throw away everything
+	void invalidate();
+	// sample data in [start, end) has been changed
+	void invalidate(pp_int32 start, pp_int32 end);
+
+	// bring the summary up to date with the sample, only rebuilds what's
+	// necessary. Returns false if there is no summary of this sample yet
+	// (the first one is still being built)
+	bool validate(const TXMSample* sample);
+
+	// a background build has finished, the next validate() picks it up
+	bool isBuildFinished() const;
+	// stop a background build, the changes it covered stay dirty
+	void cancel();
+
+	// min/max/rms of the samples in [start, end), call validate first
+	void getPeak(pp_int32 start, pp_int32 end, Peak& peak) const;
+};
+
+#endif
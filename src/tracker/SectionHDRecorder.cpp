@@ -134,7 +134,7 @@ void SectionHDRecorder::validate()
 SectionHDRecorder::SectionHDRecorder(Tracker& tracker) :
 	SectionUpperLeft(tracker, NULL, new DialogResponderHDRec(*this)),
 	recorderMode(RecorderModeToFile),
-	fromOrder(0), toOrder(0), mixerVolume(256),
+	fromOrder(0), toOrder(0), mixerVolume(256), normalize(false),
 	resampler(1),
 	insIndex(0), smpIndex(0),
 	currentFileName(TrackerConfig::untitledSong)
@@ -276,7 +276,7 @@ pp_int32 SectionHDRecorder::handleEvent(PPObject* sender, PPEvent* event)
 				if (event->getID() != eCommand)
 					break;
 
-				if (recorderMode == RecorderModeToFile)
+				if (isFileOutput())
 				{
 					if (TrackerConfig::untitledSong.compareTo(currentFileName.stripExtension()) == 0)
 					{
@@ -300,7 +300,7 @@ pp_int32 SectionHDRecorder::handleEvent(PPObject* sender, PPEvent* event)
 				if (event->getID() != eCommand)
 					break;
 
-				ASSERT(recorderMode == RecorderModeToFile);
+				ASSERT(isFileOutput());
 
 				exportWAVAs(currentFileName);
 				update();
@@ -308,10 +308,20 @@ pp_int32 SectionHDRecorder::handleEvent(PPObject* sender, PPEvent* event)
 			}
 
 			case HDRECORD_BUTTON_RECORDINGMODE:
-				if (recorderMode == RecorderModeToFile)
-					recorderMode = RecorderModeToSample;
-				else
-					recorderMode = RecorderModeToFile;
+				switch (recorderMode)
+				{
+					case RecorderModeToFile:
+						recorderMode = RecorderModeToStemFiles;
+						break;
+					case RecorderModeToStemFiles:
+						recorderMode = RecorderModeToMultiChannelFile;
+						break;
+					case RecorderModeToMultiChannelFile:
+						recorderMode = RecorderModeToSample;
+						break;
+					default:
+						recorderMode = RecorderModeToFile;
+				}
 				update();
 				break;
 
@@ -319,7 +329,7 @@ pp_int32 SectionHDRecorder::handleEvent(PPObject* sender, PPEvent* event)
 				if (event->getID() != eCommand)
 					break;
 
-				getPeakLevel();
+				normalize = !normalize;
 
 				update();
 				break;
@@ -651,10 +661,24 @@ void SectionHDRecorder::update(bool repaint/* = true*/)
 
 	slider->setCurrentValue(mixerVolume);
 
-	if (recorderMode == RecorderModeToFile)
+	PPButton* autoButton = static_cast<PPButton*>(container->getControlByID(HDRECORD_BUTTON_MIXER_AUTO));
+	ASSERT(autoButton);
+	autoButton->setPressed(normalize);
+
+	if (isFileOutput())
 	{
 		PPButton* button = static_cast<PPButton*>(container->getControlByID(HDRECORD_BUTTON_RECORDINGMODE));
-		button->setText("File:");
+		switch (recorderMode)
+		{
+			case RecorderModeToStemFiles:
+				button->setText("Stem:");
+				break;
+			case RecorderModeToMultiChannelFile:
+				button->setText("MChn:");
+				break;
+			default:
+				button->setText("File:");
+		}
 
 		button = static_cast<PPButton*>(container->getControlByID(HDRECORD_BUTTON_RECORD_AS));
 		button->enable(true);
@@ -766,6 +790,10 @@ void SectionHDRecorder::exportWAVAsFileName(const PPSystemString& fileName)
 	parameters.playMode = tracker.playerController->getPlayMode();
 	parameters.mixerShift = getSettingsMixerShift();
 	parameters.mixerVolume = mixerVolume;
+	parameters.normalize = normalize;
+	parameters.multiTrack = recorderMode == RecorderModeToStemFiles ||
+							recorderMode == RecorderModeToMultiChannelFile;
+	parameters.multiTrackSingleFile = recorderMode == RecorderModeToMultiChannelFile;
 
 	mp_ubyte* muting = new mp_ubyte[moduleEditor->getNumChannels()];
 	memset(muting, 0, moduleEditor->getNumChannels());
@@ -801,41 +829,6 @@ void SectionHDRecorder::exportWAVAsFileName(const PPSystemString& fileName)
 	}
 }
 
-void SectionHDRecorder::getPeakLevel()
-{
-	ModuleEditor* moduleEditor = tracker.moduleEditor;
-
-	ModuleServices::WAVWriterParameters parameters;
-	parameters.sampleRate = getSettingsFrequency();
-	parameters.resamplerType = (getSettingsRamping() ? 1 : 0) | (getSettingsResampler() << 1);
-	parameters.playMode = tracker.playerController->getPlayMode();
-	parameters.mixerShift = getSettingsMixerShift();
-	parameters.mixerVolume = 256;
-
-	mp_ubyte* muting = new mp_ubyte[moduleEditor->getNumChannels()];
-	memset(muting, 0, moduleEditor->getNumChannels());
-	if (getSettingsAllowMuting())
-	{
-		for (pp_int32 i = 0; i < (signed)moduleEditor->getNumChannels(); i++)
-			muting[i] = (mp_ubyte)tracker.muteChannels[i];
-	}
-
-	parameters.muting = muting;
-	parameters.panning = tracker.playerController->getPanningTable();
-	parameters.fromOrder = fromOrder;
-	parameters.toOrder = toOrder;
-
-	tracker.signalWaitState(true);
-
-	mixerVolume = moduleEditor->getModuleServices()->estimateMixerVolume(parameters);
-
-	tracker.signalWaitState(false);
-
-	delete[] muting;
-
-	tracker.screen->update();
-}
-
 void SectionHDRecorder::resetCurrentFileName()
 {
 	currentFileName = TrackerConfig::untitledSong;
@@ -872,6 +865,7 @@ void SectionHDRecorder::exportWAVAsSample()
 	parameters.playMode = tracker.playerController->getPlayMode();
 	parameters.mixerShift = getSettingsMixerShift();
 	parameters.mixerVolume = mixerVolume;
+	parameters.normalize = normalize;
 
 	mp_ubyte* muting = new mp_ubyte[moduleEditor->getNumChannels()];
 	memset(muting, 0, moduleEditor->getNumChannels());
@@ -45,6 +45,10 @@ private:
 	enum RecorderModes
 	{
 		RecorderModeToFile,
+		// one WAV per channel
+		RecorderModeToStemFiles,
+		// one WAV with a channel per module channel
+		RecorderModeToMultiChannelFile,
 		RecorderModeToSample
 	};
 
@@ -52,6 +56,7 @@ private:
 	pp_int32 fromOrder;
 	pp_int32 toOrder;
 	pp_int32 mixerVolume;
+	bool normalize;
 	pp_uint32 resampler;
 
 	pp_int32 insIndex;
@@ -74,11 +79,16 @@ private:
 	pp_int32 getSettingsMixerVolume() { return mixerVolume; }
 	void setSettingsMixerVolume(pp_int32 vol) { mixerVolume = vol; }
 	
+	bool getSettingsNormalize() { return normalize; }
+	void setSettingsNormalize(bool b) { normalize = b; }
+	
 	pp_int32 getSettingsMixerShift();
 	void setSettingsMixerShift(pp_int32 shift);
 
 	void validate();
 
+	bool isFileOutput() const { return recorderMode != RecorderModeToSample; }
+
 public:
 	SectionHDRecorder(Tracker& tracker);
 	virtual ~SectionHDRecorder();
@@ -100,8 +110,6 @@ public:
 	
 	void exportWAVAsSample();
 	
-	void getPeakLevel();
-	
 	void resetCurrentFileName();
 	void setCurrentFileName(const PPSystemString& fileName);
 	
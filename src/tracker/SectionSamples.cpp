@@ -38,6 +38,7 @@
 #include "SamplePlayer.h"
 #include "PatternEditorControl.h"
 #include "SampleEditorControl.h"
+#include "SampleEditorPreview.h"
 #include "SectionInstruments.h"
 #include "DialogBase.h"
 
@@ -465,6 +466,43 @@ pp_int32 SectionSamples::handleEvent(PPObject* sender, PPEvent* event)
 			}
 		}
 	}
+	else if (event->getID() == eValueChanged)
+	{
+		switch (reinterpret_cast<PPControl*>(sender)->getID())
+		{
+			// Tool preview started/stopped
+			case SAMPLE_EDITOR:
+			{
+				SamplePlayer samplePlayer(*moduleEditor, *tracker.playerController);
+				const SampleEditorPreview* preview = sampleEditorControl->getPreview();
+
+				if (event->getMetaData())
+				{
+					if (sampleEditor->hasValidSelection())
+						samplePlayer.playSample(*preview->getSample(), currentSamplePlayNote, preview->getRangeStart(), preview->getRangeEnd());
+					else
+						samplePlayer.playSample(*preview->getSample(), currentSamplePlayNote);
+				}
+				else
+				{
+					// the preview is freed right after this, make sure the
+					// mixer is done with it and with the updates of its data.
+					// Queued commands are carried out first, a queued
+					// playback of the preview is stopped right after
+					const bool suspended = tracker.playerController->isSuspended();
+					if (!suspended)
+						tracker.playerController->suspendPlayer(false, false);
+
+					tracker.playerController->flushSampleDataUpdates();
+					samplePlayer.stopSamplePlayback();
+
+					if (!suspended)
+						tracker.playerController->resumePlayer(false);
+				}
+				break;
+			}
+		}
+	}
 
 	return 0;
 }
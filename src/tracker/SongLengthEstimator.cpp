@@ -30,23 +30,378 @@
 
 #include "SongLengthEstimator.h"
 #include "MilkyPlay.h"
-#include "AudioDriver_NULL.h"
+
+namespace
+{
+	// The part of PlayerSTD's state which decides when and where the song
+	// continues, see PlayerSTD::tickhandler() and PlayerSTD::doEffect()
+	class SongFlowSimulator
+	{
+	private:
+		struct TChannelLoop
+		{
+			mp_sint32 loopstart, loopcounter, loopingValidPosition;
+			bool execloop, isLooping;
+
+			void reset(mp_sint32 poscnt)
+			{
+				loopstart = loopcounter = 0;
+				execloop = isLooping = false;
+				loopingValidPosition = poscnt;
+			}
+		};
+
+		const XModule& module;
+
+		mp_sint32 poscnt, rowcnt, ticker;
+		mp_sint32 tickSpeed, bpm, baseBpm;
+		mp_uint32 adder, BPMCounter;
+
+		bool patDelay, haltFlag, halted, playModeFT2;
+		mp_sint32 patDelayCount, startNextRow;
+
+		mp_sint32 pbreak, pbreakpos, pbreakPriority;
+		mp_sint32 pjump, pjumppos, pjumprow, pjumpPriority;
+
+		TChannelLoop* loops;
+		mp_ubyte* attick;
+
+		mp_ubyte rowHits[256*256/8];
+
+		bool isRowVisited(mp_sint32 row) const { return (rowHits[row>>3]>>(row&7))&1; }
+		void visitRow(mp_sint32 row) { rowHits[row>>3] |= (1<<(row&7)); }
+
+		void resetAllLooping()
+		{
+			for (mp_sint32 c = 0; c < module.header.channum; c++)
+				loops[c].reset(poscnt);
+		}
+
+		void setNewPosition(mp_sint32 poscnt)
+		{
+			if (poscnt == this->poscnt)
+				return;
+
+			if (poscnt >= module.header.ordnum)
+				poscnt = module.header.restart;
+
+			this->poscnt = poscnt;
+			resetAllLooping();
+		}
+
+		void doEffect(mp_sint32 chn, mp_sint32 effcnt, const mp_ubyte* slot, mp_sint32 numEffects)
+		{
+			const mp_ubyte eff = slot[2+effcnt*2];
+			const mp_sint32 eop = slot[2+effcnt*2+1];
+
+			switch (eff)
+			{
+				// position jump
+				case 0x0B:
+					pjump = 1;
+					pjumppos = eop;
+					pjumprow = 0;
+					pjumpPriority = MP_NUMEFFECTS*chn + effcnt;
+					break;
+				// pattern break
+				case 0x0D:
+					pbreak = 1;
+					pbreakpos = (eop>>4)*10+(eop&0xf);
+					if (pbreakpos > 63)
+						pbreakpos = 0;
+					pbreakPriority = MP_NUMEFFECTS*chn + effcnt;
+					break;
+				// set speed/BPM, the speed has been set at the beginning of the row
+				case 0x0F:
+					if (eop)
+					{
+						if (eop >= 32)
+						{
+							bpm = eop;
+							adder = PlayerSTD::getbpmrate(bpm, baseBpm);
+						}
+					}
+					else
+						haltFlag = true;
+					break;
+				// set BPM
+				case 0x16:
+					if (eop)
+					{
+						bpm = eop;
+						adder = PlayerSTD::getbpmrate(bpm, baseBpm);
+					}
+					break;
+				// far position jump
+				case 0x2B:
+					pjump = 1;
+					pjumppos = eop;
+					pjumprow = slot[2+((effcnt+1)%numEffects)*2+1];
+					pjumpPriority = MP_NUMEFFECTS*chn + effcnt;
+					break;
+				// pattern loop
+				case 0x36:
+				{
+					TChannelLoop& loop = loops[chn];
+					if (!eop)
+					{
+						loop.execloop = false;
+						loop.loopstart = rowcnt;
+						loop.loopingValidPosition = poscnt;
+					}
+					else if (loop.loopcounter == eop)
+					{
+						// imitate the FT2 loop bug like PlayerSTD does
+						if (playModeFT2)
+							startNextRow = loop.loopstart;
+						loop.reset(poscnt);
+					}
+					else
+					{
+						loop.execloop = true;
+						loop.loopcounter++;
+					}
+					break;
+				}
+				// pattern delay
+				case 0x3E:
+					patDelay = true;
+					patDelayCount = tickSpeed*(eop+1);
+					break;
+				// digibooster real BPM
+				case 0x52:
+					if (eop)
+					{
+						baseBpm = eop >= 32 ? eop : 32;
+						adder = PlayerSTD::getbpmrate(bpm, baseBpm);
+					}
+					break;
+			}
+		}
+
+	public:
+		SongFlowSimulator(const XModule& module, mp_sint32 startOrder) :
+			module(module),
+			poscnt(startOrder),
+			rowcnt(0),
+			ticker(0),
+			tickSpeed(module.header.tempo),
+			bpm(module.header.speed),
+			baseBpm(125),
+			BPMCounter(0),
+			patDelay(false),
+			haltFlag(false),
+			halted(false),
+			// PlayerSTD in auto play mode
+			playModeFT2((module.header.flags & XModule::MODULE_XMARPEGGIO) != 0),
+			patDelayCount(0),
+			startNextRow(-1),
+			pbreak(0), pbreakpos(0), pbreakPriority(0),
+			pjump(0), pjumppos(0), pjumprow(0), pjumpPriority(0)
+		{
+			adder = PlayerSTD::getbpmrate(bpm, baseBpm);
+
+			mp_sint32 numChannels = module.header.channum > 0 ? module.header.channum : 1;
+			loops = new TChannelLoop[numChannels];
+			attick = new mp_ubyte[numChannels];
+
+			resetAllLooping();
+
+			memset(rowHits, 0, sizeof(rowHits));
+			for (mp_sint32 i = 0; i < startOrder; i++)
+				for (mp_sint32 j = 0; j < 256; j++)
+					visitRow(i*256+j);
+		}
+
+		~SongFlowSimulator()
+		{
+			delete[] attick;
+			delete[] loops;
+		}
+
+		bool hasSongHalted() const { return halted; }
+		mp_sint32 getOrder() const { return poscnt; }
+
+		// number of timer ticks until the BPM counter triggers the next player tick
+		mp_uint32 advanceTimer()
+		{
+			const mp_int64 remaining = ((mp_int64)1 << 32) - (mp_int64)BPMCounter;
+			const mp_uint32 numTimerTicks = (mp_uint32)((remaining + adder - 1) / adder);
+			BPMCounter += numTimerTicks * adder;
+			return numTimerTicks;
+		}
+
+		void tick()
+		{
+			if (poscnt >= module.header.ordnum)
+			{
+				halted = true;
+				return;
+			}
+
+			mp_sint32 patternIndex = module.header.ord[poscnt];
+			const TXMPattern* pattern = &module.phead[patternIndex];
+
+			if (pattern->patternData == NULL)
+			{
+				halted = true;
+				return;
+			}
+
+			if (rowcnt >= pattern->rows)
+			{
+				ticker = 0;
+			}
+			else
+			{
+				const mp_sint32 numEffects = pattern->effnum;
+				const mp_sint32 numChannels = pattern->channum <= module.header.channum ? pattern->channum : module.header.channum;
+				const mp_sint32 slotsize = (numEffects*2)+2;
+				const mp_ubyte* row = pattern->patternData+(pattern->channum*slotsize*rowcnt);
+
+				mp_sint32 c;
+
+				if (ticker == 0)
+				{
+					mp_sint32 absolutePos = poscnt*256+rowcnt;
+					if (isRowVisited(absolutePos))
+					{
+						// pattern loop active?
+						bool b = false;
+						for (c = 0; c < numChannels; c++)
+						{
+							if (loops[c].isLooping && loops[c].loopingValidPosition == poscnt)
+							{
+								b = true;
+								break;
+							}
+						}
+
+						if (!b)
+						{
+							halted = true;
+							return;
+						}
+					}
+					else
+					{
+						visitRow(absolutePos);
+					}
+
+					pbreak = pbreakpos = pbreakPriority = pjump = pjumppos = pjumprow = pjumpPriority = 0;
+
+					// note delays and speed are evaluated in advance
+					const mp_ubyte* slot = row;
+					for (c = 0; c < numChannels; c++, slot+=slotsize)
+					{
+						attick[c] = 0;
+						for (mp_sint32 effcnt = 0; effcnt < numEffects; effcnt++)
+						{
+							const mp_ubyte eff = slot[2+effcnt*2];
+							const mp_ubyte eop = slot[2+effcnt*2+1];
+
+							if (eff == 0x3D)
+								attick[c] = eop;
+							else if (eff == 0xF && eop && eop < 32)
+								tickSpeed = eop;
+							else if (eff == 0x1C && eop)
+								tickSpeed = eop;
+						}
+					}
+				}
+
+				// effects are processed on the tick the note is triggered
+				const mp_ubyte* slot = row;
+				for (c = 0; c < numChannels; c++, slot+=slotsize)
+				{
+					if ((mp_sint32)attick[c] == ticker && ticker < tickSpeed)
+					{
+						for (mp_sint32 effcnt = 0; effcnt < numEffects; effcnt++)
+							doEffect(c, effcnt, slot, numEffects);
+					}
+				}
+
+				ticker++;
+
+				mp_sint32 maxTicks = patDelay ? patDelayCount : tickSpeed;
+				if (ticker < maxTicks)
+					return;
+
+				patDelay = false;
+				ticker = 0;
+
+				if (pbreak && (poscnt < (module.header.ordnum-1)))
+				{
+					if (!pjump || (pjump && pjumpPriority > pbreakPriority))
+						setNewPosition(poscnt+1);
+					rowcnt = pbreakpos-1;
+					startNextRow = -1;
+				}
+				else if (pbreak && (poscnt == (module.header.ordnum-1)))
+				{
+					if (!pjump || (pjump && pjumpPriority > pbreakPriority))
+						setNewPosition(module.header.restart);
+					rowcnt = pbreakpos-1;
+					startNextRow = -1;
+				}
+
+				if (pjump)
+				{
+					if (!pbreak || (pbreak && pjumpPriority > pbreakPriority))
+						rowcnt = pjumprow-1;
+					setNewPosition(pjumppos);
+					startNextRow = -1;
+				}
+
+				patternIndex = module.header.ord[poscnt];
+
+				for (c = 0; c < numChannels; c++)
+				{
+					if (loops[c].execloop)
+					{
+						rowcnt = loops[c].loopstart-1;
+						loops[c].execloop = false;
+						loops[c].isLooping = true;
+					}
+				}
+
+				rowcnt++;
+			}
+
+			// reached end of pattern?
+			if (rowcnt >= module.phead[patternIndex].rows)
+			{
+				if (startNextRow != -1)
+				{
+					rowcnt = startNextRow;
+					startNextRow = -1;
+				}
+				else
+				{
+					rowcnt = 0;
+				}
+
+				setNewPosition(poscnt+1);
+			}
+
+			if (haltFlag)
+				halted = true;
+		}
+	};
+}
 
 SongLengthEstimator::SongLengthEstimator(XModule* theModule) :
-	player(NULL),
 	module(theModule)
 {
 }
 
 SongLengthEstimator::SongLengthEstimator(const SongLengthEstimator& src) :
-	player(NULL),
 	module(src.module)
 {
 }
 
 SongLengthEstimator::~SongLengthEstimator()
 {
-	delete player;
 }
 
 const SongLengthEstimator& SongLengthEstimator::operator=(const SongLengthEstimator& src)
@@ -58,25 +413,59 @@ const SongLengthEstimator& SongLengthEstimator::operator=(const SongLengthEstima
 	return *this;
 }
 
-mp_sint32 SongLengthEstimator::estimateSongLengthInSeconds()
+mp_sint32 SongLengthEstimator::estimateSongLengthInSamples(mp_uint32 mixFrequency/* = 44100*/,
+														   mp_sint32* timingLUT/* = NULL*/,
+														   mp_sint32 startOrder/* = 0*/)
 {
-	if (!player)
+	if (module == NULL || module->header.ordnum == 0 ||
+		startOrder < 0 || startOrder >= module->header.ordnum)
+		return -1;
+
+	// the mixer calls the player once per beat packet
+	const mp_int64 beatPacketSize = (ChannelMixer::MP_BEATLENGTH*mixFrequency)/ChannelMixer::MP_BASEFREQ;
+	const mp_int64 maxTimerTicks = 0x7FFFFFFF / beatPacketSize;
+
+	if (timingLUT)
 	{
-		player = new PlayerGeneric(44100);
+		for (mp_sint32 i = 0; i < module->header.ordnum; i++)
+			timingLUT[i] = -1;
 
-		if (!player)
-			return -1;
+		timingLUT[startOrder] = 0;
+	}
+
+	SongFlowSimulator simulator(*module, startOrder);
 
-		player->setBufferSize(1024);
-		player->setResamplerType((ChannelMixer::ResamplerTypes)0);
-		player->setMasterVolume(256);
-		player->setDisableMixing(true);
+	mp_int64 numTimerTicks = 0;
+	mp_sint32 curOrderPos = startOrder;
+
+	while (!simulator.hasSongHalted() && numTimerTicks < maxTimerTicks)
+	{
+		numTimerTicks+=simulator.advanceTimer();
+
+		simulator.tick();
+
+		if (simulator.getOrder() != curOrderPos)
+		{
+			curOrderPos = simulator.getOrder();
+			// the new order starts with the beat packet of this tick
+			if (timingLUT && curOrderPos < module->header.ordnum && timingLUT[curOrderPos] == -1)
+				timingLUT[curOrderPos] = (mp_sint32)((numTimerTicks-1)*beatPacketSize);
+		}
 	}
 
-	AudioDriver_NULL* audioDriver = new AudioDriver_NULL;
-	mp_sint32 res = player->exportToWAV(NULL, module, 0, -1, NULL, module->header.channum, NULL, audioDriver) / player->getMixFrequency();
-    delete audioDriver;
+	if (numTimerTicks > maxTimerTicks)
+		numTimerTicks = maxTimerTicks;
 
-	return res;
+	return (mp_sint32)(numTimerTicks*beatPacketSize);
 }
 
+mp_sint32 SongLengthEstimator::estimateSongLengthInSeconds()
+{
+	const mp_uint32 mixFrequency = 44100;
+
+	mp_sint32 res = estimateSongLengthInSamples(mixFrequency);
+	if (res < 0)
+		return -1;
+
+	return res / mixFrequency;
+}
@@ -31,15 +31,13 @@
 #ifndef SONGLENGTHESTIMATOR__H
 #define SONGLENGTHESTIMATOR__H
 
-#include "MilkyPlayTypes.h"
+#include "MilkyPlayCommon.h"
 
-class PlayerGeneric;
 class XModule;
 
 class SongLengthEstimator
 {
 private:
-	PlayerGeneric* player;
 	XModule* module;
 	
 public:
@@ -49,6 +47,17 @@ public:
 	
 	const SongLengthEstimator& operator=(const SongLengthEstimator& src);
 	
+	// Walk the song tick by tick like PlayerSTD does, but only evaluate the
+	// effects which affect the song flow (speed/BPM, jumps, breaks, loops and
+	// pattern delays), nothing is mixed.
+	// Returns the number of samples played at the given mixing frequency,
+	// timingLUT (optional) receives the number of samples played up to each
+	// position in the orderlist (-1 = never reached) and must hold at least
+	// module->header.ordnum entries
+	mp_sint32 estimateSongLengthInSamples(mp_uint32 mixFrequency = 44100,
+										  mp_sint32* timingLUT = NULL,
+										  mp_sint32 startOrder = 0);
+
 	mp_sint32 estimateSongLengthInSeconds();
 };
 
@@ -46,6 +46,7 @@
 #include "FileIdentificator.h"
 #include "FileExtProvider.h"
 #include "Decompressor.h"
+#include "XMFileMemory.h"
 #include "Zapper.h"
 #include "TitlePageManager.h"
 
@@ -2628,7 +2629,28 @@ bool Tracker::prepareLoading(FileTypes eType, const PPSystemString& fileName, bo
 	FileIdentificator::FileTypes type = fileIdentificator->getFileType();
 	delete fileIdentificator;
 
-	if (type == FileIdentificator::FileTypeCompressed)
+	if (type == FileIdentificator::FileTypeCompressed &&
+		eType == FileTypes::FileTypeSongAllModules)
+	{
+		// modules are decompressed into memory and loaded from there,
+		// no need for a round trip through a temporary file
+		XMFileMemory* memoryFile = new XMFileMemory();
+		Decompressor decompressor(fileName);
+		if (decompressor.decompress(*memoryFile, (DecompressorBase::Hints)fileTypeToHint(eType)))
+		{
+			memoryFile->seek(0);
+			loadingParameters.memoryFile = memoryFile;
+		}
+		else
+		{
+			delete memoryFile;
+			loadingParameters.lastError = "Unrecognized type/corrupt file";
+			loadingParameters.res = false;
+			finishLoading();
+			return false;
+		}
+	}
+	else if (type == FileIdentificator::FileTypeCompressed)
 	{
 		// if this is compressed, try to decompress
 		PPSystemString tempFile(ModuleEditor::getTempFilename());
@@ -2677,6 +2699,9 @@ bool Tracker::finishLoading()
 	if (loadingParameters.deleteFile)
 		Decompressor::removeFile(loadingParameters.filename);
 
+	delete loadingParameters.memoryFile;
+	loadingParameters.memoryFile = NULL;
+
 	if (!loadingParameters.res && loadingParameters.didOpenTab)
 		tabManager->closeTab();
 
@@ -2693,7 +2718,10 @@ bool Tracker::loadTypeFromFile(FileTypes eType, const PPSystemString& fileName,
 	{
 		case FileTypes::FileTypeSongAllModules:
 		{
-			if (loadingParameters.preferredFilename.length())
+			if (loadingParameters.memoryFile)
+				loadingParameters.res = moduleEditor->openSong(*loadingParameters.memoryFile,
+				loadingParameters.preferredFilename);
+			else if (loadingParameters.preferredFilename.length())
 				loadingParameters.res = moduleEditor->openSong(loadingParameters.filename,
 				loadingParameters.preferredFilename);
 			else
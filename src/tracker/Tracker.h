@@ -57,6 +57,7 @@ class TrackerSettingsDatabase;
 class PPDictionaryKey;
 class PPFont;
 class PPButton;
+class XMFileMemory;
 
 // OS Interfaces
 class PPSavePanel;
@@ -307,7 +308,7 @@ private:
 	void doFollowSong();
 
 	PatternEditorControl* getPatternEditorControl() { return patternEditorControl; }
-	void updatePatternEditorControl(bool repaint = true, bool fast = false);
+	void updatePatternEditorControl(bool repaint = true, bool fast = false, bool incremental = false);
 	PatternEditor* getPatternEditor();
 	SampleEditor* getSampleEditor();
 	EnvelopeEditor* getEnvelopeEditor();
@@ -389,11 +390,14 @@ private:
 		bool abortLoading;
 		bool deleteFile;
 		bool didOpenTab;
+		// decompressed module, loaded straight from memory
+		XMFileMemory* memoryFile;
 
 		TPrepareLoadingParameters() :
 			abortLoading(false),
 			deleteFile(false),
-			didOpenTab(false)
+			didOpenTab(false),
+			memoryFile(NULL)
 		{
 		}
 	} loadingParameters;
@@ -80,6 +80,8 @@ void Tracker::buildDefaultSettings()
 	settingsDatabase->store("MIXERSHIFT", 1);
 	settingsDatabase->store("RAMPING", 1);
 	settingsDatabase->store("INTERPOLATION", 1);
+	settingsDatabase->store("MIXERTHREADS", 0);
+	settingsDatabase->store("RENDERAHEAD", 0);
 	settingsDatabase->store("MIXERFREQ", PlayerMaster::getPreferredSampleRate());
 #ifdef __FORCEPOWEROFTWOBUFFERSIZE__
 	settingsDatabase->store("FORCEPOWEROFTWOBUFFERSIZE", 1);
@@ -245,6 +247,7 @@ void Tracker::buildDefaultSettings()
 	// ---------- HD recorder last settings ----------
 	settingsDatabase->store("HDRECORDER_MIXFREQ", 44100);
 	settingsDatabase->store("HDRECORDER_MIXERVOLUME", 256);
+	settingsDatabase->store("HDRECORDER_NORMALIZE", 0);
 	settingsDatabase->store("HDRECORDER_MIXERSHIFT", 1);
 	settingsDatabase->store("HDRECORDER_RAMPING", 1);
 	settingsDatabase->store("HDRECORDER_INTERPOLATION", 1);
@@ -305,6 +308,14 @@ void Tracker::applySettingByKey(PPDictionaryKey* theKey, TMixerSettings& setting
 	{
 		settings.resampler = v2;
 	}
+	else if (theKey->getKey().compareTo("MIXERTHREADS") == 0)
+	{
+		settings.numMixerThreads = v2;
+	}
+	else if (theKey->getKey().compareTo("RENDERAHEAD") == 0)
+	{
+		settings.renderAhead = v2;
+	}
 	else if (theKey->getKey().compareTo("FORCEPOWEROFTWOBUFFERSIZE") == 0)
 	{
 		settings.powerOfTwoCompensation = v2;
@@ -558,6 +569,10 @@ void Tracker::applySettingByKey(PPDictionaryKey* theKey, TMixerSettings& setting
 	{
 		sectionHDRecorder->setSettingsMixerVolume(v2);
 	}
+	else if (theKey->getKey().compareTo("HDRECORDER_NORMALIZE") == 0)
+	{
+		sectionHDRecorder->setSettingsNormalize(v2 != 0);
+	}
 	else if (theKey->getKey().compareTo("HDRECORDER_MIXERSHIFT") == 0)
 	{
 		sectionHDRecorder->setSettingsMixerShift(v2);
@@ -728,6 +743,8 @@ void Tracker::getMixerSettingsFromDatabase(TMixerSettings& mixerSettings,
 	mixerSettings.powerOfTwoCompensation = currentSettings.restore("FORCEPOWEROFTWOBUFFERSIZE")->getIntValue();
 	mixerSettings.resampler = currentSettings.restore("INTERPOLATION")->getIntValue();
 	mixerSettings.ramping = currentSettings.restore("RAMPING")->getIntValue();
+	mixerSettings.numMixerThreads = currentSettings.restore("MIXERTHREADS")->getIntValue();
+	mixerSettings.renderAhead = currentSettings.restore("RENDERAHEAD")->getIntValue();
 	mixerSettings.setAudioDriverName(currentSettings.restore("AUDIODRIVER")->getStringValue());
     mixerSettings.numPlayerChannels = currentSettings.restore("XMCHANNELLIMIT")->getIntValue();
 	mixerSettings.numVirtualChannels = currentSettings.restore("VIRTUALCHANNELS")->getIntValue();
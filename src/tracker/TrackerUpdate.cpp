@@ -40,6 +40,7 @@
 #include "PeakLevelControl.h"
 #include "ScopesControl.h"
 #include "SampleEditorControl.h"
+#include "SampleEditorPreview.h"
 #include "TrackerSettingsDatabase.h"
 #include "SectionInstruments.h"
 #include "SectionSamples.h"
@@ -192,6 +193,11 @@ bool Tracker::updatePlayTime()
 	if (!playTimeText->isVisible())
 		return false;
 
+	// keep the estimated song length in sync with the edits
+	if (moduleEditor->getModuleServices()->isEstimatedSongLengthOutdated() &&
+		settingsDatabase->restore("AUTOESTPLAYTIME")->getIntValue())
+		estimateSongLength();
+
 	PPContainer* container = static_cast<PPContainer*>(screen->getControlByID(CONTAINER_ABOUT));
 
 	char buffer[100], buffer2[100];
@@ -489,7 +495,7 @@ void Tracker::updateInstrumentsListBox(bool repaint)
 ///////////////////////////////////////////
 // update pattern editor
 ///////////////////////////////////////////
-void Tracker::updatePatternEditorControl(/*TXMPattern* pattern, */bool repaint/* = true*/, bool fast/* = false*/)
+void Tracker::updatePatternEditorControl(/*TXMPattern* pattern, */bool repaint/* = true*/, bool fast/* = false*/, bool incremental/* = false*/)
 {
 	PatternEditorControl* patternEditorCtrl = getPatternEditorControl();
 
@@ -508,7 +514,12 @@ void Tracker::updatePatternEditorControl(/*TXMPattern* pattern, */bool repaint/*
 	}
 
 	if (!fast)
+	{
+		// only redraw what has changed since the last time
+		patternEditorCtrl->setIncrementalPaint(incremental);
 		screen->paintControl(patternEditorCtrl, repaint);
+		patternEditorCtrl->setIncrementalPaint(false);
+	}
 }
 
 ///////////////////////////////////////////
@@ -763,7 +774,7 @@ bool Tracker::updateSongPosition(pp_int32 pos/* = -1*/, pp_int32 row/* = -1*/, b
 			getPatternEditorControl()->setSongPosition(pos, row);
 		}
 
-		updatePatternEditorControl(false, fast);
+		updatePatternEditorControl(false, fast, true);
 
 		redraw = true;
 
@@ -854,7 +865,14 @@ void Tracker::doFollowSong()
 		bool showMarksVisibleOld = sampleEditorControl->isVisible() ? sampleEditorControl->showMarksVisible() : false;
 		bool updateSample = false;
 
-		TXMSample* smp = getSampleEditor()->getSample();
+		const TXMSample* smp = getSampleEditor()->getSample();
+
+		// while a tool is previewed the preview is played instead
+		SampleEditorPreview* preview = sampleEditorControl->getPreview();
+		if (preview->isActive())
+			smp = preview->getSample();
+
+		pp_int32 previewPos = -1;
 
 		for (pp_int32 i = 0; i < playerController->getAllNumPlayingChannels(); i++)
 		{
@@ -865,6 +883,7 @@ void Tracker::doFollowSong()
 				// => set the position mark
 				sampleEditorControl->setShowMark(i, pos, vol, pan);
 				updateSample = true;
+				previewPos = pos;
 			}
 			else
 			{
@@ -878,6 +897,10 @@ void Tracker::doFollowSong()
 			}
 		}
 
+		// render what's played next
+		if (preview->isActive())
+			sampleEditorControl->updatePreview(previewPos, playerController);
+
 		if (updateSample && sampleEditorControl->isVisible())
 		{
 			bool showMarksVisible = sampleEditorControl->showMarksVisible();
@@ -28,6 +28,179 @@
 //														patterns
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+static inline mp_sint32 getPatternSize(mp_sint32 rows, mp_sint32 channum, mp_sint32 effnum)
+{
+	return rows*channum*(2+effnum*2);
+}
+
+//---------------------------------------------------------------------------
+// Pre     : 
+// Post    : 
+// Globals : 
+// I/O     : 
+// Task    : Create a keyframe holding the entire (compressed) pattern
+//---------------------------------------------------------------------------
+PatternUndoStackEntry::Node* PatternUndoStackEntry::createKeyFrame(const TXMPattern& pattern)
+{
+	Node* node = new Node;
+	node->refCount = 1;
+	node->parent = NULL;
+	node->depth = 0;
+	node->deltaSize = 0;
+	node->rows = pattern.rows;
+	node->channum = pattern.channum;
+	node->effnum = pattern.effnum;
+	
+	node->len = pattern.compress(NULL);
+	node->data = new mp_ubyte[node->len];
+	
+	mp_sint32 len = pattern.compress(node->data);
+	
+	ASSERT(len == (signed)node->len);
+	
+	return node;
+}
+
+//---------------------------------------------------------------------------
+// Pre     : parentData holds the uncompressed pattern data of parent
+// Post    : 
+// Globals : 
+// I/O     : 
+// Task    : Create a delta node holding the cells which differ from parent,
+//			 returns NULL if nothing differs
+//---------------------------------------------------------------------------
+PatternUndoStackEntry::Node* PatternUndoStackEntry::createDelta(Node* parent, const TXMPattern& pattern, const mp_ubyte* parentData)
+{
+	const pp_uint32 cellSize = 2+pattern.effnum*2;
+	const pp_uint32 numCells = pattern.rows*pattern.channum;
+	const mp_ubyte* src = pattern.patternData;
+
+	// first pass: size of the delta
+	pp_uint32 len = 0;
+	pp_uint32 i = 0;
+	while (i < numCells)
+	{
+		if (memcmp(src + i*cellSize, parentData + i*cellSize, cellSize) == 0)
+		{
+			i++;
+			continue;
+		}
+
+		pp_uint32 count = 0;
+		while (i < numCells && count < 65535 &&
+			   memcmp(src + i*cellSize, parentData + i*cellSize, cellSize) != 0)
+		{
+			i++;
+			count++;
+		}
+		
+		len += 4 + 2 + count*cellSize;
+	}
+
+	if (len == 0)
+		return NULL;
+
+	Node* node = new Node;
+	node->refCount = 1;
+	node->parent = parent;
+	node->depth = parent->depth + 1;
+	node->deltaSize = parent->deltaSize + len;
+	node->rows = pattern.rows;
+	node->channum = pattern.channum;
+	node->effnum = pattern.effnum;
+	node->len = len;
+	node->data = new mp_ubyte[len];
+	
+	parent->refCount++;
+
+	// second pass: store runs of changed cells
+	mp_ubyte* dst = node->data;
+	i = 0;
+	while (i < numCells)
+	{
+		if (memcmp(src + i*cellSize, parentData + i*cellSize, cellSize) == 0)
+		{
+			i++;
+			continue;
+		}
+
+		pp_uint32 first = i;
+		pp_uint32 count = 0;
+		while (i < numCells && count < 65535 &&
+			   memcmp(src + i*cellSize, parentData + i*cellSize, cellSize) != 0)
+		{
+			i++;
+			count++;
+		}
+
+		*dst++ = (mp_ubyte)first;
+		*dst++ = (mp_ubyte)(first >> 8);
+		*dst++ = (mp_ubyte)(first >> 16);
+		*dst++ = (mp_ubyte)(first >> 24);
+		*dst++ = (mp_ubyte)count;
+		*dst++ = (mp_ubyte)(count >> 8);
+		memcpy(dst, src + first*cellSize, count*cellSize);
+		dst += count*cellSize;
+	}
+	
+	return node;
+}
+
+void PatternUndoStackEntry::releaseNode(Node* node)
+{
+	while (node && --node->refCount == 0)
+	{
+		Node* parent = node->parent;
+		delete[] node->data;
+		delete node;
+		node = parent;
+	}
+}
+
+//---------------------------------------------------------------------------
+// Pre     : dest is large enough to hold the uncompressed pattern
+// Post    : 
+// Globals : 
+// I/O     : 
+// Task    : Decompress the keyframe and apply the deltas on top
+//---------------------------------------------------------------------------
+void PatternUndoStackEntry::restoreNode(const Node* node, mp_ubyte* dest)
+{
+	const Node* chain[MAXDELTADEPTH+1];
+	pp_int32 depth = 0;
+	while (node->parent)
+	{
+		ASSERT(depth < MAXDELTADEPTH);
+		chain[depth++] = node;
+		node = node->parent;
+	}
+
+	TXMPattern pattern;
+	memset(&pattern, 0, sizeof(pattern));
+	pattern.rows = node->rows;
+	pattern.channum = node->channum;
+	pattern.effnum = node->effnum;
+	pattern.patternData = dest;
+	pattern.decompress(node->data, node->len);
+	
+	while (depth > 0)
+	{
+		const Node* delta = chain[--depth];
+		const pp_uint32 cellSize = 2+delta->effnum*2;
+		const mp_ubyte* src = delta->data;
+		const mp_ubyte* srcEnd = src + delta->len;
+		while (src < srcEnd)
+		{
+			pp_uint32 first = (pp_uint32)src[0] | ((pp_uint32)src[1] << 8) |
+							  ((pp_uint32)src[2] << 16) | ((pp_uint32)src[3] << 24);
+			pp_uint32 count = (pp_uint32)src[4] | ((pp_uint32)src[5] << 8);
+			src += 6;
+			memcpy(dest + first*cellSize, src, count*cellSize);
+			src += count*cellSize;
+		}
+	}
+}
+
 //---------------------------------------------------------------------------
 // Pre     : 
 // Post    : 
@@ -39,29 +212,55 @@ PatternUndoStackEntry::PatternUndoStackEntry(const TXMPattern& pattern,
 											 const pp_int32 cursorPositionChannel, 
 											 const pp_int32 cursorPositionRow, 
 											 const pp_int32 cursorPositionInner,
-											 const UserData* userData/* = NULL*/) :
-	UndoStackEntry(userData)
+											 const UserData* userData/* = NULL*/,
+											 const PatternUndoStackEntry* reference/* = NULL*/) :
+	UndoStackEntry(userData),
+	node(NULL)
 {
 	this->cursorPositionChannel = cursorPositionChannel;
 	this->cursorPositionRow = cursorPositionRow;
 	this->cursorPositionInner = cursorPositionInner;
 	
-	if (pattern.patternData)
-	{
-		this->pattern.rows = pattern.rows;
-		this->pattern.channum = pattern.channum;
-		this->pattern.effnum = pattern.effnum;
+	if (!pattern.patternData)
+		return;
+	
+	Node* refNode = reference ? reference->node : NULL;
 	
-		this->pattern.len = pattern.compress(NULL);
+	if (refNode &&
+		refNode->rows == pattern.rows &&
+		refNode->channum == pattern.channum &&
+		refNode->effnum == pattern.effnum)
+	{
+		mp_ubyte* refData = new mp_ubyte[getPatternSize(pattern.rows, pattern.channum, pattern.effnum)];
+		restoreNode(refNode, refData);
 		
-		this->pattern.patternData = new mp_ubyte[this->pattern.len];
-
-		mp_sint32 len = pattern.compress(this->pattern.patternData);
+		// keep the delta chain short and don't let it grow beyond what 
+		// a new keyframe would cost
+		Node* keyFrame = refNode;
+		while (keyFrame->parent)
+			keyFrame = keyFrame->parent;
+		
+		if (refNode->depth < MAXDELTADEPTH && refNode->deltaSize < keyFrame->len)
+		{
+			node = createDelta(refNode, pattern, refData);
+			// nothing has changed => share the reference state
+			if (node == NULL)
+			{
+				node = refNode;
+				node->refCount++;
+			}
+		}
+		else if (memcmp(pattern.patternData, refData, getPatternSize(pattern.rows, pattern.channum, pattern.effnum)) == 0)
+		{
+			node = refNode;
+			node->refCount++;
+		}
 		
-		ASSERT(len == (signed)this->pattern.len);
+		delete[] refData;
 	}
-	else
-		memset(&this->pattern, 0, sizeof(pattern));
+	
+	if (node == NULL)
+		node = createKeyFrame(pattern);
 }
 
 //---------------------------------------------------------------------------
@@ -78,13 +277,9 @@ PatternUndoStackEntry::PatternUndoStackEntry(const PatternUndoStackEntry& source
 	cursorPositionRow = source.cursorPositionRow;
 	cursorPositionInner = source.cursorPositionInner;
 
-	pattern.len = source.pattern.len;
-	pattern.rows = source.pattern.rows;
-	pattern.channum = source.pattern.channum;
-	pattern.effnum = source.pattern.effnum;
-	
-	pattern.patternData = new mp_ubyte[pattern.len];
-	memcpy(pattern.patternData, source.pattern.patternData, pattern.len);
+	node = source.node;
+	if (node)
+		node->refCount++;
 }
 
 //---------------------------------------------------------------------------
@@ -96,7 +291,7 @@ PatternUndoStackEntry::PatternUndoStackEntry(const PatternUndoStackEntry& source
 //---------------------------------------------------------------------------
 PatternUndoStackEntry::~PatternUndoStackEntry()
 {
-	delete[] pattern.patternData;
+	releaseNode(node);
 }
 
 //---------------------------------------------------------------------------
@@ -117,21 +312,31 @@ PatternUndoStackEntry& PatternUndoStackEntry::operator=(const PatternUndoStackEn
 		cursorPositionRow = source.cursorPositionRow;
 		cursorPositionInner = source.cursorPositionInner;	
 		
-		if (pattern.patternData)
-			delete[] pattern.patternData;
-	
-		pattern.len = source.pattern.len;
-		pattern.rows = source.pattern.rows;
-		pattern.channum = source.pattern.channum;
-		pattern.effnum = source.pattern.effnum;
-		
-		pattern.patternData = new mp_ubyte[pattern.len];
-		memcpy(pattern.patternData, source.pattern.patternData, pattern.len);
+		if (source.node)
+			source.node->refCount++;
+		releaseNode(node);
+		node = source.node;
 	}
 
 	return *this;
 }
 
+void PatternUndoStackEntry::restorePattern(TXMPattern& pattern) const
+{
+	ASSERT(node);
+	ASSERT(pattern.rows == node->rows && pattern.channum == node->channum && pattern.effnum == node->effnum);
+	
+	restoreNode(node, pattern.patternData);
+}
+
+pp_uint32 PatternUndoStackEntry::getMemoryUsage() const
+{
+	pp_uint32 size = sizeof(PatternUndoStackEntry) + getUserData().getDataLen();
+	if (node)
+		size += sizeof(Node) + node->len;
+	return size;
+}
+
 //---------------------------------------------------------------------------
 // Pre     : 
 // Post    : 
@@ -141,21 +346,29 @@ PatternUndoStackEntry& PatternUndoStackEntry::operator=(const PatternUndoStackEn
 //---------------------------------------------------------------------------
 bool PatternUndoStackEntry::operator==(const PatternUndoStackEntry& source)
 {
-	ASSERT(source.pattern.patternData);
-	ASSERT(pattern.patternData);
+	ASSERT(source.node);
+	ASSERT(node);
 
-	if (pattern.len == source.pattern.len &&
-		pattern.rows == source.pattern.rows &&
-		pattern.channum == source.pattern.channum &&
-		pattern.effnum == source.pattern.effnum)
-	{
-		if (memcmp(pattern.patternData, source.pattern.patternData, pattern.len) == 0)
-			return true;
-		else
-			return false;
-	}
-	else
+	if (node == source.node)
+		return true;
+	
+	if (node->rows != source.node->rows ||
+		node->channum != source.node->channum ||
+		node->effnum != source.node->effnum)
+		return false;
+	
+	// deltas are never empty
+	if (node->parent == source.node || source.node->parent == node)
 		return false;
+		
+	const mp_sint32 patternSize = getPatternSize(node->rows, node->channum, node->effnum);
+	mp_ubyte* data = new mp_ubyte[patternSize*2];
+	restoreNode(node, data);
+	restoreNode(source.node, data + patternSize);
+	bool result = memcmp(data, data + patternSize, patternSize) == 0;
+	delete[] data;
+	
+	return result;
 }
 
 bool PatternUndoStackEntry::operator!=(const PatternUndoStackEntry& source)
@@ -229,24 +442,63 @@ void EnvelopeUndoStackEntry::GetEnvelope(TEnvelope& env) const
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //														samples
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-void SampleUndoStackEntry::calcCheckSum()
+SampleUndoStackEntry::Chunk* SampleUndoStackEntry::createChunk(const pp_uint8* src, pp_uint32 size)
 {
-	checkSum = 0;
-	if (!buffer)
-		return;
-	mp_uint32 size = (flags & 16) ? samplen*2 : samplen;
-	if (size)
+	pp_uint8* mem = new pp_uint8[sizeof(Chunk) + size];
+	Chunk* chunk = (Chunk*)mem;
+	chunk->refCount = 1;
+	chunk->size = size;
+	chunk->data = mem + sizeof(Chunk);
+	memcpy(chunk->data, src, size);
+	return chunk;
+}
+
+void SampleUndoStackEntry::releaseChunk(Chunk* chunk)
+{
+	if (--chunk->refCount == 0)
+		delete[] (pp_uint8*)chunk;
+}
+
+void SampleUndoStackEntry::copyData(const SampleUndoStackEntry& src)
+{
+	numChunks = src.numChunks;
+	chunks = NULL;
+	if (numChunks)
 	{
-		mp_ubyte* mem = TXMSample::getPadStartAddr(buffer);
-		mp_uint32 realSize = TXMSample::getPaddedSize(size);
-		for (pp_uint32 i = 0; i < realSize; i++)
-			checkSum+=(pp_uint32)mem[i];		
+		chunks = new Chunk*[numChunks];
+		for (pp_uint32 i = 0; i < numChunks; i++)
+		{
+			chunks[i] = src.chunks[i];
+			chunks[i]->refCount++;
+		}
+	}
+
+	leadingPadding = src.leadingPadding;
+	padding = NULL;
+	if (src.padding)
+	{
+		const pp_uint32 paddingSize = TXMSample::getPaddedSize(0);
+		padding = new pp_uint8[paddingSize];
+		memcpy(padding, src.padding, paddingSize);
 	}
 }
 
+void SampleUndoStackEntry::releaseData()
+{
+	for (pp_uint32 i = 0; i < numChunks; i++)
+		releaseChunk(chunks[i]);
+	delete[] chunks;
+	chunks = NULL;
+	numChunks = 0;
+
+	delete[] padding;
+	padding = NULL;
+}
+
 SampleUndoStackEntry::SampleUndoStackEntry(const TXMSample& sample, 
 										   pp_int32 selectionStart, pp_int32 selectionEnd, 
-										   const UserData* userData/* = NULL*/) :
+										   const UserData* userData/* = NULL*/,
+										   const SampleUndoStackEntry* reference/* = NULL*/) :
 	UndoStackEntry(userData)
 {
 	samplen = sample.samplen;
@@ -258,26 +510,43 @@ SampleUndoStackEntry::SampleUndoStackEntry(const TXMSample& sample,
 	this->selectionStart = selectionStart;
 	this->selectionEnd = selectionEnd;
 	
-	buffer = NULL;
-
-	checkSum = 0;
+	chunks = NULL;
+	numChunks = 0;
+	padding = NULL;
+	leadingPadding = 0;
 	
 	if (sample.samplen && sample.sample)
 	{
-		// 16 bit sample
-		if (flags & 16)
-		{
-			buffer = TXMSample::allocPaddedMem(samplen*2);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, sample.sample, samplen*2);				
-		}
-		else
+		const pp_uint8* mem = (const pp_uint8*)sample.sample;
+		const pp_uint32 size = (flags & 16) ? samplen*2 : samplen;
+		
+		// padding around the sample data holds the loop double buffering state
+		const pp_uint32 paddingSize = TXMSample::getPaddedSize(0);
+		leadingPadding = (pp_uint32)(mem - TXMSample::getPadStartAddr((mp_ubyte*)mem));
+		padding = new pp_uint8[paddingSize];
+		memcpy(padding, mem - leadingPadding, leadingPadding);
+		memcpy(padding + leadingPadding, mem + size, paddingSize - leadingPadding);
+
+		numChunks = (size + CHUNKSIZE - 1) >> CHUNKSHIFT;
+		chunks = new Chunk*[numChunks];
+		for (pp_uint32 i = 0; i < numChunks; i++)
 		{
-			buffer = TXMSample::allocPaddedMem(samplen);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, sample.sample, samplen);
+			const pp_uint32 offset = i << CHUNKSHIFT;
+			const pp_uint32 chunkSize = (size - offset) < (pp_uint32)CHUNKSIZE ? (size - offset) : (pp_uint32)CHUNKSIZE;
+			
+			// unchanged since the reference entry has been taken => share
+			if (reference && i < reference->numChunks &&
+				reference->chunks[i]->size == chunkSize &&
+				memcmp(reference->chunks[i]->data, mem + offset, chunkSize) == 0)
+			{
+				chunks[i] = reference->chunks[i];
+				chunks[i]->refCount++;
+			}
+			else
+			{
+				chunks[i] = createChunk(mem + offset, chunkSize);
+			}
 		}
-		calcCheckSum();
 	}
 }
 
@@ -290,32 +559,15 @@ SampleUndoStackEntry::SampleUndoStackEntry(const SampleUndoStackEntry& src)	:
 	relnote = src.relnote;
 	finetune = src.finetune;
 	flags = src.flags;
-	checkSum = src.checkSum;
 	this->selectionStart = src.selectionStart;
 	this->selectionEnd = src.selectionEnd;
 	
-	buffer = NULL;
-	if (src.buffer && samplen)
-	{	
-		// 16 bit sample
-		if (flags & 16)
-		{			
-			buffer = TXMSample::allocPaddedMem(samplen*2);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, src.buffer, samplen*2);
-		}
-		else
-		{
-			buffer = TXMSample::allocPaddedMem(samplen);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, src.buffer, samplen);
-		}	
-	}
+	copyData(src);
 }
 
 SampleUndoStackEntry::~SampleUndoStackEntry()
 {
-	TXMSample::freePaddedMem(buffer);
+	releaseData();
 }
 
 // assignment operator
@@ -331,44 +583,21 @@ SampleUndoStackEntry& SampleUndoStackEntry::operator=(const SampleUndoStackEntry
 		relnote = src.relnote;
 		finetune = src.finetune;
 		flags = src.flags;
-		checkSum = src.checkSum;
+		this->selectionStart = src.selectionStart;
+		this->selectionEnd = src.selectionEnd;
 		
-		if (buffer)
-		{
-			TXMSample::freePaddedMem(buffer);
-			buffer = NULL;
-		}
-		
-		if (src.buffer && samplen)
-		{	
-			// 16 bit sample
-			if (flags & 16)
-			{
-				buffer = TXMSample::allocPaddedMem(samplen*2);
-				if (buffer)
-					TXMSample::copyPaddedMem(buffer, src.buffer, samplen*2);
-			}
-			else
-			{
-				buffer = TXMSample::allocPaddedMem(samplen);
-				if (buffer)
-					TXMSample::copyPaddedMem(buffer, src.buffer, samplen);
-			}	
-		}
+		releaseData();
+		copyData(src);
 	}
 
 	return (*this);
 }
 	
-// comparison is necessary too
 bool SampleUndoStackEntry::operator==(const SampleUndoStackEntry& src)
 {
 	if (samplen != src.samplen)
 		return false;
 		
-	if (checkSum != src.checkSum)
-		return false;
-
 	if (loopstart != src.loopstart)
 		return false;
 		
@@ -384,24 +613,29 @@ bool SampleUndoStackEntry::operator==(const SampleUndoStackEntry& src)
 	if (flags != src.flags)
 		return false;
 	
-	if (buffer == NULL && src.buffer != NULL)
+	if (padding == NULL && src.padding != NULL)
 		return false;
 
-	if (buffer != NULL && src.buffer == NULL)
+	if (padding != NULL && src.padding == NULL)
 		return false;
 	
-	mp_uint32 size = (flags & 16) ? samplen*2 : samplen;
-	if (size)
+	if (padding == NULL)
+		return true;
+
+	if (numChunks != src.numChunks)
+		return false;
+		
+	if (memcmp(padding, src.padding, TXMSample::getPaddedSize(0)) != 0)
+		return false;
+
+	for (pp_uint32 i = 0; i < numChunks; i++)
 	{
-		mp_ubyte* _src = src.buffer;
-		mp_ubyte* _dst = buffer;
-
-		mp_ubyte* srcmem = TXMSample::getPadStartAddr(_src);
-		mp_ubyte* dstmem = TXMSample::getPadStartAddr(_dst);
-		mp_uint32 realSize = TXMSample::getPaddedSize(size);
-		for (pp_uint32 i = 0; i < realSize; i++)
-			if (srcmem[i] != dstmem[i])
-				return false;
+		if (chunks[i] == src.chunks[i])
+			continue;
+			
+		if (chunks[i]->size != src.chunks[i]->size ||
+			memcmp(chunks[i]->data, src.chunks[i]->data, chunks[i]->size) != 0)
+			return false;
 	}
 
 	return true;
@@ -411,3 +645,22 @@ bool SampleUndoStackEntry::operator!=(const SampleUndoStackEntry& source)
 {
 	return !(*this==source);
 }
+
+void SampleUndoStackEntry::copyBuffer(void* dst) const
+{
+	if (padding == NULL)
+		return;
+		
+	pp_uint8* mem = (pp_uint8*)dst;
+	const pp_uint32 paddingSize = TXMSample::getPaddedSize(0);
+	
+	pp_uint32 offset = 0;
+	for (pp_uint32 i = 0; i < numChunks; i++)
+	{
+		memcpy(mem + offset, chunks[i]->data, chunks[i]->size);
+		offset += chunks[i]->size;
+	}
+
+	memcpy(mem - leadingPadding, padding, leadingPadding);
+	memcpy(mem + offset, padding + leadingPadding, paddingSize - leadingPadding);
+}
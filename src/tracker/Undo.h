@@ -30,7 +30,8 @@
 #define UNDODEPTH_ENVELOPEEDITOR		32
 #define UNDOHISTORYSIZE_ENVELOPEEDITOR	8
 
-#define UNDODEPTH_PATTERNEDITOR			32
+#define UNDODEPTH_PATTERNEDITOR			1024
+#define UNDOMEMORY_PATTERNEDITOR		(1024*1024)
 #define UNDOHISTORYSIZE_PATTERNEDITOR	8
 
 #define UNDODEPTH_SAMPLEEDITOR			16
@@ -123,6 +124,10 @@ public:
 };
 
 // Undo information from pattern editor
+// An entry created with a reference entry only stores the cells which
+// differ from the reference (as runs of changed cells), every couple of
+// deltas a full (compressed) keyframe is taken. The data is shared and
+// reference counted, so copying an entry is cheap.
 class PatternUndoStackEntry : public UndoStackEntry
 {
 public:
@@ -131,20 +136,29 @@ public:
 						  const pp_int32 cursorPositionChannel, 
 						  const pp_int32 cursorPositionRow, 
 						  const pp_int32 cursorPositionInner,
-						  const UserData* userData = NULL);
+						  const UserData* userData = NULL,
+						  const PatternUndoStackEntry* reference = NULL);
 	// Copy ctor
 	PatternUndoStackEntry(const PatternUndoStackEntry& source);
 
 	// dtor
 	virtual ~PatternUndoStackEntry();
 
-	// get your pattern
-	const TXMPattern& GetPattern() const { return pattern; }
+	pp_int32 getRows() const { return node ? node->rows : 0; }
+	pp_int32 getChannum() const { return node ? node->channum : 0; }
+	pp_int32 getEffnum() const { return node ? node->effnum : 0; }
+	
+	// write the saved pattern data into the given pattern, 
+	// which must have the same dimensions
+	void restorePattern(TXMPattern& pattern) const;
 
 	pp_int32 getCursorPositionChannel() const { return cursorPositionChannel; }
 	pp_int32 getCursorPositionRow() const { return cursorPositionRow; }
 	pp_int32 getCursorPositionInner() const { return cursorPositionInner; }
 
+	// approximate, keyframes shared with other entries are not counted
+	pp_uint32 getMemoryUsage() const;
+
 	// assignment operator
 	PatternUndoStackEntry& operator=(const PatternUndoStackEntry& source);
 	
@@ -154,11 +168,41 @@ public:
 
 
 private:	
-	TXMPattern pattern;
+	enum
+	{
+		// longest chain of deltas before a new keyframe is taken
+		MAXDELTADEPTH = 64
+	};
+
+	struct Node
+	{
+		pp_int32 refCount;
+		// state this delta applies to, NULL for keyframes
+		Node* parent;
+		pp_int32 depth;
+		// delta bytes from the keyframe down to this node
+		pp_uint32 deltaSize;
+		
+		mp_uword rows;
+		mp_ubyte effnum;
+		mp_ubyte channum;
+		
+		// keyframe: TXMPattern::compress'ed pattern data
+		// delta: runs of (first cell, number of cells, cell data)
+		pp_uint32 len;
+		mp_ubyte* data;
+	};
+
+	Node* node;
 	
 	pp_int32 cursorPositionChannel;
 	pp_int32 cursorPositionRow;
 	pp_int32 cursorPositionInner;
+
+	static Node* createKeyFrame(const TXMPattern& pattern);
+	static Node* createDelta(Node* parent, const TXMPattern& pattern, const mp_ubyte* parentData);
+	static void releaseNode(Node* node);
+	static void restoreNode(const Node* node, mp_ubyte* dest);
 };
 
 // Less memory consumption than TEnvelope because XMs can only handle 12 envelope points
@@ -224,18 +268,34 @@ private:
 struct TXMSample;
 
 // Undo information from Sample Editor
+// The sample data is stored in reference counted chunks. An entry created
+// with a reference entry shares every chunk whose content didn't change,
+// copying entries only copies chunk pointers.
 class SampleUndoStackEntry : public UndoStackEntry
 {
 public:
+	enum
+	{
+		CHUNKSHIFT = 16,
+		CHUNKSIZE = 1 << CHUNKSHIFT
+	};
+
 	SampleUndoStackEntry() : 
-		UndoStackEntry(NULL)
+		UndoStackEntry(NULL),
+		samplen(0), loopstart(0), looplen(0),
+		relnote(0), finetune(0),
+		chunks(NULL), numChunks(0),
+		padding(NULL), leadingPadding(0),
+		flags(0),
+		selectionStart(-1), selectionEnd(-1)
 	{
 	}
 
 	SampleUndoStackEntry(const TXMSample& sample, 
 						 pp_int32 selectionStart, 
 						 pp_int32 selectionEnd, 
-						 const UserData* userData = NULL);
+						 const UserData* userData = NULL,
+						 const SampleUndoStackEntry* reference = NULL);
 						 
 	SampleUndoStackEntry(const SampleUndoStackEntry& src);
 						 
@@ -255,25 +315,49 @@ public:
 	mp_sbyte getRelNote() const { return relnote; }
 	mp_sbyte getFineTune() const { return finetune; }
 	
-	const pp_uint8* getBuffer() const { return buffer; }
+	bool hasBuffer() const { return padding != NULL; }
+	// restore the saved data (including padding) into sample memory 
+	// allocated with TXMSample::allocPaddedMem
+	void copyBuffer(void* dst) const;
+
+	pp_uint32 getNumChunks() const { return numChunks; }
+	const pp_uint8* getChunkData(pp_uint32 index) const { return chunks[index]->data; }
+	pp_uint32 getChunkSize(pp_uint32 index) const { return chunks[index]->size; }
+	// true if both entries use the same memory for the given chunk
+	bool isSharedChunk(const SampleUndoStackEntry& source, pp_uint32 index) const 
+	{ 
+		return index < numChunks && index < source.numChunks && chunks[index] == source.chunks[index]; 
+	}
 	
 	pp_int32 getSelectionStart() const { return selectionStart; }
 	pp_int32 getSelectionEnd() const { return selectionEnd; }
 	
 private:
+	struct Chunk
+	{
+		pp_int32 refCount;
+		pp_uint32 size;
+		pp_uint8* data;
+	};
+
 	// from sample
 	pp_uint32 samplen, loopstart, looplen;
 	mp_sbyte relnote, finetune;
-	pp_uint8* buffer;
+	Chunk** chunks;
+	pp_uint32 numChunks;
+	pp_uint8* padding;
+	pp_uint32 leadingPadding;
 	pp_uint8 flags;
 
 	// from sample editor
 	pp_int32 selectionStart;
 	pp_int32 selectionEnd;
 
-	pp_int32 checkSum;
-	
-	void calcCheckSum();
+	static Chunk* createChunk(const pp_uint8* src, pp_uint32 size);
+	static void releaseChunk(Chunk* chunk);
+
+	void copyData(const SampleUndoStackEntry& src);
+	void releaseData();
 };
 
 // undo history maintainance
@@ -984,6 +984,9 @@ unrecognizedCommandLineSwitch:
 	done = 0;
 	while (!done && SDL_WaitEvent(&event))
 	{
+		// everything redrawn while handling this event is presented at once
+		myDisplayDevice->beginFrame();
+
 		switch (event.type)
 		{
 			case SDL_QUIT:
@@ -1030,6 +1033,8 @@ unrecognizedCommandLineSwitch:
 				processSDLEvents(event);
 				break;
 		}
+
+		myDisplayDevice->endFrame();
 	}
 
 	ticking = false;